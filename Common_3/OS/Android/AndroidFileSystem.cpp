@@ -109,6 +109,8 @@ static AAssetManager* pAssetManager = NULL;
 
 bool initFileSystem(FileSystemInitDesc* pDesc)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_FILESYSTEM);
+
 	if (gInitialized)
 	{
 		LOGF(LogLevel::eWARNING, "FileSystem already initialized.");
@@ -55,6 +55,9 @@ void _FailedAssert(const char* file, int line, const char* statement)
 {
 	static bool debug = true;
 
+	// Make sure queued log messages leading up to the assert are written out
+	Log::Flush();
+
 	if (debug)
 	{
 		__android_log_print(ANDROID_LOG_ERROR, "The-Forge", "Assertion failed: (%s)\n\nFile: %s\nLine: %d\n\n", statement, file, line);
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include "../../Renderer/IRenderer.h"
+#include "../../Renderer/IResourceLoader.h"
+#include "../Interfaces/ILog.h"
+#include "Atomics.h"
+
+#define IMEMORY_FROM_HEADER
+#include "../../OS/Interfaces/IMemory.h"
+
+// D3D11 buffers can not stay mapped while the GPU reads them, every allocation would be a pointer into an unmapped buffer
+#if defined(DIRECT3D11)
+#error "FrameUploadAllocator needs persistently mapped buffers, which D3D11 does not have. Use mapBuffer / unmapBuffer on a GPURingBuffer instead"
+#endif
+
+/************************************************************************/
+/* FRAME UPLOAD ALLOCATOR											   */
+/************************************************************************/
+// Linear allocator for data written by the CPU once per frame and read by the GPU in the same frame (uniforms, dynamic
+// vertex / index data, structured buffers). One persistently mapped buffer holds a region per frame in flight, the
+// region of a frame is handed out with an atomic bump so any number of threads can allocate without a lock, and it is
+// recycled by beginFrameUploadAllocator once the fence of that frame signaled. Unlike GPURingBuffer it never wraps
+// into data the GPU may still read: a frame that runs out of space gets empty allocations and should grow mSizePerFrame.
+//
+// Frame usage:
+//   beginFrameUploadAllocator(frameIndex, fence) -> getFrameUploadAllocation(...) from any thread -> bind pBuffer + mOffset
+
+typedef struct FrameUploadAllocatorDesc
+{
+	/// Frames in flight, one region each
+	uint32_t       mFrameCount;
+	/// Bytes available to a frame
+	uint64_t       mSizePerFrame;
+	/// Views the buffer gets bound as, DESCRIPTOR_TYPE_UNIFORM_BUFFER if 0
+	DescriptorType mDescriptors;
+	/// Stride of the structured buffer view if mDescriptors has DESCRIPTOR_TYPE_BUFFER
+	uint32_t       mStructStride;
+	const char*    pName;
+} FrameUploadAllocatorDesc;
+
+typedef struct FrameUploadAllocation
+{
+	Buffer*  pBuffer;
+	/// Offset from the start of pBuffer, pass it to cmdBindVertexBuffer, DescriptorData::pOffsets and such
+	uint64_t mOffset;
+	/// Where to write the data, NULL if the frame ran out of space
+	void*    pData;
+} FrameUploadAllocation;
+
+typedef struct FrameUploadAllocator
+{
+	/// Bytes allocated from the current frame, bumped by every allocation
+	tfrg_atomic64_t mOffset;
+	/// Set by the first failed allocation of the frame so it is only reported once
+	tfrg_atomic32_t mOutOfMemory;
+	Renderer*       pRenderer;
+	Buffer*         pBuffer;
+	uint32_t        mAlignment;
+	uint32_t        mFrameCount;
+	uint32_t        mFrameIndex;
+	/// Bytes of a frame region, multiple of mAlignment
+	uint64_t        mSizePerFrame;
+	/// Most bytes any frame used since the allocator was created
+	tfrg_atomic64_t mPeakSize;
+} FrameUploadAllocator;
+
+static inline void addFrameUploadAllocator(Renderer* pRenderer, const FrameUploadAllocatorDesc* pDesc, FrameUploadAllocator** ppAllocator)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->mFrameCount && pDesc->mSizePerFrame);
+	ASSERT(ppAllocator);
+
+	FrameUploadAllocator* pAllocator = (FrameUploadAllocator*)tf_calloc(1, sizeof(FrameUploadAllocator));
+	pAllocator->pRenderer = pRenderer;
+	pAllocator->mFrameCount = pDesc->mFrameCount;
+	// Every allocation starts on a boundary usable by uniform and structured buffer views and float4 vertex fetch
+	pAllocator->mAlignment = max((uint32_t)pRenderer->pActiveGpuSettings->mUniformBufferAlignment, (uint32_t)sizeof(float[4]));
+	// and element aligned for the structured buffer view, which addresses the buffer in whole elements
+	const uint32_t baseAlignment = pAllocator->mAlignment;
+	while (pDesc->mStructStride && pAllocator->mAlignment % pDesc->mStructStride)
+		pAllocator->mAlignment += baseAlignment;
+	pAllocator->mSizePerFrame = round_up_64(pDesc->mSizePerFrame, pAllocator->mAlignment);
+
+	BufferDesc bufferDesc = {};
+	bufferDesc.mDescriptors = pDesc->mDescriptors ? pDesc->mDescriptors : DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	bufferDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | BUFFER_CREATION_FLAG_NO_DESCRIPTOR_VIEW_CREATION;
+	bufferDesc.mSize = pAllocator->mSizePerFrame * pDesc->mFrameCount;
+	bufferDesc.mStructStride = pDesc->mStructStride;
+	bufferDesc.mElementCount = pDesc->mStructStride ? bufferDesc.mSize / pDesc->mStructStride : 0;
+	bufferDesc.pName = pDesc->pName;
+	BufferLoadDesc loadDesc = {};
+	loadDesc.mDesc = bufferDesc;
+	loadDesc.ppBuffer = &pAllocator->pBuffer;
+	addResource(&loadDesc, NULL);
+	ASSERT(pAllocator->pBuffer->pCpuMappedAddress);
+
+	*ppAllocator = pAllocator;
+}
+
+static inline void removeFrameUploadAllocator(FrameUploadAllocator* pAllocator)
+{
+	ASSERT(pAllocator);
+	removeResource(pAllocator->pBuffer);
+	tf_free(pAllocator);
+}
+
+/// Recycles the region of frameIndex. pFence is the fence of the last submit that read it, waited on if it did not
+/// signal yet; pass NULL if the caller already waited. Not thread safe against getFrameUploadAllocation
+static inline void beginFrameUploadAllocator(FrameUploadAllocator* pAllocator, uint32_t frameIndex, Fence* pFence)
+{
+	ASSERT(frameIndex < pAllocator->mFrameCount);
+
+	if (pFence)
+	{
+		FenceStatus fenceStatus;
+		getFenceStatus(pAllocator->pRenderer, pFence, &fenceStatus);
+		if (fenceStatus == FENCE_STATUS_INCOMPLETE)
+			waitForFences(pAllocator->pRenderer, 1, &pFence);
+	}
+
+	pAllocator->mFrameIndex = frameIndex;
+	tfrg_atomic64_store_release(&pAllocator->mOffset, 0);
+	tfrg_atomic32_store_relaxed(&pAllocator->mOutOfMemory, 0);
+}
+
+/// Thread safe and lock free. The offset is a multiple of both alignment and the default alignment of the allocator
+static inline FrameUploadAllocation getFrameUploadAllocation(FrameUploadAllocator* pAllocator, uint64_t size, uint32_t alignment = 0)
+{
+	FrameUploadAllocation allocation = {};
+	uint32_t              allocationAlignment = pAllocator->mAlignment;
+	while (alignment && allocationAlignment % alignment)
+		allocationAlignment += pAllocator->mAlignment;
+	// Padding the size keeps the bump of the next allocation aligned, so the common case is a single atomic add
+	const uint64_t alignedSize = round_up_64(size, pAllocator->mAlignment);
+
+	// Regions start on a multiple of the default alignment only, larger alignments apply to the offset in the buffer
+	const uint64_t regionOffset = (uint64_t)pAllocator->mFrameIndex * pAllocator->mSizePerFrame;
+	uint64_t       offset = 0;
+	if (allocationAlignment == pAllocator->mAlignment)
+	{
+		offset = tfrg_atomic64_add_relaxed(&pAllocator->mOffset, alignedSize);
+	}
+	else
+	{
+		uint64_t current = tfrg_atomic64_load_relaxed(&pAllocator->mOffset);
+		for (;;)
+		{
+			offset = round_up_64(regionOffset + current, allocationAlignment) - regionOffset;
+			const uint64_t prev = tfrg_atomic64_cas_relaxed(&pAllocator->mOffset, current, offset + alignedSize);
+			if (prev == current)
+				break;
+			current = prev;
+		}
+	}
+
+	const uint64_t end = offset + alignedSize;
+	if (end > pAllocator->mSizePerFrame)
+	{
+		// Leave mOffset past the end, later allocations of the frame fail the same way instead of reusing the tail
+		if (!tfrg_atomic32_cas_relaxed(&pAllocator->mOutOfMemory, 0, 1))
+		{
+			LOGF(eWARNING, "Frame upload allocator out of memory allocating %llu bytes, increase mSizePerFrame (%llu)",
+				 (unsigned long long)size, (unsigned long long)pAllocator->mSizePerFrame);
+		}
+		return allocation;
+	}
+	tfrg_atomic64_max_relaxed(&pAllocator->mPeakSize, end);
+
+	allocation.pBuffer = pAllocator->pBuffer;
+	allocation.mOffset = regionOffset + offset;
+	allocation.pData = (uint8_t*)pAllocator->pBuffer->pCpuMappedAddress + allocation.mOffset;
+	return allocation;
+}
+
+/// Copies size bytes of pData into a new allocation
+static inline FrameUploadAllocation uploadFrameData(FrameUploadAllocator* pAllocator, const void* pData, uint64_t size, uint32_t alignment = 0)
+{
+	FrameUploadAllocation allocation = getFrameUploadAllocation(pAllocator, size, alignment);
+	if (allocation.pData)
+		memcpy(allocation.pData, pData, (size_t)size);
+	return allocation;
+}
+
+/// Bytes used by the current frame so far and the most any frame used, to size mSizePerFrame
+static inline void getFrameUploadAllocatorUsage(FrameUploadAllocator* pAllocator, uint64_t* pUsedSize, uint64_t* pPeakSize)
+{
+	if (pUsedSize)
+		*pUsedSize = min((uint64_t)tfrg_atomic64_load_relaxed(&pAllocator->mOffset), pAllocator->mSizePerFrame);
+	if (pPeakSize)
+		*pPeakSize = tfrg_atomic64_load_relaxed(&pAllocator->mPeakSize);
+}
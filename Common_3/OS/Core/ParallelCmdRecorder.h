@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Renderer/IRenderer.h"
+#include "../Interfaces/ILog.h"
+#include "../Interfaces/IThread.h"
+#include "Atomics.h"
+#include "ThreadSystem.h"
+
+#define IMEMORY_FROM_HEADER
+#include "../../OS/Interfaces/IMemory.h"
+
+/************************************************************************/
+/* PARALLEL COMMAND RECORDING										   */
+/************************************************************************/
+// Splits command recording of a pass over the ThreadSystem workers.
+// Every task records into its own Cmd allocated from its own CmdPool (pools are not thread safe), one set per frame in
+// flight so the pools of a frame can be reset once its fence signaled. Cmds are handed out by task index, not by
+// worker thread, so getParallelCmds always returns them in the order the tasks were issued and the submission order
+// does not depend on scheduling.
+//
+// Frame usage:
+//   beginParallelCmdRecording(frameIndex) -> recordParallelCmds(...) for every parallel pass -> getParallelCmds -> queueSubmit
+//
+// Tasks record primary command buffers that are submitted after the Cmd of the calling thread, so each task has to bind
+// its render targets (with LOAD_ACTION_LOAD) and pipeline state itself.
+
+typedef void (*ParallelCmdRecordFunc)(Cmd* pCmd, uint32_t taskIndex, void* pUserData);
+
+typedef struct ParallelCmdRecorderDesc
+{
+	/// Queue the cmds get submitted to
+	Queue*        pQueue;
+	/// NULL records all tasks on the calling thread
+	ThreadSystem* pThreadSystem;
+	/// Frames in flight, one set of CmdPools each
+	uint32_t      mFrameCount;
+	/// Max number of tasks recorded per frame, summed over all recordParallelCmds calls
+	uint32_t      mMaxCmdsPerFrame;
+} ParallelCmdRecorderDesc;
+
+typedef struct ParallelCmdRecorder
+{
+	Renderer*     pRenderer;
+	ThreadSystem* pThreadSystem;
+	/// mFrameCount * mMaxCmdsPerFrame entries, frame major
+	CmdPool**     ppCmdPools;
+	Cmd**         ppCmds;
+	uint32_t      mFrameCount;
+	uint32_t      mMaxCmdsPerFrame;
+	uint32_t      mFrameIndex;
+	/// Cmds recorded into the current frame so far
+	uint32_t      mCmdCount;
+	/// Pools of the current frame used by the previous recording of this frame index, only those need a reset
+	uint32_t*     pUsedCmdCounts;
+} ParallelCmdRecorder;
+
+typedef struct ParallelCmdRecordTask
+{
+	ParallelCmdRecorder*  pRecorder;
+	ParallelCmdRecordFunc pFunc;
+	void*                 pUserData;
+	uint32_t              mFirstCmd;
+	tfrg_atomic32_t       mDoneCount;
+} ParallelCmdRecordTask;
+
+static inline void addParallelCmdRecorder(Renderer* pRenderer, const ParallelCmdRecorderDesc* pDesc, ParallelCmdRecorder** ppRecorder)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->pQueue);
+	ASSERT(pDesc->mFrameCount && pDesc->mMaxCmdsPerFrame);
+	ASSERT(ppRecorder);
+
+	const uint32_t       cmdCount = pDesc->mFrameCount * pDesc->mMaxCmdsPerFrame;
+	ParallelCmdRecorder* pRecorder = (ParallelCmdRecorder*)tf_calloc(1, sizeof(ParallelCmdRecorder));
+	pRecorder->pRenderer = pRenderer;
+	pRecorder->pThreadSystem = pDesc->pThreadSystem;
+	pRecorder->mFrameCount = pDesc->mFrameCount;
+	pRecorder->mMaxCmdsPerFrame = pDesc->mMaxCmdsPerFrame;
+	pRecorder->ppCmdPools = (CmdPool**)tf_calloc(cmdCount, sizeof(CmdPool*));
+	pRecorder->ppCmds = (Cmd**)tf_calloc(cmdCount, sizeof(Cmd*));
+	pRecorder->pUsedCmdCounts = (uint32_t*)tf_calloc(pDesc->mFrameCount, sizeof(uint32_t));
+
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pDesc->pQueue;
+	cmdPoolDesc.mTransient = true;
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		addCmdPool(pRenderer, &cmdPoolDesc, &pRecorder->ppCmdPools[i]);
+		CmdDesc cmdDesc = {};
+		cmdDesc.pPool = pRecorder->ppCmdPools[i];
+		addCmd(pRenderer, &cmdDesc, &pRecorder->ppCmds[i]);
+	}
+
+	*ppRecorder = pRecorder;
+}
+
+static inline void removeParallelCmdRecorder(ParallelCmdRecorder* pRecorder)
+{
+	ASSERT(pRecorder);
+
+	const uint32_t cmdCount = pRecorder->mFrameCount * pRecorder->mMaxCmdsPerFrame;
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		removeCmd(pRecorder->pRenderer, pRecorder->ppCmds[i]);
+		removeCmdPool(pRecorder->pRenderer, pRecorder->ppCmdPools[i]);
+	}
+
+	tf_free(pRecorder->pUsedCmdCounts);
+	tf_free(pRecorder->ppCmds);
+	tf_free(pRecorder->ppCmdPools);
+	tf_free(pRecorder);
+}
+
+/// Call once the fence of frameIndex signaled, resets the pools used by the previous recording of that frame
+static inline void beginParallelCmdRecording(ParallelCmdRecorder* pRecorder, uint32_t frameIndex)
+{
+	ASSERT(frameIndex < pRecorder->mFrameCount);
+
+	CmdPool** ppCmdPools = pRecorder->ppCmdPools + frameIndex * pRecorder->mMaxCmdsPerFrame;
+	for (uint32_t i = 0; i < pRecorder->pUsedCmdCounts[frameIndex]; ++i)
+		resetCmdPool(pRecorder->pRenderer, ppCmdPools[i]);
+
+	pRecorder->pUsedCmdCounts[frameIndex] = 0;
+	pRecorder->mFrameIndex = frameIndex;
+	pRecorder->mCmdCount = 0;
+}
+
+static inline void parallelCmdRecordTask(void* pUserData, uintptr_t taskIndex)
+{
+	ParallelCmdRecordTask* pTask = (ParallelCmdRecordTask*)pUserData;
+	ParallelCmdRecorder*   pRecorder = pTask->pRecorder;
+	Cmd* pCmd = pRecorder->ppCmds[pRecorder->mFrameIndex * pRecorder->mMaxCmdsPerFrame + pTask->mFirstCmd + (uint32_t)taskIndex];
+
+	beginCmd(pCmd);
+	pTask->pFunc(pCmd, (uint32_t)taskIndex, pTask->pUserData);
+	endCmd(pCmd);
+
+	tfrg_atomic32_add_relaxed(&pTask->mDoneCount, 1);
+}
+
+/// Calls pFunc for taskIndex in [0, taskCount) on the worker threads, each with its own Cmd in recording state.
+/// The calling thread helps recording and returns once all tasks are done
+static inline void recordParallelCmds(ParallelCmdRecorder* pRecorder, uint32_t taskCount, ParallelCmdRecordFunc pFunc, void* pUserData)
+{
+	ASSERT(pFunc);
+	if (!taskCount)
+		return;
+
+	if (pRecorder->mCmdCount + taskCount > pRecorder->mMaxCmdsPerFrame)
+	{
+		LOGF(eERROR, "Recording %u parallel cmds exceeds mMaxCmdsPerFrame (%u), %u already recorded this frame", taskCount,
+			 pRecorder->mMaxCmdsPerFrame, pRecorder->mCmdCount);
+		ASSERT(false);
+		return;
+	}
+
+	ParallelCmdRecordTask task = {};
+	task.pRecorder = pRecorder;
+	task.pFunc = pFunc;
+	task.pUserData = pUserData;
+	task.mFirstCmd = pRecorder->mCmdCount;
+
+	if (pRecorder->pThreadSystem && taskCount > 1)
+	{
+		addThreadSystemRangeTask(pRecorder->pThreadSystem, parallelCmdRecordTask, &task, taskCount);
+		while ((uint32_t)tfrg_atomic32_load_acquire(&task.mDoneCount) < taskCount)
+		{
+			if (!assistThreadSystem(pRecorder->pThreadSystem))
+				Thread::Sleep(0);
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < taskCount; ++i)
+			parallelCmdRecordTask(&task, i);
+	}
+
+	pRecorder->mCmdCount += taskCount;
+	pRecorder->pUsedCmdCounts[pRecorder->mFrameIndex] = pRecorder->mCmdCount;
+}
+
+/// Cmds recorded this frame in issue order, append them to the QueueSubmitDesc after the cmds they depend on
+static inline Cmd** getParallelCmds(ParallelCmdRecorder* pRecorder, uint32_t* pCmdCount)
+{
+	ASSERT(pCmdCount);
+	*pCmdCount = pRecorder->mCmdCount;
+	return pRecorder->ppCmds + pRecorder->mFrameIndex * pRecorder->mMaxCmdsPerFrame;
+}
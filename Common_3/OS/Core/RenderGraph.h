@@ -0,0 +1,583 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Renderer/IRenderer.h"
+#include "../../Renderer/IResourceLoader.h"
+#include "../Interfaces/ILog.h"
+#include "../../ThirdParty/OpenSource/EASTL/vector.h"
+#include "ResourceStateTracker.h"
+
+#define IMEMORY_FROM_HEADER
+#include "../../OS/Interfaces/IMemory.h"
+
+/************************************************************************/
+/* FRAME RENDER GRAPH												   */
+/************************************************************************/
+// Passes declare the resources they read and write and the state they need them in, the graph:
+//  - culls passes whose outputs are never read (unless flagged with side effects or writing an imported resource)
+//  - records the barriers between passes, one cmdResourceBarrier per pass
+//  - backs transient render targets / buffers with pooled physical resources. Transients with matching descs whose
+//    lifetimes (first to last live pass using them) do not overlap share one physical resource, which keeps the
+//    footprint at the peak of simultaneously live transients instead of their sum.
+//
+// Frame usage:
+//   beginRenderGraph -> add / import resources, add passes with their reads and writes -> compileRenderGraph -> cmdExecuteRenderGraph
+//
+// Transient contents are undefined at the first write of every frame, passes have to clear or fully overwrite them.
+// The physical resource behind a handle can change when the graph changes shape, so passes should fetch it with
+// getRenderGraphRenderTarget / getRenderGraphBuffer while executing and update their descriptor sets accordingly.
+// Pooled resources unused for RENDER_GRAPH_MAX_UNUSED_FRAMES are released, which has to stay above the frame latency.
+
+#define RENDER_GRAPH_INVALID_HANDLE       0xFFFFFFFF
+#define RENDER_GRAPH_MAX_UNUSED_FRAMES    8
+
+typedef uint32_t RenderGraphHandle;
+typedef struct RenderGraph RenderGraph;
+typedef void (*RenderGraphPassFunc)(Cmd* pCmd, RenderGraph* pGraph, void* pUserData);
+
+typedef enum RenderGraphResourceType
+{
+	RENDER_GRAPH_RESOURCE_RENDER_TARGET = 0,
+	RENDER_GRAPH_RESOURCE_BUFFER,
+	RENDER_GRAPH_RESOURCE_TEXTURE,
+} RenderGraphResourceType;
+
+typedef struct RenderGraphResource
+{
+	RenderGraphResourceType mType;
+	bool                    mImported;
+	RenderTargetDesc        mRenderTargetDesc;
+	BufferDesc              mBufferDesc;
+	/// Physical resource, pool index for transients
+	void*                   pResource;
+	uint32_t                mPhysicalIndex;
+	/// Imported resources are transitioned to this state at the end of the graph
+	ResourceState           mState;
+	ResourceState           mFinalState;
+	/// Live passes reading it, the resource keeps its writers alive while non zero
+	uint32_t                mReadCount;
+	uint32_t                mFirstPass;
+	uint32_t                mLastPass;
+} RenderGraphResource;
+
+typedef struct RenderGraphAccess
+{
+	RenderGraphHandle mHandle;
+	ResourceState     mState;
+	bool              mWrite;
+} RenderGraphAccess;
+
+typedef struct RenderGraphPass
+{
+	const char*                       pName;
+	RenderGraphPassFunc               pFunc;
+	void*                             pUserData;
+	eastl::vector<RenderGraphAccess>  mAccesses;
+	/// Outputs still read by a live pass
+	uint32_t                          mRefCount;
+	bool                              mSideEffects;
+	bool                              mCulled;
+} RenderGraphPass;
+
+typedef struct RenderGraphPhysicalResource
+{
+	RenderTargetDesc mRenderTargetDesc;
+	BufferDesc       mBufferDesc;
+	void*            pResource;
+	ResourceState    mState;
+	uint32_t         mLastUsedFrame;
+	/// Last pass of the transient currently using it, pool entries are free for transients starting after it
+	uint32_t         mBusyUntilPass;
+	bool             mBusy;
+} RenderGraphPhysicalResource;
+
+typedef struct RenderGraphStats
+{
+	uint32_t mPassCount;
+	uint32_t mCulledPassCount;
+	uint32_t mTransientResourceCount;
+	/// Physical resources backing the transients this frame
+	uint32_t mPhysicalResourceCount;
+	uint32_t mBarrierCount;
+} RenderGraphStats;
+
+typedef struct RenderGraph
+{
+	Renderer*                                  pRenderer;
+	eastl::vector<RenderGraphResource>         mResources;
+	eastl::vector<RenderGraphPass>             mPasses;
+	eastl::vector<RenderGraphPhysicalResource> mRenderTargetPool;
+	eastl::vector<RenderGraphPhysicalResource> mBufferPool;
+	eastl::vector<BufferBarrier>               mBufferBarriers;
+	eastl::vector<TextureBarrier>              mTextureBarriers;
+	eastl::vector<RenderTargetBarrier>         mRenderTargetBarriers;
+	RenderGraphStats                           mStats;
+	uint32_t                                   mFrameIndex;
+	bool                                       mCompiled;
+} RenderGraph;
+
+static inline void addRenderGraph(Renderer* pRenderer, RenderGraph** ppGraph)
+{
+	RenderGraph* pGraph = tf_new(RenderGraph);
+	pGraph->pRenderer = pRenderer;
+	pGraph->mStats = {};
+	pGraph->mFrameIndex = 0;
+	pGraph->mCompiled = false;
+	*ppGraph = pGraph;
+}
+
+/// The caller has to make sure the GPU is done with the graph resources
+static inline void removeRenderGraph(RenderGraph* pGraph)
+{
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mRenderTargetPool.size(); ++i)
+		removeRenderTarget(pGraph->pRenderer, (RenderTarget*)pGraph->mRenderTargetPool[i].pResource);
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mBufferPool.size(); ++i)
+		removeResource((Buffer*)pGraph->mBufferPool[i].pResource);
+	tf_delete(pGraph);
+}
+
+/// Starts declaring the graph of the current frame
+static inline void beginRenderGraph(RenderGraph* pGraph)
+{
+	pGraph->mResources.clear();
+	pGraph->mPasses.clear();
+	pGraph->mCompiled = false;
+}
+
+static inline RenderGraphHandle addRenderGraphResource(RenderGraph* pGraph, RenderGraphResourceType type, bool imported)
+{
+	RenderGraphResource resource = {};
+	resource.mType = type;
+	resource.mImported = imported;
+	resource.mPhysicalIndex = RENDER_GRAPH_INVALID_HANDLE;
+	resource.mFirstPass = RENDER_GRAPH_INVALID_HANDLE;
+	pGraph->mResources.push_back(resource);
+	return (RenderGraphHandle)pGraph->mResources.size() - 1;
+}
+
+/// Transient render target, only valid while the graph executes. pName has to outlive the graph
+static inline RenderGraphHandle addRenderGraphRenderTarget(RenderGraph* pGraph, const RenderTargetDesc* pDesc)
+{
+	ASSERT(pDesc);
+	ASSERT(!pDesc->pNativeHandle);
+	RenderGraphHandle handle = addRenderGraphResource(pGraph, RENDER_GRAPH_RESOURCE_RENDER_TARGET, false);
+	pGraph->mResources[handle].mRenderTargetDesc = *pDesc;
+	return handle;
+}
+
+/// Transient GPU only buffer, only valid while the graph executes
+static inline RenderGraphHandle addRenderGraphBuffer(RenderGraph* pGraph, const BufferDesc* pDesc)
+{
+	ASSERT(pDesc);
+	ASSERT(RESOURCE_MEMORY_USAGE_GPU_ONLY == pDesc->mMemoryUsage);
+	RenderGraphHandle handle = addRenderGraphResource(pGraph, RENDER_GRAPH_RESOURCE_BUFFER, false);
+	pGraph->mResources[handle].mBufferDesc = *pDesc;
+	return handle;
+}
+
+/// Resource owned by the application, e.g. the swapchain image. It is in currentState when the graph starts executing
+/// and is left in finalState
+static inline RenderGraphHandle importRenderGraphRenderTarget(
+	RenderGraph* pGraph, RenderTarget* pRenderTarget, ResourceState currentState, ResourceState finalState)
+{
+	RenderGraphHandle handle = addRenderGraphResource(pGraph, RENDER_GRAPH_RESOURCE_RENDER_TARGET, true);
+	pGraph->mResources[handle].pResource = pRenderTarget;
+	pGraph->mResources[handle].mState = currentState;
+	pGraph->mResources[handle].mFinalState = finalState;
+	return handle;
+}
+
+static inline RenderGraphHandle importRenderGraphTexture(RenderGraph* pGraph, Texture* pTexture, ResourceState currentState, ResourceState finalState)
+{
+	RenderGraphHandle handle = addRenderGraphResource(pGraph, RENDER_GRAPH_RESOURCE_TEXTURE, true);
+	pGraph->mResources[handle].pResource = pTexture;
+	pGraph->mResources[handle].mState = currentState;
+	pGraph->mResources[handle].mFinalState = finalState;
+	return handle;
+}
+
+static inline RenderGraphHandle importRenderGraphBuffer(RenderGraph* pGraph, Buffer* pBuffer, ResourceState currentState, ResourceState finalState)
+{
+	RenderGraphHandle handle = addRenderGraphResource(pGraph, RENDER_GRAPH_RESOURCE_BUFFER, true);
+	pGraph->mResources[handle].pResource = pBuffer;
+	pGraph->mResources[handle].mState = currentState;
+	pGraph->mResources[handle].mFinalState = finalState;
+	return handle;
+}
+
+/// Passes execute in the order they are added. Passes with side effects (readbacks, queries, ...) are never culled
+static inline uint32_t addRenderGraphPass(RenderGraph* pGraph, const char* pName, RenderGraphPassFunc pFunc, void* pUserData, bool sideEffects = false)
+{
+	RenderGraphPass pass = {};
+	pass.pName = pName;
+	pass.pFunc = pFunc;
+	pass.pUserData = pUserData;
+	pass.mSideEffects = sideEffects;
+	pGraph->mPasses.push_back(pass);
+	return (uint32_t)pGraph->mPasses.size() - 1;
+}
+
+static inline void addRenderGraphAccess(RenderGraph* pGraph, uint32_t passIndex, RenderGraphHandle handle, ResourceState state, bool write)
+{
+	ASSERT(passIndex < pGraph->mPasses.size());
+	ASSERT(handle < pGraph->mResources.size());
+	RenderGraphPass* pPass = &pGraph->mPasses[passIndex];
+	for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+	{
+		RenderGraphAccess* pAccess = &pPass->mAccesses[i];
+		if (pAccess->mHandle == handle)
+		{
+			// Reading the same resource through several bindings needs all the read states at once
+			ASSERT(!write && !pAccess->mWrite && "A pass can only access a resource it writes once");
+			pAccess->mState = (ResourceState)(pAccess->mState | state);
+			return;
+		}
+	}
+	RenderGraphAccess access = { handle, state, write };
+	pPass->mAccesses.push_back(access);
+}
+
+/// The pass reads handle in state (e.g. RESOURCE_STATE_SHADER_RESOURCE)
+static inline void readRenderGraphResource(RenderGraph* pGraph, uint32_t passIndex, RenderGraphHandle handle, ResourceState state)
+{
+	addRenderGraphAccess(pGraph, passIndex, handle, state, false);
+}
+
+/// The pass writes handle in state (e.g. RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_UNORDERED_ACCESS)
+static inline void writeRenderGraphResource(RenderGraph* pGraph, uint32_t passIndex, RenderGraphHandle handle, ResourceState state)
+{
+	addRenderGraphAccess(pGraph, passIndex, handle, state, true);
+}
+
+static inline bool isRenderGraphDescCompatible(const RenderTargetDesc* pA, const RenderTargetDesc* pB)
+{
+	return pA->mFlags == pB->mFlags && pA->mWidth == pB->mWidth && pA->mHeight == pB->mHeight && pA->mDepth == pB->mDepth &&
+		   pA->mArraySize == pB->mArraySize && pA->mMipLevels == pB->mMipLevels && pA->mSampleCount == pB->mSampleCount &&
+		   pA->mSampleQuality == pB->mSampleQuality && pA->mFormat == pB->mFormat && pA->mDescriptors == pB->mDescriptors &&
+		   !memcmp(&pA->mClearValue, &pB->mClearValue, sizeof(ClearValue));
+}
+
+static inline bool isRenderGraphDescCompatible(const BufferDesc* pA, const BufferDesc* pB)
+{
+	return pA->mSize == pB->mSize && pA->mMemoryUsage == pB->mMemoryUsage && pA->mFlags == pB->mFlags && pA->mFormat == pB->mFormat &&
+		   pA->mDescriptors == pB->mDescriptors && pA->mFirstElement == pB->mFirstElement && pA->mElementCount == pB->mElementCount &&
+		   pA->mStructStride == pB->mStructStride && pA->pCounterBuffer == pB->pCounterBuffer;
+}
+
+
+static inline void releaseRenderGraphPool(RenderGraph* pGraph, eastl::vector<RenderGraphPhysicalResource>& pool, bool isRenderTarget)
+{
+	for (uint32_t i = 0; i < (uint32_t)pool.size();)
+	{
+		if (pGraph->mFrameIndex - pool[i].mLastUsedFrame > RENDER_GRAPH_MAX_UNUSED_FRAMES)
+		{
+			if (isRenderTarget)
+				removeRenderTarget(pGraph->pRenderer, (RenderTarget*)pool[i].pResource);
+			else
+				removeResource((Buffer*)pool[i].pResource);
+			pool.erase_unsorted(pool.begin() + i);
+			continue;
+		}
+		pool[i].mBusy = false;
+		++i;
+	}
+}
+
+static inline void allocateRenderGraphResource(RenderGraph* pGraph, RenderGraphResource* pResource)
+{
+	const bool isRenderTarget = RENDER_GRAPH_RESOURCE_RENDER_TARGET == pResource->mType;
+	eastl::vector<RenderGraphPhysicalResource>& pool = isRenderTarget ? pGraph->mRenderTargetPool : pGraph->mBufferPool;
+
+	uint32_t physicalIndex = RENDER_GRAPH_INVALID_HANDLE;
+	for (uint32_t i = 0; i < (uint32_t)pool.size(); ++i)
+	{
+		const RenderGraphPhysicalResource* pPhysical = &pool[i];
+		if (pPhysical->mBusy && pPhysical->mBusyUntilPass >= pResource->mFirstPass)
+			continue;
+		if (isRenderTarget ? isRenderGraphDescCompatible(&pPhysical->mRenderTargetDesc, &pResource->mRenderTargetDesc)
+						   : isRenderGraphDescCompatible(&pPhysical->mBufferDesc, &pResource->mBufferDesc))
+		{
+			physicalIndex = i;
+			break;
+		}
+	}
+
+	if (RENDER_GRAPH_INVALID_HANDLE == physicalIndex)
+	{
+		RenderGraphPhysicalResource physical = {};
+		if (isRenderTarget)
+		{
+			physical.mRenderTargetDesc = pResource->mRenderTargetDesc;
+			RenderTarget* pRenderTarget = NULL;
+			addRenderTarget(pGraph->pRenderer, &physical.mRenderTargetDesc, &pRenderTarget);
+			physical.pResource = pRenderTarget;
+			physical.mState = physical.mRenderTargetDesc.mStartState;
+		}
+		else
+		{
+			Buffer*        pBuffer = NULL;
+			BufferLoadDesc loadDesc = {};
+			loadDesc.mDesc = pResource->mBufferDesc;
+			loadDesc.ppBuffer = &pBuffer;
+			addResource(&loadDesc, NULL);
+			physical.mBufferDesc = pResource->mBufferDesc;
+			physical.pResource = pBuffer;
+			physical.mState = loadDesc.mDesc.mStartState;
+		}
+		pool.push_back(physical);
+		physicalIndex = (uint32_t)pool.size() - 1;
+	}
+
+	RenderGraphPhysicalResource* pPhysical = &pool[physicalIndex];
+	if (pPhysical->mLastUsedFrame != pGraph->mFrameIndex)
+		++pGraph->mStats.mPhysicalResourceCount;
+	pPhysical->mBusy = true;
+	pPhysical->mBusyUntilPass = pResource->mLastPass;
+	pPhysical->mLastUsedFrame = pGraph->mFrameIndex;
+	pResource->mPhysicalIndex = physicalIndex;
+	pResource->pResource = pPhysical->pResource;
+}
+
+static inline void cullRenderGraphPass(RenderGraph* pGraph, RenderGraphPass* pPass, eastl::vector<RenderGraphHandle>& unreferenced)
+{
+	pPass->mCulled = true;
+	++pGraph->mStats.mCulledPassCount;
+	for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+	{
+		const RenderGraphAccess* pAccess = &pPass->mAccesses[i];
+		RenderGraphResource*     pResource = &pGraph->mResources[pAccess->mHandle];
+		if (!pAccess->mWrite && 0 == --pResource->mReadCount && !pResource->mImported)
+			unreferenced.push_back(pAccess->mHandle);
+	}
+}
+
+/// Culls unused passes and assigns physical resources to the transients, call once all passes of the frame are declared
+static inline void compileRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(!pGraph->mCompiled);
+	++pGraph->mFrameIndex;
+	pGraph->mStats = {};
+	pGraph->mStats.mPassCount = (uint32_t)pGraph->mPasses.size();
+
+	// Passes are referenced by the resources they write, resources by the passes reading them
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		RenderGraphPass* pPass = &pGraph->mPasses[p];
+		pPass->mRefCount = 0;
+		pPass->mCulled = false;
+		for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+		{
+			if (pPass->mAccesses[i].mWrite)
+				++pPass->mRefCount;
+			else
+				++pGraph->mResources[pPass->mAccesses[i].mHandle].mReadCount;
+		}
+	}
+
+	// Imported resources are read by the application after the graph, so they keep their writers alive.
+	// Seeded before any pass is culled, cullRenderGraphPass queues the resources whose read count it brings to 0 and
+	// every handle must be queued only once, each pop releases one reference of its writers
+	eastl::vector<RenderGraphHandle> unreferenced;
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+	{
+		if (!pGraph->mResources[r].mReadCount && !pGraph->mResources[r].mImported)
+			unreferenced.push_back(r);
+	}
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		RenderGraphPass* pPass = &pGraph->mPasses[p];
+		if (!pPass->mRefCount && !pPass->mSideEffects)
+			cullRenderGraphPass(pGraph, pPass, unreferenced);
+	}
+	while (!unreferenced.empty())
+	{
+		const RenderGraphHandle handle = unreferenced.back();
+		unreferenced.pop_back();
+		for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+		{
+			RenderGraphPass* pPass = &pGraph->mPasses[p];
+			if (pPass->mCulled)
+				continue;
+			for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+			{
+				if (pPass->mAccesses[i].mHandle == handle && pPass->mAccesses[i].mWrite)
+				{
+					if (0 == --pPass->mRefCount && !pPass->mSideEffects)
+						cullRenderGraphPass(pGraph, pPass, unreferenced);
+					break;
+				}
+			}
+		}
+	}
+
+	// Lifetimes over the live passes
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		const RenderGraphPass* pPass = &pGraph->mPasses[p];
+		if (pPass->mCulled)
+			continue;
+		for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+		{
+			RenderGraphResource* pResource = &pGraph->mResources[pPass->mAccesses[i].mHandle];
+			if (RENDER_GRAPH_INVALID_HANDLE == pResource->mFirstPass)
+				pResource->mFirstPass = p;
+			pResource->mLastPass = p;
+		}
+	}
+
+	// Transients are assigned in the order they become live, so pool entries are reused as soon as their previous
+	// user is done and the assignment stays the same from frame to frame while the graph does not change
+	releaseRenderGraphPool(pGraph, pGraph->mRenderTargetPool, true);
+	releaseRenderGraphPool(pGraph, pGraph->mBufferPool, false);
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		const RenderGraphPass* pPass = &pGraph->mPasses[p];
+		if (pPass->mCulled)
+			continue;
+		for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+		{
+			RenderGraphResource* pResource = &pGraph->mResources[pPass->mAccesses[i].mHandle];
+			if (!pResource->mImported && pResource->mFirstPass == p && RENDER_GRAPH_INVALID_HANDLE == pResource->mPhysicalIndex)
+			{
+				++pGraph->mStats.mTransientResourceCount;
+				allocateRenderGraphResource(pGraph, pResource);
+			}
+		}
+	}
+
+	pGraph->mCompiled = true;
+}
+
+static inline ResourceState* getRenderGraphResourceState(RenderGraph* pGraph, RenderGraphResource* pResource)
+{
+	if (pResource->mImported)
+		return &pResource->mState;
+	return RENDER_GRAPH_RESOURCE_RENDER_TARGET == pResource->mType ? &pGraph->mRenderTargetPool[pResource->mPhysicalIndex].mState
+																	: &pGraph->mBufferPool[pResource->mPhysicalIndex].mState;
+}
+
+static inline void addRenderGraphBarrier(RenderGraph* pGraph, RenderGraphResource* pResource, ResourceState newState)
+{
+	ResourceState* pState = getRenderGraphResourceState(pGraph, pResource);
+	if (!isResourceTransitionNeeded(*pState, newState))
+		return;
+
+	switch (pResource->mType)
+	{
+	case RENDER_GRAPH_RESOURCE_RENDER_TARGET:
+	{
+		RenderTargetBarrier barrier = { (RenderTarget*)pResource->pResource, *pState, newState };
+		pGraph->mRenderTargetBarriers.push_back(barrier);
+		break;
+	}
+	case RENDER_GRAPH_RESOURCE_BUFFER:
+	{
+		BufferBarrier barrier = { (Buffer*)pResource->pResource, *pState, newState };
+		pGraph->mBufferBarriers.push_back(barrier);
+		break;
+	}
+	case RENDER_GRAPH_RESOURCE_TEXTURE:
+	{
+		TextureBarrier barrier = { (Texture*)pResource->pResource, *pState, newState };
+		pGraph->mTextureBarriers.push_back(barrier);
+		break;
+	}
+	}
+	*pState = newState;
+}
+
+static inline void cmdFlushRenderGraphBarriers(Cmd* pCmd, RenderGraph* pGraph)
+{
+	const uint32_t barrierCount =
+		(uint32_t)(pGraph->mBufferBarriers.size() + pGraph->mTextureBarriers.size() + pGraph->mRenderTargetBarriers.size());
+	if (!barrierCount)
+		return;
+
+	cmdResourceBarrier(
+		pCmd, (uint32_t)pGraph->mBufferBarriers.size(), pGraph->mBufferBarriers.data(), (uint32_t)pGraph->mTextureBarriers.size(),
+		pGraph->mTextureBarriers.data(), (uint32_t)pGraph->mRenderTargetBarriers.size(), pGraph->mRenderTargetBarriers.data());
+	pGraph->mStats.mBarrierCount += barrierCount;
+	pGraph->mBufferBarriers.clear();
+	pGraph->mTextureBarriers.clear();
+	pGraph->mRenderTargetBarriers.clear();
+}
+
+/// Records the live passes into pCmd, each preceded by the barriers it needs, and leaves imported resources in their final state
+static inline void cmdExecuteRenderGraph(Cmd* pCmd, RenderGraph* pGraph)
+{
+	ASSERT(pGraph->mCompiled);
+
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		RenderGraphPass* pPass = &pGraph->mPasses[p];
+		if (pPass->mCulled)
+			continue;
+
+		for (uint32_t i = 0; i < (uint32_t)pPass->mAccesses.size(); ++i)
+			addRenderGraphBarrier(pGraph, &pGraph->mResources[pPass->mAccesses[i].mHandle], pPass->mAccesses[i].mState);
+		cmdFlushRenderGraphBarriers(pCmd, pGraph);
+
+		cmdBeginDebugMarker(pCmd, 1, 1, 0, pPass->pName);
+		pPass->pFunc(pCmd, pGraph, pPass->pUserData);
+		cmdEndDebugMarker(pCmd);
+	}
+
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+	{
+		RenderGraphResource* pResource = &pGraph->mResources[r];
+		if (pResource->mImported)
+			addRenderGraphBarrier(pGraph, pResource, pResource->mFinalState);
+	}
+	cmdFlushRenderGraphBarriers(pCmd, pGraph);
+}
+
+/// Physical resources behind a handle, only valid between compileRenderGraph and the next beginRenderGraph
+static inline RenderTarget* getRenderGraphRenderTarget(RenderGraph* pGraph, RenderGraphHandle handle)
+{
+	ASSERT(RENDER_GRAPH_RESOURCE_RENDER_TARGET == pGraph->mResources[handle].mType);
+	return (RenderTarget*)pGraph->mResources[handle].pResource;
+}
+
+static inline Buffer* getRenderGraphBuffer(RenderGraph* pGraph, RenderGraphHandle handle)
+{
+	ASSERT(RENDER_GRAPH_RESOURCE_BUFFER == pGraph->mResources[handle].mType);
+	return (Buffer*)pGraph->mResources[handle].pResource;
+}
+
+static inline Texture* getRenderGraphTexture(RenderGraph* pGraph, RenderGraphHandle handle)
+{
+	RenderGraphResource* pResource = &pGraph->mResources[handle];
+	if (RENDER_GRAPH_RESOURCE_RENDER_TARGET == pResource->mType)
+		return pResource->pResource ? ((RenderTarget*)pResource->pResource)->pTexture : NULL;
+	ASSERT(RENDER_GRAPH_RESOURCE_TEXTURE == pResource->mType);
+	return (Texture*)pResource->pResource;
+}
+
+/// Counters of the last compiled and executed frame
+static inline RenderGraphStats getRenderGraphStats(const RenderGraph* pGraph)
+{
+	return pGraph->mStats;
+}
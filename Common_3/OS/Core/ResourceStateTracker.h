@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../../Renderer/IRenderer.h"
+#include "../Interfaces/ILog.h"
+#include "../../ThirdParty/OpenSource/EASTL/hash_map.h"
+#include "../../ThirdParty/OpenSource/EASTL/vector.h"
+
+#define IMEMORY_FROM_HEADER
+#include "../../OS/Interfaces/IMemory.h"
+
+/************************************************************************/
+/* RESOURCE STATE TRACKING											  */
+/************************************************************************/
+// Optional layer over cmdResourceBarrier: callers only name the state a resource has to be in next and the
+// tracker fills in mCurrentState, per buffer and per texture / render target subresource (mip + layer).
+//
+// Every command buffer records with its own CmdResourceStates, so command buffers can be recorded in parallel.
+// The state a resource is in when a command buffer starts executing is not known while recording, so the first
+// use of each resource is kept aside. resolveResourceStates runs at submit time, in submission order: it records
+// the transitions from the state after all earlier submissions (ResourceStateTracker) to the state each first use
+// expects into a small fixup command buffer, and advances the tracker to the state the command buffer ends in.
+//
+// Transitions that change nothing are skipped: a resource already in a read only state containing all requested
+// read bits stays there. UAV to UAV still emits a barrier, it orders writes of consecutive dispatches.
+// Queue ownership transfers (mAcquire / mRelease) are not tracked, record those with cmdResourceBarrier.
+
+typedef enum TrackedResourceType
+{
+	TRACKED_RESOURCE_BUFFER = 0,
+	TRACKED_RESOURCE_TEXTURE,
+	TRACKED_RESOURCE_RENDER_TARGET,
+} TrackedResourceType;
+
+// Marks subresources a command buffer has not touched yet
+#define RESOURCE_STATE_UNTRACKED ((ResourceState)0xFFFFFFFF)
+
+typedef struct TrackedResource
+{
+	void*                        pResource;
+	TrackedResourceType          mType;
+	uint32_t                     mMipLevels;
+	/// mMipLevels * array size entries, subresource mip + layer * mMipLevels
+	eastl::vector<ResourceState> mStates;
+} TrackedResource;
+
+/// State of every registered resource after all command buffers resolved so far
+typedef struct ResourceStateTracker
+{
+	eastl::hash_map<void*, TrackedResource> mResources;
+} ResourceStateTracker;
+
+typedef struct CmdTrackedResource
+{
+	TrackedResource              mCurrent;
+	/// State expected by the first use of each subresource, RESOURCE_STATE_UNTRACKED if not used
+	eastl::vector<ResourceState> mFirstStates;
+} CmdTrackedResource;
+
+/// Per command buffer recording state, reset with beginCmdResourceStates for every recording
+typedef struct CmdResourceStates
+{
+	Cmd*                                       pCmd;
+	eastl::hash_map<void*, CmdTrackedResource> mResources;
+	eastl::vector<BufferBarrier>               mBufferBarriers;
+	eastl::vector<TextureBarrier>              mTextureBarriers;
+	eastl::vector<RenderTargetBarrier>         mRenderTargetBarriers;
+} CmdResourceStates;
+
+static inline bool isReadOnlyResourceState(ResourceState state)
+{
+	return !(state & (RESOURCE_STATE_RENDER_TARGET | RESOURCE_STATE_UNORDERED_ACCESS | RESOURCE_STATE_DEPTH_WRITE | RESOURCE_STATE_STREAM_OUT |
+					  RESOURCE_STATE_COPY_DEST));
+}
+
+// True if a resource in currentState has to be transitioned before it can be used as newState
+static inline bool isResourceTransitionNeeded(ResourceState currentState, ResourceState newState)
+{
+	if (RESOURCE_STATE_UNORDERED_ACCESS == currentState && RESOURCE_STATE_UNORDERED_ACCESS == newState)
+		return true;
+	if (currentState == newState)
+		return false;
+	return !(RESOURCE_STATE_UNDEFINED != newState && isReadOnlyResourceState(currentState) && (currentState & newState) == newState);
+}
+
+static inline void initTrackedResource(TrackedResource* pTracked, void* pResource, TrackedResourceType type, ResourceState state)
+{
+	uint32_t arraySize = 1;
+	pTracked->pResource = pResource;
+	pTracked->mType = type;
+	pTracked->mMipLevels = 1;
+	if (TRACKED_RESOURCE_TEXTURE == type)
+	{
+		pTracked->mMipLevels = ((Texture*)pResource)->mMipLevels;
+		arraySize = ((Texture*)pResource)->mArraySizeMinusOne + 1;
+	}
+	else if (TRACKED_RESOURCE_RENDER_TARGET == type)
+	{
+		pTracked->mMipLevels = ((RenderTarget*)pResource)->mMipLevels;
+		arraySize = ((RenderTarget*)pResource)->mArraySize;
+	}
+	pTracked->mMipLevels = max(1U, pTracked->mMipLevels);
+	pTracked->mStates.assign(pTracked->mMipLevels * max(1U, arraySize), state);
+}
+
+/************************************************************************/
+// Tracker
+/************************************************************************/
+static inline void addResourceStateTracker(ResourceStateTracker** ppTracker)
+{
+	*ppTracker = tf_new(ResourceStateTracker);
+}
+
+static inline void removeResourceStateTracker(ResourceStateTracker* pTracker)
+{
+	tf_delete(pTracker);
+}
+
+/// Registers a resource in the state it is in now, e.g. the mStartState of its desc. Unregistered resources are
+/// assumed to already be in the state of their first use
+static inline void trackResourceState(ResourceStateTracker* pTracker, Buffer* pBuffer, ResourceState state)
+{
+	initTrackedResource(&pTracker->mResources[pBuffer], pBuffer, TRACKED_RESOURCE_BUFFER, state);
+}
+
+static inline void trackResourceState(ResourceStateTracker* pTracker, Texture* pTexture, ResourceState state)
+{
+	initTrackedResource(&pTracker->mResources[pTexture], pTexture, TRACKED_RESOURCE_TEXTURE, state);
+}
+
+static inline void trackResourceState(ResourceStateTracker* pTracker, RenderTarget* pRenderTarget, ResourceState state)
+{
+	initTrackedResource(&pTracker->mResources[pRenderTarget], pRenderTarget, TRACKED_RESOURCE_RENDER_TARGET, state);
+}
+
+/// Call before removing the resource
+static inline void untrackResourceState(ResourceStateTracker* pTracker, void* pResource)
+{
+	pTracker->mResources.erase(pResource);
+}
+
+/************************************************************************/
+// Recording
+/************************************************************************/
+static inline void addCmdResourceStates(CmdResourceStates** ppStates)
+{
+	*ppStates = tf_new(CmdResourceStates);
+}
+
+static inline void removeCmdResourceStates(CmdResourceStates* pStates)
+{
+	tf_delete(pStates);
+}
+
+/// Call after beginCmd, forgets everything recorded for the previous use of pCmd
+static inline void beginCmdResourceStates(CmdResourceStates* pStates, Cmd* pCmd)
+{
+	pStates->pCmd = pCmd;
+	pStates->mResources.clear();
+	pStates->mBufferBarriers.clear();
+	pStates->mTextureBarriers.clear();
+	pStates->mRenderTargetBarriers.clear();
+}
+
+static inline void addTrackedBarrier(
+	CmdResourceStates* pStates, const TrackedResource* pTracked, uint32_t subresource, bool wholeResource, ResourceState currentState,
+	ResourceState newState)
+{
+	const uint32_t mipLevel = subresource % pTracked->mMipLevels;
+	const uint32_t arrayLayer = subresource / pTracked->mMipLevels;
+	switch (pTracked->mType)
+	{
+	case TRACKED_RESOURCE_BUFFER:
+	{
+		BufferBarrier barrier = { (Buffer*)pTracked->pResource, currentState, newState };
+		pStates->mBufferBarriers.push_back(barrier);
+		break;
+	}
+	case TRACKED_RESOURCE_TEXTURE:
+	{
+		TextureBarrier barrier = { (Texture*)pTracked->pResource, currentState, newState };
+		barrier.mSubresourceBarrier = !wholeResource;
+		barrier.mMipLevel = (uint8_t)mipLevel;
+		barrier.mArrayLayer = (uint16_t)arrayLayer;
+		pStates->mTextureBarriers.push_back(barrier);
+		break;
+	}
+	case TRACKED_RESOURCE_RENDER_TARGET:
+	{
+		RenderTargetBarrier barrier = { (RenderTarget*)pTracked->pResource, currentState, newState };
+		barrier.mSubresourceBarrier = !wholeResource;
+		barrier.mMipLevel = (uint8_t)mipLevel;
+		barrier.mArrayLayer = (uint16_t)arrayLayer;
+		pStates->mRenderTargetBarriers.push_back(barrier);
+		break;
+	}
+	}
+}
+
+// Moves the subresources [first, first + count) of pTracked to newState. Emits a single whole resource barrier when
+// every subresource is covered and transitions from the same state, per subresource barriers otherwise.
+// exactState also transitions read-only supersets of newState, for when later barriers were recorded with newState as before state
+static inline void transitionTrackedSubresources(
+	CmdResourceStates* pStates, TrackedResource* pTracked, uint32_t first, uint32_t count, ResourceState newState, bool exactState = false)
+{
+	const uint32_t subresourceCount = (uint32_t)pTracked->mStates.size();
+	bool uniform = first == 0 && count == subresourceCount;
+	for (uint32_t i = 1; uniform && i < count; ++i)
+		uniform = pTracked->mStates[i] == pTracked->mStates[0];
+
+	if (uniform)
+	{
+		if (isResourceTransitionNeeded(pTracked->mStates[0], newState) || (exactState && pTracked->mStates[0] != newState))
+		{
+			addTrackedBarrier(pStates, pTracked, 0, true, pTracked->mStates[0], newState);
+			pTracked->mStates.assign(subresourceCount, newState);
+		}
+		return;
+	}
+
+	for (uint32_t i = first; i < first + count; ++i)
+	{
+		if (isResourceTransitionNeeded(pTracked->mStates[i], newState) || (exactState && pTracked->mStates[i] != newState))
+		{
+			addTrackedBarrier(pStates, pTracked, i, false, pTracked->mStates[i], newState);
+			pTracked->mStates[i] = newState;
+		}
+	}
+}
+
+static inline void cmdTransitionTracked(
+	CmdResourceStates* pStates, void* pResource, TrackedResourceType type, uint32_t mipLevel, uint32_t arrayLayer, bool wholeResource,
+	ResourceState newState)
+{
+	CmdTrackedResource* pEntry = NULL;
+	eastl::hash_map<void*, CmdTrackedResource>::iterator it = pStates->mResources.find(pResource);
+	if (it == pStates->mResources.end())
+	{
+		pEntry = &pStates->mResources[pResource];
+		initTrackedResource(&pEntry->mCurrent, pResource, type, RESOURCE_STATE_UNTRACKED);
+		pEntry->mFirstStates.assign(pEntry->mCurrent.mStates.size(), RESOURCE_STATE_UNTRACKED);
+	}
+	else
+	{
+		pEntry = &it->second;
+	}
+
+	TrackedResource* pCurrent = &pEntry->mCurrent;
+	const uint32_t first = wholeResource ? 0 : mipLevel + arrayLayer * pCurrent->mMipLevels;
+	const uint32_t count = wholeResource ? (uint32_t)pCurrent->mStates.size() : 1;
+	ASSERT(first + count <= pCurrent->mStates.size());
+
+	// First use of a subresource in this command buffer, the transition into newState is recorded by resolveResourceStates
+	for (uint32_t i = first; i < first + count; ++i)
+	{
+		if (RESOURCE_STATE_UNTRACKED == pCurrent->mStates[i])
+		{
+			pEntry->mFirstStates[i] = newState;
+			pCurrent->mStates[i] = newState;
+		}
+	}
+
+	transitionTrackedSubresources(pStates, pCurrent, first, count, newState);
+}
+
+/// Requests pResource in newState for the following commands. Barriers are collected until cmdFlushResourceStates
+static inline void cmdTransitionResource(CmdResourceStates* pStates, Buffer* pBuffer, ResourceState newState)
+{
+	cmdTransitionTracked(pStates, pBuffer, TRACKED_RESOURCE_BUFFER, 0, 0, true, newState);
+}
+
+static inline void cmdTransitionResource(CmdResourceStates* pStates, Texture* pTexture, ResourceState newState)
+{
+	cmdTransitionTracked(pStates, pTexture, TRACKED_RESOURCE_TEXTURE, 0, 0, true, newState);
+}
+
+static inline void cmdTransitionResource(CmdResourceStates* pStates, RenderTarget* pRenderTarget, ResourceState newState)
+{
+	cmdTransitionTracked(pStates, pRenderTarget, TRACKED_RESOURCE_RENDER_TARGET, 0, 0, true, newState);
+}
+
+static inline void cmdTransitionSubresource(CmdResourceStates* pStates, Texture* pTexture, uint32_t mipLevel, uint32_t arrayLayer, ResourceState newState)
+{
+	cmdTransitionTracked(pStates, pTexture, TRACKED_RESOURCE_TEXTURE, mipLevel, arrayLayer, false, newState);
+}
+
+static inline void cmdTransitionSubresource(
+	CmdResourceStates* pStates, RenderTarget* pRenderTarget, uint32_t mipLevel, uint32_t arrayLayer, ResourceState newState)
+{
+	cmdTransitionTracked(pStates, pRenderTarget, TRACKED_RESOURCE_RENDER_TARGET, mipLevel, arrayLayer, false, newState);
+}
+
+/// Records the transitions requested since the last flush with one cmdResourceBarrier. Call before the draw, dispatch or copy using them
+static inline void cmdFlushResourceStates(CmdResourceStates* pStates)
+{
+	if (pStates->mBufferBarriers.empty() && pStates->mTextureBarriers.empty() && pStates->mRenderTargetBarriers.empty())
+		return;
+
+	cmdResourceBarrier(
+		pStates->pCmd, (uint32_t)pStates->mBufferBarriers.size(), pStates->mBufferBarriers.data(), (uint32_t)pStates->mTextureBarriers.size(),
+		pStates->mTextureBarriers.data(), (uint32_t)pStates->mRenderTargetBarriers.size(), pStates->mRenderTargetBarriers.data());
+	pStates->mBufferBarriers.clear();
+	pStates->mTextureBarriers.clear();
+	pStates->mRenderTargetBarriers.clear();
+}
+
+/************************************************************************/
+// Submission
+/************************************************************************/
+/// Call for every recorded command buffer in the order they are submitted, after endCmd.
+/// Records into pFixupCmd (between beginCmd / endCmd of the caller) the transitions from the tracked states to the
+/// states the first uses in pStates expect, and advances pTracker to the states pStates ends in.
+/// Returns the number of transitions recorded, if 0 pFixupCmd does not need to be submitted before the command buffer
+static inline uint32_t resolveResourceStates(ResourceStateTracker* pTracker, CmdResourceStates* pStates, Cmd* pFixupCmd)
+{
+	CmdResourceStates fixup;
+	fixup.pCmd = pFixupCmd;
+
+	for (eastl::hash_map<void*, CmdTrackedResource>::iterator it = pStates->mResources.begin(); it != pStates->mResources.end(); ++it)
+	{
+		CmdTrackedResource* pEntry = &it->second;
+		eastl::hash_map<void*, TrackedResource>::iterator known = pTracker->mResources.find(it->first);
+		if (known == pTracker->mResources.end())
+		{
+			known = pTracker->mResources.insert(it->first).first;
+			known->second = pEntry->mCurrent;
+			// Untouched subresources of an unregistered resource are assumed to be in the state of the first touched one
+			ResourceState fallback = RESOURCE_STATE_UNDEFINED;
+			for (uint32_t i = 0; i < (uint32_t)pEntry->mFirstStates.size() && RESOURCE_STATE_UNDEFINED == fallback; ++i)
+				fallback = RESOURCE_STATE_UNTRACKED != pEntry->mFirstStates[i] ? pEntry->mFirstStates[i] : fallback;
+			for (uint32_t i = 0; i < (uint32_t)known->second.mStates.size(); ++i)
+				if (RESOURCE_STATE_UNTRACKED == known->second.mStates[i])
+					known->second.mStates[i] = fallback;
+			continue;
+		}
+
+		TrackedResource* pKnown = &known->second;
+		ASSERT(pKnown->mStates.size() == pEntry->mFirstStates.size());
+
+		// Transition to exactly the first use states, the barriers recorded in pStates use them as before state.
+		// Whole resource when they agree
+		const uint32_t subresourceCount = (uint32_t)pEntry->mFirstStates.size();
+		bool uniform = true;
+		for (uint32_t i = 1; uniform && i < subresourceCount; ++i)
+			uniform = pEntry->mFirstStates[i] == pEntry->mFirstStates[0];
+
+		if (uniform && RESOURCE_STATE_UNTRACKED != pEntry->mFirstStates[0])
+		{
+			transitionTrackedSubresources(&fixup, pKnown, 0, subresourceCount, pEntry->mFirstStates[0], true);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < subresourceCount; ++i)
+			{
+				if (RESOURCE_STATE_UNTRACKED != pEntry->mFirstStates[i])
+					transitionTrackedSubresources(&fixup, pKnown, i, 1, pEntry->mFirstStates[i], true);
+			}
+		}
+
+		// Subresources the command buffer touched end in its last state, the others keep theirs
+		for (uint32_t i = 0; i < subresourceCount; ++i)
+		{
+			if (RESOURCE_STATE_UNTRACKED != pEntry->mCurrent.mStates[i])
+				pKnown->mStates[i] = pEntry->mCurrent.mStates[i];
+		}
+	}
+
+	const uint32_t barrierCount =
+		(uint32_t)(fixup.mBufferBarriers.size() + fixup.mTextureBarriers.size() + fixup.mRenderTargetBarriers.size());
+	cmdFlushResourceStates(&fixup);
+	return barrierCount;
+}
@@ -73,6 +73,7 @@ void mapRenderTarget(Renderer* pRenderer, Queue* pQueue, Cmd* pCmd, RenderTarget
 #if defined(VULKAN)
 	extern void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer);
 	extern void removeBuffer(Renderer* pRenderer, Buffer* pBuffer);
+	extern void util_flush_barriers(Cmd* pCmd);
 
 	// Add a staging buffer.
 	uint16_t formatByteWidth = TinyImageFormat_BitSizeOfBlock(pRenderTarget->mFormat) / 8;
@@ -112,6 +113,7 @@ void mapRenderTarget(Renderer* pRenderer, Queue* pQueue, Cmd* pCmd, RenderTarget
 	copy.imageExtent.width = width;
 	copy.imageExtent.height = height;
 	copy.imageExtent.depth = depth;
+	util_flush_barriers(pCmd);
 	vkCmdCopyImageToBuffer(pCmd->pVkCmdBuf, pRenderTarget->pTexture->pVkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer->pVkBuffer, 1, &copy);
 
 	srcBarrier = { pRenderTarget, RESOURCE_STATE_COPY_SOURCE, currentResourceState };
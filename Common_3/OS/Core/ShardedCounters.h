@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include "Atomics.h"
+#include "../Interfaces/IThread.h"
+
+// Always on statistics that are bumped from many threads (file reads, resource loader) keep
+// COUNTER_SHARD_COUNT copies of their counters. Writers pick a shard from their thread id and do a
+// relaxed atomic add, so threads rarely share a cache line. Readers sum all shards.
+#define COUNTER_SHARD_COUNT 16
+// Trailing padding of a shard struct so neighbouring shards never share a cache line
+#define COUNTER_SHARD_PADDING 64
+
+static inline uint32_t getCounterShard()
+{
+	uint64_t threadId = (uint64_t)(uintptr_t)Thread::GetCurrentThreadID();
+	return (uint32_t)((threadId * 0x9E3779B97F4A7C15ull) >> 32) % COUNTER_SHARD_COUNT;
+}
+
+// pCounter is the counter in the first shard, shardSize the size of the shard struct
+static inline uint64_t sumCounterShards(tfrg_atomic64_t* pCounter, size_t shardSize)
+{
+	uint64_t sum = 0;
+	for (uint32_t i = 0; i < COUNTER_SHARD_COUNT; ++i)
+	{
+		sum += tfrg_atomic64_load_relaxed((tfrg_atomic64_t*)((uint8_t*)pCounter + i * shardSize));
+	}
+	return sum;
+}
@@ -975,6 +975,9 @@ if (!(exp))                   \
 	textureDesc.mSampleCount = SAMPLE_COUNT_1;
 	textureDesc.mFormat = TinyImageFormat_R8G8B8A8_UNORM;
 
+	// Sparse page binding currently assumes 32 bit texels
+	RETURN_IF_FAILED(header.mComponentCount == 4);
+
 	return true;
 }
 #endif
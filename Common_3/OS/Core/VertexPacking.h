@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+/************************************************************************/
+// Vertex attribute packing used when loading geometry (see ResourceLoader.cpp)
+/************************************************************************/
+#define F16_EXPONENT_BITS 0x1F
+#define F16_EXPONENT_SHIFT 10
+#define F16_EXPONENT_BIAS 15
+#define F16_MANTISSA_BITS 0x3ff
+#define F16_MANTISSA_SHIFT (23 - F16_EXPONENT_SHIFT)
+#define F16_MAX_EXPONENT (F16_EXPONENT_BITS << F16_EXPONENT_SHIFT)
+
+static inline uint16_t util_float_to_half(float val)
+{
+	uint32_t           f32 = (*(uint32_t*)&val);
+	uint16_t           f16 = 0;
+	/* Decode IEEE 754 little-endian 32-bit floating-point value */
+	int sign = (f32 >> 16) & 0x8000;
+	/* Map exponent to the range [-127,128] */
+	int exponent = ((f32 >> 23) & 0xff) - 127;
+	int mantissa = f32 & 0x007fffff;
+	if (exponent == 128)
+	{ /* Infinity or NaN */
+		f16 = (uint16_t)(sign | F16_MAX_EXPONENT);
+		if (mantissa)
+			f16 |= (mantissa & F16_MANTISSA_BITS);
+	}
+	else if (exponent > 15)
+	{ /* Overflow - flush to Infinity */
+		f16 = (unsigned short)(sign | F16_MAX_EXPONENT);
+	}
+	else if (exponent > -15)
+	{ /* Representable value */
+		exponent += F16_EXPONENT_BIAS;
+		mantissa >>= F16_MANTISSA_SHIFT;
+		f16 = (unsigned short)(sign | exponent << F16_EXPONENT_SHIFT | mantissa);
+	}
+	else
+	{
+		f16 = (unsigned short)sign;
+	}
+	return f16;
+}
+
+static inline void util_pack_float2_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	struct f2 { float x; float y; };
+	f2* f = (f2*)src;
+	for (uint32_t e = 0; e < count; ++e)
+	{
+		*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = (
+			(util_float_to_half(f[e].x) & 0x0000FFFF) | ((util_float_to_half(f[e].y) << 16) & 0xFFFF0000));
+	}
+}
+
+static inline uint32_t util_float2_to_unorm2x16(const float* v)
+{
+	uint32_t x = (uint32_t)roundf((v[0] < 0.0f ? 0.0f : (v[0] > 1.0f ? 1.0f : v[0])) * 65535.0f);
+	uint32_t y = (uint32_t)roundf((v[1] < 0.0f ? 0.0f : (v[1] > 1.0f ? 1.0f : v[1])) * 65535.0f);
+	return ((uint32_t)0x0000FFFF & x) | ((y << 16) & (uint32_t)0xFFFF0000);
+}
+
+#define OCT_WRAP(v, w) ((1.0f - fabsf((w))) * ((v) >= 0.0f ? 1.0f : -1.0f))
+
+static inline void util_pack_float3_direction_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	struct f3 { float x; float y; float z; };
+	for (uint32_t e = 0; e < count; ++e)
+	{
+		f3 f = *(f3*)(src + e * stride);
+		float absLength = (fabsf(f.x) + fabsf(f.y) + fabsf(f.z));
+		f3 enc = {};
+		if (absLength)
+		{
+			enc.x = f.x / absLength;
+			enc.y = f.y / absLength;
+			enc.z = f.z / absLength;
+			if (enc.z < 0)
+			{
+				float oldX = enc.x;
+				enc.x = OCT_WRAP(enc.x, enc.y);
+				enc.y = OCT_WRAP(enc.y, oldX);
+			}
+			enc.x = enc.x * 0.5f + 0.5f;
+			enc.y = enc.y * 0.5f + 0.5f;
+			*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = util_float2_to_unorm2x16(&enc.x);
+		}
+		else
+		{
+			*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = 0;
+		}
+	}
+}
@@ -42,6 +42,8 @@ static char gApplicationPath[FS_MAX_PATH] = {};
 
 bool initFileSystem(FileSystemInitDesc* pDesc)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_FILESYSTEM);
+
 	if (gInitialized)
 	{
 		LOGF(LogLevel::eWARNING, "FileSystem already initialized.");
@@ -105,7 +105,12 @@ void ConditionVariable::Wait(const Mutex& mutex, uint32_t ms)
 		clock_get_time(cclock, &mts);
 		mach_port_deallocate(mach_task_self(), cclock);
 		time.tv_sec = mts.tv_sec + ms / 1000;
-		time.tv_nsec = mts.tv_nsec + (ms % 1000) * 1000;
+		time.tv_nsec = mts.tv_nsec + (ms % 1000) * 1000000;
+		if (time.tv_nsec >= 1000000000)
+		{
+			time.tv_sec += 1;
+			time.tv_nsec -= 1000000000;
+		}
 		
 		pthread_cond_timedwait(&pHandle, mutexHandle, &time);
 	}
@@ -25,6 +25,8 @@
 #include <errno.h>
 
 #include "../Interfaces/ILog.h"
+#include "../Interfaces/ITime.h"
+#include "../Core/ShardedCounters.h"
 #include "../Interfaces/IMemory.h"
 
 bool PlatformOpenFile(ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut);
@@ -38,6 +40,16 @@ typedef struct ResourceDirectoryInfo
 
 static ResourceDirectoryInfo gResourceDirectories[RD_COUNT] = {};
 
+typedef struct FileSystemStatsShard
+{
+	tfrg_atomic64_t mBytesRead[RD_COUNT];
+	tfrg_atomic64_t mReadTimeUs[RD_COUNT];
+	tfrg_atomic64_t mReadCount[RD_COUNT];
+	uint8_t         mPadding[COUNTER_SHARD_PADDING];
+} FileSystemStatsShard;
+
+static FileSystemStatsShard gFileSystemStats[COUNTER_SHARD_COUNT] = {};
+
 /************************************************************************/
 // Memory Stream Functions
 /************************************************************************/
@@ -287,6 +299,7 @@ bool fsOpenStreamFromMemory(const void* buffer, size_t bufferSize, FileMode mode
 	stream.mSize = bufferSize;
 	stream.mMode = mode;
 	stream.pIO = &gMemoryFileIO;
+	stream.mResourceDir = RD_NONE;
 	*pOut = stream;
 	return true;
 }
@@ -295,6 +308,8 @@ bool fsOpenStreamFromMemory(const void* buffer, size_t bufferSize, FileMode mode
 /// to read from or modify the file. May return NULL if the file could not be opened.
 bool fsOpenStreamFromPath(const ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_FILESYSTEM);
+
 	IFileSystem* io = gResourceDirectories[resourceDir].pIO;
 	if (!io)
 	{
@@ -302,7 +317,13 @@ bool fsOpenStreamFromPath(const ResourceDirectory resourceDir, const char* fileN
 		return false;
 	}
 
-	return io->Open(io, resourceDir, fileName, mode, pOut);
+	if (!io->Open(io, resourceDir, fileName, mode, pOut))
+	{
+		return false;
+	}
+
+	pOut->mResourceDir = resourceDir;
+	return true;
 }
 
 /// Closes and invalidates the file stream.
@@ -314,7 +335,21 @@ bool fsCloseStream(FileStream* pStream)
 /// Returns the number of bytes read.
 size_t fsReadFromStream(FileStream* pStream, void* pOutputBuffer, size_t bufferSizeInBytes)
 {
-	return pStream->pIO->Read(pStream, pOutputBuffer, bufferSizeInBytes);
+	// Streams without a resource directory are not attributed to any directory
+	const ResourceDirectory resourceDir = pStream->mResourceDir;
+	if (resourceDir == RD_NONE)
+	{
+		return pStream->pIO->Read(pStream, pOutputBuffer, bufferSizeInBytes);
+	}
+
+	const int64_t start = getUSec();
+	const size_t bytesRead = pStream->pIO->Read(pStream, pOutputBuffer, bufferSizeInBytes);
+
+	FileSystemStatsShard& shard = gFileSystemStats[getCounterShard()];
+	tfrg_atomic64_add_relaxed(&shard.mBytesRead[resourceDir], bytesRead);
+	tfrg_atomic64_add_relaxed(&shard.mReadTimeUs[resourceDir], getUSec() - start);
+	tfrg_atomic64_add_relaxed(&shard.mReadCount[resourceDir], 1);
+	return bytesRead;
 }
 
 /// Reads at most `bufferSizeInBytes` bytes from sourceBuffer and writes them into the file.
@@ -354,6 +389,32 @@ bool fsStreamAtEnd(const FileStream* pStream)
 	return pStream->pIO->IsAtEnd(pStream);
 }
 /************************************************************************/
+// Statistics
+/************************************************************************/
+void fsGetStats(FileSystemStats* pOutStats)
+{
+	ASSERT(pOutStats);
+	for (uint32_t i = 0; i < RD_COUNT; ++i)
+	{
+		pOutStats->mBytesRead[i] = sumCounterShards(&gFileSystemStats[0].mBytesRead[i], sizeof(FileSystemStatsShard));
+		pOutStats->mReadTimeUs[i] = sumCounterShards(&gFileSystemStats[0].mReadTimeUs[i], sizeof(FileSystemStatsShard));
+		pOutStats->mReadCount[i] = sumCounterShards(&gFileSystemStats[0].mReadCount[i], sizeof(FileSystemStatsShard));
+	}
+}
+
+void fsResetStats()
+{
+	for (uint32_t i = 0; i < COUNTER_SHARD_COUNT; ++i)
+	{
+		for (uint32_t j = 0; j < RD_COUNT; ++j)
+		{
+			tfrg_atomic64_store_relaxed(&gFileSystemStats[i].mBytesRead[j], 0);
+			tfrg_atomic64_store_relaxed(&gFileSystemStats[i].mReadTimeUs[j], 0);
+			tfrg_atomic64_store_relaxed(&gFileSystemStats[i].mReadCount[j], 0);
+		}
+	}
+}
+/************************************************************************/
 // Platform independent filename, extension functions
 /************************************************************************/
 static inline FORGE_CONSTEXPR const char fsGetDirectorySeparator()
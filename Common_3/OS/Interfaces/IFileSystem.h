@@ -87,7 +87,9 @@ typedef enum ResourceDirectory
 	RD_MIDDLEWARE_15,
 
 	____rd_lib_counter_end = ____rd_lib_counter_begin + 99 * 2,
-	RD_COUNT
+	RD_COUNT,
+	/// Streams that were not opened from a resource directory (memory streams, streams opened directly through an IFileSystem)
+	RD_NONE = RD_COUNT
 } ResourceDirectory;
 
 typedef enum SeekBaseOffset
@@ -146,6 +148,8 @@ typedef struct FileStream
 	};
 	ssize_t           mSize;
 	FileMode          mMode;
+	/// Directory the stream was opened from, RD_NONE if it was not opened through fsOpenStreamFromPath. Used for read statistics.
+	ResourceDirectory mResourceDir = RD_NONE;
 } FileStream;
 
 typedef struct FileSystemInitDesc
@@ -216,6 +220,22 @@ bool fsFlushStream(FileStream* stream);
 /// Returns whether the current seek position is at the end of the file stream.
 bool fsStreamAtEnd(const FileStream* stream);
 /************************************************************************/
+// MARK: - Statistics
+/************************************************************************/
+typedef struct FileSystemStats
+{
+	/// Bytes returned by fsReadFromStream, per directory the stream was opened from
+	uint64_t mBytesRead[RD_COUNT];
+	/// Microseconds spent inside fsReadFromStream
+	uint64_t mReadTimeUs[RD_COUNT];
+	uint64_t mReadCount[RD_COUNT];
+} FileSystemStats;
+
+/// Always on read statistics of streams opened with fsOpenStreamFromPath, summed over all threads
+/// since start or the last fsResetStats.
+void fsGetStats(FileSystemStats* pOutStats);
+void fsResetStats();
+/************************************************************************/
 // MARK: - Minor filename manipulation
 /************************************************************************/
 /// Appends `pathComponent` to `basePath`, where `basePath` is assumed to be a directory.
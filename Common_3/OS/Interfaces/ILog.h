@@ -79,6 +79,15 @@ void _PrintUnicode(const char* str, bool error = false);
 #define LOGF(log_level, ...) Log::Write((log_level), __FILE__, __LINE__, __VA_ARGS__)
 // Usage: LOGF_IF(LogLevel::eINFO | LogLevel::eDEBUG, boolean_value && integer_value == 5, "Whatever string %s, this is an int %d", "This is a string", 1)
 #define LOGF_IF(log_level, condition, ...) ((condition) ? Log::Write((log_level), __FILE__, __LINE__, __VA_ARGS__) : (void)0)
+// Usage: BLOGF(LogLevel::eINFO, "Streamed %u pages from %s", pageCount, fileName)
+// Same as LOGF unless Log::SetBinaryLogging is on, then only the call site id and the raw arguments are recorded and
+// formatting happens offline. format must be a string literal, arguments must be integers, floats, strings or pointers.
+#define BLOGF(log_level, format, ...)                                                                                 \
+	do                                                                                                                 \
+	{                                                                                                                  \
+		static LogFormatSite ANONIMOUS_VARIABLE_LOG(blogf_site_) = { (uint32_t)(log_level), __FILE__, __LINE__, format, 0 }; \
+		Log::WriteBinary(&ANONIMOUS_VARIABLE_LOG(blogf_site_), ##__VA_ARGS__);                                        \
+	} while (0)
 //
 #define LOGF_SCOPE(log_level, ...) Log::LogScope ANONIMOUS_VARIABLE_LOG(scope_log_){ (log_level), __FILE__, __LINE__, __VA_ARGS__ }
 
@@ -89,6 +89,180 @@ static void tf_delete_internal(T* ptr, const char *f, int l, const char *sf)
 #define tf_delete(ptr) tf_delete_internal(ptr,  __FILE__, __LINE__, __FUNCTION__)
 #endif
 
+//--------------------------------------------------------------------------------------------
+// Memory tracking
+// With USE_MEMORY_TRACKING every allocation is attributed to the tag that is active on the
+// allocating thread. Tags are set with MEMORY_TAG_SCOPE and default to MEMORY_TAG_UNTAGGED.
+// Without USE_MEMORY_TRACKING the scope macro compiles away and the stats stay zero.
+//--------------------------------------------------------------------------------------------
+typedef enum MemoryTag
+{
+	MEMORY_TAG_UNTAGGED = 0,
+	MEMORY_TAG_RENDERER,
+	MEMORY_TAG_RESOURCE_LOADER,
+	MEMORY_TAG_FILESYSTEM,
+	MEMORY_TAG_ANIMATION,
+	MEMORY_TAG_UI,
+	MEMORY_TAG_PROFILER,
+	MEMORY_TAG_SCRIPTING,
+	MEMORY_TAG_COUNT,
+} MemoryTag;
+
+typedef struct MemoryTagStats
+{
+	int64_t mLiveBytes;           // Bytes currently allocated
+	int64_t mLiveCount;           // Allocations currently alive
+	int64_t mTotalBytes;          // Bytes allocated since startup
+	int64_t mTotalCount;          // Allocations made since startup
+} MemoryTagStats;
+
+typedef struct MemoryStats
+{
+	MemoryTagStats mTags[MEMORY_TAG_COUNT];
+} MemoryStats;
+
+// Sets the tag of the calling thread and returns the previous one
+MemoryTag   memSetThreadTag(MemoryTag tag);
+MemoryTag   memGetThreadTag();
+const char* memGetTagName(MemoryTag tag);
+
+// Snapshot of the live and cumulative counters of every tag
+void memGetStats(MemoryStats* pOutStats);
+// pOutDiff = pAfter - pBefore, per tag and per counter
+void memDiffStats(const MemoryStats* pBefore, const MemoryStats* pAfter, MemoryStats* pOutDiff);
+
+struct MemoryTagScope
+{
+	MemoryTagScope(MemoryTag tag) : mPrevTag(memSetThreadTag(tag)) {}
+	~MemoryTagScope() { memSetThreadTag(mPrevTag); }
+
+	MemoryTag mPrevTag;
+};
+
+#define MEMORY_TAG_CONCAT0(a, b) a ## b
+#define MEMORY_TAG_CONCAT(a, b) MEMORY_TAG_CONCAT0(a, b)
+
+#if defined(USE_MEMORY_TRACKING)
+// Attributes every allocation made by this thread until the end of the enclosing block to tag
+#define MEMORY_TAG_SCOPE(tag) MemoryTagScope MEMORY_TAG_CONCAT(memoryTagScope, __LINE__)(tag)
+#else
+#define MEMORY_TAG_SCOPE(tag)
+#endif
+
+//--------------------------------------------------------------------------------------------
+// Linear allocator
+// Bump allocator over a chain of blocks. Allocations are never freed individually, everything
+// is released at once with resetLinearAllocator (e.g. once per frame or per loop iteration) or
+// back to a marker with rewindLinearAllocator. Blocks are kept across resets so a warmed up
+// allocator does not touch the heap. Not thread safe, use one allocator per thread.
+//--------------------------------------------------------------------------------------------
+typedef struct LinearAllocatorBlock LinearAllocatorBlock;
+
+typedef struct LinearAllocator
+{
+	LinearAllocatorBlock* pFirst;
+	LinearAllocatorBlock* pCurrent;
+	size_t                mBlockSize;
+	size_t                mOffset;        // Offset of the next allocation in pCurrent
+	size_t                mHighWaterMark; // Largest amount of memory used between two resets
+	size_t                mUsed;
+} LinearAllocator;
+
+typedef struct LinearAllocatorMarker
+{
+	LinearAllocatorBlock* pBlock;
+	size_t                mOffset;
+	size_t                mUsed;
+} LinearAllocatorMarker;
+
+// pInitialBuffer (optional) is used as the first block, e.g. stack memory for function local arenas
+void  initLinearAllocator(LinearAllocator* pAllocator, size_t blockSize, void* pInitialBuffer = NULL, size_t initialBufferSize = 0);
+void  exitLinearAllocator(LinearAllocator* pAllocator);
+void* linearAlloc(LinearAllocator* pAllocator, size_t size, size_t align = EA_PLATFORM_MIN_MALLOC_ALIGNMENT);
+void  resetLinearAllocator(LinearAllocator* pAllocator);
+LinearAllocatorMarker getLinearAllocatorMarker(const LinearAllocator* pAllocator);
+void  rewindLinearAllocator(LinearAllocator* pAllocator, LinearAllocatorMarker marker);
+
+//--------------------------------------------------------------------------------------------
+// Pool allocator
+// Fixed size objects handed out from a free list threaded through blocks of elementsPerBlock
+// objects. Blocks are only returned to the system by exitPoolAllocator. Not thread safe.
+//--------------------------------------------------------------------------------------------
+typedef struct PoolAllocatorBlock PoolAllocatorBlock;
+
+typedef struct PoolAllocator
+{
+	PoolAllocatorBlock* pBlocks;
+	void*               pFreeList;
+	size_t              mElementSize;
+	size_t              mElementAlign;
+	uint32_t            mElementsPerBlock;
+	uint32_t            mLiveCount;
+} PoolAllocator;
+
+void  initPoolAllocator(PoolAllocator* pAllocator, size_t elementSize, size_t elementAlign, uint32_t elementsPerBlock);
+void  exitPoolAllocator(PoolAllocator* pAllocator);
+void* poolAlloc(PoolAllocator* pAllocator);
+void  poolFree(PoolAllocator* pAllocator, void* ptr);
+
+template <typename T, typename... Args>
+static T* poolNew(PoolAllocator* pAllocator, Args&&... args)
+{
+	return tf_placement_new<T>(poolAlloc(pAllocator), eastl::forward<Args>(args)...);
+}
+
+template <typename T>
+static void poolDelete(PoolAllocator* pAllocator, T* ptr)
+{
+	if (ptr)
+	{
+		ptr->~T();
+		poolFree(pAllocator, ptr);
+	}
+}
+
+//--------------------------------------------------------------------------------------------
+// EASTL adapter so containers can allocate from a LinearAllocator:
+//   LinearAllocator arena; ...
+//   eastl::vector<Foo, LinearEASTLAllocator> foos(LinearEASTLAllocator(&arena));
+// deallocate is a no-op, memory comes back with the next reset of the arena.
+// A default constructed adapter has no arena and forwards to tf_malloc/tf_free.
+//--------------------------------------------------------------------------------------------
+class LinearEASTLAllocator
+{
+public:
+	LinearEASTLAllocator(const char* pName = "LinearEASTLAllocator") : pAllocator(NULL) { (void)pName; }
+	explicit LinearEASTLAllocator(LinearAllocator* pLinearAllocator) : pAllocator(pLinearAllocator) {}
+	LinearEASTLAllocator(const LinearEASTLAllocator& x) : pAllocator(x.pAllocator) {}
+	LinearEASTLAllocator(const LinearEASTLAllocator& x, const char* pName) : pAllocator(x.pAllocator) { (void)pName; }
+
+	LinearEASTLAllocator& operator=(const LinearEASTLAllocator& x) { pAllocator = x.pAllocator; return *this; }
+
+	void* allocate(size_t n, int flags = 0)
+	{
+		return pAllocator ? linearAlloc(pAllocator, n) : tf_malloc_internal(n, __FILE__, __LINE__, __FUNCTION__);
+	}
+
+	void* allocate(size_t n, size_t alignment, size_t offset, int flags = 0)
+	{
+		return pAllocator ? linearAlloc(pAllocator, n, alignment) : tf_memalign_internal(alignment, n, __FILE__, __LINE__, __FUNCTION__);
+	}
+
+	void deallocate(void* p, size_t n)
+	{
+		if (!pAllocator)
+			tf_free_internal(p, __FILE__, __LINE__, __FUNCTION__);
+	}
+
+	const char* get_name() const { return "LinearEASTLAllocator"; }
+	void        set_name(const char* pName) { (void)pName; }
+
+	LinearAllocator* pAllocator;
+};
+
+inline bool operator==(const LinearEASTLAllocator& a, const LinearEASTLAllocator& b) { return a.pAllocator == b.pAllocator; }
+inline bool operator!=(const LinearEASTLAllocator& a, const LinearEASTLAllocator& b) { return a.pAllocator != b.pAllocator; }
+
 #endif 
 
 #ifndef IMEMORY_FROM_HEADER
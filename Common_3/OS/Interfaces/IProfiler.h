@@ -68,9 +68,16 @@ void setAggregateFrames(uint32_t nFrames);
 // Dump profile data to "profile-(date).html" of recorded frames, until a maximum amount of frames
 void dumpProfileData(Renderer* pRenderer, const char* appName = "" , uint32_t nMaxFrames = 64);
 
-// Dump benchmark data to "benchmark-(data).txt" of recorded frames
+// Dump benchmark data to "benchmark-(date).json": frame time percentiles, stats of every cpu/gpu timer, counters and memory.
+// Two reports can be diffed with Common_3/Tools/BenchmarkCompare to flag regressions.
 void dumpBenchmarkData(Renderer* pRenderer, IApp::Settings* pSettings, const char* appName = "");
 
+// Stream every recorded frame (cpu and gpu timelines) to "profile-(date).json" in Chrome trace format until stopProfileCapture.
+// Frames are buffered in at most nMaxBufferedBytes and written from a background thread, frames that don't fit are dropped.
+bool startProfileCapture(const char* appName = "", uint32_t nMaxBufferedBytes = 16 * 1024 * 1024);
+void stopProfileCapture();
+bool isProfileCaptureRunning();
+
 
 //------ Profiler UI Widget --------//
 
@@ -156,8 +163,15 @@ float getCpuProfileTime(const char* pGroup, const char* pName, ThreadID* pThread
 float getCpuProfileAvgTime(const char* pGroup, const char* pName, ThreadID* pThreadID = NULL);
 float getCpuProfileMinTime(const char* pGroup, const char* pName, ThreadID* pThreadID = NULL);
 float getCpuProfileMaxTime(const char* pGroup, const char* pName, ThreadID* pThreadID = NULL);
+// Percentile in [0, 100] over every frame the timer ran in since start or the last resetProfileHistograms
+float getCpuProfilePercentileTime(const char* pGroup, const char* pName, float fPercentile, ThreadID* pThreadID = NULL);
+// Number of frames where the timer took longer than twice its median
+uint32_t getCpuProfileSpikeCount(const char* pGroup, const char* pName, ThreadID* pThreadID = NULL);
 
 float getCpuFrameTime();
 float getCpuAvgFrameTime();
 float getCpuMinFrameTime();
-float getCpuMaxFrameTime();
\ No newline at end of file
+float getCpuMaxFrameTime();
+float getCpuPercentileFrameTime(float fPercentile);
+uint32_t getCpuFrameSpikeCount();
+void resetProfileHistograms();
\ No newline at end of file
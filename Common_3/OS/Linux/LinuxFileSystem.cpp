@@ -32,6 +32,8 @@
 #include <fcntl.h>           //for open and O_* enums
 #include <dirent.h>
 
+#include "../Interfaces/IMemory.h"
+
 static bool gInitialized = false;
 static const char* gResourceMounts[RM_COUNT];
 const char* getResourceMount(ResourceMount mount) {
@@ -43,6 +45,8 @@ static const char* gHomedir;
 
 bool initFileSystem(FileSystemInitDesc* pDesc)
 {	
+	MEMORY_TAG_SCOPE(MEMORY_TAG_FILESYSTEM);
+
 	if (gInitialized)
 	{
 		LOGF(LogLevel::eWARNING, "FileSystem already initialized.");
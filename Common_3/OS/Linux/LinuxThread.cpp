@@ -94,9 +94,16 @@ void ConditionVariable::Wait(const Mutex& mutex, uint32_t ms)
 	}
 	else
 	{
+		// pthread_cond_timedwait takes an absolute CLOCK_REALTIME deadline
 		timespec ts;
-		ts.tv_sec = ms / 1000;
-		ts.tv_nsec = (ms % 1000) * 1000;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += ms / 1000;
+		ts.tv_nsec += (ms % 1000) * 1000000;
+		if (ts.tv_nsec >= 1000000000)
+		{
+			ts.tv_sec += 1;
+			ts.tv_nsec -= 1000000000;
+		}
 		pthread_cond_timedwait(&pHandle, mutexHandle, &ts);
 	}
 }
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+// On-disk layout of binary logs written by BLOGF (see ILog.h). Shared between the runtime
+// (Log.cpp) and the offline decoder (Common_3/Tools/BinaryLogDecoder), so it only depends on stdint.
+//
+// File:    BinaryLogFileHeader followed by a stream of records, all little endian and unaligned.
+// Record:  uint8_t type, then
+//          BINARY_LOG_RECORD_FORMAT   uint32 formatId, uint32 level, uint32 line, uint16 fileLength, uint16 formatLength, file, format
+//          BINARY_LOG_RECORD_THREAD   uint32 threadIndex, uint8 nameLength, name
+//          BINARY_LOG_RECORD_MESSAGE  uint32 formatId, uint32 threadIndex, uint64 timestampUs, uint16 payloadSize, payload
+// Payload: per argument uint8 BinaryLogArgType followed by its value, strings are uint16 length + bytes (no terminator)
+
+#include <stdint.h>
+
+#define BINARY_LOG_MAGIC 0x4C424654u // 'TFBL'
+#define BINARY_LOG_VERSION 1u
+
+// Size limit of the argument payload of one message, longer strings get truncated
+#define BINARY_LOG_MAX_PAYLOAD 512
+// Type byte + formatId + threadIndex + timestamp + payloadSize
+#define BINARY_LOG_MESSAGE_HEADER_SIZE (1 + 4 + 4 + 8 + 2)
+
+typedef enum BinaryLogRecordType
+{
+	BINARY_LOG_RECORD_FORMAT = 1,
+	BINARY_LOG_RECORD_THREAD = 2,
+	BINARY_LOG_RECORD_MESSAGE = 3,
+} BinaryLogRecordType;
+
+typedef enum BinaryLogArgType
+{
+	BINARY_LOG_ARG_I32 = 1,
+	BINARY_LOG_ARG_U32 = 2,
+	BINARY_LOG_ARG_I64 = 3,
+	BINARY_LOG_ARG_U64 = 4,
+	BINARY_LOG_ARG_F64 = 5,
+	BINARY_LOG_ARG_STRING = 6,
+	BINARY_LOG_ARG_POINTER = 7,
+} BinaryLogArgType;
+
+#pragma pack(push, 1)
+typedef struct BinaryLogFileHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	// getUSec() and wall clock (seconds since epoch) when the file was opened, lets the decoder print absolute times
+	uint64_t mStartTimestampUs;
+	uint64_t mStartTime;
+} BinaryLogFileHeader;
+#pragma pack(pop)
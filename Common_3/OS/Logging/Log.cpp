@@ -27,6 +27,13 @@
 #include "../Interfaces/IFileSystem.h"
 #include "../Interfaces/IOperatingSystem.h"
 #include "../../ThirdParty/OpenSource/EASTL/unordered_map.h"
+#include "../Core/Atomics.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <signal.h>
+#include <unistd.h>
+#define LOG_FLUSH_ON_FATAL_SIGNAL
+#endif
 
 #include "../Interfaces/IMemory.h"
 
@@ -34,10 +41,191 @@
 #define LOG_LEVEL_SIZE 6
 #define LOG_MESSAGE_OFFSET (LOG_PREAMBLE_SIZE + LOG_LEVEL_SIZE)
 
+// Same size as Log::Buffer, so a formatted message always fits in a record
+#define ASYNC_LOG_MESSAGE_SIZE (1024 + 2)
+// Upper bound of records written between two callback flushes
+#define ASYNC_LOG_MAX_BATCH 256
+#define ASYNC_LOG_WRITER_TIMEOUT_MS 100
+// Log files the fatal signal handler can write to
+#define ASYNC_LOG_MAX_SIGNAL_FDS 8
+
 static Log* pLogger = NULL;
 
 thread_local char Log::Buffer[MAX_BUFFER + 2];
 bool Log::sConsoleLogging = true;
+volatile bool Log::sBinaryLogging = false;
+
+// Set while the calling thread is running log callbacks, so a LOGF/ASSERT from inside a callback does not flush recursively
+static thread_local bool tInsideLogDispatch = false;
+// File callbacks flush once per batch in async mode instead of once per message
+static volatile bool gDeferLogFileFlush = false;
+// Set on the async writer thread. Its own messages bypass the queue, with eLOG_OVERFLOW_BLOCK it would wait on itself.
+static thread_local bool tIsAsyncLogWriter = false;
+// Index of the calling thread in binary logs and the binary log file it last announced its name to
+static thread_local uint32_t tBinaryLogThreadIndex = 0;
+static thread_local uint32_t tBinaryLogFileGeneration = 0;
+
+/************************************************************************/
+// Async log queue
+// Bounded MPSC ring of fixed size records. Producers claim a slot with a CAS on mEnqueuePos and publish it by
+// writing the slot sequence, the writer thread (or Log::Flush) consumes in order. See Vyukov's bounded MPMC queue.
+/************************************************************************/
+struct AsyncLogRecord
+{
+	tfrg_atomic64_t mSequence;
+	uint32_t        mLevel;
+	uint16_t        mError;
+	uint16_t        mBinary;
+	uint32_t        mLength;
+	char            mMessage[ASYNC_LOG_MESSAGE_SIZE];
+};
+
+struct AsyncLogQueue
+{
+	AsyncLogRecord*   pRecords;
+	uint64_t          mMask;
+	LogOverflowPolicy mPolicy;
+	char              mPad0[64];
+	tfrg_atomic64_t   mEnqueuePos;
+	char              mPad1[64];
+	tfrg_atomic64_t   mDequeuePos;
+	tfrg_atomic64_t   mDroppedCount;
+	uint64_t          mReportedDroppedCount;
+	tfrg_atomic32_t   mConsumerLock;
+	tfrg_atomic32_t   mWriterSleeping;
+	volatile int      mRun;
+	Mutex             mWakeMutex;
+	ConditionVariable mWakeCond;
+	ThreadDesc        mThreadDesc;
+	ThreadHandle      mThread;
+};
+
+static bool tryAcquireLogConsumer(AsyncLogQueue* pQueue, uint32_t maxWaitMs)
+{
+	for (uint32_t i = 0;; ++i)
+	{
+		if (tfrg_atomic32_cas_relaxed(&pQueue->mConsumerLock, 0, 1) == 0)
+			return true;
+		if (i >= maxWaitMs)
+			return false;
+		Thread::Sleep(1);
+	}
+}
+
+static void releaseLogConsumer(AsyncLogQueue* pQueue) { tfrg_atomic32_store_release(&pQueue->mConsumerLock, 0); }
+
+static bool isAsyncLogQueueEmpty(AsyncLogQueue* pQueue)
+{
+	const uint64_t pos = tfrg_atomic64_load_acquire(&pQueue->mDequeuePos);
+	const AsyncLogRecord* pRecord = &pQueue->pRecords[pos & pQueue->mMask];
+	return tfrg_atomic64_load_acquire((tfrg_atomic64_t*)&pRecord->mSequence) != pos + 1;
+}
+
+static void wakeAsyncLogWriter(AsyncLogQueue* pQueue)
+{
+	// The writer holds mWakeMutex from raising the flag until it is inside Wait, so taking the mutex here cannot lose the wakeup.
+	// Only the producer that clears the flag signals, the others stay off the mutex.
+	if (tfrg_atomic32_load_relaxed(&pQueue->mWriterSleeping) && tfrg_atomic32_cas_relaxed(&pQueue->mWriterSleeping, 1, 0) == 1)
+	{
+		pQueue->mWakeMutex.Acquire();
+		pQueue->mWakeCond.WakeOne();
+		pQueue->mWakeMutex.Release();
+	}
+}
+
+#if defined(LOG_FLUSH_ON_FATAL_SIGNAL)
+static const int gFatalSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+static struct sigaction gPrevFatalSignalActions[sizeof(gFatalSignals) / sizeof(gFatalSignals[0])];
+
+// Snapshot of the log outputs as raw file descriptors, taken under mLogMutex whenever they change. The signal handler
+// can't take locks or go through FILE*, so it only uses this table and write(2).
+struct LogSignalFd
+{
+	int      mFd;
+	uint32_t mLevel;
+};
+
+static LogSignalFd          gLogSignalFds[ASYNC_LOG_MAX_SIGNAL_FDS];
+static volatile uint32_t    gLogSignalFdCount = 0;
+static volatile int         gLogSignalBinaryFd = -1;
+// 0: no console output, 1: everything, 2: errors only (quiet mode)
+static volatile uint32_t    gLogSignalConsole = 0;
+static AsyncLogQueue* volatile gLogSignalQueue = NULL;
+
+static void writeLogSignalFd(int fd, const char* pData, uint32_t size)
+{
+	while (size)
+	{
+		const ssize_t written = write(fd, pData, size);
+		if (written <= 0)
+			return;
+		pData += written;
+		size -= (uint32_t)written;
+	}
+}
+
+// Async-signal-safe drain of the queue. Records are not handed back to producers, the process is about to die.
+static void drainAsyncLogQueueFromSignal(AsyncLogQueue* pQueue)
+{
+	// The crashing thread may be the writer itself, so don't wait for the consumer lock, just try to keep others out
+	for (uint32_t i = 0; i < 1024 && tfrg_atomic32_cas_relaxed(&pQueue->mConsumerLock, 0, 1) != 0; ++i)
+		;
+
+	const uint32_t fdCount = gLogSignalFdCount;
+	uint64_t       pos = tfrg_atomic64_load_acquire(&pQueue->mDequeuePos);
+	for (uint64_t i = 0; i <= pQueue->mMask; ++i, ++pos)
+	{
+		const AsyncLogRecord* pRecord = &pQueue->pRecords[pos & pQueue->mMask];
+		if (tfrg_atomic64_load_acquire((tfrg_atomic64_t*)&pRecord->mSequence) != pos + 1)
+			break;
+
+		if (pRecord->mBinary)
+		{
+			if (gLogSignalBinaryFd >= 0)
+				writeLogSignalFd(gLogSignalBinaryFd, pRecord->mMessage, pRecord->mLength);
+			continue;
+		}
+
+		if (gLogSignalConsole == 1 || (gLogSignalConsole == 2 && pRecord->mError))
+			writeLogSignalFd(pRecord->mError ? STDERR_FILENO : STDOUT_FILENO, pRecord->mMessage, pRecord->mLength);
+		for (uint32_t f = 0; f < fdCount; ++f)
+		{
+			if (gLogSignalFds[f].mLevel & pRecord->mLevel)
+				writeLogSignalFd(gLogSignalFds[f].mFd, pRecord->mMessage, pRecord->mLength);
+		}
+	}
+}
+
+static void logFatalSignalHandler(int sig)
+{
+	AsyncLogQueue* pQueue = gLogSignalQueue;
+	if (pQueue)
+		drainAsyncLogQueueFromSignal(pQueue);
+
+	// Put back whatever was installed before and re-raise so the usual crash handling still happens
+	for (uint32_t i = 0; i < sizeof(gFatalSignals) / sizeof(gFatalSignals[0]); ++i)
+	{
+		if (gFatalSignals[i] == sig)
+			sigaction(sig, &gPrevFatalSignalActions[i], NULL);
+	}
+	raise(sig);
+}
+
+static void installFatalSignalHandlers()
+{
+	struct sigaction action = {};
+	action.sa_handler = logFatalSignalHandler;
+	sigemptyset(&action.sa_mask);
+	for (uint32_t i = 0; i < sizeof(gFatalSignals) / sizeof(gFatalSignals[0]); ++i)
+		sigaction(gFatalSignals[i], &action, &gPrevFatalSignalActions[i]);
+}
+
+static void removeFatalSignalHandlers()
+{
+	for (uint32_t i = 0; i < sizeof(gFatalSignals) / sizeof(gFatalSignals[0]); ++i)
+		sigaction(gFatalSignals[i], &gPrevFatalSignalActions[i], NULL);
+}
+#endif
 
 eastl::string GetTimeStamp()
 {
@@ -66,7 +254,8 @@ void log_write(void * user_data, const char* message)
     ASSERT(fh);
     
     fsWriteToStream(fh, message, strlen(message));
-    fsFlushStream(fh);
+	if (!gDeferLogFileFlush)
+		fsFlushStream(fh);
 }
 
 // Close callback
@@ -99,6 +288,8 @@ void Log::Init(const char* appName, LogLevel level /* = LogLevel::eALL */)
 
 void Log::Exit()
 {
+	SetBinaryLogging(false);
+	SetAsync(false);
 	pLogger->mLogMutex.Destroy();
 	tf_delete(pLogger);
 	pLogger = NULL;
@@ -136,11 +327,124 @@ Log::LogScope::~LogScope()
 }
 
 void Log::SetLevel(LogLevel level)             { pLogger->mLogLevel = level; }
-void Log::SetQuiet(bool bQuiet)                { pLogger->mQuietMode = bQuiet; }
+void Log::SetQuiet(bool bQuiet)                { pLogger->mQuietMode = bQuiet; UpdateSignalFds(); }
 void Log::SetTimeStamp(bool bEnable)           { pLogger->mRecordTimestamp = bEnable; }
 void Log::SetRecordingFile(bool bEnable)       { pLogger->mRecordFile = bEnable; }
 void Log::SetRecordingThreadName(bool bEnable) { pLogger->mRecordThreadName = bEnable; }
-void Log::SetConsoleLogging(bool bEnable)      { pLogger->sConsoleLogging = bEnable; } // @CONFFX: Change by Koste: Controllable console logging
+void Log::SetConsoleLogging(bool bEnable)      { pLogger->sConsoleLogging = bEnable; UpdateSignalFds(); } // @CONFFX: Change by Koste: Controllable console logging
+
+void Log::UpdateSignalFds()
+{
+#if defined(LOG_FLUSH_ON_FATAL_SIGNAL)
+	MutexLock lock{ pLogger->mLogMutex };
+	uint32_t  fdCount = 0;
+	for (LogCallback& callback : pLogger->mCallbacks)
+	{
+		FileStream* pStream = (FileStream*)callback.mUserData;
+		if (callback.mCallback != log_write || pStream->pIO != pSystemFileIO || !pStream->pFile)
+			continue;
+		if (fdCount == ASYNC_LOG_MAX_SIGNAL_FDS)
+			break;
+		gLogSignalFds[fdCount].mFd = fileno(pStream->pFile);
+		gLogSignalFds[fdCount].mLevel = callback.mLevel;
+		++fdCount;
+	}
+	gLogSignalFdCount = fdCount;
+	gLogSignalBinaryFd = pLogger->mBinaryFileOpen && pLogger->mBinaryFile.pIO == pSystemFileIO && pLogger->mBinaryFile.pFile
+		? fileno(pLogger->mBinaryFile.pFile) : -1;
+	gLogSignalConsole = !sConsoleLogging ? 0 : (pLogger->mQuietMode ? 2 : 1);
+#endif
+}
+
+void Log::SetAsync(bool bEnable, uint32_t queueSize, LogOverflowPolicy policy)
+{
+	if (bEnable == (pLogger->pAsyncQueue != NULL))
+		return;
+
+	if (bEnable)
+	{
+		uint64_t recordCount = 16;
+		while (recordCount < queueSize)
+			recordCount <<= 1;
+
+		AsyncLogQueue* pQueue = tf_new(AsyncLogQueue);
+		memset((void*)pQueue, 0, sizeof(*pQueue));
+		pQueue->pRecords = (AsyncLogRecord*)tf_memalign(64, recordCount * sizeof(AsyncLogRecord));
+		pQueue->mMask = recordCount - 1;
+		pQueue->mPolicy = policy;
+		for (uint64_t i = 0; i < recordCount; ++i)
+			pQueue->pRecords[i].mSequence = i;
+		pQueue->mRun = 1;
+		pQueue->mWakeMutex.Init();
+		pQueue->mWakeCond.Init();
+		pQueue->mThreadDesc.pFunc = AsyncWriterFunc;
+		pQueue->mThreadDesc.pData = pQueue;
+#if defined(NX64)
+		pQueue->mThreadDesc.pThreadName = "AsyncLog";
+#endif
+		pQueue->mThread = create_thread(&pQueue->mThreadDesc);
+
+		gDeferLogFileFlush = true;
+		tfrg_atomicptr_store_release((tfrg_atomicptr_t*)&pLogger->pAsyncQueue, (uintptr_t)pQueue);
+#if defined(LOG_FLUSH_ON_FATAL_SIGNAL)
+		UpdateSignalFds();
+		gLogSignalQueue = pQueue;
+		installFatalSignalHandlers();
+#endif
+	}
+	else
+	{
+		AsyncLogQueue* pQueue = pLogger->pAsyncQueue;
+#if defined(LOG_FLUSH_ON_FATAL_SIGNAL)
+		removeFatalSignalHandlers();
+		gLogSignalQueue = NULL;
+#endif
+		// New messages go straight to the callbacks, wait for producers that already grabbed the queue.
+		// Pairs with the fence in Submit: either the producer sees the cleared pointer or we see its increment.
+		tfrg_atomicptr_store_relaxed((tfrg_atomicptr_t*)&pLogger->pAsyncQueue, 0);
+		tfrg_memorybarrier_full();
+		while (tfrg_atomic32_load_acquire(&pLogger->mAsyncProducers))
+			Thread::Sleep(0);
+
+		pQueue->mRun = 0;
+		pQueue->mWakeMutex.Acquire();
+		pQueue->mWakeCond.WakeOne();
+		pQueue->mWakeMutex.Release();
+		destroy_thread(pQueue->mThread);
+
+		// The writer is gone, drain what it did not get to
+		tInsideLogDispatch = true;
+		while (DrainAsyncQueue(pQueue))
+			;
+		tInsideLogDispatch = false;
+		gDeferLogFileFlush = false;
+		FlushCallbacks();
+
+		pQueue->mWakeCond.Destroy();
+		pQueue->mWakeMutex.Destroy();
+		tf_free(pQueue->pRecords);
+		tf_delete(pQueue);
+	}
+}
+
+void Log::Flush()
+{
+	if (!pLogger || tInsideLogDispatch)
+		return;
+
+	AsyncLogQueue* pQueue = pLogger->pAsyncQueue;
+	// Bounded wait: when called from a crash handler the writer thread might be the one that died holding the queue
+	if (pQueue && tryAcquireLogConsumer(pQueue, 1000))
+	{
+		tInsideLogDispatch = true;
+		while (DrainAsyncQueue(pQueue))
+			;
+		tInsideLogDispatch = false;
+		releaseLogConsumer(pQueue);
+	}
+
+	FlushCallbacks();
+}
 
 // Gettors
 uint32_t Log::GetLevel()            { return pLogger->mLogLevel; }
@@ -148,6 +452,8 @@ bool Log::IsQuiet()                 { return pLogger->mQuietMode; }
 bool Log::IsRecordingTimeStamp()    { return pLogger->mRecordTimestamp; }
 bool Log::IsRecordingFile()         { return pLogger->mRecordFile; }
 bool Log::IsRecordingThreadName()   { return pLogger->mRecordThreadName; }
+bool Log::IsAsync()                 { return pLogger->pAsyncQueue != NULL; }
+uint64_t Log::GetDroppedMessageCount() { return pLogger->pAsyncQueue ? tfrg_atomic64_load_relaxed(&pLogger->pAsyncQueue->mDroppedCount) : 0; }
 
 void Log::AddFile(const char * filename, FileMode file_mode, LogLevel log_level)
 {
@@ -196,6 +502,7 @@ void Log::AddCallback(const char * id, uint32_t log_level, void * user_data, log
 	if (!CallbackExists(id))
 	{
 		pLogger->mCallbacks.emplace_back(LogCallback{ id, user_data, callback, close, flush, log_level });
+		UpdateSignalFds();
 	}
 	else
 		close(user_data);
@@ -248,26 +555,7 @@ void Log::Write(uint32_t level, const char * filename, int line_number, const ch
 	for (uint32_t i = 0; i < log_level_count; ++i)
 	{
 		strncpy(Buffer + preable_end, logLevelPrefixes[log_levels[i]].second, LOG_LEVEL_SIZE);
-
-		if (sConsoleLogging)
-		{
-			if (pLogger->mQuietMode)
-			{
-				if (level & LogLevel::eERROR)
-					_PrintUnicode(Buffer, true);
-			}
-			else
-			{
-				_PrintUnicode(Buffer, level & LogLevel::eERROR);
-			}
-		}
-
-		MutexLock lock{ pLogger->mLogMutex };
-		for (LogCallback & callback : pLogger->mCallbacks)
-		{
-			if (callback.mLevel & log_levels[i])
-				callback.mCallback(callback.mUserData, Buffer);
-		}
+		Submit(logLevelPrefixes[log_levels[i]].first, (level & LogLevel::eERROR) != 0, Buffer, offset + 1);
 	}
 }
 
@@ -275,26 +563,338 @@ void Log::WriteRaw(uint32_t level, bool error, const char* message, ...)
 {
 	va_list args;
 	va_start(args, message);
-	vsnprintf(Buffer, MAX_BUFFER, message, args);
+	int length = vsnprintf(Buffer, MAX_BUFFER, message, args);
 	va_end(args);
 
+	length = length < 0 ? 0 : (length >= MAX_BUFFER ? MAX_BUFFER - 1 : length);
+	Submit(level, error, Buffer, (uint32_t)length);
+}
+
+void Log::Dispatch(uint32_t level, bool error, const char* message)
+{
 	if (sConsoleLogging)
 	{
 		if (pLogger->mQuietMode)
 		{
 			if (error)
-				_PrintUnicode(Buffer, true);
+				_PrintUnicode(message, true);
 		}
 		else
-			_PrintUnicode(Buffer, error);
+			_PrintUnicode(message, error);
 	}
 
 	MutexLock lock{ pLogger->mLogMutex };
 	for (LogCallback & callback : pLogger->mCallbacks)
 	{
 		if (callback.mLevel & level)
-			callback.mCallback(callback.mUserData, Buffer);
+			callback.mCallback(callback.mUserData, message);
+	}
+}
+
+void Log::Submit(uint32_t level, bool error, const char* message, uint32_t length, bool binary)
+{
+	AsyncLogQueue* pQueue = pLogger->pAsyncQueue;
+	if (pQueue && (tIsAsyncLogWriter || tInsideLogDispatch))
+	{
+		// The consumer can't wait for itself to make room, write directly
+		if (binary)
+			WriteBinaryRecord(message, length);
+		else
+			Dispatch(level, error, message);
+		return;
+	}
+
+	if (pQueue)
+	{
+		tfrg_atomic32_add_relaxed(&pLogger->mAsyncProducers, 1);
+		// Re-check, SetAsync(false) clears the pointer before waiting for active producers
+		tfrg_memorybarrier_full();
+		pQueue = pLogger->pAsyncQueue;
+		if (!pQueue)
+			tfrg_atomic32_add_relaxed(&pLogger->mAsyncProducers, -1);
+	}
+
+	if (!pQueue)
+	{
+		// Without the writer thread binary records are appended on the calling thread
+		if (binary)
+			WriteBinaryRecord(message, length);
+		else
+			Dispatch(level, error, message);
+		return;
+	}
+
+	const bool mustDeliver = error || pQueue->mPolicy == eLOG_OVERFLOW_BLOCK;
+	AsyncLogRecord* pRecord = NULL;
+	uint64_t pos = tfrg_atomic64_load_relaxed(&pQueue->mEnqueuePos);
+	for (;;)
+	{
+		pRecord = &pQueue->pRecords[pos & pQueue->mMask];
+		const int64_t diff = (int64_t)(tfrg_atomic64_load_acquire(&pRecord->mSequence) - pos);
+		if (diff == 0)
+		{
+			if ((uint64_t)tfrg_atomic64_cas_relaxed(&pQueue->mEnqueuePos, pos, pos + 1) == pos)
+				break;
+		}
+		else if (diff < 0)
+		{
+			// Queue is full
+			if (!mustDeliver)
+			{
+				tfrg_atomic64_add_relaxed(&pQueue->mDroppedCount, 1);
+				tfrg_atomic32_add_relaxed(&pLogger->mAsyncProducers, -1);
+				return;
+			}
+			wakeAsyncLogWriter(pQueue);
+			Thread::Sleep(0);
+		}
+		pos = tfrg_atomic64_load_relaxed(&pQueue->mEnqueuePos);
+	}
+
+	length = length < ASYNC_LOG_MESSAGE_SIZE - 1 ? length : ASYNC_LOG_MESSAGE_SIZE - 1;
+	memcpy(pRecord->mMessage, message, length);
+	pRecord->mMessage[length] = 0;
+	pRecord->mLevel = level;
+	pRecord->mError = error;
+	pRecord->mBinary = binary;
+	pRecord->mLength = length;
+	tfrg_atomic64_store_release(&pRecord->mSequence, pos + 1);
+
+	wakeAsyncLogWriter(pQueue);
+	tfrg_atomic32_add_relaxed(&pLogger->mAsyncProducers, -1);
+}
+
+uint32_t Log::DrainAsyncQueue(AsyncLogQueue* pQueue)
+{
+	uint32_t count = 0;
+	uint64_t pos = tfrg_atomic64_load_relaxed(&pQueue->mDequeuePos);
+	for (; count < ASYNC_LOG_MAX_BATCH; ++count, ++pos)
+	{
+		AsyncLogRecord* pRecord = &pQueue->pRecords[pos & pQueue->mMask];
+		if (tfrg_atomic64_load_acquire(&pRecord->mSequence) != pos + 1)
+			break;
+
+		if (pRecord->mBinary)
+			WriteBinaryRecord(pRecord->mMessage, pRecord->mLength);
+		else
+			Dispatch(pRecord->mLevel, pRecord->mError != 0, pRecord->mMessage);
+		// Hand the slot back to producers for the next lap around the ring
+		tfrg_atomic64_store_release(&pRecord->mSequence, pos + pQueue->mMask + 1);
+	}
+	tfrg_atomic64_store_release(&pQueue->mDequeuePos, pos);
+
+	const uint64_t dropped = tfrg_atomic64_load_relaxed(&pQueue->mDroppedCount);
+	if (dropped != pQueue->mReportedDroppedCount)
+	{
+		char message[128];
+		snprintf(message, sizeof(message), "WARN| Async log queue full, %llu messages dropped\n",
+			(unsigned long long)(dropped - pQueue->mReportedDroppedCount));
+		pQueue->mReportedDroppedCount = dropped;
+		Dispatch(LogLevel::eWARNING, false, message);
+	}
+
+	return count;
+}
+
+void Log::AsyncWriterFunc(void* pData)
+{
+	AsyncLogQueue* pQueue = (AsyncLogQueue*)pData;
+	Thread::SetCurrentThreadName("AsyncLog");
+	tIsAsyncLogWriter = true;
+
+	while (pQueue->mRun)
+	{
+		uint32_t written = 0;
+		if (tryAcquireLogConsumer(pQueue, 0))
+		{
+			tInsideLogDispatch = true;
+			written = DrainAsyncQueue(pQueue);
+			// One flush per batch instead of one per message
+			if (written)
+				FlushCallbacks();
+			tInsideLogDispatch = false;
+			releaseLogConsumer(pQueue);
+		}
+
+		if (!written)
+		{
+			pQueue->mWakeMutex.Acquire();
+			tfrg_atomic32_store_release(&pQueue->mWriterSleeping, 1);
+			if (pQueue->mRun && isAsyncLogQueueEmpty(pQueue))
+				pQueue->mWakeCond.Wait(pQueue->mWakeMutex, ASYNC_LOG_WRITER_TIMEOUT_MS);
+			tfrg_atomic32_store_release(&pQueue->mWriterSleeping, 0);
+			pQueue->mWakeMutex.Release();
+		}
+	}
+}
+
+void Log::FlushCallbacks()
+{
+	MutexLock lock{ pLogger->mLogMutex };
+	for (LogCallback & callback : pLogger->mCallbacks)
+	{
+		if (callback.mFlush)
+			callback.mFlush(callback.mUserData);
+	}
+
+	if (pLogger->mBinaryFileOpen)
+		fsFlushStream(&pLogger->mBinaryFile);
+}
+
+/************************************************************************/
+// Binary logging
+/************************************************************************/
+static void writeBinaryFormatRecord(FileStream* pFile, const LogFormatSite* pSite, uint32_t id)
+{
+	const size_t fileLength = strlen(pSite->pFile);
+	const size_t formatLength = strlen(pSite->pFormat);
+	const uint8_t  type = BINARY_LOG_RECORD_FORMAT;
+	const uint32_t level = pSite->mLevel;
+	const uint32_t line = (uint32_t)pSite->mLine;
+	const uint16_t fileSize = (uint16_t)(fileLength < UINT16_MAX ? fileLength : UINT16_MAX);
+	const uint16_t formatSize = (uint16_t)(formatLength < UINT16_MAX ? formatLength : UINT16_MAX);
+
+	fsWriteToStream(pFile, &type, sizeof(type));
+	fsWriteToStream(pFile, &id, sizeof(id));
+	fsWriteToStream(pFile, &level, sizeof(level));
+	fsWriteToStream(pFile, &line, sizeof(line));
+	fsWriteToStream(pFile, &fileSize, sizeof(fileSize));
+	fsWriteToStream(pFile, &formatSize, sizeof(formatSize));
+	fsWriteToStream(pFile, pSite->pFile, fileSize);
+	fsWriteToStream(pFile, pSite->pFormat, formatSize);
+}
+
+void Log::SetBinaryLogging(bool bEnable, const char* fileName)
+{
+	if (bEnable == sBinaryLogging)
+		return;
+
+	if (bEnable)
+	{
+		if (!pLogger->pAsyncQueue)
+			SetAsync(true);
+
+		char defaultFileName[FS_MAX_PATH] = { 0 };
+		if (!fileName)
+		{
+			snprintf(defaultFileName, sizeof(defaultFileName), "%s.blog", pLogger->mAppName.empty() ? "Log" : pLogger->mAppName.c_str());
+			fileName = defaultFileName;
+		}
+
+		bool opened = false;
+		{
+			MutexLock lock{ pLogger->mLogMutex };
+			opened = fsOpenStreamFromPath(RD_LOG, fileName, FM_WRITE_BINARY, &pLogger->mBinaryFile);
+		}
+		if (!opened)
+		{
+			Write(LogLevel::eERROR, __FILE__, __LINE__, "Failed to create binary log file %s", fileName);
+			return;
+		}
+
+		{
+			MutexLock lock{ pLogger->mLogMutex };
+			BinaryLogFileHeader header = {};
+			header.mMagic = BINARY_LOG_MAGIC;
+			header.mVersion = BINARY_LOG_VERSION;
+			header.mStartTimestampUs = (uint64_t)getUSec();
+			header.mStartTime = (uint64_t)time(NULL);
+			fsWriteToStream(&pLogger->mBinaryFile, &header, sizeof(header));
+
+			// Sites registered during a previous binary session keep their ids
+			for (uint32_t i = 0; i < (uint32_t)pLogger->mBinaryFormats.size(); ++i)
+				writeBinaryFormatRecord(&pLogger->mBinaryFile, pLogger->mBinaryFormats[i], i + 1);
+
+			pLogger->mBinaryFileOpen = true;
+			++pLogger->mBinaryFileGeneration;
+			UpdateSignalFds();
+		}
+
+		sBinaryLogging = true;
+		Write(LogLevel::eINFO, __FILE__, __LINE__, "Opened binary log file %s", fileName);
+	}
+	else
+	{
+		sBinaryLogging = false;
+		// Write out records still in the queue before closing the file
+		Flush();
+
+		MutexLock lock{ pLogger->mLogMutex };
+		pLogger->mBinaryFileOpen = false;
+		UpdateSignalFds();
+		fsCloseStream(&pLogger->mBinaryFile);
+	}
+}
+
+void Log::RegisterBinaryFormat(LogFormatSite* pSite)
+{
+	MutexLock lock{ pLogger->mLogMutex };
+	if (tfrg_atomic32_load_acquire(&pSite->mId))
+		return;
+
+	pLogger->mBinaryFormats.push_back(pSite);
+	const uint32_t id = (uint32_t)pLogger->mBinaryFormats.size();
+	// Written straight to the file so the definition always precedes the first message using it
+	if (pLogger->mBinaryFileOpen)
+		writeBinaryFormatRecord(&pLogger->mBinaryFile, pSite, id);
+	tfrg_atomic32_store_release(&pSite->mId, id);
+}
+
+void Log::RegisterBinaryThread()
+{
+	MutexLock lock{ pLogger->mLogMutex };
+	if (!tBinaryLogThreadIndex)
+		tBinaryLogThreadIndex = ++pLogger->mBinaryThreadCount;
+	tBinaryLogFileGeneration = pLogger->mBinaryFileGeneration;
+
+	if (!pLogger->mBinaryFileOpen)
+		return;
+
+	char name[MAX_THREAD_NAME_LENGTH + 1] = { 0 };
+	Thread::GetCurrentThreadName(name, MAX_THREAD_NAME_LENGTH + 1);
+	if (!name[0])
+		snprintf(name, sizeof(name), "NoName");
+
+	const uint8_t type = BINARY_LOG_RECORD_THREAD;
+	const uint8_t nameLength = (uint8_t)strlen(name);
+	fsWriteToStream(&pLogger->mBinaryFile, &type, sizeof(type));
+	fsWriteToStream(&pLogger->mBinaryFile, &tBinaryLogThreadIndex, sizeof(tBinaryLogThreadIndex));
+	fsWriteToStream(&pLogger->mBinaryFile, &nameLength, sizeof(nameLength));
+	fsWriteToStream(&pLogger->mBinaryFile, name, nameLength);
+}
+
+void Log::SubmitBinary(LogFormatSite* pSite, const BinaryLogPayload* pPayload)
+{
+	uint32_t id = tfrg_atomic32_load_acquire(&pSite->mId);
+	if (!id)
+	{
+		RegisterBinaryFormat(pSite);
+		id = tfrg_atomic32_load_acquire(&pSite->mId);
 	}
+	if (tBinaryLogFileGeneration != pLogger->mBinaryFileGeneration)
+		RegisterBinaryThread();
+
+	// Serialize the complete record here, the writer thread only appends it to the file
+	char record[BINARY_LOG_MESSAGE_HEADER_SIZE + BINARY_LOG_MAX_PAYLOAD];
+	const uint8_t  type = BINARY_LOG_RECORD_MESSAGE;
+	const uint64_t timestamp = (uint64_t)getUSec();
+	const uint16_t payloadSize = (uint16_t)pPayload->mSize;
+	char* pDst = record;
+	memcpy(pDst, &type, sizeof(type)); pDst += sizeof(type);
+	memcpy(pDst, &id, sizeof(id)); pDst += sizeof(id);
+	memcpy(pDst, &tBinaryLogThreadIndex, sizeof(tBinaryLogThreadIndex)); pDst += sizeof(tBinaryLogThreadIndex);
+	memcpy(pDst, &timestamp, sizeof(timestamp)); pDst += sizeof(timestamp);
+	memcpy(pDst, &payloadSize, sizeof(payloadSize)); pDst += sizeof(payloadSize);
+	memcpy(pDst, pPayload->mData, payloadSize); pDst += payloadSize;
+
+	Submit(pSite->mLevel, (pSite->mLevel & LogLevel::eERROR) != 0, record, (uint32_t)(pDst - record), true);
+}
+
+void Log::WriteBinaryRecord(const void* pData, uint32_t size)
+{
+	MutexLock lock{ pLogger->mLogMutex };
+	if (pLogger->mBinaryFileOpen)
+		fsWriteToStream(&pLogger->mBinaryFile, pData, size);
 }
 
 void Log::AddInitialLogFile(const char* appName)
@@ -376,6 +976,13 @@ Log::Log(const char* appName, LogLevel level)
 	, mRecordTimestamp(true)
 	, mRecordFile(true)
 	, mRecordThreadName(true)
+	, pAsyncQueue(NULL)
+	, mAsyncProducers(0)
+	, mAppName(appName ? appName : "")
+	, mBinaryFile()
+	, mBinaryFileOpen(false)
+	, mBinaryThreadCount(0)
+	, mBinaryFileGeneration(0)
 {
 	Thread::SetMainThread();
 	Thread::SetCurrentThreadName("MainThread");
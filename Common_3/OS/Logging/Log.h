@@ -27,6 +27,8 @@
 #include "../../ThirdParty/OpenSource/EASTL/vector.h"
 #include "../../ThirdParty/OpenSource/EASTL/string.h"
 
+#include "../../OS/Core/Atomics.h"
+#include "BinaryLogFormat.h"
 #include "../../OS/Interfaces/IThread.h"
 #include "../../OS/Interfaces/IFileSystem.h"
 
@@ -62,6 +64,81 @@ enum LogLevel
 };
 
 
+// What a producer does when the async log queue is full. Errors always wait for space.
+enum LogOverflowPolicy
+{
+	eLOG_OVERFLOW_DROP = 0,
+	eLOG_OVERFLOW_BLOCK = 1,
+};
+
+struct AsyncLogQueue;
+
+// Static per call site data of BLOGF. mId is assigned the first time the site logs in binary mode.
+struct LogFormatSite
+{
+	uint32_t        mLevel;
+	const char*     pFile;
+	int             mLine;
+	const char*     pFormat;
+	tfrg_atomic32_t mId;
+};
+
+// Raw arguments of one BLOGF call, see BinaryLogFormat.h for the encoding
+struct BinaryLogPayload
+{
+	uint32_t mSize;
+	uint8_t  mData[BINARY_LOG_MAX_PAYLOAD];
+};
+
+static inline void encodeBinaryLogValue(BinaryLogPayload* pPayload, BinaryLogArgType type, const void* pValue, uint32_t size)
+{
+	if (pPayload->mSize + 1 + size > BINARY_LOG_MAX_PAYLOAD)
+	{
+		// Out of space, the decoder prints the remaining arguments as missing
+		pPayload->mSize = BINARY_LOG_MAX_PAYLOAD;
+		return;
+	}
+	pPayload->mData[pPayload->mSize] = (uint8_t)type;
+	memcpy(pPayload->mData + pPayload->mSize + 1, pValue, size);
+	pPayload->mSize += 1 + size;
+}
+
+static inline void encodeBinaryLogString(BinaryLogPayload* pPayload, const char* str)
+{
+	if (!str)
+		str = "(null)";
+	if (pPayload->mSize + 3 > BINARY_LOG_MAX_PAYLOAD)
+	{
+		pPayload->mSize = BINARY_LOG_MAX_PAYLOAD;
+		return;
+	}
+	const uint32_t available = BINARY_LOG_MAX_PAYLOAD - pPayload->mSize - 3;
+	const size_t   length = strlen(str);
+	const uint16_t size = (uint16_t)(length < available ? length : available);
+	pPayload->mData[pPayload->mSize] = (uint8_t)BINARY_LOG_ARG_STRING;
+	memcpy(pPayload->mData + pPayload->mSize + 1, &size, sizeof(size));
+	memcpy(pPayload->mData + pPayload->mSize + 3, str, size);
+	pPayload->mSize += 3 + size;
+}
+
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, bool v)               { int32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_I32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, char v)               { int32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_I32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, signed char v)        { int32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_I32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, unsigned char v)      { uint32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_U32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, short v)              { int32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_I32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, unsigned short v)     { uint32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_U32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, int v)                { int32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_I32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, unsigned int v)       { uint32_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_U32, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, long v)               { int64_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_I64, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, unsigned long v)      { uint64_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_U64, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, long long v)          { int64_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_I64, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, unsigned long long v) { uint64_t x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_U64, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, float v)              { double x = v; encodeBinaryLogValue(p, BINARY_LOG_ARG_F64, &x, sizeof(x)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, double v)             { encodeBinaryLogValue(p, BINARY_LOG_ARG_F64, &v, sizeof(v)); }
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, const char* v)        { encodeBinaryLogString(p, v); }
+template <typename T>
+static inline void encodeBinaryLogArg(BinaryLogPayload* p, const T* v)           { uint64_t x = (uint64_t)(uintptr_t)v; encodeBinaryLogValue(p, BINARY_LOG_ARG_POINTER, &x, sizeof(x)); }
+
 typedef void(*log_callback_t)(void * user_data, const char* message);
 typedef void(*log_close_t)(void * user_data);
 typedef void(*log_flush_t)(void * user_data);
@@ -93,6 +170,12 @@ public:
 	static void SetRecordingFile(bool bEnable);
 	static void SetRecordingThreadName(bool bEnable);
 	static void SetConsoleLogging(bool bEnable);
+	/// In async mode Write only formats the message and pushes it into a bounded queue. A background
+	/// thread prints it and runs the callbacks. queueSize is rounded up to a power of two.
+	static void SetAsync(bool bEnable, uint32_t queueSize = 1024, LogOverflowPolicy policy = eLOG_OVERFLOW_DROP);
+	/// Writes out every queued message on the calling thread and flushes all callbacks.
+	/// Called on exit and on failed asserts / crashes so the tail of the log is not lost.
+	static void Flush();
 
 	static uint32_t        GetLevel();
 	static eastl::string   GetLastMessage();
@@ -100,6 +183,8 @@ public:
 	static bool            IsRecordingTimeStamp();
 	static bool            IsRecordingFile();
 	static bool            IsRecordingThreadName();
+	static bool            IsAsync();
+	static uint64_t        GetDroppedMessageCount();
 
 	static void AddFile(const char * filename, FileMode file_mode, LogLevel log_level);
 	static void AddCallback(const char * id, uint32_t log_level, void * user_data, log_callback_t callback, log_close_t close = nullptr, log_flush_t flush = nullptr);
@@ -107,10 +192,42 @@ public:
 	static void Write(uint32_t level, const char * filename, int line_number, const char* message, ...);
 	static void WriteRaw(uint32_t level, bool error, const char* message, ...);
 
+	/// Binary logging (BLOGF) records the call site id and the raw arguments into the async queue, the writer
+	/// thread appends them to fileName (default <appName>.blog) in RD_LOG. Decode with Tools/BinaryLogDecoder.
+	/// Turns on async mode if needed. After SetAsync(false) records are appended on the calling thread.
+	static void SetBinaryLogging(bool bEnable, const char* fileName = NULL);
+	static bool IsBinaryLogging() { return sBinaryLogging; }
+
+	template <typename... Args>
+	static void WriteBinary(LogFormatSite* pSite, const Args&... args)
+	{
+		if (!sBinaryLogging)
+		{
+			Write(pSite->mLevel, pSite->pFile, pSite->mLine, pSite->pFormat, args...);
+			return;
+		}
+
+		BinaryLogPayload payload;
+		payload.mSize = 0;
+		int expand[] = { 0, (encodeBinaryLogArg(&payload, args), 0)... };
+		(void)expand;
+		SubmitBinary(pSite, &payload);
+	}
+
 private:
 	static void AddInitialLogFile(const char* appName);
 	static uint32_t WritePreamble(char * buffer, uint32_t buffer_size, const char * file, int line);
 	static bool CallbackExists(const char * id);
+	static void Dispatch(uint32_t level, bool error, const char* message);
+	static void Submit(uint32_t level, bool error, const char* message, uint32_t length, bool binary = false);
+	static void SubmitBinary(LogFormatSite* pSite, const BinaryLogPayload* pPayload);
+	static void RegisterBinaryFormat(LogFormatSite* pSite);
+	static void RegisterBinaryThread();
+	static void WriteBinaryRecord(const void* pData, uint32_t size);
+	static void AsyncWriterFunc(void* pData);
+	static uint32_t DrainAsyncQueue(AsyncLogQueue* pQueue);
+	static void FlushCallbacks();
+	static void UpdateSignalFds();
 
 	// Singleton
 	Log(const Log &) = delete;
@@ -146,11 +263,23 @@ private:
 	bool            mRecordTimestamp;
 	bool            mRecordFile;
 	bool            mRecordThreadName;
+	AsyncLogQueue* volatile pAsyncQueue;
+	/// Writers currently pushing into pAsyncQueue, lets SetAsync(false) know when the queue can be freed
+	tfrg_atomic32_t mAsyncProducers;
+
+	eastl::string                mAppName;
+	eastl::vector<LogFormatSite*> mBinaryFormats;
+	FileStream                   mBinaryFile;
+	bool                         mBinaryFileOpen;
+	uint32_t                     mBinaryThreadCount;
+	/// Bumped every time a binary log file is opened so threads re-emit their name record
+	uint32_t                     mBinaryFileGeneration;
 
 	enum{MAX_BUFFER=1024};
 
 	static thread_local char Buffer[MAX_BUFFER+2];
 	static bool sConsoleLogging;
+	static volatile bool sBinaryLogging;
 };
 
 eastl::string ToString(const char* formatString, ...);
@@ -27,11 +27,28 @@
 #endif
 
 #include "../../ThirdParty/OpenSource/EASTL/EABase/eabase.h"
+#include "../Core/Compiler.h"
 
 #include <stdlib.h>
 #include <memory.h>
-
-#define ALIGN_TO(size, alignment) (size + alignment - 1) & ~(alignment - 1)
+#include <string.h>
+
+#include "../Core/Atomics.h"
+#include "../Interfaces/ILog.h"
+
+// Only the memory tracking declarations are needed, this file implements the allocation functions themselves
+#define IMEMORY_FROM_HEADER
+#include "../Interfaces/IMemory.h"
+#undef tf_malloc
+#undef tf_memalign
+#undef tf_calloc
+#undef tf_calloc_memalign
+#undef tf_realloc
+#undef tf_free
+#undef tf_new
+#undef tf_delete
+
+#define ALIGN_TO(size, alignment) (((size) + (alignment)-1) & ~((alignment)-1))
 #define MIN_ALLOC_ALIGNMENT EA_PLATFORM_MIN_MALLOC_ALIGNMENT
 
 #if USE_MTUNER
@@ -46,53 +63,318 @@
 #define MTUNER_FREE(_handle, _ptr)
 #endif
 
+static const char* gMemoryTagNames[MEMORY_TAG_COUNT] =
+{
+	"Untagged",
+	"Renderer",
+	"ResourceLoader",
+	"FileSystem",
+	"Animation",
+	"UI",
+	"Profiler",
+	"Scripting",
+};
+
+const char* memGetTagName(MemoryTag tag)
+{
+	return tag < MEMORY_TAG_COUNT ? gMemoryTagNames[tag] : "Invalid";
+}
+
+void memDiffStats(const MemoryStats* pBefore, const MemoryStats* pAfter, MemoryStats* pOutDiff)
+{
+	for (uint32_t i = 0; i < MEMORY_TAG_COUNT; ++i)
+	{
+		pOutDiff->mTags[i].mLiveBytes = pAfter->mTags[i].mLiveBytes - pBefore->mTags[i].mLiveBytes;
+		pOutDiff->mTags[i].mLiveCount = pAfter->mTags[i].mLiveCount - pBefore->mTags[i].mLiveCount;
+		pOutDiff->mTags[i].mTotalBytes = pAfter->mTags[i].mTotalBytes - pBefore->mTags[i].mTotalBytes;
+		pOutDiff->mTags[i].mTotalCount = pAfter->mTags[i].mTotalCount - pBefore->mTags[i].mTotalCount;
+	}
+}
+
 #if defined(USE_MEMORY_TRACKING)
 
-#define _CRT_SECURE_NO_WARNINGS 1
+// Bookkeeping is split into shards so threads only contend when they free memory allocated by another thread.
+// Every thread is assigned a shard on its first allocation and keeps it for its lifetime.
+#define MEMORY_TRACKING_SHARD_COUNT 32
+#define MEMORY_TRACKING_MAX_REPORTED_LEAKS 256
+#define MEMORY_TRACKING_MAGIC 0x7F0E3A11u
 
-// Just include the cpp here so we don't have to add it to the all projects
-#include "../../ThirdParty/OpenSource/FluidStudios/MemoryManager/mmgr.cpp"
+// Stored right in front of every tracked allocation so frees never need a lookup
+struct AllocationHeader
+{
+	AllocationHeader* pPrev;
+	AllocationHeader* pNext;
+	const char*       pFile;
+	const char*       pFunc;
+	size_t            mSize;
+	uint32_t          mLine;
+	uint32_t          mOffset;    // Distance from the start of the system allocation to the user pointer
+	uint32_t          mAlign;
+	uint16_t          mTag;
+	uint16_t          mShard;
+	uint32_t          mMagic;
+};
+
+struct MemoryShard
+{
+	DEFINE_ALIGNED(tfrg_atomic32_t mLock, 64);
+	AllocationHeader* pHead;
+	MemoryTagStats    mStats[MEMORY_TAG_COUNT];
+};
+
+static MemoryShard                gShards[MEMORY_TRACKING_SHARD_COUNT];
+static tfrg_atomic32_t            gNextShard = 0;
+static thread_local uint32_t      gThreadShard = UINT32_MAX;
+static thread_local MemoryTag     gThreadTag = MEMORY_TAG_UNTAGGED;
+static char                       gAppName[64] = {};
+
+static inline void lockShard(MemoryShard* pShard)
+{
+	while (tfrg_atomic32_cas_relaxed(&pShard->mLock, 0, 1) != 0)
+	{
+		// Wait for the lock to look free before retrying so waiters do not keep stealing the cache line
+		while (tfrg_atomic32_load_relaxed(&pShard->mLock) != 0)
+			tfrg_cpu_pause();
+	}
+	tfrg_memorybarrier_acquire();
+}
 
-void* tf_malloc_internal(size_t size, const char *f, int l, const char *sf)
+static inline void unlockShard(MemoryShard* pShard)
 {
-	return tf_memalign_internal(MIN_ALLOC_ALIGNMENT, size, f, l, sf);
+	tfrg_atomic32_store_release(&pShard->mLock, 0);
 }
 
-void* tf_calloc_internal(size_t count, size_t size, const char *f, int l, const char *sf) 
+static inline uint32_t getThreadShard()
 {
-	return tf_calloc_memalign_internal(count, MIN_ALLOC_ALIGNMENT, size, f, l, sf);
+	if (gThreadShard == UINT32_MAX)
+		gThreadShard = tfrg_atomic32_add_relaxed(&gNextShard, 1) % MEMORY_TRACKING_SHARD_COUNT;
+	return gThreadShard;
 }
 
-void* tf_memalign_internal(size_t align, size_t size, const char *f, int l, const char *sf)
+static inline AllocationHeader* getHeader(void* ptr)
 {
-	void* pMemAlign = mmgrAllocator(f, l, sf, m_alloc_malloc, align, size);
+	AllocationHeader* pHeader = (AllocationHeader*)ptr - 1;
+	ASSERT(pHeader->mMagic == MEMORY_TRACKING_MAGIC && "Pointer was not allocated by the memory tracker or is corrupted");
+	return pHeader;
+}
+
+static void* trackedAlloc(size_t align, size_t size, bool zero, const char* f, int l, const char* sf)
+{
+	align = align > MIN_ALLOC_ALIGNMENT ? align : MIN_ALLOC_ALIGNMENT;
+	const size_t offset = ALIGN_TO(sizeof(AllocationHeader), align);
+	const size_t actualSize = offset + size;
+
+#ifdef _MSC_VER
+	unsigned char* pActual = (unsigned char*)_aligned_malloc(actualSize, align);
+#else
+	unsigned char* pActual = NULL;
+	if (posix_memalign((void**)&pActual, align, actualSize))
+		pActual = NULL;
+#endif
+
+	if (!pActual)
+		return NULL;
+
+	if (zero)
+		memset(pActual + offset, 0, size);
+
+	const uint32_t shardIndex = getThreadShard();
+	const MemoryTag tag = gThreadTag;
+
+	AllocationHeader* pHeader = (AllocationHeader*)(pActual + offset) - 1;
+	pHeader->pPrev = NULL;
+	pHeader->pFile = f;
+	pHeader->pFunc = sf;
+	pHeader->mSize = size;
+	pHeader->mLine = (uint32_t)l;
+	pHeader->mOffset = (uint32_t)offset;
+	pHeader->mAlign = (uint32_t)align;
+	pHeader->mTag = (uint16_t)tag;
+	pHeader->mShard = (uint16_t)shardIndex;
+	pHeader->mMagic = MEMORY_TRACKING_MAGIC;
+
+	MemoryShard* pShard = &gShards[shardIndex];
+	lockShard(pShard);
+	pHeader->pNext = pShard->pHead;
+	if (pShard->pHead)
+		pShard->pHead->pPrev = pHeader;
+	pShard->pHead = pHeader;
+	MemoryTagStats& stats = pShard->mStats[tag];
+	stats.mLiveBytes += (int64_t)size;
+	stats.mLiveCount += 1;
+	stats.mTotalBytes += (int64_t)size;
+	stats.mTotalCount += 1;
+	unlockShard(pShard);
+
+	void* ptr = pActual + offset;
 
 	// If using MTuner, report allocation to rmem.
-	MTUNER_ALIGNED_ALLOC(0, pMemAlign, size, 0, align);
+	MTUNER_ALIGNED_ALLOC(0, ptr, size, offset, align);
 
-	// Return handle to allocated memory.
-	return pMemAlign;
+	return ptr;
 }
 
-void* tf_calloc_memalign_internal(size_t count, size_t align, size_t size, const char *f, int l, const char *sf)
+static void trackedFree(void* ptr)
 {
-	size = ALIGN_TO(size, align);
+	if (!ptr)
+		return;
 
-	void* pMemAlign = mmgrAllocator(f, l, sf, m_alloc_calloc, align, size * count);
+	// If using MTuner, report free to rmem.
+	MTUNER_FREE(0, ptr);
 
-	// If using MTuner, report allocation to rmem.
-	MTUNER_ALIGNED_ALLOC(0, pMemAlign, size, 0, align);
+	AllocationHeader* pHeader = getHeader(ptr);
+
+	// The allocation can belong to a shard of another thread
+	MemoryShard* pShard = &gShards[pHeader->mShard];
+	lockShard(pShard);
+	if (pHeader->pPrev)
+		pHeader->pPrev->pNext = pHeader->pNext;
+	else
+		pShard->pHead = pHeader->pNext;
+	if (pHeader->pNext)
+		pHeader->pNext->pPrev = pHeader->pPrev;
+	MemoryTagStats& stats = pShard->mStats[pHeader->mTag];
+	stats.mLiveBytes -= (int64_t)pHeader->mSize;
+	stats.mLiveCount -= 1;
+	unlockShard(pShard);
+
+	pHeader->mMagic = 0;
+	unsigned char* pActual = (unsigned char*)ptr - pHeader->mOffset;
+
+#ifdef _MSC_VER
+	_aligned_free(pActual);
+#else
+	free(pActual);
+#endif
+}
+
+bool MemAllocInit(const char* appName)
+{
+	strncpy(gAppName, appName ? appName : "", sizeof(gAppName) - 1);
+	return true;
+}
+
+void MemAllocExit()
+{
+	// NOTE: The file system and the logger may already be shut down at this point, so leaks only go to the debug output
+	uint32_t leakCount = 0;
+	int64_t  leakBytes = 0;
+
+	for (uint32_t i = 0; i < MEMORY_TRACKING_SHARD_COUNT; ++i)
+	{
+		MemoryShard* pShard = &gShards[i];
+		lockShard(pShard);
+		for (AllocationHeader* pHeader = pShard->pHead; pHeader; pHeader = pHeader->pNext)
+		{
+			if (leakCount < MEMORY_TRACKING_MAX_REPORTED_LEAKS)
+			{
+				_OutputDebugString("Memory leak: %zu bytes [%s] allocated by %s(%u) %s\n",
+					pHeader->mSize, memGetTagName((MemoryTag)pHeader->mTag), pHeader->pFile, pHeader->mLine, pHeader->pFunc);
+			}
+			++leakCount;
+			leakBytes += (int64_t)pHeader->mSize;
+		}
+		unlockShard(pShard);
+	}
+
+	if (leakCount)
+	{
+		_OutputDebugString("%s: %u memory leak%s found (%lld bytes)\n", gAppName, leakCount, leakCount == 1 ? "" : "s", (long long)leakBytes);
+		MemoryStats stats = {};
+		memGetStats(&stats);
+		for (uint32_t i = 0; i < MEMORY_TAG_COUNT; ++i)
+		{
+			if (stats.mTags[i].mLiveCount)
+				_OutputDebugString("\t%-16s %lld allocations, %lld bytes\n", memGetTagName((MemoryTag)i), (long long)stats.mTags[i].mLiveCount, (long long)stats.mTags[i].mLiveBytes);
+		}
+	}
+
+	ASSERT(leakCount == 0 && "Memory leaks found");
+}
+
+MemoryTag memSetThreadTag(MemoryTag tag)
+{
+	MemoryTag prevTag = gThreadTag;
+	gThreadTag = tag;
+	return prevTag;
+}
+
+MemoryTag memGetThreadTag()
+{
+	return gThreadTag;
+}
+
+void memGetStats(MemoryStats* pOutStats)
+{
+	memset(pOutStats, 0, sizeof(*pOutStats));
+
+	// Each shard is copied under its lock so its counters are consistent with each other,
+	// the sum can still be off by allocations made while other shards are being read.
+	for (uint32_t i = 0; i < MEMORY_TRACKING_SHARD_COUNT; ++i)
+	{
+		MemoryShard* pShard = &gShards[i];
+		MemoryTagStats shardStats[MEMORY_TAG_COUNT];
+		lockShard(pShard);
+		memcpy(shardStats, pShard->mStats, sizeof(shardStats));
+		unlockShard(pShard);
+
+		for (uint32_t j = 0; j < MEMORY_TAG_COUNT; ++j)
+		{
+			pOutStats->mTags[j].mLiveBytes += shardStats[j].mLiveBytes;
+			pOutStats->mTags[j].mLiveCount += shardStats[j].mLiveCount;
+			pOutStats->mTags[j].mTotalBytes += shardStats[j].mTotalBytes;
+			pOutStats->mTags[j].mTotalCount += shardStats[j].mTotalCount;
+		}
+	}
+}
+
+void* tf_malloc_internal(size_t size, const char *f, int l, const char *sf)
+{
+	return trackedAlloc(MIN_ALLOC_ALIGNMENT, size, false, f, l, sf);
+}
+
+void* tf_calloc_internal(size_t count, size_t size, const char *f, int l, const char *sf) 
+{
+	return trackedAlloc(MIN_ALLOC_ALIGNMENT, count * size, true, f, l, sf);
+}
+
+void* tf_memalign_internal(size_t align, size_t size, const char *f, int l, const char *sf)
+{
+	return trackedAlloc(align, size, false, f, l, sf);
+}
+
+void* tf_calloc_memalign_internal(size_t count, size_t align, size_t size, const char *f, int l, const char *sf)
+{
+	size = ALIGN_TO(size, align);
 
-	// Return handle to allocated memory.
-	return pMemAlign;
+	return trackedAlloc(align, size * count, true, f, l, sf);
 }
 
 void* tf_realloc_internal(void* ptr, size_t size, const char *f, int l, const char *sf) 
 {
-	void* pRealloc = mmgrReallocator(f, l, sf, m_alloc_realloc, size, ptr);
+	if (!ptr)
+		return trackedAlloc(MIN_ALLOC_ALIGNMENT, size, false, f, l, sf);
+
+	if (!size)
+	{
+		trackedFree(ptr);
+		return NULL;
+	}
+
+	AllocationHeader* pHeader = getHeader(ptr);
+	if (pHeader->mSize == size)
+		return ptr;
 
-	// If using MTuner, report reallocation to rmem.
-	MTUNER_REALLOC(0, pRealloc, size, 0, ptr);
+	// Keep the alignment and tag of the original allocation
+	MemoryTag prevTag = memSetThreadTag((MemoryTag)pHeader->mTag);
+	void* pRealloc = trackedAlloc(pHeader->mAlign, size, false, f, l, sf);
+	memSetThreadTag(prevTag);
+
+	if (pRealloc)
+	{
+		memcpy(pRealloc, ptr, pHeader->mSize < size ? pHeader->mSize : size);
+		trackedFree(ptr);
+	}
 
 	// Return handle to reallocated memory.
 	return pRealloc;
@@ -100,13 +382,10 @@ void* tf_realloc_internal(void* ptr, size_t size, const char *f, int l, const ch
 
 void tf_free_internal(void* ptr, const char *f, int l, const char *sf)
 {
-	// If using MTuner, report free to rmem.
-	MTUNER_FREE(0, ptr);
-
-	mmgrDeallocator(f, l, sf, m_alloc_free, ptr);
+	trackedFree(ptr);
 }
 
-#else // defined(USE_MEMORY_TRACKING) || defined(USE_MTUNER)
+#else // defined(USE_MEMORY_TRACKING)
 
 bool MemAllocInit(const char* appName)
 {
@@ -119,6 +398,12 @@ void MemAllocExit()
 	// Return all allocated memory to the OS. Analyze memory usage, dump memory leaks, ...
 }
 
+MemoryTag memSetThreadTag(MemoryTag tag) { return MEMORY_TAG_UNTAGGED; }
+
+MemoryTag memGetThreadTag() { return MEMORY_TAG_UNTAGGED; }
+
+void memGetStats(MemoryStats* pOutStats) { memset(pOutStats, 0, sizeof(*pOutStats)); }
+
 void* tf_malloc(size_t size)
 {
 #ifdef _MSC_VER
@@ -221,4 +506,198 @@ void* tf_realloc_internal(void* ptr, size_t size, const char *f, int l, const ch
 
 void tf_free_internal(void* ptr, const char *f, int l, const char *sf) { tf_free(ptr); }
 
-#endif // defined(USE_MEMORY_TRACKING) || defined(USE_MTUNER)
+#endif // defined(USE_MEMORY_TRACKING)
+
+/************************************************************************/
+// Linear allocator
+/************************************************************************/
+struct LinearAllocatorBlock
+{
+	LinearAllocatorBlock* pNext;
+	unsigned char*        pData;
+	size_t                mSize;
+	bool                  mOwned;
+};
+
+void initLinearAllocator(LinearAllocator* pAllocator, size_t blockSize, void* pInitialBuffer, size_t initialBufferSize)
+{
+	ASSERT(pAllocator);
+	memset(pAllocator, 0, sizeof(*pAllocator));
+	pAllocator->mBlockSize = blockSize;
+
+	// The block header is carved out of the user buffer so the first block never touches the heap
+	const size_t headerSize = ALIGN_TO(sizeof(LinearAllocatorBlock), MIN_ALLOC_ALIGNMENT);
+	const uintptr_t bufferStart = ALIGN_TO((uintptr_t)pInitialBuffer, alignof(LinearAllocatorBlock));
+	if (pInitialBuffer && (bufferStart - (uintptr_t)pInitialBuffer) + headerSize < initialBufferSize)
+	{
+		LinearAllocatorBlock* pBlock = (LinearAllocatorBlock*)bufferStart;
+		pBlock->pNext = NULL;
+		pBlock->pData = (unsigned char*)bufferStart + headerSize;
+		pBlock->mSize = initialBufferSize - (bufferStart - (uintptr_t)pInitialBuffer) - headerSize;
+		pBlock->mOwned = false;
+		pAllocator->pFirst = pBlock;
+		pAllocator->pCurrent = pBlock;
+	}
+}
+
+void exitLinearAllocator(LinearAllocator* pAllocator)
+{
+	LinearAllocatorBlock* pBlock = pAllocator->pFirst;
+	while (pBlock)
+	{
+		LinearAllocatorBlock* pNext = pBlock->pNext;
+		if (pBlock->mOwned)
+			tf_free_internal(pBlock, __FILE__, __LINE__, __FUNCTION__);
+		pBlock = pNext;
+	}
+	memset(pAllocator, 0, sizeof(*pAllocator));
+}
+
+void* linearAlloc(LinearAllocator* pAllocator, size_t size, size_t align)
+{
+	ASSERT(pAllocator);
+	ASSERT(align && !(align & (align - 1)));
+
+	for (;;)
+	{
+		LinearAllocatorBlock* pBlock = pAllocator->pCurrent;
+		if (pBlock)
+		{
+			const uintptr_t base = (uintptr_t)pBlock->pData;
+			const size_t offset = (size_t)(ALIGN_TO(base + pAllocator->mOffset, align) - base);
+			if (offset + size <= pBlock->mSize)
+			{
+				pAllocator->mUsed += offset + size - pAllocator->mOffset;
+				pAllocator->mOffset = offset + size;
+				if (pAllocator->mUsed > pAllocator->mHighWaterMark)
+					pAllocator->mHighWaterMark = pAllocator->mUsed;
+				return (void*)(base + offset);
+			}
+		}
+
+		// Reuse the blocks kept from before the last reset
+		LinearAllocatorBlock* pNext = pBlock ? pBlock->pNext : pAllocator->pFirst;
+		if (pNext && pNext->mSize >= size + align - 1)
+		{
+			pAllocator->pCurrent = pNext;
+			pAllocator->mOffset = 0;
+			continue;
+		}
+
+		// Oversized requests get a dedicated block
+		const size_t headerSize = ALIGN_TO(sizeof(LinearAllocatorBlock), MIN_ALLOC_ALIGNMENT);
+		const size_t dataSize = size + align - 1 > pAllocator->mBlockSize ? size + align - 1 : pAllocator->mBlockSize;
+		LinearAllocatorBlock* pNewBlock =
+			(LinearAllocatorBlock*)tf_memalign_internal(MIN_ALLOC_ALIGNMENT, headerSize + dataSize, __FILE__, __LINE__, __FUNCTION__);
+		if (!pNewBlock)
+			return NULL;
+
+		pNewBlock->pNext = pNext;
+		pNewBlock->pData = (unsigned char*)pNewBlock + headerSize;
+		pNewBlock->mSize = dataSize;
+		pNewBlock->mOwned = true;
+		if (pBlock)
+			pBlock->pNext = pNewBlock;
+		else
+			pAllocator->pFirst = pNewBlock;
+
+		pAllocator->pCurrent = pNewBlock;
+		pAllocator->mOffset = 0;
+	}
+}
+
+void resetLinearAllocator(LinearAllocator* pAllocator)
+{
+	pAllocator->pCurrent = pAllocator->pFirst;
+	pAllocator->mOffset = 0;
+	pAllocator->mUsed = 0;
+}
+
+LinearAllocatorMarker getLinearAllocatorMarker(const LinearAllocator* pAllocator)
+{
+	LinearAllocatorMarker marker = { pAllocator->pCurrent, pAllocator->mOffset, pAllocator->mUsed };
+	return marker;
+}
+
+void rewindLinearAllocator(LinearAllocator* pAllocator, LinearAllocatorMarker marker)
+{
+	pAllocator->pCurrent = marker.pBlock;
+	pAllocator->mOffset = marker.mOffset;
+	pAllocator->mUsed = marker.mUsed;
+}
+
+/************************************************************************/
+// Pool allocator
+/************************************************************************/
+struct PoolAllocatorBlock
+{
+	PoolAllocatorBlock* pNext;
+};
+
+void initPoolAllocator(PoolAllocator* pAllocator, size_t elementSize, size_t elementAlign, uint32_t elementsPerBlock)
+{
+	ASSERT(pAllocator && elementsPerBlock);
+	memset(pAllocator, 0, sizeof(*pAllocator));
+
+	// Free elements store the free list link in place
+	elementAlign = elementAlign > alignof(void*) ? elementAlign : alignof(void*);
+	elementSize = elementSize > sizeof(void*) ? elementSize : sizeof(void*);
+	pAllocator->mElementSize = ALIGN_TO(elementSize, elementAlign);
+	pAllocator->mElementAlign = elementAlign;
+	pAllocator->mElementsPerBlock = elementsPerBlock;
+}
+
+void exitPoolAllocator(PoolAllocator* pAllocator)
+{
+	ASSERT(pAllocator->mLiveCount == 0 && "Pool allocator destroyed with live elements");
+
+	PoolAllocatorBlock* pBlock = pAllocator->pBlocks;
+	while (pBlock)
+	{
+		PoolAllocatorBlock* pNext = pBlock->pNext;
+		tf_free_internal(pBlock, __FILE__, __LINE__, __FUNCTION__);
+		pBlock = pNext;
+	}
+	memset(pAllocator, 0, sizeof(*pAllocator));
+}
+
+void* poolAlloc(PoolAllocator* pAllocator)
+{
+	if (!pAllocator->pFreeList)
+	{
+		const size_t align = pAllocator->mElementAlign > MIN_ALLOC_ALIGNMENT ? pAllocator->mElementAlign : MIN_ALLOC_ALIGNMENT;
+		const size_t headerSize = ALIGN_TO(sizeof(PoolAllocatorBlock), align);
+		PoolAllocatorBlock* pBlock = (PoolAllocatorBlock*)tf_memalign_internal(
+			align, headerSize + pAllocator->mElementSize * pAllocator->mElementsPerBlock, __FILE__, __LINE__, __FUNCTION__);
+		if (!pBlock)
+			return NULL;
+
+		pBlock->pNext = pAllocator->pBlocks;
+		pAllocator->pBlocks = pBlock;
+
+		// Thread the free list front to back so consecutive allocations are adjacent in memory
+		unsigned char* pElements = (unsigned char*)pBlock + headerSize;
+		for (uint32_t i = 0; i < pAllocator->mElementsPerBlock; ++i)
+		{
+			void** ppElement = (void**)(pElements + i * pAllocator->mElementSize);
+			*ppElement = (i + 1 < pAllocator->mElementsPerBlock) ? (void*)(pElements + (i + 1) * pAllocator->mElementSize) : NULL;
+		}
+		pAllocator->pFreeList = pElements;
+	}
+
+	void* ptr = pAllocator->pFreeList;
+	pAllocator->pFreeList = *(void**)ptr;
+	++pAllocator->mLiveCount;
+	return ptr;
+}
+
+void poolFree(PoolAllocator* pAllocator, void* ptr)
+{
+	if (!ptr)
+		return;
+
+	ASSERT(pAllocator->mLiveCount);
+	*(void**)ptr = pAllocator->pFreeList;
+	pAllocator->pFreeList = ptr;
+	--pAllocator->mLiveCount;
+}
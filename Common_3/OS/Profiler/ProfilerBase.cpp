@@ -29,16 +29,24 @@ void exitProfiler() {}
 void flipProfiler() {}
 void dumpProfileData(Renderer* pRenderer, const char* appName, uint32_t nMaxFrames) {}
 void dumpBenchmarkData(Renderer* pRenderer, IApp::Settings* pSettings, const char* appName) {}
+bool startProfileCapture(const char* appName, uint32_t nMaxBufferedBytes) { return false; }
+void stopProfileCapture() {}
+bool isProfileCaptureRunning() { return false; }
 void setAggregateFrames(uint32_t nFrames) {}
 float getCpuProfileTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
 float getCpuProfileAvgTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
 float getCpuProfileMinTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
 float getCpuProfileMaxTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
+float getCpuProfilePercentileTime(const char* pGroup, const char* pName, float fPercentile, ThreadID* pThreadID) { return -1.0f; }
+uint32_t getCpuProfileSpikeCount(const char* pGroup, const char* pName, ThreadID* pThreadID) { return 0; }
 
 float getCpuFrameTime() { return -1.0f; }
 float getCpuAvgFrameTime() { return -1.0f; }
 float getCpuMinFrameTime() { return -1.0f; }
 float getCpuMaxFrameTime() { return -1.0f; }
+float getCpuPercentileFrameTime(float fPercentile) { return -1.0f; }
+uint32_t getCpuFrameSpikeCount() { return 0; }
+void resetProfileHistograms() {}
 
 uint64_t cpuProfileEnter(ProfileToken nToken) { return 0; }
 void cpuProfileLeave(ProfileToken nToken, uint64_t nTick) {}
@@ -121,7 +129,7 @@ inline void ProfileThreadStart(ProfileThread* pThread, ProfileThreadFunc Func)
 #endif
 	desc[count].pFunc = Func;
 	desc[count].pData = *pThread;
-	create_thread(&desc[count++]);
+	**pThread = create_thread(&desc[count++]);
 }
 inline void ProfileThreadJoin(ProfileThread* pThread)
 {
@@ -178,6 +186,14 @@ inline Mutex& ProfileMutex()
 	return sMutex;
 }
 
+// Held while thread logs are walked by the aggregation, so they can't be freed underneath it.
+// Lock order is ProfileMutex -> ProfileAggregateMutex.
+inline Mutex& ProfileAggregateMutex()
+{
+	static Mutex sMutex;
+	return sMutex;
+}
+
 Mutex& ProfileGetMutex()
 {
 	return ProfileMutex();
@@ -200,6 +216,7 @@ void ProfileInit()
 	{
 		g_bOnce = false;
         mutex.Init();
+		ProfileAggregateMutex().Init();
 		memset(&S, 0, sizeof(S));
 		S.nMemUsage = sizeof(S);
 		for (int i = 0; i < PROFILE_MAX_GROUPS; ++i)
@@ -263,9 +280,12 @@ void ProfileInit()
 void initProfiler(Renderer* pRenderer, Queue** ppQueue, const char** ppProfilerNames, ProfileToken* pProfileTokens, uint32_t nGpuProfilerCount)
 {
 #if PROFILE_ENABLED
+    MEMORY_TAG_SCOPE(MEMORY_TAG_PROFILER);
     ProfileInit();
     ProfileSetEnableAllGroups(true);
     ProfileWebServerStart();
+    ProfileContextSwitchTraceStart();
+    ProfileAggregateStart();
 
 #if GPU_PROFILER_SUPPORTED
     initGpuProfilers();
@@ -284,11 +304,24 @@ void initProfiler(Renderer* pRenderer, Queue** ppQueue, const char** ppProfilerN
 
 void exitCpuProfiler()
 {
+	// The aggregate thread publishes under ProfileMutex, stop it before taking the lock
+	ProfileAggregateStop();
+
 	MutexLock lock(ProfileMutex());
 
 	ProfileOnThreadExit();
 	ProfileWebServerStop();
 	ProfileContextSwitchTraceStop();
+	stopProfileCapture();
+
+	Profile & S = g_Profile;
+	char* pLabelBuffer = (char*)tfrg_atomicptr_load_relaxed(&S.LabelBuffer);
+	if (pLabelBuffer)
+	{
+		tfrg_atomic64_store_release(&S.LabelBuffer, 0);
+		tf_free(pLabelBuffer);
+		S.nMemUsage -= PROFILE_LABEL_BUFFER_SIZE + PROFILE_LABEL_MAX_LEN;
+	}
 
     g_bOnce = true;
     g_bUseLock = false;
@@ -347,6 +380,7 @@ PROFILE_API void ProfileRemoveThreadLog(ProfileThreadLog * pLog)
 		}
 		P_ASSERT(nLogIndex < PROFILE_MAX_THREADS);
 
+		MutexLock aggregateLock(ProfileAggregateMutex());
 		S.Pool[nLogIndex] = 0;
 
 		for (int i = 0; i < PROFILE_MAX_FRAME_HISTORY; ++i)
@@ -395,6 +429,7 @@ ProfileThreadLog* ProfileCreateThreadLog(const char* pName)
 	memcpy(&pLog->ThreadName[0], pName, len);
 	pLog->ThreadName[len] = '\0';
 	pLog->nThreadId = Thread::GetCurrentThreadID();
+	pLog->nSystemThreadId = P_GETCURRENTSYSTEMTHREADID();
 	return pLog;
 }
 
@@ -430,6 +465,7 @@ void ProfileOnThreadExit()
 		}
 		P_ASSERT(nLogIndex < PROFILE_MAX_THREADS);
 
+		MutexLock aggregateLock(ProfileAggregateMutex());
 		S.Pool[nLogIndex] = 0;
 
 		for (int i = 0; i < PROFILE_MAX_FRAME_HISTORY; ++i)
@@ -671,21 +707,22 @@ const char* ProfileCounterFullName(int nCounter)
 	{
 		nNodes[nIndex++] = nCounter;
 		nCounter = S.CounterInfo[nCounter].nParent;
-	} while (nCounter >= 0);
+	} while (nCounter >= 0 && nIndex < 32);
+	nIndex--;
 	int nOffset = 0;
 	while (nIndex >= 0 && nOffset < (int)sizeof(Buffer) - 2)
 	{
-		uint32_t nLen = S.CounterInfo[nNodes[nIndex]].nNameLen + nOffset;// < sizeof(Buffer)-1 
-		nLen = ProfileMin((uint32_t)(sizeof(Buffer) - 2 - nOffset), nLen);
+		uint32_t nLen = ProfileMin((uint32_t)(sizeof(Buffer) - 2 - nOffset), (uint32_t)S.CounterInfo[nNodes[nIndex]].nNameLen);
 		memcpy(&Buffer[nOffset], S.CounterInfo[nNodes[nIndex]].pName, nLen);
 
-		nOffset += S.CounterInfo[nNodes[nIndex]].nNameLen + 1;
+		nOffset += nLen;
 		if (nIndex)
 		{
 			Buffer[nOffset++] = '/';
 		}
 		nIndex--;
 	}
+	Buffer[nOffset] = '\0';
 	return &Buffer[0];
 }
 
@@ -766,6 +803,7 @@ inline void ProfileLogPut(ProfileToken nToken_, uint64_t nTick, uint64_t nBegin,
 	{
 		if (!pLog->Log)
 		{
+			MEMORY_TAG_SCOPE(MEMORY_TAG_PROFILER);
 			pLog->Log = static_cast<ProfileLogEntry *>(tf_malloc(sizeof(ProfileLogEntry) * PROFILE_BUFFER_SIZE));
 			memset(pLog->Log, 0, sizeof(ProfileLogEntry) * PROFILE_BUFFER_SIZE);
 			S.nMemUsage += sizeof(ProfileLogEntry) * PROFILE_BUFFER_SIZE;
@@ -820,7 +858,7 @@ uint64_t ProfileAllocateLabel(const char* pName)
 			pLabelBuffer = static_cast<char *>(tf_malloc(PROFILE_LABEL_BUFFER_SIZE + PROFILE_LABEL_MAX_LEN));
 			memset(pLabelBuffer, 0, PROFILE_LABEL_BUFFER_SIZE + PROFILE_LABEL_MAX_LEN);
 			S.nMemUsage += PROFILE_LABEL_BUFFER_SIZE + PROFILE_LABEL_MAX_LEN;
-			tfrg_atomic64_store_release(&S.LabelBuffer, *pLabelBuffer);
+			tfrg_atomic64_store_release(&S.LabelBuffer, (uint64_t)(uintptr_t)pLabelBuffer);
 		}
 	}
 
@@ -1026,19 +1064,59 @@ void ProfileGetRange(uint32_t nPut, uint32_t nGet, uint32_t nRange[2][2])
 }
 
 void ProfileDumpToFile(Renderer* pRenderer);
+void ProfileCaptureFlip(ProfileFrameState* pFrameCurrent, ProfileFrameState* pFrameNext);
 
-void ProfileFlipCpu()
+// One flipped frame waiting to be aggregated. Built by the flip under ProfileMutex, consumed in order by the aggregate thread.
+struct ProfileAggregateJob
 {
-    MutexLock lock(ProfileMutex());
+	uint32_t nFrameCurrent;
+	uint32_t nFrameNext;
+	uint32_t bFrame;        // a frame was flipped, its logs [nFrameCurrent, nFrameNext) can be walked
+	uint32_t bRunning;
+	uint32_t bResetStacks;  // running state was toggled, open scopes are dropped
+	uint32_t nAggregateClear;
+	uint32_t nAggregateFlip;
+};
+
+// Aggregation of the per-thread logs runs on a background thread, so the cost of ProfileFlipCpu on the frame thread only
+// depends on the number of threads, not on the number of markers. Producers can't overwrite log entries that are still
+// queued: the aggregation moves nGet forward once a frame has been walked.
+struct ProfileAggregator
+{
+	Mutex mQueueMutex;
+	ConditionVariable mQueueCond;
+	ThreadDesc mThreadDesc;
+	ThreadHandle mThread;
+	bool bThreadRunning;
+	bool bStop;
+	// Guarded by mQueueMutex
+	ProfileAggregateJob Jobs[PROFILE_AGGREGATE_MAX_PENDING];
+	uint32_t nJobPut;
+	uint32_t nJobGet;
+
+	// Per frame results of the log walk, published to g_Profile under ProfileMutex
+	ProfileTimer Frame[PROFILE_MAX_TIMERS];
+	uint64_t FrameExclusive[PROFILE_MAX_TIMERS];
+	uint64_t FrameGroup[PROFILE_MAX_GROUPS];
+	uint64_t FrameMetaCounters[PROFILE_META_MAX][PROFILE_MAX_TIMERS];
+	int64_t FrameThreadGroupTicks[PROFILE_MAX_THREADS][PROFILE_MAX_GROUPS];
+};
 
+static ProfileAggregator g_ProfileAggregator;
+
+// Walks the thread logs of one frame. Only takes ProfileAggregateMutex, so it never blocks threads creating timers or the flip.
+// Results only go to the aggregator, anything the UI reads is written in ProfileAggregatePublish under ProfileMutex.
+static void ProfileAggregateWalk(const ProfileAggregateJob& Job)
+{
 	Profile & S = g_Profile;
+	ProfileAggregator& A = g_ProfileAggregator;
+	// ProfileGetToken takes ProfileMutex, resolve the tokens before ProfileAggregateMutex to keep the lock order
+	ProfileToken nClearToken = ProfileGetToken("Profile", "Clear", 0x3355ee, ProfileTokenTypeCpu);
+	ProfileToken nThreadLoopToken = ProfileGetToken("Profile", "ThreadLoop", 0x3355ee, ProfileTokenTypeCpu);
+	MutexLock lock(ProfileAggregateMutex());
 
-	if (S.nToggleRunning)
+	if (Job.bResetStacks)
 	{
-		S.nRunning = !S.nRunning;
-		if (!S.nRunning)
-			S.nPauseTicks = P_TICK();
-		S.nToggleRunning = 0;
 		for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
 		{
 			ProfileThreadLog* pLog = S.Pool[i];
@@ -1048,267 +1126,279 @@ void ProfileFlipCpu()
 			}
 		}
 	}
-	uint32_t nAggregateClear = S.nAggregateClear || S.nAutoClearFrames, nAggregateFlip = 0;
-	if (S.nDumpFileNextFrame)
-	{
-		ProfileDumpToFile(nullptr);
-		S.nDumpFileNextFrame = 0;
-		S.nAutoClearFrames = PROFILE_GPU_FRAME_DELAY + 3; //hide spike from dumping webpage
-	}
-
-	if (S.nAutoClearFrames)
-	{
-		nAggregateClear = 1;
-		nAggregateFlip = 1;
-		S.nAutoClearFrames -= 1;
-	}
-
-
-	if (S.nRunning || S.nForceEnable)
-	{
-		S.nFramePutIndex++;
-		S.nFramePut = (S.nFramePut + 1) % PROFILE_MAX_FRAME_HISTORY;
-		P_ASSERT((S.nFramePutIndex % PROFILE_MAX_FRAME_HISTORY) == S.nFramePut);
-		S.nFrameCurrent = (S.nFramePut + PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 1) % PROFILE_MAX_FRAME_HISTORY;
-		S.nFrameCurrentIndex++;
-		uint32_t nFrameNext = (S.nFrameCurrent + 1) % PROFILE_MAX_FRAME_HISTORY;
-
-		uint32_t nContextSwitchPut = S.nContextSwitchPut;
-		if (S.nContextSwitchLastPut < nContextSwitchPut)
-		{
-			S.nContextSwitchUsage = (nContextSwitchPut - S.nContextSwitchLastPut);
-		}
-		else
-		{
-			S.nContextSwitchUsage = PROFILE_CONTEXT_SWITCH_BUFFER_SIZE - S.nContextSwitchLastPut + nContextSwitchPut;
-		}
-		S.nContextSwitchLastPut = nContextSwitchPut;
-
-		ProfileFrameState* pFramePut = &S.Frames[S.nFramePut];
-		ProfileFrameState* pFrameCurrent = &S.Frames[S.nFrameCurrent];
-		ProfileFrameState* pFrameNext = &S.Frames[nFrameNext];
 
-		pFramePut->nFrameStartCpu = P_TICK();
-        memset(&pFramePut->nFrameStartGpu[0], 0, PROFILE_MAX_THREADS * sizeof(pFramePut->nFrameStartGpu[0]));
+	if (!Job.bFrame)
+		return;
 
-		uint64_t nFrameStartCpu = pFrameCurrent->nFrameStartCpu;
-		uint64_t nFrameEndCpu = pFrameNext->nFrameStartCpu;
+	ProfileFrameState* pFrameCurrent = &S.Frames[Job.nFrameCurrent];
+	ProfileFrameState* pFrameNext = &S.Frames[Job.nFrameNext];
 
-		{
-			uint64_t nTick = nFrameEndCpu - nFrameStartCpu;
-			S.nFlipTicks = nTick;
-			S.nFlipAggregate += nTick;
-            S.nFlipMin = ProfileMin(S.nFlipMin, nTick);
-			S.nFlipMax = ProfileMax(S.nFlipMax, nTick);
-		}
+	ProfileCaptureFlip(pFrameCurrent, pFrameNext);
 
+	if (Job.bRunning)
+	{
 		uint8_t* pTimerToGroup = &S.TimerToGroup[0];
-		for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
+		uint64_t* pFrameGroup = &A.FrameGroup[0];
+		uint32_t nTotalTimers = S.nTotalTimers;
 		{
-			ProfileThreadLog* pLog = S.Pool[i];
-			if (!pLog)
-			{
-				pFramePut->nLogStart[i] = 0;
-			}
-			else
+			PROFILE_SCOPE_TOKEN(nClearToken);
+			memset(&A.Frame[0], 0, sizeof(A.Frame[0]) * nTotalTimers);
+			memset(&A.FrameExclusive[0], 0, sizeof(A.FrameExclusive[0]) * nTotalTimers);
+			memset(pFrameGroup, 0, sizeof(A.FrameGroup));
+			for (uint32_t j = 0; j < PROFILE_META_MAX; ++j)
 			{
-				uint32_t nPut = tfrg_atomic32_load_acquire(&pLog->nPut);
-				pFramePut->nLogStart[i] = nPut;
-				P_ASSERT(nPut < PROFILE_BUFFER_SIZE);
-                if (pLog->nGpu && pLog->Log && pFramePut->nFrameStartGpu[i] == 0)
-                {
-                    uint32_t nPreviousPos = (nPut - 1) % PROFILE_BUFFER_SIZE;
-                    pFramePut->nFrameStartGpu[i] = ProfileLogGetTick(pLog->Log[nPreviousPos]);
-                }
-				//need to keep last frame around to close timers. timers more than 1 frame old is ditched.
-                tfrg_atomic32_store_relaxed(&pLog->nGet, nPut);
+				memset(&A.FrameMetaCounters[j][0], 0, sizeof(A.FrameMetaCounters[j][0]) * nTotalTimers);
 			}
+			memset(A.FrameThreadGroupTicks, 0, sizeof(A.FrameThreadGroupTicks));
 		}
-
-		if (S.nRunning)
 		{
-			uint64_t* pFrameGroup = &S.FrameGroup[0];
+			PROFILE_SCOPE_TOKEN(nThreadLoopToken);
+			for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
 			{
-                PROFILER_SET_CPU_SCOPE("Profile", "Clear", 0x3355ee);
-				for (uint32_t i = 0; i < S.nTotalTimers; ++i)
-				{
-                    if (S.GroupInfo[S.TimerInfo[i].nGroupIndex].Type == ProfileTokenTypeGpu)
-                    {
-                        continue;
-                    }
-					S.Frame[i].nTicks = 0;
-					S.Frame[i].nCount = 0;
-					S.FrameExclusive[i] = 0;
-				}
-				for (uint32_t i = 0; i < PROFILE_MAX_GROUPS; ++i)
-				{
-					pFrameGroup[i] = 0;
-				}
-				for (uint32_t j = 0; j < PROFILE_META_MAX; ++j)
-				{
-					if (S.MetaCounters[j].pName && 0 != (S.nActiveBars & (P_DRAW_META_FIRST << j)))
-					{
-						auto& Meta = S.MetaCounters[j];
-						for (uint32_t i = 0; i < S.nTotalTimers; ++i)
-						{
-							Meta.nCounters[i] = 0;
-						}
-					}
-				}
+				ProfileThreadLog* pLog = S.Pool[i];
+				if (!pLog)
+					continue;
 
-			}
-			{
-                PROFILER_SET_CPU_SCOPE("Profile", "ThreadLoop", 0x3355ee);
-				for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
-				{
-					ProfileThreadLog* pLog = S.Pool[i];
-					if (!pLog)
-						continue;
+				uint8_t* pGroupStackPos = &pLog->nGroupStackPos[0];
+				int64_t* nGroupTicks = &A.FrameThreadGroupTicks[i][0];
 
-					uint8_t* pGroupStackPos = &pLog->nGroupStackPos[0];
-					int64_t nGroupTicks[PROFILE_MAX_GROUPS] = { 0 };
-
-
-					uint32_t nPut = pFrameNext->nLogStart[i];
-					uint32_t nGet = pFrameCurrent->nLogStart[i];
-					uint32_t nRange[2][2] = { {0, 0}, {0, 0}, };
-					ProfileGetRange(nPut, nGet, nRange);
-
-
-					//fetch gpu results.
-					//if (pLog->nGpu)
-					//{
-					//	// Get current log's initial gpu tick
-					//	uint64_t nGPUTick = PROFILE_INVALID_TICK;
-					//	if (pFrameCurrent->nFrameStartGpuTimer != (uint32_t)-1) 
-					//		nGPUTick = ProfileGpuGetTimeStamp(pLog, pFrameCurrent->nFrameStartGpuTimer);
-					//	uint64_t nLastTick = (nGPUTick == PROFILE_INVALID_TICK) ? pFrameCurrent->nFrameStartGpu : nGPUTick;
-                    //
-					//	for (uint32_t j = 0; j < 2; ++j)
-					//	{
-					//		uint32_t nStart = nRange[j][0];
-					//		uint32_t nEnd = nRange[j][1];
-					//		for (uint32_t k = nStart; k < nEnd; ++k)
-					//		{
-					//			ProfileLogEntry L = pLog->Log[k];
-                    //
-					//			uint64_t Type = ProfileLogType(L);
-                    //
-					//			if (Type == P_LOG_ENTER || Type == P_LOG_LEAVE)
-					//			{
-					//				uint32_t nTimer = (uint32_t)ProfileLogGetTick(L);
-					//				uint64_t nTick = ProfileGpuGetTimeStamp(pLog, nTimer);
-                    //
-					//				if (nTick != PROFILE_INVALID_TICK)
-					//					nLastTick = nTick;
-                    //
-					//				pLog->Log[k] = ProfileLogSetTick(L, nLastTick);
-					//			}
-					//		}
-					//	}
-					//}
-
-
-					uint32_t* pStack = &pLog->nStack[0];
-					int64_t* pChildTickStack = &pLog->nChildTickStack[0];
-					uint32_t nStackPos = pLog->nStackPos;
-
-					for (uint32_t j = 0; j < 2; ++j)
+				uint32_t nPut = pFrameNext->nLogStart[i];
+				uint32_t nGet = pFrameCurrent->nLogStart[i];
+				uint32_t nRange[2][2] = { {0, 0}, {0, 0}, };
+				ProfileGetRange(nPut, nGet, nRange);
+
+				uint32_t* pStack = &pLog->nStack[0];
+				int64_t* pChildTickStack = &pLog->nChildTickStack[0];
+				uint32_t nStackPos = pLog->nStackPos;
+
+				for (uint32_t j = 0; j < 2; ++j)
+				{
+					uint32_t nStart = nRange[j][0];
+					uint32_t nEnd = nRange[j][1];
+					for (uint32_t k = nStart; k < nEnd; ++k)
 					{
-						uint32_t nStart = nRange[j][0];
-						uint32_t nEnd = nRange[j][1];
-						for (uint32_t k = nStart; k < nEnd; ++k)
+						ProfileLogEntry LE = pLog->Log[k];
+						uint64_t nType = ProfileLogType(LE);
+
+						if (P_LOG_ENTER == nType)
 						{
-							ProfileLogEntry LE = pLog->Log[k];
-							uint64_t nType = ProfileLogType(LE);
+							uint64_t nTimer = ProfileLogTimerIndex(LE);
+							uint8_t nGroup = pTimerToGroup[nTimer];
+							P_ASSERT(nStackPos < PROFILE_STACK_MAX);
+							P_ASSERT(nGroup < PROFILE_MAX_GROUPS);
+							pGroupStackPos[nGroup]++;
+							pStack[nStackPos++] = k;
+							pChildTickStack[nStackPos] = 0;
 
-							if (P_LOG_ENTER == nType)
+						}
+						else if (P_LOG_META == nType)
+						{
+							if (nStackPos)
 							{
-								uint64_t nTimer = ProfileLogTimerIndex(LE);
-								uint8_t nGroup = pTimerToGroup[nTimer];
-								P_ASSERT(nStackPos < PROFILE_STACK_MAX);
-								P_ASSERT(nGroup < PROFILE_MAX_GROUPS);
-								pGroupStackPos[nGroup]++;
-								pStack[nStackPos++] = k;
-								pChildTickStack[nStackPos] = 0;
-
+								int64_t nMetaIndex = ProfileLogTimerIndex(LE);
+								int64_t nMetaCount = ProfileLogGetTick(LE);
+								P_ASSERT(nMetaIndex < PROFILE_META_MAX);
+								int64_t nCounter = ProfileLogTimerIndex(pLog->Log[pStack[nStackPos - 1]]);
+								A.FrameMetaCounters[nMetaIndex][nCounter] += nMetaCount;
 							}
-							else if (P_LOG_META == nType)
+						}
+						else if (P_LOG_LEAVE == nType)
+						{
+							uint64_t nTimer = ProfileLogTimerIndex(LE);
+							uint8_t nGroup = pTimerToGroup[nTimer];
+							P_ASSERT(nGroup < PROFILE_MAX_GROUPS);
+							if (nStackPos)
 							{
-								if (nStackPos)
+								int64_t nTickStart = pLog->Log[pStack[nStackPos - 1]];
+								int64_t nTicks = ProfileLogTickDifference(nTickStart, LE);
+								int64_t nChildTicks = pChildTickStack[nStackPos];
+								nStackPos--;
+								pChildTickStack[nStackPos] += nTicks;
+
+								if (!pLog->nGpu)
 								{
-									int64_t nMetaIndex = ProfileLogTimerIndex(LE);
-									int64_t nMetaCount = ProfileLogGetTick(LE);
-									P_ASSERT(nMetaIndex < PROFILE_META_MAX);
-									int64_t nCounter = ProfileLogTimerIndex(pLog->Log[pStack[nStackPos - 1]]);
-									S.MetaCounters[nMetaIndex].nCounters[nCounter] += nMetaCount;
+									uint32_t nTimerIndex = (uint32_t)ProfileLogTimerIndex(LE);
+									A.Frame[nTimerIndex].nTicks += nTicks;
+									A.FrameExclusive[nTimerIndex] += (nTicks - nChildTicks);
+									A.Frame[nTimerIndex].nCount += 1;
 								}
-							}
-							else if (P_LOG_LEAVE == nType)
-							{
-								uint64_t nTimer = ProfileLogTimerIndex(LE);
-								uint8_t nGroup = pTimerToGroup[nTimer];
 								P_ASSERT(nGroup < PROFILE_MAX_GROUPS);
-								if (nStackPos)
+								uint8_t nGroupStackPos = pGroupStackPos[nGroup];
+								if (nGroupStackPos)
 								{
-									int64_t nTickStart = pLog->Log[pStack[nStackPos - 1]];
-									int64_t nTicks = ProfileLogTickDifference(nTickStart, LE);
-									int64_t nChildTicks = pChildTickStack[nStackPos];
-									nStackPos--;
-									pChildTickStack[nStackPos] += nTicks;
-
-                                    if (!pLog->nGpu)
-                                    {
-									    uint32_t nTimerIndex = (uint32_t)ProfileLogTimerIndex(LE);
-                                        S.Frame[nTimerIndex].nTicks += nTicks;
-                                        S.FrameExclusive[nTimerIndex] += (nTicks - nChildTicks);
-                                        S.Frame[nTimerIndex].nCount += 1;
-                                    }
-									P_ASSERT(nGroup < PROFILE_MAX_GROUPS);
-									uint8_t nGroupStackPos = pGroupStackPos[nGroup];
-									if (nGroupStackPos)
+									nGroupStackPos--;
+									if (0 == nGroupStackPos)
 									{
-										nGroupStackPos--;
-										if (0 == nGroupStackPos)
-										{
-											nGroupTicks[nGroup] += nTicks;
-										}
-										pGroupStackPos[nGroup] = nGroupStackPos;
+										nGroupTicks[nGroup] += nTicks;
 									}
+									pGroupStackPos[nGroup] = nGroupStackPos;
 								}
 							}
 						}
 					}
-					for (uint32_t i = 0; i < PROFILE_MAX_GROUPS; ++i)
-					{
-						pLog->nGroupTicks[i] += nGroupTicks[i];
-						pFrameGroup[i] += nGroupTicks[i];
-					}
-					pLog->nStackPos = nStackPos;
 				}
+				for (uint32_t i = 0; i < PROFILE_MAX_GROUPS; ++i)
+				{
+					pFrameGroup[i] += nGroupTicks[i];
+				}
+				pLog->nStackPos = nStackPos;
 			}
+		}
+	}
+
+	//need to keep last frame around to close timers. timers more than 1 frame old is ditched.
+	for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
+	{
+		ProfileThreadLog* pLog = S.Pool[i];
+		if (pLog)
+		{
+			tfrg_atomic32_store_release(&pLog->nGet, pFrameNext->nLogStart[i]);
+		}
+	}
+}
+
+static uint32_t ProfileHistogramBucket(uint64_t nUs)
+{
+	if (nUs < PROFILE_HISTOGRAM_SUB_BUCKETS)
+		return (uint32_t)nUs;
+	uint32_t nLog2 = 0;
+	for (uint64_t v = nUs; v > 1; v >>= 1)
+		++nLog2;
+	if (nLog2 > PROFILE_HISTOGRAM_MAX_LOG2)
+		return PROFILE_HISTOGRAM_BUCKETS - 1;
+	uint32_t nShift = nLog2 - PROFILE_HISTOGRAM_SUB_BUCKET_BITS;
+	return (nShift + 1) * PROFILE_HISTOGRAM_SUB_BUCKETS + (uint32_t)((nUs >> nShift) - PROFILE_HISTOGRAM_SUB_BUCKETS);
+}
+
+// Midpoint of a bucket in microseconds
+static float ProfileHistogramBucketValue(uint32_t nBucket)
+{
+	if (nBucket < PROFILE_HISTOGRAM_SUB_BUCKETS)
+		return (float)nBucket;
+	uint32_t nShift = nBucket / PROFILE_HISTOGRAM_SUB_BUCKETS - 1;
+	uint64_t nLow = (uint64_t)(nBucket % PROFILE_HISTOGRAM_SUB_BUCKETS + PROFILE_HISTOGRAM_SUB_BUCKETS) << nShift;
+	return (float)nLow + 0.5f * (float)(1ull << nShift);
+}
+
+static void ProfileHistogramAdd(uint32_t* pHistogram, uint32_t* pCount, uint64_t nTicks, double fTicksToUs)
+{
+	pHistogram[ProfileHistogramBucket((uint64_t)(nTicks * fTicksToUs))]++;
+	(*pCount)++;
+}
+
+static uint32_t ProfileHistogramPercentileBucket(const uint32_t* pHistogram, uint32_t nCount, float fPercentile)
+{
+	float fRank = ProfileClamp(fPercentile, 0.f, 100.f) * 0.01f * nCount;
+	uint32_t nRank = ProfileMax(1u, (uint32_t)ceilf(fRank));
+	uint32_t nSum = 0;
+	for (uint32_t i = 0; i < PROFILE_HISTOGRAM_BUCKETS; ++i)
+	{
+		nSum += pHistogram[i];
+		if (nSum >= nRank)
+			return i;
+	}
+	return PROFILE_HISTOGRAM_BUCKETS - 1;
+}
+
+float ProfileHistogramPercentile(const uint32_t* pHistogram, uint32_t nCount, float fPercentile)
+{
+	if (!nCount)
+		return 0.f;
+	return ProfileHistogramBucketValue(ProfileHistogramPercentileBucket(pHistogram, nCount, fPercentile)) * 0.001f;
+}
+
+uint32_t ProfileHistogramSpikes(const uint32_t* pHistogram, uint32_t nCount)
+{
+	if (!nCount)
+		return 0;
+	float fThreshold = ProfileHistogramBucketValue(ProfileHistogramPercentileBucket(pHistogram, nCount, 50.f)) * PROFILE_HISTOGRAM_SPIKE_FACTOR;
+	uint32_t nSpikes = 0;
+	for (uint32_t i = PROFILE_HISTOGRAM_BUCKETS; i-- > 0 && ProfileHistogramBucketValue(i) > fThreshold;)
+	{
+		nSpikes += pHistogram[i];
+	}
+	return nSpikes;
+}
+
+void ProfileHistogramReset()
+{
+	Profile & S = g_Profile;
+	MutexLock lock(ProfileMutex());
+	memset(S.TimerHistogram, 0, sizeof(S.TimerHistogram));
+	memset(S.TimerHistogramCount, 0, sizeof(S.TimerHistogramCount));
+	memset(S.FrameHistogram, 0, sizeof(S.FrameHistogram));
+	S.FrameHistogramCount = 0;
+}
+
+// Publishes the walked frame into the displayed timers and aggregates
+static void ProfileAggregatePublish(const ProfileAggregateJob& Job)
+{
+	Profile & S = g_Profile;
+	ProfileAggregator& A = g_ProfileAggregator;
+	MutexLock lock(ProfileMutex());
+
+	uint32_t nAggregateClear = Job.nAggregateClear, nAggregateFlip = Job.nAggregateFlip;
+	const double fTicksToUs = 1000000.0 / ProfileTicksPerSecondCpu();
+
+	if (Job.bFrame)
+	{
+		uint64_t nFrameStartCpu = S.Frames[Job.nFrameCurrent].nFrameStartCpu;
+		uint64_t nFrameEndCpu = S.Frames[Job.nFrameNext].nFrameStartCpu;
+
+		{
+			uint64_t nTick = nFrameEndCpu - nFrameStartCpu;
+			S.nFlipTicks = nTick;
+			S.nFlipAggregate += nTick;
+			S.nFlipMin = ProfileMin(S.nFlipMin, nTick);
+			S.nFlipMax = ProfileMax(S.nFlipMax, nTick);
+			ProfileHistogramAdd(S.FrameHistogram, &S.FrameHistogramCount, nTick, fTicksToUs);
+		}
+
+		if (Job.bRunning)
+		{
+			uint64_t* pFrameGroup = &S.FrameGroup[0];
 			{
-                PROFILER_SET_CPU_SCOPE("Profile", "Accumulate", 0x3355ee);
+				PROFILER_SET_CPU_SCOPE("Profile", "Accumulate", 0x3355ee);
 				for (uint32_t i = 0; i < S.nTotalTimers; ++i)
 				{
-                    if (S.GroupInfo[S.TimerInfo[i].nGroupIndex].Type == ProfileTokenTypeGpu)
-                    {
-                        continue;
-                    }
-                     
+					if (S.GroupInfo[S.TimerInfo[i].nGroupIndex].Type == ProfileTokenTypeGpu)
+					{
+						continue;
+					}
+
+					S.Frame[i] = A.Frame[i];
+					S.FrameExclusive[i] = A.FrameExclusive[i];
+
 					S.AccumTimers[i].nTicks += S.Frame[i].nTicks;
 					S.AccumTimers[i].nCount += S.Frame[i].nCount;
 					S.AccumMaxTimers[i] = ProfileMax(S.AccumMaxTimers[i], S.Frame[i].nTicks);
 					S.AccumMinTimers[i] = ProfileMin(S.AccumMinTimers[i], S.Frame[i].nTicks);
 					S.AccumTimersExclusive[i] += S.FrameExclusive[i];
 					S.AccumMaxTimersExclusive[i] = ProfileMax(S.AccumMaxTimersExclusive[i], S.FrameExclusive[i]);
+
+					// Only frames the timer ran in, so rarely hit timers do not collapse to a zero median
+					if (S.Frame[i].nCount)
+					{
+						ProfileHistogramAdd(S.TimerHistogram[i], &S.TimerHistogramCount[i], S.Frame[i].nTicks, fTicksToUs);
+					}
 				}
 
+				memcpy(pFrameGroup, &A.FrameGroup[0], sizeof(S.FrameGroup));
 				for (uint32_t i = 0; i < PROFILE_MAX_GROUPS; ++i)
 				{
 					S.AccumGroup[i] += pFrameGroup[i];
 					S.AccumGroupMax[i] = ProfileMax(S.AccumGroupMax[i], pFrameGroup[i]);
 				}
+				for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+				{
+					ProfileThreadLog* pLog = S.Pool[j];
+					if (!pLog)
+						continue;
+					for (uint32_t i = 0; i < PROFILE_MAX_GROUPS; ++i)
+					{
+						pLog->nGroupTicks[i] += A.FrameThreadGroupTicks[j][i];
+					}
+				}
 
 				for (uint32_t j = 0; j < PROFILE_META_MAX; ++j)
 				{
@@ -1316,6 +1406,7 @@ void ProfileFlipCpu()
 					{
 						auto& Meta = S.MetaCounters[j];
 						uint64_t nSum = 0;;
+						memcpy(&Meta.nCounters[0], &A.FrameMetaCounters[j][0], sizeof(Meta.nCounters[0]) * S.nTotalTimers);
 						for (uint32_t i = 0; i < S.nTotalTimers; ++i)
 						{
 							uint64_t nCounter = Meta.nCounters[i];
@@ -1338,15 +1429,13 @@ void ProfileFlipCpu()
 			}
 			S.nGraphPut = (S.nGraphPut + 1) % PROFILE_GRAPH_HISTORY;
 
-		}
-
-
-		if (S.nRunning && S.nAggregateFlip <= ++S.nAggregateFlipCount)
-		{
-			nAggregateFlip = 1;
-			if (S.nAggregateFlip) // if 0 accumulate indefinitely
+			if (S.nAggregateFlip <= ++S.nAggregateFlipCount)
 			{
-				nAggregateClear = 1;
+				nAggregateFlip = 1;
+				if (S.nAggregateFlip) // if 0 accumulate indefinitely
+				{
+					nAggregateClear = 1;
+				}
 			}
 		}
 	}
@@ -1394,14 +1483,10 @@ void ProfileFlipCpu()
 			}
 		}
 
-
-
-
-
 		S.nAggregateFrames = S.nAggregateFlipCount;
 		S.nFlipAggregateDisplay = S.nFlipAggregate;
 		S.nFlipMaxDisplay = S.nFlipMax;
-        S.nFlipMinDisplay = S.nFlipMin;
+		S.nFlipMinDisplay = S.nFlipMin;
 		if (nAggregateClear)
 		{
 			memset(&S.AccumTimers[0], 0, sizeof(S.Aggregate[0]) * S.nTotalTimers);
@@ -1415,7 +1500,7 @@ void ProfileFlipCpu()
 			S.nAggregateFlipCount = 0;
 			S.nFlipAggregate = 0;
 			S.nFlipMax = 0;
-            S.nFlipMin = -1;
+			S.nFlipMin = -1;
 
 			S.nAggregateFlipTick = P_TICK();
 		}
@@ -1435,50 +1520,269 @@ void ProfileFlipCpu()
 		}
 #endif
 	}
-	S.nAggregateClear = 0;
+}
 
-	uint64_t nNewActiveGroup = 0;
-	if (S.nRunning || S.nForceEnable)
-		nNewActiveGroup = S.nAllGroupsWanted ? S.nGroupMask : S.nActiveGroupWanted;
-	nNewActiveGroup |= S.nForceEnableGroup;
-	nNewActiveGroup |= S.nForceGroupUI;
-	nNewActiveGroup &= ~S.nForceDisableGroup;
-	if (S.nActiveGroup != nNewActiveGroup)
-		S.nActiveGroup = nNewActiveGroup;
+static void ProfileAggregateFrame(const ProfileAggregateJob& Job)
+{
+	ProfileAggregateWalk(Job);
+	ProfileAggregatePublish(Job);
+}
 
-	uint32_t nNewActiveBars = 0;
-	if (S.nRunning || S.nForceEnable)
-		nNewActiveBars = S.nBars;
-	if (S.nForceMetaCounters)
+static void ProfileAggregateThreadFunc(void* pData)
+{
+	ProfileAggregator* pAggregator = (ProfileAggregator*)pData;
+	Thread::SetCurrentThreadName("ProfileAggregate");
+	// Create the log up front, timers on this thread must not take ProfileMutex while ProfileAggregateMutex is held
+	ProfileOnThreadCreate("ProfileAggregate");
+
+	for (;;)
 	{
-		for (int i = 0; i < PROFILE_META_MAX; ++i)
+		ProfileAggregateJob Job;
 		{
-			if (S.MetaCounters[i].pName)
-			{
-				nNewActiveBars |= (P_DRAW_META_FIRST << i);
-			}
+			MutexLock lock(pAggregator->mQueueMutex);
+			while (pAggregator->nJobGet == pAggregator->nJobPut && !pAggregator->bStop)
+				pAggregator->mQueueCond.Wait(pAggregator->mQueueMutex);
+			if (pAggregator->nJobGet == pAggregator->nJobPut)
+				break;
+			Job = pAggregator->Jobs[pAggregator->nJobGet % PROFILE_AGGREGATE_MAX_PENDING];
+		}
+
+		ProfileAggregateFrame(Job);
+
+		{
+			MutexLock lock(pAggregator->mQueueMutex);
+			pAggregator->nJobGet++;
+			pAggregator->mQueueCond.WakeAll();
 		}
 	}
-	if (nNewActiveBars != S.nActiveBars)
-		S.nActiveBars = nNewActiveBars;
+
+	ProfileOnThreadExit();
 }
 
-void flipProfiler()
+// Hands the job to the aggregate thread. Must not be called with ProfileMutex held, when the queue is full this waits
+// for the aggregation to catch up instead of dropping frames.
+static void ProfileAggregateSubmit(const ProfileAggregateJob& Job)
 {
-    PROFILER_SET_CPU_SCOPE("Profile", "ProfileFlip", 0x3355ee);
+	ProfileAggregator& A = g_ProfileAggregator;
+	if (!A.bThreadRunning)
+	{
+		ProfileAggregateFrame(Job);
+		return;
+	}
 
-	ProfileFlipCpu();
+	MutexLock lock(A.mQueueMutex);
+	while (A.nJobPut - A.nJobGet >= PROFILE_AGGREGATE_MAX_PENDING)
+		A.mQueueCond.Wait(A.mQueueMutex);
+	A.Jobs[A.nJobPut % PROFILE_AGGREGATE_MAX_PENDING] = Job;
+	A.nJobPut++;
+	A.mQueueCond.WakeAll();
 }
 
-void ProfileSetForceEnable(bool bEnable)
-{
-	Profile & S = g_Profile;
-	S.nForceEnable = bEnable ? 1 : 0;
-}
-bool ProfileGetForceEnable()
+void ProfileAggregateStart()
 {
-	Profile & S = g_Profile;
-	return S.nForceEnable != 0;
+	ProfileAggregator& A = g_ProfileAggregator;
+	if (A.bThreadRunning)
+		return;
+
+	A.mQueueMutex.Init();
+	A.mQueueCond.Init();
+	A.nJobPut = 0;
+	A.nJobGet = 0;
+	A.bStop = false;
+	A.mThreadDesc.pFunc = ProfileAggregateThreadFunc;
+	A.mThreadDesc.pData = &A;
+	A.mThread = create_thread(&A.mThreadDesc);
+	A.bThreadRunning = true;
+}
+
+// Aggregates all queued frames and joins the aggregate thread, later flips aggregate on the calling thread
+void ProfileAggregateStop()
+{
+	ProfileAggregator& A = g_ProfileAggregator;
+	if (!A.bThreadRunning)
+		return;
+
+	{
+		MutexLock lock(A.mQueueMutex);
+		A.bStop = true;
+		A.mQueueCond.WakeAll();
+	}
+	join_thread(A.mThread);
+	A.bThreadRunning = false;
+	A.mQueueCond.Destroy();
+	A.mQueueMutex.Destroy();
+}
+
+// Advances the frame and records where every thread log starts. O(threads), the log walk is left to the aggregation.
+static void ProfileFlipFrame(ProfileAggregateJob* pJob)
+{
+	MutexLock lock(ProfileMutex());
+
+	Profile & S = g_Profile;
+
+	if (S.nToggleRunning)
+	{
+		S.nRunning = !S.nRunning;
+		if (!S.nRunning)
+			S.nPauseTicks = P_TICK();
+		S.nToggleRunning = 0;
+		pJob->bResetStacks = 1;
+	}
+	uint32_t nAggregateClear = S.nAggregateClear || S.nAutoClearFrames, nAggregateFlip = 0;
+	if (S.nDumpFileNextFrame)
+	{
+		ProfileDumpToFile(nullptr);
+		S.nDumpFileNextFrame = 0;
+		S.nAutoClearFrames = PROFILE_GPU_FRAME_DELAY + 3; //hide spike from dumping webpage
+	}
+
+	if (S.nAutoClearFrames)
+	{
+		nAggregateClear = 1;
+		nAggregateFlip = 1;
+		S.nAutoClearFrames -= 1;
+	}
+
+
+	if (S.nRunning || S.nForceEnable)
+	{
+		S.nFramePutIndex++;
+		S.nFramePut = (S.nFramePut + 1) % PROFILE_MAX_FRAME_HISTORY;
+		P_ASSERT((S.nFramePutIndex % PROFILE_MAX_FRAME_HISTORY) == S.nFramePut);
+		S.nFrameCurrent = (S.nFramePut + PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 1) % PROFILE_MAX_FRAME_HISTORY;
+		S.nFrameCurrentIndex++;
+		uint32_t nFrameNext = (S.nFrameCurrent + 1) % PROFILE_MAX_FRAME_HISTORY;
+
+		uint32_t nContextSwitchPut = S.nContextSwitchPut;
+		if (S.nContextSwitchLastPut < nContextSwitchPut)
+		{
+			S.nContextSwitchUsage = (nContextSwitchPut - S.nContextSwitchLastPut);
+		}
+		else
+		{
+			S.nContextSwitchUsage = PROFILE_CONTEXT_SWITCH_BUFFER_SIZE - S.nContextSwitchLastPut + nContextSwitchPut;
+		}
+		S.nContextSwitchLastPut = nContextSwitchPut;
+
+		ProfileFrameState* pFramePut = &S.Frames[S.nFramePut];
+
+		pFramePut->nFrameStartCpu = P_TICK();
+        memset(&pFramePut->nFrameStartGpu[0], 0, PROFILE_MAX_THREADS * sizeof(pFramePut->nFrameStartGpu[0]));
+
+		for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
+		{
+			ProfileThreadLog* pLog = S.Pool[i];
+			if (!pLog)
+			{
+				pFramePut->nLogStart[i] = 0;
+			}
+			else
+			{
+				uint32_t nPut = tfrg_atomic32_load_acquire(&pLog->nPut);
+				pFramePut->nLogStart[i] = nPut;
+				P_ASSERT(nPut < PROFILE_BUFFER_SIZE);
+                if (pLog->nGpu && pLog->Log && pFramePut->nFrameStartGpu[i] == 0)
+                {
+                    uint32_t nPreviousPos = (nPut - 1) % PROFILE_BUFFER_SIZE;
+                    pFramePut->nFrameStartGpu[i] = ProfileLogGetTick(pLog->Log[nPreviousPos]);
+                }
+			}
+		}
+
+		pJob->bFrame = 1;
+		pJob->bRunning = S.nRunning;
+		pJob->nFrameCurrent = S.nFrameCurrent;
+		pJob->nFrameNext = nFrameNext;
+	}
+	pJob->nAggregateClear = nAggregateClear;
+	pJob->nAggregateFlip = nAggregateFlip;
+	S.nAggregateClear = 0;
+
+	uint64_t nNewActiveGroup = 0;
+	if (S.nRunning || S.nForceEnable)
+		nNewActiveGroup = S.nAllGroupsWanted ? S.nGroupMask : S.nActiveGroupWanted;
+	nNewActiveGroup |= S.nForceEnableGroup;
+	nNewActiveGroup |= S.nForceGroupUI;
+	nNewActiveGroup &= ~S.nForceDisableGroup;
+	if (S.nActiveGroup != nNewActiveGroup)
+		S.nActiveGroup = nNewActiveGroup;
+
+	uint32_t nNewActiveBars = 0;
+	if (S.nRunning || S.nForceEnable)
+		nNewActiveBars = S.nBars;
+	if (S.nForceMetaCounters)
+	{
+		for (int i = 0; i < PROFILE_META_MAX; ++i)
+		{
+			if (S.MetaCounters[i].pName)
+			{
+				nNewActiveBars |= (P_DRAW_META_FIRST << i);
+			}
+		}
+	}
+	if (nNewActiveBars != S.nActiveBars)
+		S.nActiveBars = nNewActiveBars;
+}
+
+void ProfileFlipCpu()
+{
+	ProfileAggregateJob Job = {};
+	ProfileFlipFrame(&Job);
+	ProfileAggregateSubmit(Job);
+}
+
+#if defined(USE_MEMORY_TRACKING)
+// Publishes the live bytes/allocations of every memory tag as "memory/<tag>/..." counters
+static void ProfileUpdateMemoryCounters()
+{
+	static ProfileToken gMemoryBytesCounters[MEMORY_TAG_COUNT];
+	static ProfileToken gMemoryCountCounters[MEMORY_TAG_COUNT];
+	static bool gMemoryCountersInitialized = false;
+
+	if (!gMemoryCountersInitialized)
+	{
+		char name[PROFILE_NAME_MAX_LEN];
+		for (uint32_t i = 0; i < MEMORY_TAG_COUNT; ++i)
+		{
+			snprintf(name, sizeof(name), "memory/%s/bytes", memGetTagName((MemoryTag)i));
+			ProfileCounterConfig(name, PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+			gMemoryBytesCounters[i] = ProfileGetCounterToken(name);
+			snprintf(name, sizeof(name), "memory/%s/allocations", memGetTagName((MemoryTag)i));
+			gMemoryCountCounters[i] = ProfileGetCounterToken(name);
+		}
+		gMemoryCountersInitialized = true;
+	}
+
+	MemoryStats stats = {};
+	memGetStats(&stats);
+	for (uint32_t i = 0; i < MEMORY_TAG_COUNT; ++i)
+	{
+		ProfileCounterSet(gMemoryBytesCounters[i], stats.mTags[i].mLiveBytes);
+		ProfileCounterSet(gMemoryCountCounters[i], stats.mTags[i].mLiveCount);
+	}
+}
+#endif
+
+void flipProfiler()
+{
+    PROFILER_SET_CPU_SCOPE("Profile", "ProfileFlip", 0x3355ee);
+
+#if defined(USE_MEMORY_TRACKING)
+	ProfileUpdateMemoryCounters();
+#endif
+
+	ProfileFlipCpu();
+}
+
+void ProfileSetForceEnable(bool bEnable)
+{
+	Profile & S = g_Profile;
+	S.nForceEnable = bEnable ? 1 : 0;
+}
+bool ProfileGetForceEnable()
+{
+	Profile & S = g_Profile;
+	return S.nForceEnable != 0;
 }
 
 void ProfileSetEnableAllGroups(bool bEnableAllGroups)
@@ -1715,6 +2019,47 @@ float getCpuProfileTime(const char* pGroup, const char* pName, ThreadID* pThread
 	return S.Frame[nTimerIndex].nTicks * fToMs;
 }
 
+float getCpuProfilePercentileTime(const char* pGroup, const char* pName, float fPercentile, ThreadID* pThreadID)
+{
+	ProfileToken nToken = ProfileFindToken(pGroup, pName, pThreadID);
+	if (nToken == PROFILE_INVALID_TOKEN)
+	{
+		return 0.f;
+	}
+	Profile & S = g_Profile;
+	uint32_t nTimerIndex = ProfileGetTimerIndex(nToken);
+	return ProfileHistogramPercentile(S.TimerHistogram[nTimerIndex], S.TimerHistogramCount[nTimerIndex], fPercentile);
+}
+
+uint32_t getCpuProfileSpikeCount(const char* pGroup, const char* pName, ThreadID* pThreadID)
+{
+	ProfileToken nToken = ProfileFindToken(pGroup, pName, pThreadID);
+	if (nToken == PROFILE_INVALID_TOKEN)
+	{
+		return 0;
+	}
+	Profile & S = g_Profile;
+	uint32_t nTimerIndex = ProfileGetTimerIndex(nToken);
+	return ProfileHistogramSpikes(S.TimerHistogram[nTimerIndex], S.TimerHistogramCount[nTimerIndex]);
+}
+
+float getCpuPercentileFrameTime(float fPercentile)
+{
+	Profile & S = g_Profile;
+	return ProfileHistogramPercentile(S.FrameHistogram, S.FrameHistogramCount, fPercentile);
+}
+
+uint32_t getCpuFrameSpikeCount()
+{
+	Profile & S = g_Profile;
+	return ProfileHistogramSpikes(S.FrameHistogram, S.FrameHistogramCount);
+}
+
+void resetProfileHistograms()
+{
+	ProfileHistogramReset();
+}
+
 float getCpuMinFrameTime()
 {
     float fToMs = ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu());
@@ -2087,7 +2432,9 @@ void ProfileDumpHtml(ProfileWriteCallback CB, void* Handle, int nMaxFrames, cons
 
 		uint32_t nColor = S.TimerInfo[i].nColor;
 		uint32_t nColorDark = (nColor >> 1) & ~0x80808080;
-		ProfilePrintf(CB, Handle, "TimerInfo[%d] = MakeTimer(%d, \"%s\", %d, '#%06x','#%06x', %f, %f, %f, %f, %f, %f, %d, %f,\n",
+		const uint32_t* pHistogram = S.TimerHistogram[i];
+		uint32_t nHistogramCount = S.TimerHistogramCount[i];
+		ProfilePrintf(CB, Handle, "TimerInfo[%d] = MakeTimer(%d, \"%s\", %d, '#%06x','#%06x', %f, %f, %f, %f, %f, %f, %d, %f, %f, %f, %f, %f, %d,\n",
 			S.TimerInfo[i].nTimerIndex, S.TimerInfo[i].nTimerIndex, S.TimerInfo[i].pName, S.TimerInfo[i].nGroupIndex,
 			((PROFILE_UNPACK_RED(nColor) & 0xff) << 16) | ((PROFILE_UNPACK_GREEN(nColor) & 0xff) << 8) | (PROFILE_UNPACK_BLUE(nColor) & 0xff),
 			((PROFILE_UNPACK_RED(nColorDark) & 0xff) << 16) | ((PROFILE_UNPACK_GREEN(nColorDark) & 0xff) << 8) | (PROFILE_UNPACK_BLUE(nColorDark) & 0xff),
@@ -2098,7 +2445,12 @@ void ProfileDumpHtml(ProfileWriteCallback CB, void* Handle, int nMaxFrames, cons
 			pMaxExclusive[nIdx],
 			pCallAverage[nIdx],
 			S.Aggregate[i].nCount,
-			pTotal[nIdx]);
+			pTotal[nIdx],
+			ProfileHistogramPercentile(pHistogram, nHistogramCount, 50.f),
+			ProfileHistogramPercentile(pHistogram, nHistogramCount, 90.f),
+			ProfileHistogramPercentile(pHistogram, nHistogramCount, 99.f),
+			ProfileHistogramPercentile(pHistogram, nHistogramCount, 99.9f),
+			ProfileHistogramSpikes(pHistogram, nHistogramCount));
 
 		ProfilePrintString(CB, Handle, "\t[");
 		for (int j = 0; j < PROFILE_META_MAX; ++j)
@@ -2137,12 +2489,13 @@ void ProfileDumpHtml(ProfileWriteCallback CB, void* Handle, int nMaxFrames, cons
 	ProfilePrintString(CB, Handle, "];\n\n");
 
 
+	// Keys into the context switch data, 0 (no bars) for gpu logs
 	ProfilePrintString(CB, Handle, "\nvar ThreadIds = [");
 	for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
 	{
 		if (!S.Pool[i])
 			continue;
-		ProfilePrintUIntComma(CB, Handle, i);
+		ProfilePrintUIntComma(CB, Handle, S.Pool[i]->nGpu ? 0 : (uint64_t)S.Pool[i]->nSystemThreadId);
 	}
 	ProfilePrintString(CB, Handle, "];\n\n");
 
@@ -2430,8 +2783,8 @@ void ProfileDumpHtml(ProfileWriteCallback CB, void* Handle, int nMaxFrames, cons
 	{
 		ProfileContextSwitch CS = S.ContextSwitch[j];
 		int nCpu = CS.nCpu;
-		ProfilePrintUIntComma(CB, Handle, 0);
-		ProfilePrintUIntComma(CB, Handle, 0);
+		ProfilePrintUIntComma(CB, Handle, (uint64_t)CS.nThreadIn);
+		ProfilePrintUIntComma(CB, Handle, (uint64_t)CS.nThreadOut);
 		ProfilePrintUIntComma(CB, Handle, nCpu);
 	}
 	ProfilePrintString(CB, Handle, "];\n");
@@ -2457,7 +2810,15 @@ void ProfileDumpHtml(ProfileWriteCallback CB, void* Handle, int nMaxFrames, cons
 		char Name[256];
 		const char* pProcessName = ProfileGetProcessName(Threads[i].nProcessId, Name, sizeof(Name));
 
-		const char* p1 = i < nNumThreadsBase && S.Pool[i] ? S.Pool[i]->ThreadName : "?";
+		const char* p1 = "?";
+		for (uint32_t j = 0; i < nNumThreadsBase && j < PROFILE_MAX_THREADS; ++j)
+		{
+			if (S.Pool[j] && !S.Pool[j]->nGpu && S.Pool[j]->nSystemThreadId == Threads[i].nThreadId)
+			{
+				p1 = S.Pool[j]->ThreadName;
+				break;
+			}
+		}
 		const char* p2 = pProcessName ? pProcessName : "?";
 
 		ProfilePrintf(CB, Handle, "%lld:{\'tid\':%lld,\'pid\':%lld,\'t\':\'%s\',\'p\':\'%s\'},",
@@ -2582,125 +2943,851 @@ void dumpProfileData(Renderer* pRenderer, const char* appName, uint32_t nMaxFram
     }
 }
 
-void dumpBenchmarkData(Renderer* pRenderer, IApp::Settings* pSettings, const char* appName)
-{
-    //time_t t = time(0);
-    //eastl::string tempName = eastl::string().sprintf("%s", appName) + eastl::string(R"(Benchmark-%Y-%m-%d-%H.%M.%S.txt)");
-    //char name[128] = {};
-    //strftime(name, sizeof(name), tempName.c_str(), localtime(&t));
-    //FileStream* statsFile = fsOpenFile(RD_LOG, name, FM_WRITE);
-    //if (statsFile)
-    //{
-    //    fsPrintToStream(statsFile, "{\n");
-
-    //    fsPrintToStream(statsFile, "\"Application\": \"%s\", \n", pRenderer->pName);
-    //    fsPrintToStream(statsFile, "\"Width\": %d, \n", pSettings->mWidth);
-    //    fsPrintToStream(statsFile, "\"Height\": %d, \n\n", pSettings->mHeight);
-    //    fsPrintToStream(statsFile, "\"GpuName\": \"%s\", \n", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mGpuName);
-    //    fsPrintToStream(statsFile, "\"VendorID\": \"%s\", \n", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mVendorId);
-    //    fsPrintToStream(statsFile, "\"ModelID\": \"%s\", \n\n", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mModelId);
-    //    const Profile& S = *ProfileGet();
-    //    for (uint32_t groupIndex = 0; groupIndex < S.nGroupCount; ++groupIndex)
-    //    {
-    //        if (S.GroupInfo[groupIndex].Type != ProfileTokenTypeGpu)
-    //            continue;
-
-    //        for (uint32_t timerIndex = 0; timerIndex < S.nTotalTimers; ++timerIndex)
-    //        {
-    //            if (strcmp(S.TimerInfo[timerIndex].pName, S.GroupInfo[groupIndex].pName) == 0)
-    //            {
-    //                fsPrintToStream(statsFile, "\"%s\": { \n", S.GroupInfo[groupIndex].pName);
-    //                float fToMs = ProfileTickToMsMultiplier(getGpuProfileTicksPerSecond(S.GroupInfo[groupIndex].nGpuProfileToken));
-    //                uint32_t nAggregateFrames = S.nAggregateFrames ? S.nAggregateFrames : 1;
-    //                uint32_t nAggregateCount = S.Aggregate[timerIndex].nCount ? S.Aggregate[timerIndex].nCount : 1;
-    //                float fAverage = fToMs * (S.Aggregate[timerIndex].nTicks / nAggregateFrames);
-    //                float fMax = fToMs * (S.AggregateMax[timerIndex]);
-    //                float fMin = fToMs * (S.AggregateMin[timerIndex]);
-    //                fsPrintToStream(statsFile, "\"Average\": %0.4f, \n", fAverage);
-    //                fsPrintToStream(statsFile, "\"Min\": %0.4f, \n", fMin);
-    //                fsPrintToStream(statsFile, "\"Max\": %0.4f, \n", fMax);
-    //                fsPrintToStream(statsFile, "\"Frames\": %d \n", nAggregateCount);
-    //                fsPrintToStream(statsFile, "}, \n\n");
-    //                break;
-    //            }
-    //        }
-    //    }
-    //    fsPrintToStream(statsFile, "\"Cpu\": { \n");
-    //    fsPrintToStream(statsFile, "\"Average\": %0.4f, \n", getCpuAvgFrameTime());
-    //    fsPrintToStream(statsFile, "\"Min\": %0.4f, \n", getCpuMinFrameTime());
-    //    fsPrintToStream(statsFile, "\"Max\": %0.4f, \n", getCpuMaxFrameTime());
-    //    fsPrintToStream(statsFile, "\"Frames\": %d \n", S.nAggregateFrames);
-    //    fsPrintToStream(statsFile, "} \n");
-    //    fsPrintToStream(statsFile, "}");
-
-    //    fsCloseStream(statsFile);
-    //}
-}
-
-#if PROFILE_WEBSERVER
-uint32_t ProfileWebServerPort()
+// Json string contents, names come from user code
+static void ProfilePrintJsonString(ProfileWriteCallback CB, void* Handle, const char* pString)
 {
-	Profile & S = g_Profile;
-	return S.nWebServerPort;
+	char Buffer[2 * PROFILE_NAME_MAX_LEN + 8];
+	uint32_t nLength = 0;
+	Buffer[nLength++] = '"';
+	for (const char* p = pString; *p && nLength < sizeof(Buffer) - 4; ++p)
+	{
+		char c = *p;
+		if (c == '"' || c == '\\')
+		{
+			Buffer[nLength++] = '\\';
+			Buffer[nLength++] = c;
+		}
+		else if ((unsigned char)c >= 0x20)
+		{
+			Buffer[nLength++] = c;
+		}
+	}
+	Buffer[nLength++] = '"';
+	CB(Handle, nLength, Buffer);
 }
 
-void ProfileSendSocket(MpSocket Socket, const char* pData, size_t nSize)
+static float ProfilePercentile(const uint64_t* pSorted, uint32_t nCount, float fPercentile)
 {
-#ifdef MSG_NOSIGNAL
-	int nFlags = MSG_NOSIGNAL;
-#else
-	int nFlags = 0;
-#endif
-
-	send(Socket, pData, (int)nSize, nFlags);
+	if (!nCount)
+		return 0.f;
+	uint32_t nIndex = (uint32_t)(fPercentile * 0.01f * (nCount - 1) + 0.5f);
+	return (float)pSorted[ProfileMin(nIndex, nCount - 1)];
 }
 
-void ProfileFlushSocket(MpSocket Socket)
+// Writes the aggregated stats as json. Field names ending in Ms or Bytes are lower-is-better metrics, PerSecond higher-is-better,
+// which is what Tools/BenchmarkCompare uses to flag regressions between two reports.
+void ProfileDumpBenchmark(ProfileWriteCallback CB, void* Handle, Renderer* pRenderer, IApp::Settings* pSettings, const char* pAppName)
 {
 	Profile & S = g_Profile;
-	if (S.nWebServerPut)
+	uint32_t nAggregateFrames = S.nAggregateFrames ? S.nAggregateFrames : 1;
+	float fToMsCpu = ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu());
+
+	ProfilePrintString(CB, Handle, "{\n\"application\": ");
+	ProfilePrintJsonString(CB, Handle, pAppName);
+	if (pSettings)
 	{
-		ProfileSendSocket(Socket, &S.WebServerBuffer[0], S.nWebServerPut);
-		S.nWebServerPut = 0;
+		ProfilePrintf(CB, Handle, ",\n\"width\": %d,\n\"height\": %d", pSettings->mWidth, pSettings->mHeight);
 	}
-}
+	if (pRenderer && pRenderer->pActiveGpuSettings)
+	{
+		const GPUVendorPreset& Preset = pRenderer->pActiveGpuSettings->mGpuVendorPreset;
+		ProfilePrintString(CB, Handle, ",\n\"gpu\": { \"name\": ");
+		ProfilePrintJsonString(CB, Handle, Preset.mGpuName);
+		ProfilePrintString(CB, Handle, ", \"vendorId\": ");
+		ProfilePrintJsonString(CB, Handle, Preset.mVendorId);
+		ProfilePrintString(CB, Handle, ", \"modelId\": ");
+		ProfilePrintJsonString(CB, Handle, Preset.mModelId);
+		ProfilePrintString(CB, Handle, ", \"driver\": ");
+		ProfilePrintJsonString(CB, Handle, Preset.mGpuDriverVersion);
+		ProfilePrintString(CB, Handle, " }");
+	}
+	ProfilePrintf(CB, Handle, ",\n\"frames\": %u", nAggregateFrames);
 
-void ProfileWriteSocket(void* Handle, size_t nSize, const char* pData)
-{
-	Profile & S = g_Profile;
-	MpSocket Socket = *(MpSocket*)Handle;
-	if (nSize > PROFILE_WEBSERVER_SOCKET_BUFFER_SIZE / 2)
+	// Frame times of the whole recorded history, the aggregate only has average/min/max
 	{
-		ProfileFlushSocket(Socket);
-		ProfileSendSocket(Socket, pData, nSize);
+		const uint32_t nMaxCount = PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 3;
+		// nFrameCurrentIndex lags the flip by the gpu delay, frames before the first flip have no duration
+		const uint64_t nRecorded = S.nFrameCurrentIndex > PROFILE_GPU_FRAME_DELAY + 1 ? S.nFrameCurrentIndex - PROFILE_GPU_FRAME_DELAY - 1 : 0;
+		const uint32_t nCount = (uint32_t)ProfileMin((uint64_t)nMaxCount, nRecorded);
+		const uint32_t nStart = S.nFrameCurrent;
+		uint64_t* pFrameTicks = (uint64_t*)tf_malloc(sizeof(uint64_t) * nMaxCount);
+		uint64_t nTotal = 0;
+		for (uint32_t i = 0; i < nCount; ++i)
+		{
+			uint32_t nFrame = (nStart + PROFILE_MAX_FRAME_HISTORY - nCount + i) % PROFILE_MAX_FRAME_HISTORY;
+			uint32_t nFrameNext = (nFrame + 1) % PROFILE_MAX_FRAME_HISTORY;
+			pFrameTicks[i] = S.Frames[nFrameNext].nFrameStartCpu - S.Frames[nFrame].nFrameStartCpu;
+			nTotal += pFrameTicks[i];
+		}
+		eastl::sort(pFrameTicks, pFrameTicks + nCount);
+
+		const float fMedian = ProfilePercentile(pFrameTicks, nCount, 50.f);
+		uint32_t nSpikes = 0;
+		while (nSpikes < nCount && pFrameTicks[nCount - 1 - nSpikes] > fMedian * PROFILE_HISTOGRAM_SPIKE_FACTOR)
+			++nSpikes;
+
+		ProfilePrintf(CB, Handle, ",\n\"cpuFrame\": { \"sampleCount\": %u, \"averageMs\": %.4f, \"minMs\": %.4f, \"maxMs\": %.4f, \"p50Ms\": %.4f, \"p90Ms\": %.4f, \"p99Ms\": %.4f, \"p999Ms\": %.4f, \"spikes\": %u }",
+			nCount,
+			nCount ? fToMsCpu * nTotal / nCount : 0.f,
+			nCount ? fToMsCpu * pFrameTicks[0] : 0.f,
+			nCount ? fToMsCpu * pFrameTicks[nCount - 1] : 0.f,
+			fToMsCpu * fMedian,
+			fToMsCpu * ProfilePercentile(pFrameTicks, nCount, 90.f),
+			fToMsCpu * ProfilePercentile(pFrameTicks, nCount, 99.f),
+			fToMsCpu * ProfilePercentile(pFrameTicks, nCount, 99.9f),
+			nSpikes);
+		tf_free(pFrameTicks);
 	}
-	else
+
+	// Keyed by "group/name", timers with the same name on several threads get the timer index appended
+	ProfilePrintString(CB, Handle, ",\n\"timers\": {");
+	for (uint32_t i = 0; i < S.nTotalTimers; ++i)
 	{
-		memcpy(&S.WebServerBuffer[S.nWebServerPut], pData, nSize);
-		S.nWebServerPut += (uint32_t)nSize;
-		if (S.nWebServerPut > PROFILE_WEBSERVER_SOCKET_BUFFER_SIZE / 2)
+		const ProfileTimerInfo& Timer = S.TimerInfo[i];
+		const ProfileGroupInfo& Group = S.GroupInfo[Timer.nGroupIndex];
+		const bool bGpu = Group.Type == ProfileTokenTypeGpu;
+		const float fToMs = bGpu ? ProfileTickToMsMultiplier(getGpuProfileTicksPerSecond(Group.nGpuProfileToken)) : fToMsCpu;
+
+		bool bDuplicate = false;
+		for (uint32_t j = 0; j < i && !bDuplicate; ++j)
 		{
-			ProfileFlushSocket(Socket);
+			bDuplicate = S.TimerInfo[j].nGroupIndex == Timer.nGroupIndex && !strcmp(S.TimerInfo[j].pName, Timer.pName);
+		}
+		char Key[2 * PROFILE_NAME_MAX_LEN + 16];
+		if (bDuplicate)
+			snprintf(Key, sizeof(Key), "%s/%s#%u", Group.pName, Timer.pName, i);
+		else
+			snprintf(Key, sizeof(Key), "%s/%s", Group.pName, Timer.pName);
+
+		ProfilePrintString(CB, Handle, i ? ",\n\t" : "\n\t");
+		ProfilePrintJsonString(CB, Handle, Key);
+		ProfilePrintf(CB, Handle, ": { \"type\": \"%s\", \"averageMs\": %.4f, \"minMs\": %.4f, \"maxMs\": %.4f, \"exclusiveAverageMs\": %.4f, \"exclusiveMaxMs\": %.4f, \"callsPerFrame\": %.2f",
+			bGpu ? "gpu" : "cpu",
+			fToMs * (S.Aggregate[i].nTicks / nAggregateFrames),
+			fToMs * (S.AggregateMin[i] != uint64_t(-1) ? S.AggregateMin[i] : 0),
+			fToMs * S.AggregateMax[i],
+			fToMs * (S.AggregateExclusive[i] / nAggregateFrames),
+			fToMs * S.AggregateMaxExclusive[i],
+			(float)S.Aggregate[i].nCount / nAggregateFrames);
+		// Session histograms only exist for cpu timers
+		const uint32_t* pHistogram = S.TimerHistogram[i];
+		const uint32_t nHistogramCount = S.TimerHistogramCount[i];
+		if (nHistogramCount)
+		{
+			ProfilePrintf(CB, Handle, ", \"sampleCount\": %u, \"p50Ms\": %.4f, \"p90Ms\": %.4f, \"p99Ms\": %.4f, \"p999Ms\": %.4f, \"spikes\": %u",
+				nHistogramCount,
+				ProfileHistogramPercentile(pHistogram, nHistogramCount, 50.f),
+				ProfileHistogramPercentile(pHistogram, nHistogramCount, 90.f),
+				ProfileHistogramPercentile(pHistogram, nHistogramCount, 99.f),
+				ProfileHistogramPercentile(pHistogram, nHistogramCount, 99.9f),
+				ProfileHistogramSpikes(pHistogram, nHistogramCount));
 		}
+		ProfilePrintString(CB, Handle, " }");
 	}
+	ProfilePrintString(CB, Handle, "\n}");
 
-	S.nWebServerDataSent += nSize;
-}
+	// Current values, byte counters get a Bytes suffix so they are compared as lower-is-better
+	ProfilePrintString(CB, Handle, ",\n\"counters\": {");
+	bool bFirstCounter = true;
+	for (uint32_t i = 0; i < S.nNumCounters; ++i)
+	{
+		if (0 == (S.CounterInfo[i].nFlags & PROFILE_COUNTER_FLAG_LEAF))
+			continue;
+		const char* pName = ProfileCounterFullName((int)i);
+		size_t nNameLen = strlen(pName);
+		bool bBytesSuffix = nNameLen >= 5 && !P_STRCASECMP(pName + nNameLen - 5, "bytes");
+		char Key[1024 + 8];
+		snprintf(Key, sizeof(Key), "%s%s", pName, S.CounterInfo[i].eFormat == PROFILE_COUNTER_FORMAT_BYTES && !bBytesSuffix ? "Bytes" : "");
+		ProfilePrintString(CB, Handle, bFirstCounter ? "\n\t" : ",\n\t");
+		ProfilePrintJsonString(CB, Handle, Key);
+		ProfilePrintf(CB, Handle, ": %lld", (long long)tfrg_atomic64_load_relaxed(&S.Counters[i]));
+		bFirstCounter = false;
+	}
+	ProfilePrintString(CB, Handle, "\n}");
 
-#if PROFILE_MINIZ
-#ifndef PROFILE_COMPRESS_BUFFER_SIZE
-#define PROFILE_COMPRESS_BUFFER_SIZE (256<<10)
+#if defined(USE_MEMORY_TRACKING)
+	MemoryStats Stats = {};
+	memGetStats(&Stats);
+	ProfilePrintString(CB, Handle, ",\n\"memory\": {");
+	for (uint32_t i = 0; i < MEMORY_TAG_COUNT; ++i)
+	{
+		const MemoryTagStats& Tag = Stats.mTags[i];
+		ProfilePrintString(CB, Handle, i ? ",\n\t" : "\n\t");
+		ProfilePrintJsonString(CB, Handle, memGetTagName((MemoryTag)i));
+		ProfilePrintf(CB, Handle, ": { \"liveBytes\": %lld, \"liveCount\": %lld, \"totalBytes\": %lld, \"totalCount\": %lld }",
+			(long long)Tag.mLiveBytes, (long long)Tag.mLiveCount, (long long)Tag.mTotalBytes, (long long)Tag.mTotalCount);
+	}
+	ProfilePrintString(CB, Handle, "\n}");
 #endif
 
-#define PROFILE_COMPRESS_CHUNK (PROFILE_COMPRESS_BUFFER_SIZE/2)
-struct ProfileCompressedSocketState
+	ProfilePrintString(CB, Handle, "\n}\n");
+}
+
+void dumpBenchmarkData(Renderer* pRenderer, IApp::Settings* pSettings, const char* appName)
 {
-	unsigned char DeflateOut[PROFILE_COMPRESS_CHUNK];
-	unsigned char DeflateIn[PROFILE_COMPRESS_CHUNK];
-	mz_stream Stream;
-	MpSocket Socket;
-	uint32_t nSize;
-	uint32_t nCompressedSize;
+    MutexLock lock(ProfileMutex());
+    time_t t = time(0);
+    eastl::string tempName = eastl::string().sprintf("%s", appName) + eastl::string(R"(Benchmark-%Y-%m-%d-%H.%M.%S.json)");
+    char name[128] = {};
+    strftime(name, sizeof(name), tempName.c_str(), localtime(&t));
+	FileStream fh = {};
+    if (fsOpenStreamFromPath(RD_LOG, name, FM_WRITE, &fh))
+    {
+        ProfileDumpBenchmark(ProfileWriteFile, &fh, pRenderer, pSettings, appName);
+        fsCloseStream(&fh);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Streaming capture
+//////////////////////////////////////////////////////////////////////////
+// Every completed frame is copied out of the thread logs into fixed size chunks during the flip and a background thread
+// turns the chunks into Chrome trace events (chrome://tracing, ui.perfetto.dev). Memory is bounded by the chunk pool,
+// frames that don't fit while the writer is behind are dropped and reported in the trace.
+
+#define PROFILE_CAPTURE_CHUNK_SIZE (256 * 1024)
+// Hand a partially filled chunk to the writer after this long so the file keeps up with the capture
+#define PROFILE_CAPTURE_FLUSH_MS 500.f
+#define PROFILE_CAPTURE_MAX_LABEL 255
+#define PROFILE_CAPTURE_WRITE_BUFFER_SIZE (64 * 1024)
+
+struct ProfileCaptureChunk
+{
+	ProfileCaptureChunk* pNext;
+	int64_t nFirstFrameTick;
+	uint32_t nSize;
+	DEFINE_ALIGNED(uint8_t Data[PROFILE_CAPTURE_CHUNK_SIZE], 8);
+};
+
+struct ProfileCaptureFrame
+{
+	uint64_t nFrameIndex;
+	int64_t nFrameStartCpu;
+	int64_t nFrameEndCpu;
+	uint32_t nNumThreads;
+	uint32_t nDroppedFrames;
+};
+
+// Followed by nNumEntries log entries and nLabelBytes of label strings, labels in the log point into those
+struct ProfileCaptureThread
+{
+	uint32_t nThreadIndex;
+	uint32_t nGpu;
+	uint32_t nNumEntries;
+	uint32_t nLabelBytes;
+	int64_t nFrameStartGpu;
+	uint64_t nTicksPerSecondGpu;
+	char ThreadName[ProfileThreadLog::THREAD_MAX_LEN];
+};
+
+struct ProfileCapture
+{
+	Mutex mMutex;
+	ConditionVariable mCond;
+	ThreadDesc mThreadDesc;
+	ThreadHandle mThread;
+	FileStream mFile;
+	bool bStop;
+
+	ProfileCaptureChunk* pChunks;
+	uint32_t nNumChunks;
+	// Guarded by mMutex
+	ProfileCaptureChunk* pFree;
+	ProfileCaptureChunk* pQueueHead;
+	ProfileCaptureChunk* pQueueTail;
+
+	// Producer state, guarded by ProfileAggregateMutex
+	ProfileCaptureChunk* pCurrent;
+	uint32_t nDroppedFrames;
+	uint64_t nTotalDroppedFrames;
+	uint64_t nFrameIndex;
+
+	// Writer state
+	int64_t nTickBase;
+	bool bFirstEvent;
+	uint32_t nWriteBufferSize;
+	char WriteBuffer[PROFILE_CAPTURE_WRITE_BUFFER_SIZE];
+	char ThreadNames[PROFILE_MAX_THREADS][ProfileThreadLog::THREAD_MAX_LEN];
+	uint32_t nStackPos[PROFILE_MAX_THREADS];
+	int64_t StackTicks[PROFILE_MAX_THREADS][PROFILE_STACK_MAX];
+	uint32_t StackTimers[PROFILE_MAX_THREADS][PROFILE_STACK_MAX];
+};
+
+static ProfileCapture* g_pProfileCapture = NULL;
+
+static ProfileCaptureChunk* ProfileCaptureAcquireChunk(ProfileCapture* pCapture)
+{
+	MutexLock lock(pCapture->mMutex);
+	ProfileCaptureChunk* pChunk = pCapture->pFree;
+	if (pChunk)
+	{
+		pCapture->pFree = pChunk->pNext;
+		pChunk->pNext = NULL;
+		pChunk->nSize = 0;
+	}
+	return pChunk;
+}
+
+static void ProfileCaptureSubmitChunk(ProfileCapture* pCapture, ProfileCaptureChunk* pChunk)
+{
+	MutexLock lock(pCapture->mMutex);
+	if (pCapture->pQueueTail)
+		pCapture->pQueueTail->pNext = pChunk;
+	else
+		pCapture->pQueueHead = pChunk;
+	pCapture->pQueueTail = pChunk;
+	pCapture->mCond.WakeOne();
+}
+
+// Bytes the copy of the label of LE takes in a capture chunk, 0 for entries that are not labels
+static uint32_t ProfileCaptureLabelBytes(ProfileLogEntry LE)
+{
+	uint64_t nType = ProfileLogType(LE);
+	if (nType != P_LOG_LABEL && nType != P_LOG_LABEL_LITERAL)
+		return 0;
+	const char* pLabel = ProfileGetLabel((uint32_t)nType, ProfileLogGetTick(LE));
+	size_t nLength = pLabel ? strlen(pLabel) : 0;
+	return (uint32_t)(nLength > PROFILE_CAPTURE_MAX_LABEL ? PROFILE_CAPTURE_MAX_LABEL : nLength) + 1;
+}
+
+// Copies one frame of all thread logs into the chunk, returns false if it doesn't fit.
+// With bTruncate the frame is cut at the end of the chunk instead, only fails if not even the frame header fits.
+static bool ProfileCaptureCopyFrame(ProfileCapture* pCapture, ProfileCaptureChunk* pChunk, ProfileFrameState* pFrameCurrent, ProfileFrameState* pFrameNext, bool bTruncate)
+{
+	Profile & S = g_Profile;
+	uint32_t nSize = pChunk->nSize;
+	if (nSize + sizeof(ProfileCaptureFrame) > PROFILE_CAPTURE_CHUNK_SIZE)
+		return false;
+
+	ProfileCaptureFrame* pFrame = (ProfileCaptureFrame*)(pChunk->Data + nSize);
+	pFrame->nFrameIndex = pCapture->nFrameIndex;
+	pFrame->nFrameStartCpu = pFrameCurrent->nFrameStartCpu;
+	pFrame->nFrameEndCpu = pFrameNext->nFrameStartCpu;
+	pFrame->nNumThreads = 0;
+	pFrame->nDroppedFrames = pCapture->nDroppedFrames;
+	nSize += sizeof(ProfileCaptureFrame);
+
+	for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
+	{
+		ProfileThreadLog* pLog = S.Pool[i];
+		if (!pLog || !pLog->Log)
+			continue;
+		uint32_t nGet = pFrameCurrent->nLogStart[i];
+		uint32_t nPut = pFrameNext->nLogStart[i];
+		if (nGet == nPut || (pLog->nGpu && !pFrameCurrent->nFrameStartGpu[i]))
+			continue;
+
+		if (nSize + sizeof(ProfileCaptureThread) > PROFILE_CAPTURE_CHUNK_SIZE)
+		{
+			if (!bTruncate)
+				return false;
+			break;
+		}
+		ProfileCaptureThread* pThread = (ProfileCaptureThread*)(pChunk->Data + nSize);
+		nSize += sizeof(ProfileCaptureThread);
+
+		uint32_t nNumEntries = (nPut + PROFILE_BUFFER_SIZE - nGet) % PROFILE_BUFFER_SIZE;
+		uint32_t nMaxEntries = (uint32_t)((PROFILE_CAPTURE_CHUNK_SIZE - nSize) / sizeof(ProfileLogEntry));
+		if (nNumEntries > nMaxEntries && !bTruncate)
+			return false;
+		if (bTruncate)
+		{
+			// Keep the entries that fit together with the copies of their labels
+			const uint32_t nAvailable = PROFILE_CAPTURE_CHUNK_SIZE - nSize;
+			uint32_t nBytes = 0;
+			uint32_t nFit = 0;
+			for (; nFit < nNumEntries; ++nFit)
+			{
+				uint32_t nEntryBytes = sizeof(ProfileLogEntry) + ProfileCaptureLabelBytes(pLog->Log[(nGet + nFit) % PROFILE_BUFFER_SIZE]);
+				if (nBytes + nEntryBytes > nAvailable)
+					break;
+				nBytes += nEntryBytes;
+			}
+			nNumEntries = nFit;
+		}
+
+		pThread->nThreadIndex = i;
+		pThread->nGpu = pLog->nGpu;
+		pThread->nFrameStartGpu = pFrameCurrent->nFrameStartGpu[i];
+		pThread->nTicksPerSecondGpu = pLog->nGpu ? getGpuProfileTicksPerSecond(pLog->nGpuToken) : 0;
+		memcpy(pThread->ThreadName, pLog->ThreadName, sizeof(pThread->ThreadName));
+
+		ProfileLogEntry* pEntries = (ProfileLogEntry*)(pChunk->Data + nSize);
+		nSize += nNumEntries * sizeof(ProfileLogEntry);
+		uint32_t nLabelBytes = 0;
+		for (uint32_t k = 0; k < nNumEntries; ++k)
+		{
+			ProfileLogEntry LE = pLog->Log[(nGet + k) % PROFILE_BUFFER_SIZE];
+			uint64_t nType = ProfileLogType(LE);
+			if (nType == P_LOG_LABEL || nType == P_LOG_LABEL_LITERAL)
+			{
+				// Label storage is a ring that gets overwritten, keep a copy next to the entries
+				const char* pLabel = ProfileGetLabel((uint32_t)nType, ProfileLogGetTick(LE));
+				size_t nLength = pLabel ? strlen(pLabel) : 0;
+				nLength = nLength > PROFILE_CAPTURE_MAX_LABEL ? PROFILE_CAPTURE_MAX_LABEL : nLength;
+				if (nSize + nLabelBytes + nLength + 1 > PROFILE_CAPTURE_CHUNK_SIZE)
+				{
+					if (!bTruncate)
+						return false;
+					// The label changed since the entries were counted and no longer fits. Keep the slot
+					// but turn it into an entry type the capture writer skips, nothing is written past the chunk.
+					pEntries[k] = ProfileMakeLogIndex(P_LOG_GPU_EXTRA, 0, 0);
+					continue;
+				}
+				char* pDst = (char*)(pChunk->Data + nSize + nLabelBytes);
+				if (pLabel)
+					memcpy(pDst, pLabel, nLength);
+				pDst[nLength] = '\0';
+				LE = ProfileLogSetTick(LE, nLabelBytes);
+				nLabelBytes += (uint32_t)nLength + 1;
+			}
+			pEntries[k] = LE;
+		}
+		pThread->nNumEntries = nNumEntries;
+		pThread->nLabelBytes = nLabelBytes;
+		// Keep the next header 8 byte aligned
+		nSize += (nLabelBytes + 7) & ~7u;
+		if (nSize > PROFILE_CAPTURE_CHUNK_SIZE)
+		{
+			if (!bTruncate)
+				return false;
+			nSize = PROFILE_CAPTURE_CHUNK_SIZE;
+		}
+		pFrame->nNumThreads++;
+	}
+
+	pChunk->nSize = nSize;
+	return true;
+}
+
+void ProfileCaptureFlip(ProfileFrameState* pFrameCurrent, ProfileFrameState* pFrameNext)
+{
+	ProfileCapture* pCapture = g_pProfileCapture;
+	if (!pCapture)
+		return;
+
+	pCapture->nFrameIndex++;
+	int64_t nTick = P_TICK();
+	ProfileCaptureChunk* pChunk = pCapture->pCurrent;
+	bool bCopied = pChunk && ProfileCaptureCopyFrame(pCapture, pChunk, pFrameCurrent, pFrameNext, false);
+	if (!bCopied)
+	{
+		if (pChunk && pChunk->nSize)
+		{
+			ProfileCaptureSubmitChunk(pCapture, pChunk);
+			pChunk = NULL;
+		}
+		if (!pChunk)
+			pChunk = ProfileCaptureAcquireChunk(pCapture);
+		pCapture->pCurrent = pChunk;
+		if (pChunk)
+		{
+			pChunk->nFirstFrameTick = nTick;
+			bCopied = ProfileCaptureCopyFrame(pCapture, pChunk, pFrameCurrent, pFrameNext, true);
+		}
+	}
+
+	if (!bCopied)
+	{
+		pCapture->nDroppedFrames++;
+		pCapture->nTotalDroppedFrames++;
+		return;
+	}
+	pCapture->nDroppedFrames = 0;
+
+	float fChunkAgeMs = ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu()) * (nTick - pChunk->nFirstFrameTick);
+	if (fChunkAgeMs > PROFILE_CAPTURE_FLUSH_MS)
+	{
+		ProfileCaptureSubmitChunk(pCapture, pChunk);
+		pCapture->pCurrent = ProfileCaptureAcquireChunk(pCapture);
+		if (pCapture->pCurrent)
+			pCapture->pCurrent->nFirstFrameTick = nTick;
+	}
+}
+
+static void ProfileCaptureWrite(ProfileCapture* pCapture, const char* pData, size_t nSize)
+{
+	if (pCapture->nWriteBufferSize + nSize > PROFILE_CAPTURE_WRITE_BUFFER_SIZE)
+	{
+		fsWriteToStream(&pCapture->mFile, pCapture->WriteBuffer, pCapture->nWriteBufferSize);
+		pCapture->nWriteBufferSize = 0;
+	}
+	if (nSize > PROFILE_CAPTURE_WRITE_BUFFER_SIZE)
+	{
+		fsWriteToStream(&pCapture->mFile, pData, nSize);
+		return;
+	}
+	memcpy(pCapture->WriteBuffer + pCapture->nWriteBufferSize, pData, nSize);
+	pCapture->nWriteBufferSize += (uint32_t)nSize;
+}
+
+static void ProfileCaptureWriteString(ProfileCapture* pCapture, const char* pString)
+{
+	// Json string contents, names come from user code and labels
+	char Buffer[2 * PROFILE_CAPTURE_MAX_LABEL + 8];
+	uint32_t nLength = 0;
+	for (const char* p = pString; *p && nLength < sizeof(Buffer) - 8; ++p)
+	{
+		char c = *p;
+		if (c == '"' || c == '\\')
+		{
+			Buffer[nLength++] = '\\';
+			Buffer[nLength++] = c;
+		}
+		else if ((unsigned char)c >= 0x20)
+		{
+			Buffer[nLength++] = c;
+		}
+	}
+	ProfileCaptureWrite(pCapture, Buffer, nLength);
+}
+
+PROFILE_FORMAT(2, 3) static void ProfileCaptureWriteEvent(ProfileCapture* pCapture, const char* pFmt, ...)
+{
+	char Buffer[512];
+	va_list args;
+	va_start(args, pFmt);
+	int nSize = vsnprintf(Buffer, sizeof(Buffer), pFmt, args);
+	va_end(args);
+	if (nSize <= 0)
+		return;
+	ProfileCaptureWrite(pCapture, Buffer, ProfileMin((size_t)nSize, sizeof(Buffer) - 1));
+}
+
+static void ProfileCaptureBeginEvent(ProfileCapture* pCapture, const char* pName)
+{
+	ProfileCaptureWrite(pCapture, pCapture->bFirstEvent ? "\n{\"name\":\"" : ",\n{\"name\":\"", pCapture->bFirstEvent ? 10 : 11);
+	pCapture->bFirstEvent = false;
+	ProfileCaptureWriteString(pCapture, pName);
+	ProfileCaptureWrite(pCapture, "\"", 1);
+}
+
+static double ProfileCaptureTickToUs(ProfileCapture* pCapture, int64_t nTick)
+{
+	return (double)(nTick - pCapture->nTickBase) * 1000000.0 / (double)ProfileTicksPerSecondCpu();
+}
+
+static void ProfileCaptureWriteThread(ProfileCapture* pCapture, const ProfileCaptureFrame* pFrame, const ProfileCaptureThread* pThread)
+{
+	Profile & S = g_Profile;
+	const uint32_t nThreadIndex = pThread->nThreadIndex;
+	const uint32_t nPid = pThread->nGpu ? 1 : 0;
+	const ProfileLogEntry* pEntries = (const ProfileLogEntry*)(pThread + 1);
+	const char* pLabels = (const char*)(pEntries + pThread->nNumEntries);
+
+	if (strncmp(pCapture->ThreadNames[nThreadIndex], pThread->ThreadName, sizeof(pThread->ThreadName)) != 0)
+	{
+		memcpy(pCapture->ThreadNames[nThreadIndex], pThread->ThreadName, sizeof(pThread->ThreadName));
+		ProfileCaptureBeginEvent(pCapture, "thread_name");
+		ProfileCaptureWriteEvent(pCapture, ",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"", nPid, nThreadIndex);
+		ProfileCaptureWriteString(pCapture, pThread->ThreadName);
+		ProfileCaptureWrite(pCapture, "\"}}", 3);
+	}
+
+	// Log entries only keep the low 48 bits of the tick, rebuild them relative to the frame start. There is no cpu/gpu
+	// clock calibration, gpu timelines are aligned to the start of the cpu frame they were submitted in.
+	const int64_t nFrameStart = pThread->nGpu ? pThread->nFrameStartGpu : pFrame->nFrameStartCpu;
+	const double fGpuToCpu = pThread->nGpu && pThread->nTicksPerSecondGpu ? (double)ProfileTicksPerSecondCpu() / (double)pThread->nTicksPerSecondGpu : 1.0;
+
+	uint32_t& nStackPos = pCapture->nStackPos[nThreadIndex];
+	for (uint32_t k = 0; k < pThread->nNumEntries; ++k)
+	{
+		ProfileLogEntry LE = pEntries[k];
+		uint64_t nType = ProfileLogType(LE);
+		if (nType != P_LOG_ENTER && nType != P_LOG_LEAVE && nType != P_LOG_LABEL && nType != P_LOG_LABEL_LITERAL)
+			continue;
+
+		int64_t nTick = pFrame->nFrameStartCpu + (int64_t)((double)ProfileLogTickDifference(nFrameStart, LE) * fGpuToCpu);
+		if (nType == P_LOG_ENTER)
+		{
+			if (nStackPos < PROFILE_STACK_MAX)
+			{
+				pCapture->StackTicks[nThreadIndex][nStackPos] = nTick;
+				pCapture->StackTimers[nThreadIndex][nStackPos] = (uint32_t)ProfileLogTimerIndex(LE);
+			}
+			++nStackPos;
+		}
+		else if (nType == P_LOG_LEAVE)
+		{
+			if (!nStackPos)
+				continue;
+			--nStackPos;
+			uint32_t nTimer = (uint32_t)ProfileLogTimerIndex(LE);
+			if (nStackPos >= PROFILE_STACK_MAX || pCapture->StackTimers[nThreadIndex][nStackPos] != nTimer)
+				continue;
+
+			int64_t nTickStart = pCapture->StackTicks[nThreadIndex][nStackPos];
+			const ProfileTimerInfo& TI = S.TimerInfo[nTimer];
+			ProfileCaptureBeginEvent(pCapture, TI.pName);
+			ProfileCaptureWrite(pCapture, ",\"cat\":\"", 8);
+			ProfileCaptureWriteString(pCapture, S.GroupInfo[TI.nGroupIndex].pName);
+			ProfileCaptureWriteEvent(pCapture, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+				ProfileCaptureTickToUs(pCapture, nTickStart), ProfileCaptureTickToUs(pCapture, nTick) - ProfileCaptureTickToUs(pCapture, nTickStart),
+				nPid, nThreadIndex);
+		}
+		else
+		{
+			uint64_t nLabel = ProfileLogGetTick(LE);
+			if (nLabel >= pThread->nLabelBytes || !pLabels[nLabel])
+				continue;
+			// Labels don't carry a tick, show them at the start of the scope they were added in
+			int64_t nLabelTick = nStackPos && nStackPos <= PROFILE_STACK_MAX ? pCapture->StackTicks[nThreadIndex][nStackPos - 1] : pFrame->nFrameStartCpu;
+			ProfileCaptureBeginEvent(pCapture, pLabels + nLabel);
+			ProfileCaptureWriteEvent(pCapture, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u}",
+				ProfileCaptureTickToUs(pCapture, nLabelTick), nPid, nThreadIndex);
+		}
+	}
+}
+
+static void ProfileCaptureWriteChunk(ProfileCapture* pCapture, const ProfileCaptureChunk* pChunk)
+{
+	uint32_t nOffset = 0;
+	while (nOffset + sizeof(ProfileCaptureFrame) <= pChunk->nSize)
+	{
+		const ProfileCaptureFrame* pFrame = (const ProfileCaptureFrame*)(pChunk->Data + nOffset);
+		nOffset += sizeof(ProfileCaptureFrame);
+
+		if (pFrame->nDroppedFrames)
+		{
+			// Scopes that were open in the dropped frames will never see their leave
+			memset(pCapture->nStackPos, 0, sizeof(pCapture->nStackPos));
+			char Name[64];
+			snprintf(Name, sizeof(Name), "Dropped %u frames", pFrame->nDroppedFrames);
+			ProfileCaptureBeginEvent(pCapture, Name);
+			ProfileCaptureWriteEvent(pCapture, ",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+				ProfileCaptureTickToUs(pCapture, pFrame->nFrameStartCpu), PROFILE_MAX_THREADS);
+		}
+
+		char Name[64];
+		snprintf(Name, sizeof(Name), "Frame %llu", (unsigned long long)pFrame->nFrameIndex);
+		ProfileCaptureBeginEvent(pCapture, Name);
+		ProfileCaptureWriteEvent(pCapture, ",\"cat\":\"Frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+			ProfileCaptureTickToUs(pCapture, pFrame->nFrameStartCpu),
+			ProfileCaptureTickToUs(pCapture, pFrame->nFrameEndCpu) - ProfileCaptureTickToUs(pCapture, pFrame->nFrameStartCpu),
+			PROFILE_MAX_THREADS);
+
+		for (uint32_t i = 0; i < pFrame->nNumThreads && nOffset + sizeof(ProfileCaptureThread) <= pChunk->nSize; ++i)
+		{
+			const ProfileCaptureThread* pThread = (const ProfileCaptureThread*)(pChunk->Data + nOffset);
+			ProfileCaptureWriteThread(pCapture, pFrame, pThread);
+			nOffset += (uint32_t)(sizeof(ProfileCaptureThread) + pThread->nNumEntries * sizeof(ProfileLogEntry) + ((pThread->nLabelBytes + 7) & ~7u));
+		}
+	}
+}
+
+static void ProfileCaptureThreadFunc(void* pData)
+{
+	ProfileCapture* pCapture = (ProfileCapture*)pData;
+	Thread::SetCurrentThreadName("ProfileCapture");
+
+	for (;;)
+	{
+		ProfileCaptureChunk* pChunk = NULL;
+		bool bStop = false;
+		{
+			MutexLock lock(pCapture->mMutex);
+			while (!pCapture->pQueueHead && !pCapture->bStop)
+				pCapture->mCond.Wait(pCapture->mMutex);
+			pChunk = pCapture->pQueueHead;
+			if (pChunk)
+			{
+				pCapture->pQueueHead = pChunk->pNext;
+				if (!pCapture->pQueueHead)
+					pCapture->pQueueTail = NULL;
+			}
+			bStop = pCapture->bStop;
+		}
+
+		if (!pChunk)
+		{
+			if (bStop)
+				break;
+			continue;
+		}
+
+		ProfileCaptureWriteChunk(pCapture, pChunk);
+
+		MutexLock lock(pCapture->mMutex);
+		pChunk->pNext = pCapture->pFree;
+		pCapture->pFree = pChunk;
+	}
+}
+
+bool startProfileCapture(const char* appName, uint32_t nMaxBufferedBytes)
+{
+	MutexLock lock(ProfileAggregateMutex());
+	if (g_pProfileCapture)
+		return true;
+
+	MEMORY_TAG_SCOPE(MEMORY_TAG_PROFILER);
+	ProfileCapture* pCapture = tf_new(ProfileCapture);
+	memset(pCapture->ThreadNames, 0, sizeof(pCapture->ThreadNames));
+	memset(pCapture->nStackPos, 0, sizeof(pCapture->nStackPos));
+
+	time_t t = time(0);
+	eastl::string tempName = eastl::string().sprintf("%s", appName ? appName : "") + eastl::string(R"(Profile-%Y-%m-%d-%H.%M.%S.json)");
+	char name[128] = {};
+	strftime(name, sizeof(name), tempName.c_str(), localtime(&t));
+	pCapture->mFile = {};
+	if (!fsOpenStreamFromPath(RD_LOG, name, FM_WRITE, &pCapture->mFile))
+	{
+		LOGF(LogLevel::eERROR, "Profiler: could not open '%s' for the capture", name);
+		tf_delete(pCapture);
+		return false;
+	}
+
+	pCapture->nNumChunks = ProfileMax(2u, nMaxBufferedBytes / (uint32_t)sizeof(ProfileCaptureChunk));
+	pCapture->pChunks = (ProfileCaptureChunk*)tf_malloc(pCapture->nNumChunks * sizeof(ProfileCaptureChunk));
+	pCapture->pFree = NULL;
+	for (uint32_t i = 0; i < pCapture->nNumChunks; ++i)
+	{
+		pCapture->pChunks[i].pNext = pCapture->pFree;
+		pCapture->pFree = &pCapture->pChunks[i];
+	}
+	pCapture->pQueueHead = NULL;
+	pCapture->pQueueTail = NULL;
+	pCapture->pCurrent = NULL;
+	pCapture->nDroppedFrames = 0;
+	pCapture->nTotalDroppedFrames = 0;
+	pCapture->nFrameIndex = 0;
+	pCapture->nTickBase = P_TICK();
+	pCapture->bFirstEvent = true;
+	pCapture->nWriteBufferSize = 0;
+	pCapture->bStop = false;
+	pCapture->mMutex.Init();
+	pCapture->mCond.Init();
+
+	const char* pHeader = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	ProfileCaptureWrite(pCapture, pHeader, strlen(pHeader));
+	ProfileCaptureBeginEvent(pCapture, "process_name");
+	ProfileCaptureWriteEvent(pCapture, ",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}}");
+	ProfileCaptureBeginEvent(pCapture, "process_name");
+	ProfileCaptureWriteEvent(pCapture, ",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}");
+	ProfileCaptureBeginEvent(pCapture, "thread_name");
+	ProfileCaptureWriteEvent(pCapture, ",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Frames\"}}", PROFILE_MAX_THREADS);
+
+	pCapture->mThreadDesc.pFunc = ProfileCaptureThreadFunc;
+	pCapture->mThreadDesc.pData = pCapture;
+	pCapture->mThread = create_thread(&pCapture->mThreadDesc);
+
+	g_pProfileCapture = pCapture;
+	LOGF(LogLevel::eINFO, "Profiler: streaming capture to '%s'", name);
+	return true;
+}
+
+void stopProfileCapture()
+{
+	// Frames flipped before the stop may still wait for the aggregation, let them reach the capture
+	ProfileAggregator& A = g_ProfileAggregator;
+	if (A.bThreadRunning)
+	{
+		MutexLock lock(A.mQueueMutex);
+		while (A.nJobGet != A.nJobPut)
+			A.mQueueCond.Wait(A.mQueueMutex);
+	}
+
+	ProfileCapture* pCapture = NULL;
+	{
+		MutexLock lock(ProfileAggregateMutex());
+		pCapture = g_pProfileCapture;
+		if (!pCapture)
+			return;
+		g_pProfileCapture = NULL;
+		if (pCapture->pCurrent && pCapture->pCurrent->nSize)
+			ProfileCaptureSubmitChunk(pCapture, pCapture->pCurrent);
+		pCapture->pCurrent = NULL;
+	}
+
+	{
+		MutexLock lock(pCapture->mMutex);
+		pCapture->bStop = true;
+		pCapture->mCond.WakeAll();
+	}
+	join_thread(pCapture->mThread);
+
+	if (pCapture->nTotalDroppedFrames)
+		LOGF(LogLevel::eWARNING, "Profiler: capture dropped %llu frames, increase the capture buffer size", (unsigned long long)pCapture->nTotalDroppedFrames);
+
+	const char* pFooter = "\n]}\n";
+	ProfileCaptureWrite(pCapture, pFooter, strlen(pFooter));
+	fsWriteToStream(&pCapture->mFile, pCapture->WriteBuffer, pCapture->nWriteBufferSize);
+	fsCloseStream(&pCapture->mFile);
+
+	pCapture->mCond.Destroy();
+	pCapture->mMutex.Destroy();
+	tf_free(pCapture->pChunks);
+	tf_delete(pCapture);
+}
+
+bool isProfileCaptureRunning()
+{
+	return g_pProfileCapture != NULL;
+}
+
+#if PROFILE_WEBSERVER
+uint32_t ProfileWebServerPort()
+{
+	Profile & S = g_Profile;
+	return S.nWebServerPort;
+}
+
+void ProfileSendSocket(MpSocket Socket, const char* pData, size_t nSize)
+{
+#ifdef MSG_NOSIGNAL
+	int nFlags = MSG_NOSIGNAL;
+#else
+	int nFlags = 0;
+#endif
+
+	send(Socket, pData, (int)nSize, nFlags);
+}
+
+void ProfileFlushSocket(MpSocket Socket)
+{
+	Profile & S = g_Profile;
+	if (S.nWebServerPut)
+	{
+		ProfileSendSocket(Socket, &S.WebServerBuffer[0], S.nWebServerPut);
+		S.nWebServerPut = 0;
+	}
+}
+
+void ProfileWriteSocket(void* Handle, size_t nSize, const char* pData)
+{
+	Profile & S = g_Profile;
+	MpSocket Socket = *(MpSocket*)Handle;
+	if (nSize > PROFILE_WEBSERVER_SOCKET_BUFFER_SIZE / 2)
+	{
+		ProfileFlushSocket(Socket);
+		ProfileSendSocket(Socket, pData, nSize);
+	}
+	else
+	{
+		memcpy(&S.WebServerBuffer[S.nWebServerPut], pData, nSize);
+		S.nWebServerPut += (uint32_t)nSize;
+		if (S.nWebServerPut > PROFILE_WEBSERVER_SOCKET_BUFFER_SIZE / 2)
+		{
+			ProfileFlushSocket(Socket);
+		}
+	}
+
+	S.nWebServerDataSent += nSize;
+}
+
+#if PROFILE_MINIZ
+#ifndef PROFILE_COMPRESS_BUFFER_SIZE
+#define PROFILE_COMPRESS_BUFFER_SIZE (256<<10)
+#endif
+
+#define PROFILE_COMPRESS_CHUNK (PROFILE_COMPRESS_BUFFER_SIZE/2)
+struct ProfileCompressedSocketState
+{
+	unsigned char DeflateOut[PROFILE_COMPRESS_CHUNK];
+	unsigned char DeflateIn[PROFILE_COMPRESS_CHUNK];
+	mz_stream Stream;
+	MpSocket Socket;
+	uint32_t nSize;
+	uint32_t nCompressedSize;
 	uint32_t nFlushes;
 	uint32_t nMemmoveBytes;
 };
@@ -3107,10 +4194,10 @@ uint32_t ProfileContextSwitchGatherThreads(uint32_t nContextSwitchStart, uint32_
 	Profile & S = g_Profile;
 	for (uint32_t i = 0; i < PROFILE_MAX_THREADS; ++i)
 	{
-		if (!S.Pool[i])
+		if (!S.Pool[i] || S.Pool[i]->nGpu)
 			continue;
 		Threads[nNumThreads].nProcessId = nCurrentProcessId;
-		Threads[nNumThreads].nThreadId = S.Pool[i]->nThreadId;
+		Threads[nNumThreads].nThreadId = S.Pool[i]->nSystemThreadId;
 		nNumThreads++;
 	}
 
@@ -3149,6 +4236,39 @@ uint32_t ProfileContextSwitchGatherThreads(uint32_t nContextSwitchStart, uint32_
 	return nNumThreads;
 }
 
+int64_t ProfileContextSwitchOffCpuTicks(ThreadID nSystemThreadId, int64_t nTickStart, int64_t nTickEnd)
+{
+	Profile & S = g_Profile;
+	uint32_t nContextSwitchStart = 0;
+	uint32_t nContextSwitchEnd = 0;
+	ProfileContextSwitchSearch(&nContextSwitchStart, &nContextSwitchEnd, nTickStart, nTickEnd);
+
+	// The thread is running when the timer starts, so only a switch out opens a gap
+	int64_t nOffCpuTicks = 0;
+	int64_t nTickOut = -1;
+	for (uint32_t i = nContextSwitchStart; i != nContextSwitchEnd; i = (i + 1) % PROFILE_CONTEXT_SWITCH_BUFFER_SIZE)
+	{
+		const ProfileContextSwitch& CS = S.ContextSwitch[i];
+		int64_t nTicks = CS.nTicks;
+		if (nTicks >= nTickEnd)
+			break;
+		if (CS.nThreadOut == nSystemThreadId && nTickOut < 0)
+		{
+			nTickOut = nTicks;
+		}
+		else if (CS.nThreadIn == nSystemThreadId && nTickOut >= 0)
+		{
+			if (nTicks > nTickStart)
+				nOffCpuTicks += nTicks - (nTickOut > nTickStart ? nTickOut : nTickStart);
+			nTickOut = -1;
+		}
+	}
+	if (nTickOut >= 0)
+		nOffCpuTicks += nTickEnd - (nTickOut > nTickStart ? nTickOut : nTickStart);
+
+	return nOffCpuTicks;
+}
+
 #if defined(_WINDOWS) || defined(XBOX)
 #include <psapi.h>
 #pragma comment(lib, "psapi.lib")
@@ -3266,6 +4386,359 @@ void ProfileTraceThread(void*)
 		S.bContextSwitchRunning = false;
 	}
 }
+#elif defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+
+// ProfileContextSwitch::nCpu is a signed 8 bit field
+#define PROFILE_CONTEXT_SWITCH_MAX_CPUS 127
+// Data pages mapped per cpu for the perf ring buffer, has to be a power of two
+#define PROFILE_PERF_DATA_PAGES 64
+
+const char* ProfileGetProcessName(ProfileProcessIdType nId, char* Buffer, uint32_t nSize)
+{
+	char Path[64];
+	snprintf(Path, sizeof(Path), "/proc/%u/comm", nId);
+	int fd = open(Path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return nullptr;
+
+	ssize_t nRead = read(fd, Buffer, nSize - 1);
+	close(fd);
+	if (nRead <= 0)
+		return nullptr;
+
+	// comm is terminated by a new line
+	Buffer[nRead] = 0;
+	if (Buffer[nRead - 1] == '\n')
+		Buffer[nRead - 1] = 0;
+	return Buffer;
+}
+
+static int64_t ProfileClockOffset(clockid_t nClock)
+{
+	// Offset that converts nClock timestamps to P_TICK (CLOCK_REALTIME)
+	timespec ts;
+	clock_gettime(nClock, &ts);
+	int64_t nTick = P_TICK();
+	return nTick - (1000000000ll * ts.tv_sec + ts.tv_nsec);
+}
+
+static void ProfileContextSwitchPutSorted(eastl::vector<ProfileContextSwitch>& Pending, int64_t nTickSafe)
+{
+	// Records of different cpus are read from different rings, sort them and only publish those that are older than the drain
+	// start, anything newer may still have an earlier record sitting in a ring we have already read.
+	eastl::sort(Pending.begin(), Pending.end(), [](const ProfileContextSwitch& a, const ProfileContextSwitch& b) { return a.nTicks < b.nTicks; });
+	size_t nCount = 0;
+	while (nCount < Pending.size() && Pending[nCount].nTicks < nTickSafe)
+	{
+		ProfileContextSwitchPut(&Pending[nCount]);
+		++nCount;
+	}
+	Pending.erase(Pending.begin(), Pending.begin() + nCount);
+}
+
+struct ProfilePerfCpuStream
+{
+	int nFd;
+	uint8_t* pMapping;
+};
+
+// Cpu wide PERF_RECORD_SWITCH_CPU_WIDE records (Linux 4.3+). Needs perf_event_paranoid <= 0 or CAP_PERFMON / CAP_SYS_ADMIN.
+static bool ProfileTracePerf(uint32_t nCpus)
+{
+	Profile & S = g_Profile;
+	const size_t nPageSize = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t nDataSize = nPageSize * PROFILE_PERF_DATA_PAGES;
+
+	perf_event_attr Attr;
+	memset(&Attr, 0, sizeof(Attr));
+	Attr.size = sizeof(Attr);
+	Attr.type = PERF_TYPE_SOFTWARE;
+	Attr.config = PERF_COUNT_SW_DUMMY;
+	Attr.sample_type = PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_CPU;
+	Attr.disabled = 1;
+	Attr.context_switch = 1;
+	Attr.sample_id_all = 1;
+	Attr.watermark = 1;
+	Attr.wakeup_watermark = (uint32_t)(nDataSize / 4);
+	Attr.use_clockid = 1;
+	Attr.clockid = CLOCK_REALTIME;
+
+	int64_t nClockOffset = 0;
+	ProfilePerfCpuStream Streams[PROFILE_CONTEXT_SWITCH_MAX_CPUS];
+	uint32_t nStreams = 0;
+	for (uint32_t i = 0; i < nCpus; ++i)
+	{
+		int fd = (int)syscall(SYS_perf_event_open, &Attr, -1, (int)i, -1, PERF_FLAG_FD_CLOEXEC);
+		if (fd < 0 && errno == EINVAL && Attr.clockid == CLOCK_REALTIME)
+		{
+			// Older kernels only accept the NMI safe clocks
+			Attr.clockid = CLOCK_MONOTONIC;
+			nClockOffset = ProfileClockOffset(CLOCK_MONOTONIC);
+			fd = (int)syscall(SYS_perf_event_open, &Attr, -1, (int)i, -1, PERF_FLAG_FD_CLOEXEC);
+		}
+		if (fd < 0)
+		{
+			// Offline cpus can't be traced, everything else means we don't have the permission
+			if (errno == ENODEV)
+				continue;
+			break;
+		}
+
+		void* pMapping = mmap(NULL, nPageSize + nDataSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (pMapping == MAP_FAILED)
+		{
+			close(fd);
+			break;
+		}
+		Streams[nStreams].nFd = fd;
+		Streams[nStreams].pMapping = (uint8_t*)pMapping;
+		++nStreams;
+	}
+
+	if (!nStreams)
+		return false;
+
+	for (uint32_t i = 0; i < nStreams; ++i)
+		ioctl(Streams[i].nFd, PERF_EVENT_IOC_ENABLE, 0);
+
+	S.bContextSwitchRunning = true;
+
+	struct pollfd PollFds[PROFILE_CONTEXT_SWITCH_MAX_CPUS];
+	for (uint32_t i = 0; i < nStreams; ++i)
+	{
+		PollFds[i].fd = Streams[i].nFd;
+		PollFds[i].events = POLLIN;
+	}
+
+	eastl::vector<ProfileContextSwitch> Pending;
+	Pending.reserve(4096);
+	while (!S.bContextSwitchStop)
+	{
+		poll(PollFds, nStreams, 100);
+
+		int64_t nTickSafe = P_TICK();
+		for (uint32_t i = 0; i < nStreams; ++i)
+		{
+			perf_event_mmap_page* pHeader = (perf_event_mmap_page*)Streams[i].pMapping;
+			const uint8_t* pData = Streams[i].pMapping + nPageSize;
+			uint64_t nHead = __atomic_load_n(&pHeader->data_head, __ATOMIC_ACQUIRE);
+			uint64_t nTail = pHeader->data_tail;
+			while (nTail < nHead)
+			{
+				// Records may wrap around the end of the ring, copy them out first
+				uint8_t Record[256];
+				perf_event_header* pRecord = (perf_event_header*)Record;
+				uint64_t nOffset = nTail % nDataSize;
+				size_t nFirst = eastl::min((size_t)(nDataSize - nOffset), sizeof(perf_event_header));
+				memcpy(Record, pData + nOffset, nFirst);
+				memcpy(Record + nFirst, pData, sizeof(perf_event_header) - nFirst);
+				size_t nRecordSize = pRecord->size;
+				if (!nRecordSize)
+					break;
+
+				if (pRecord->type == PERF_RECORD_SWITCH_CPU_WIDE && (pRecord->misc & PERF_RECORD_MISC_SWITCH_OUT) &&
+					nRecordSize >= sizeof(perf_event_header) + 8 * sizeof(uint32_t) && nRecordSize <= sizeof(Record))
+				{
+					nFirst = eastl::min((size_t)(nDataSize - nOffset), nRecordSize);
+					memcpy(Record, pData + nOffset, nFirst);
+					memcpy(Record + nFirst, pData, nRecordSize - nFirst);
+
+					// next_prev_pid, next_prev_tid, then sample_id: pid, tid, time, cpu, res
+					const uint32_t* pBody = (const uint32_t*)(Record + sizeof(perf_event_header));
+					uint64_t nTime;
+					memcpy(&nTime, pBody + 4, sizeof(nTime));
+
+					ProfileContextSwitch Switch;
+					Switch.nThreadOut = pBody[3];
+					Switch.nThreadIn = pBody[1];
+					Switch.nProcessIn = pBody[0];
+					Switch.nCpu = pBody[6];
+					Switch.nTicks = (int64_t)nTime + nClockOffset;
+					Pending.push_back(Switch);
+				}
+				nTail += nRecordSize;
+			}
+			__atomic_store_n(&pHeader->data_tail, nTail, __ATOMIC_RELEASE);
+		}
+
+		ProfileContextSwitchPutSorted(Pending, nTickSafe);
+	}
+
+	for (uint32_t i = 0; i < nStreams; ++i)
+	{
+		munmap(Streams[i].pMapping, nPageSize + nDataSize);
+		close(Streams[i].nFd);
+	}
+	S.bContextSwitchRunning = false;
+	return true;
+}
+
+static bool ProfileTraceFsWrite(const char* pRoot, const char* pFile, const char* pValue)
+{
+	char Path[256];
+	snprintf(Path, sizeof(Path), "%s/%s", pRoot, pFile);
+	int fd = open(Path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+	bool bResult = write(fd, pValue, strlen(pValue)) == (ssize_t)strlen(pValue);
+	close(fd);
+	return bResult;
+}
+
+static ProfileProcessIdType ProfileTraceFsGetProcess(ProfileProcessIdType* pCache, uint32_t nTid)
+{
+	// sched_switch doesn't report the process, look it up once per tid
+	const uint32_t nCacheSize = 1024;
+	uint32_t nSlot = (nTid % nCacheSize) * 2;
+	if (pCache[nSlot] == nTid)
+		return pCache[nSlot + 1];
+
+	ProfileProcessIdType nProcess = 0;
+	char Path[64];
+	snprintf(Path, sizeof(Path), "/proc/%u/status", nTid);
+	int fd = open(Path, O_RDONLY | O_CLOEXEC);
+	if (fd >= 0)
+	{
+		char Buffer[1024];
+		ssize_t nRead = read(fd, Buffer, sizeof(Buffer) - 1);
+		close(fd);
+		Buffer[nRead > 0 ? nRead : 0] = 0;
+		if (const char* pTgid = strstr(Buffer, "Tgid:"))
+			nProcess = (ProfileProcessIdType)strtoul(pTgid + 5, NULL, 10);
+	}
+	pCache[nSlot] = nTid;
+	pCache[nSlot + 1] = nProcess;
+	return nProcess;
+}
+
+// sched_switch tracepoint through tracefs, needs write access to the tracing directory (usually root).
+// Traces into a private instance so the clock, events and trace_pipe of the global buffer and other tracers are left alone
+static bool ProfileTraceFs()
+{
+	Profile & S = g_Profile;
+	const char* pRoots[] = { "/sys/kernel/tracing", "/sys/kernel/debug/tracing" };
+	char Instance[256] = {};
+	for (uint32_t i = 0; i < sizeof(pRoots) / sizeof(pRoots[0]) && !Instance[0]; ++i)
+	{
+		snprintf(Instance, sizeof(Instance), "%s/instances/theforge-%d", pRoots[i], (int)getpid());
+		// Left over by a process with the same pid that did not exit cleanly
+		rmdir(Instance);
+		if (mkdir(Instance, 0700) != 0)
+			Instance[0] = '\0';
+	}
+	if (!Instance[0])
+		return false;
+
+	int fd = -1;
+	if (ProfileTraceFsWrite(Instance, "trace_clock", "mono") && ProfileTraceFsWrite(Instance, "events/sched/sched_switch/enable", "1"))
+	{
+		char Path[320];
+		snprintf(Path, sizeof(Path), "%s/trace_pipe", Instance);
+		fd = open(Path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	}
+	if (fd < 0)
+	{
+		rmdir(Instance);
+		return false;
+	}
+
+	S.bContextSwitchRunning = true;
+
+	int64_t nClockOffset = ProfileClockOffset(CLOCK_MONOTONIC);
+	ProfileProcessIdType* pProcessCache = (ProfileProcessIdType*)tf_calloc(2048, sizeof(ProfileProcessIdType));
+	eastl::vector<ProfileContextSwitch> Pending;
+	Pending.reserve(4096);
+	char Buffer[16 * 1024];
+	size_t nBuffered = 0;
+	struct pollfd PollFd = { fd, POLLIN, 0 };
+	while (!S.bContextSwitchStop)
+	{
+		poll(&PollFd, 1, 100);
+
+		int64_t nTickSafe = P_TICK();
+		ssize_t nRead;
+		while ((nRead = read(fd, Buffer + nBuffered, sizeof(Buffer) - 1 - nBuffered)) > 0)
+		{
+			nBuffered += nRead;
+			Buffer[nBuffered] = 0;
+
+			// "<comm>-<tid> [<cpu>] <flags> <sec>.<usec>: sched_switch: prev_comm=.. prev_pid=.. ... ==> next_comm=.. next_pid=.. next_prio=.."
+			char* pLine = Buffer;
+			while (char* pEnd = strchr(pLine, '\n'))
+			{
+				*pEnd = 0;
+				char* pEvent = strstr(pLine, ": sched_switch: ");
+				char* pCpu = strchr(pLine, '[');
+				char* pPrev = pEvent ? strstr(pEvent, " prev_pid=") : NULL;
+				char* pNext = pEvent ? strstr(pEvent, "==> ") : NULL;
+				pNext = pNext ? strstr(pNext, " next_pid=") : NULL;
+				if (pCpu && pPrev && pNext && pCpu < pEvent)
+				{
+					char* pTime = pEvent;
+					while (pTime > pCpu && pTime[-1] != ' ')
+						--pTime;
+					char* pFraction = NULL;
+					int64_t nSeconds = strtoll(pTime, &pFraction, 10);
+					int64_t nNanoSeconds = 0;
+					int nDigits = 0;
+					for (char* p = pFraction + 1; *pFraction == '.' && *p >= '0' && *p <= '9'; ++p, ++nDigits)
+						nNanoSeconds = nNanoSeconds * 10 + (*p - '0');
+					for (; nDigits < 9; ++nDigits)
+						nNanoSeconds *= 10;
+
+					ProfileContextSwitch Switch;
+					Switch.nThreadOut = strtoul(pPrev + 10, NULL, 10);
+					Switch.nThreadIn = strtoul(pNext + 10, NULL, 10);
+					Switch.nProcessIn = Switch.nThreadIn ? ProfileTraceFsGetProcess(pProcessCache, (uint32_t)Switch.nThreadIn) : 0;
+					Switch.nCpu = strtol(pCpu + 1, NULL, 10);
+					Switch.nTicks = nSeconds * 1000000000ll + nNanoSeconds + nClockOffset;
+					Pending.push_back(Switch);
+				}
+				pLine = pEnd + 1;
+			}
+
+			nBuffered = (size_t)(Buffer + nBuffered - pLine);
+			memmove(Buffer, pLine, nBuffered);
+			if (nBuffered == sizeof(Buffer) - 1)
+				nBuffered = 0;
+		}
+
+		ProfileContextSwitchPutSorted(Pending, nTickSafe);
+	}
+
+	tf_free(pProcessCache);
+	close(fd);
+	// Removing the instance disables its events and frees its buffers
+	rmdir(Instance);
+	S.bContextSwitchRunning = false;
+	return true;
+}
+
+void ProfileTraceThread(void*)
+{
+	Thread::SetCurrentThreadName("ContextSwitchTrace");
+	MEMORY_TAG_SCOPE(MEMORY_TAG_PROFILER);
+
+	long nCpus = sysconf(_SC_NPROCESSORS_CONF);
+	nCpus = nCpus > PROFILE_CONTEXT_SWITCH_MAX_CPUS ? PROFILE_CONTEXT_SWITCH_MAX_CPUS : (nCpus > 0 ? nCpus : 1);
+
+	if (ProfileTracePerf((uint32_t)nCpus))
+		return;
+
+	int nPerfError = errno;
+	if (!ProfileTraceFs())
+	{
+		LOGF(LogLevel::eINFO, "Profiler: context switch trace unavailable (perf_event_open: %s). "
+			"Lower /proc/sys/kernel/perf_event_paranoid to 0 or grant CAP_PERFMON to see scheduling gaps.", strerror(nPerfError));
+	}
+}
 #endif
 #else
 void ProfileContextSwitchTraceStart()
@@ -3303,6 +4776,15 @@ const char* ProfileGetProcessName(ProfileProcessIdType nId, char* Buffer, uint32
 
 	return nullptr;
 }
+
+int64_t ProfileContextSwitchOffCpuTicks(ThreadID nSystemThreadId, int64_t nTickStart, int64_t nTickEnd)
+{
+	(void)nSystemThreadId;
+	(void)nTickStart;
+	(void)nTickEnd;
+
+	return 0;
+}
 #endif
 
 #if PROFILE_EMBED_HTML
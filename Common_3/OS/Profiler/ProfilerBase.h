@@ -118,6 +118,8 @@
 #define ProfileDisableMetaCounter(c) do{} while(0)
 #define ProfileContextSwitchTraceStart() do{} while(0)
 #define ProfileContextSwitchTraceStop() do{} while(0)
+#define ProfileAggregateStart() do{} while(0)
+#define ProfileAggregateStop() do{} while(0)
 #define ProfileDumpFile(path,type,frames) do{} while(0)
 #define ProfileDumpHtml(cb,handle,frames,host) do{} while(0)
 #define ProfileWebServerStart() do{} while(0)
@@ -201,6 +203,11 @@ inline int64_t ProfileGetTick()
 typedef uint64_t ProfileThreadIdType;
 #define P_GETCURRENTPROCESSID() getpid()
 typedef uint32_t ProfileProcessIdType;
+#if defined(__linux__)
+#include <sys/syscall.h>
+// Context switch records from the kernel use tids, not pthread_t
+#define P_GETCURRENTSYSTEMTHREADID() ((ThreadID)syscall(SYS_gettid))
+#endif
 
 #elif defined(NX64)
 #include <time.h>
@@ -227,6 +234,10 @@ inline int64_t ProfileTicksPerSecondCpu()
 typedef uint32_t ProfileProcessIdType;
 #endif
 
+#ifndef P_GETCURRENTSYSTEMTHREADID
+#define P_GETCURRENTSYSTEMTHREADID() Thread::GetCurrentThreadID()
+#endif
+
 #ifndef P_ASSERT
 #define P_ASSERT(a) do{if(!(a)){P_BREAK();} }while(0)
 #endif
@@ -296,6 +307,11 @@ typedef uint16_t ProfileGroupId;
 #define PROFILE_GPU_FRAME_DELAY 3
 #endif
 
+// Flipped frames that can wait for the aggregate thread before the flip blocks
+#ifndef PROFILE_AGGREGATE_MAX_PENDING
+#define PROFILE_AGGREGATE_MAX_PENDING 16
+#endif
+
 #ifndef PROFILE_NAME_MAX_LEN
 #define PROFILE_NAME_MAX_LEN 64
 #endif
@@ -389,6 +405,14 @@ PROFILE_API void ProfileRemoveThreadLog(struct ProfileThreadLog * pLog);
 PROFILE_API void ProfileContextSwitchTraceStart();
 PROFILE_API void ProfileContextSwitchTraceStop();
 
+PROFILE_API void ProfileAggregateStart();
+PROFILE_API void ProfileAggregateStop();
+
+PROFILE_API void ProfileHistogramReset();
+// Percentile in [0, 100], returns the bucket midpoint in ms
+PROFILE_API float ProfileHistogramPercentile(const uint32_t* pHistogram, uint32_t nCount, float fPercentile);
+PROFILE_API uint32_t ProfileHistogramSpikes(const uint32_t* pHistogram, uint32_t nCount);
+
 struct ProfileThreadInfo
 {
 	ProfileProcessIdType nProcessId;
@@ -399,6 +423,8 @@ PROFILE_API void ProfileContextSwitchSearch(uint32_t* pContextSwitchStart, uint3
 PROFILE_API uint32_t ProfileContextSwitchGatherThreads(uint32_t nContextSwitchStart, uint32_t nContextSwitchEnd, ProfileThreadInfo* Threads, uint32_t* nNumThreadsBase);
 
 PROFILE_API const char* ProfileGetProcessName(ProfileProcessIdType nId, char* Buffer, uint32_t nSize);
+// Time the thread spent switched out between nTickStart and nTickEnd according to the context switch trace
+PROFILE_API int64_t ProfileContextSwitchOffCpuTicks(ThreadID nSystemThreadId, int64_t nTickStart, int64_t nTickEnd);
 
 PROFILE_API void ProfileDumpFile(const char* pPath, ProfileDumpType eType, uint32_t nFrames);
 
@@ -459,6 +485,19 @@ struct ProfileScopeHandlerCpu
 #define PROFILE_MAX_THREADS 256
 #endif 
 
+// Per timer log-linear histograms of frame times in microseconds (HDR histogram style).
+// Values below PROFILE_HISTOGRAM_SUB_BUCKETS are exact, above each power of two is split into
+// PROFILE_HISTOGRAM_SUB_BUCKETS buckets (<= 6.25% error), up to 2^PROFILE_HISTOGRAM_MAX_LOG2 us (~4s).
+#define PROFILE_HISTOGRAM_SUB_BUCKET_BITS 4
+#define PROFILE_HISTOGRAM_SUB_BUCKETS (1 << PROFILE_HISTOGRAM_SUB_BUCKET_BITS)
+#define PROFILE_HISTOGRAM_MAX_LOG2 22
+#define PROFILE_HISTOGRAM_BUCKETS ((PROFILE_HISTOGRAM_MAX_LOG2 - PROFILE_HISTOGRAM_SUB_BUCKET_BITS + 2) * PROFILE_HISTOGRAM_SUB_BUCKETS)
+
+// A frame counts as a spike when it takes longer than this factor times the median
+#ifndef PROFILE_HISTOGRAM_SPIKE_FACTOR
+#define PROFILE_HISTOGRAM_SPIKE_FACTOR 2.0f
+#endif
+
 #ifndef PROFILE_UNPACK_RED
 #define PROFILE_UNPACK_RED(c) ((c)>>16)
 #endif
@@ -475,13 +514,16 @@ struct ProfileScopeHandlerCpu
 #define PROFILE_DEFAULT_PRESET "Default"
 #endif
 
-// We disable context switch trace because it's unable to open the file needed, and because
-// no documentation was found on how to use this
+// We disable context switch trace on Windows and macOS because it's unable to open the file needed, and because
+// no documentation was found on how to use this.
+// On Linux the trace is captured in process through perf_event_open (or tracefs as a fallback), see ProfileTraceThread
 #ifndef PROFILE_CONTEXT_SWITCH_TRACE
 #if defined(_WINDOWS) || defined(XBOX)
 #define PROFILE_CONTEXT_SWITCH_TRACE 0
 #elif defined(__APPLE__) && !TARGET_OS_IPHONE
 #define PROFILE_CONTEXT_SWITCH_TRACE 0
+#elif defined(__linux__) && !defined(__ANDROID__)
+#define PROFILE_CONTEXT_SWITCH_TRACE 1
 #else
 #define PROFILE_CONTEXT_SWITCH_TRACE 0
 #endif
@@ -626,8 +668,14 @@ struct ProfileContextSwitch
 	ThreadID nThreadOut;
 	ThreadID nThreadIn;
 	ProfileProcessIdType nProcessIn;
+#if defined(__linux__)
+	// P_TICK is CLOCK_REALTIME in nanoseconds here, which doesn't fit in 56 bits
+	int8_t nCpu;
+	int64_t nTicks;
+#else
 	int64_t nCpu : 8;
 	int64_t nTicks : 56;
+#endif
 };
 
 
@@ -646,6 +694,8 @@ struct ProfileThreadLog
 
 	uint32_t 				nGpu;
 	ThreadID 				nThreadId;
+	// Id the OS scheduler uses for this thread, matches ProfileContextSwitch::nThreadIn/nThreadOut
+	ThreadID 				nSystemThreadId;
 	uint32_t 				nLogIndex;
     ProfileToken            nGpuToken;
 
@@ -788,6 +838,12 @@ struct Profile
 	uint64_t				nFlipMaxDisplay;
 	uint64_t				nFlipMinDisplay;
 
+	// Histograms accumulate over the whole session, cleared with ProfileHistogramReset
+	uint32_t				TimerHistogram[PROFILE_MAX_TIMERS][PROFILE_HISTOGRAM_BUCKETS];
+	uint32_t				TimerHistogramCount[PROFILE_MAX_TIMERS];
+	uint32_t				FrameHistogram[PROFILE_HISTOGRAM_BUCKETS];
+	uint32_t				FrameHistogramCount;
+
 	ProfileThread 			ContextSwitchThread;
 	bool  						bContextSwitchRunning;
 	bool						bContextSwitchStart;
@@ -201,9 +201,9 @@ const char g_ProfileHtml_begin_0[] =
 "	return group;\n"
 "}\n"
 "\n"
-"function MakeTimer(id, name, group, color, colordark, average, max, min, exclaverage, exclmax, callaverage, callcount, total, meta, metaagg, metamax)\n"
+"function MakeTimer(id, name, group, color, colordark, average, max, min, exclaverage, exclmax, callaverage, callcount, total, p50, p90, p99, p999, spikes, meta, metaagg, metamax)\n"
 "{\n"
-"	var timer = {\"id\":id, \"name\":name, \"namelabel\":name.startsWith(\"$\"), \"color\":color, \"colordark\":colordark,\"timercolor\":color, \"textcolor\":InvertColor(color), \"group\":group, \"average\":average, \"max\":max, \"min\":min, \"exclaverage\":exclaverage, \"exclmax\":exclmax, \"callaverage\":callaverage, \"callcount\":callcount, \"total\":total, \"meta\":meta, \"textcolorindex\":InvertColorIndex(color), \"metaagg\":metaagg, \"metamax\":metamax, \"worst\":0, \"worststart\":0, \"worstend\":0};\n"
+"	var timer = {\"id\":id, \"name\":name, \"namelabel\":name.startsWith(\"$\"), \"color\":color, \"colordark\":colordark,\"timercolor\":color, \"textcolor\":InvertColor(color), \"group\":group, \"average\":average, \"max\":max, \"min\":min, \"exclaverage\":exclaverage, \"exclmax\":exclmax, \"callaverage\":callaverage, \"callcount\":callcount, \"total\":total, \"p50\":p50, \"p90\":p90, \"p99\":p99, \"p999\":p999, \"spikes\":spikes, \"meta\":meta, \"textcolorindex\":InvertColorIndex(color), \"metaagg\":metaagg, \"metamax\":metamax, \"worst\":0, \"worststart\":0, \"worstend\":0};\n"
 "	return timer;\n"
 "}\n"
 "\n"
@@ -1755,6 +1755,23 @@ const char g_ProfileHtml_end_1[] =
 "			StringArray.push(\"\");\n"
 "			StringArray.push(\"\");\n"
 "\n"
+"			if(Timer.p50 > 0)\n"
+"			{\n"
+"				StringArray.push(\"P50:\");\n"
+"				StringArray.push(Timer.p50.toFixed(3)+\"ms\");\n"
+"				StringArray.push(\"P90:\");\n"
+"				StringArray.push(Timer.p90.toFixed(3)+\"ms\");\n"
+"				StringArray.push(\"P99:\");\n"
+"				StringArray.push(Timer.p99.toFixed(3)+\"ms\");\n"
+"				StringArray.push(\"P99.9:\");\n"
+"				StringArray.push(Timer.p999.toFixed(3)+\"ms\");\n"
+"				StringArray.push(\"Spikes:\");\n"
+"				StringArray.push(Timer.spikes.toString());\n"
+"\n"
+"				StringArray.push(\"\");\n"
+"				StringArray.push(\"\");\n"
+"			}\n"
+"\n"
 "			StringArray.push(\"Group:\");\n"
 "			StringArray.push(Group.name);\n"
 "			StringArray.push(\"Frame Average:\");\n"
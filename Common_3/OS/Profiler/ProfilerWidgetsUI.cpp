@@ -77,6 +77,8 @@ struct  ProfileDetailedModeTime
 	float mEndTime;
 	uint32_t mFrameNum;
 	float mCurrFrameTime;
+	// Time the thread was switched out by the OS while inside the timer, from the context switch trace
+	float mOffCpuTime;
 	eastl::string mThreadName;
 };
 
@@ -255,6 +257,7 @@ ProfileReferenceTimes gReferenceTime = PROFILE_REFTIME_MS_15;
 ProfileDumpFramesFile gDumpFramesToFile = PROFILE_DUMPFILE_NUM_32;
 ProfileDumpFramesDetailedMode gDumpFramesDetailedMode = PROFILE_DUMPFRAME_NUM_4;
 bool gProfilerPaused = false;
+bool gProfileCaptureRunning = false;
 float gMinPlotReferenceTime = 0.f;
 float gFrameTime = 0.f;
 float gFrameTimeData[FRAME_HISTORY_LEN] = { 0.f };
@@ -437,6 +440,15 @@ void profileCallbkPauseProfiler()
 	ProfileTogglePause();
 }
 
+void profileCallbkStreamCapture()
+{
+	ASSERT(pAppUIRef);
+	if (gProfileCaptureRunning)
+		gProfileCaptureRunning = startProfileCapture(pAppUIRef->pImpl->pRenderer->pName);
+	else
+		stopProfileCapture();
+}
+
 void ProfileCallbkReferenceTimeUpdated()
 {
 	if (gProfileMode == PROFILE_MODE_PLOT)
@@ -594,6 +606,7 @@ void profileUpdateDetailedModeData(Profile& S)
 						timerLog.mTimerInfoIndex = (uint32_t)nTimerIndex;
 						timerLog.mStartTime = fMsStart;
 						timerLog.mEndTime = fMsEnd;
+						timerLog.mOffCpuTime = bGpu ? 0.f : fToMs * ProfileContextSwitchOffCpuTicks(pLog->nSystemThreadId, nTickStart, nTickEnd);
 						timerLog.mThreadName.append(pLog->ThreadName);
 						timerLog.mFrameNum = (uint32_t)gDetailedModeDump.size() + 1;
 						frameLog.mTimers.push_back(timerLog);
@@ -656,6 +669,13 @@ void profileUpdateDetailedModeTooltip(Profile& S)
 			tooltipData.append(eastl::to_string(timer.mEndTime - timer.mStartTime));
 			tooltipData.append("\n");
 
+			if (timer.mOffCpuTime > 0.f)
+			{
+				tooltipData.append("Descheduled(ms): ");
+				tooltipData.append(eastl::to_string(timer.mOffCpuTime));
+				tooltipData.append("\n");
+			}
+
 
 			strcpy(gTooltipData, tooltipData.c_str());
 			gShowTooltip = true;
@@ -849,6 +869,11 @@ void profileDrawTimerMode(Profile& S)
 	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "Exclusive Time", gLilacColor));
 	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "Exclusive Average", gLilacColor));
 	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "Exclusive Max Time", gLilacColor));
+	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "P50 Time", gLilacColor));
+	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "P90 Time", gLilacColor));
+	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "P99 Time", gLilacColor));
+	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "P99.9 Time", gLilacColor));
+	header.push_back(tf_placement_new<ColorLabelWidget>(tf_calloc(1, sizeof(ColorLabelWidget)), "Spike Count", gLilacColor));
 	gWidgetTable.push_back(header);
 
 	// Add the header coloumn.
@@ -872,8 +897,8 @@ void profileDrawTimerMode(Profile& S)
 				eastl::vector<char*> timeRowData;
 				eastl::vector<float4*> timeColorData;
 
-				// There are 9 time categories in the header above.
-				for (uint32_t i = 0; i < 9; ++i)
+				// There are 14 time categories in the header above.
+				for (uint32_t i = 0; i < 14; ++i)
 				{
 					char* timeResult = (char*)tf_calloc(MAX_TIME_STR_LEN, sizeof(char));
 					strcpy(timeResult, "-");
@@ -911,6 +936,11 @@ void profileResetTimerModeData(uint32_t tableLocation)
 	strcpy(timeCol[6], "-");
 	strcpy(timeCol[7], "-");
 	strcpy(timeCol[8], "-");
+	strcpy(timeCol[9], "-");
+	strcpy(timeCol[10], "-");
+	strcpy(timeCol[11], "-");
+	strcpy(timeCol[12], "-");
+	strcpy(timeCol[13], "-");
 	*timeColor[0] = gNormalColor;
 	*timeColor[1] = gNormalColor;
 	*timeColor[2] = gNormalColor;
@@ -920,6 +950,11 @@ void profileResetTimerModeData(uint32_t tableLocation)
 	*timeColor[6] = gNormalColor;
 	*timeColor[7] = gNormalColor;
 	*timeColor[8] = gNormalColor;
+	*timeColor[9] = gNormalColor;
+	*timeColor[10] = gNormalColor;
+	*timeColor[11] = gNormalColor;
+	*timeColor[12] = gNormalColor;
+	*timeColor[13] = gNormalColor;
 }
 
 /// Get data for timer mode functionality.
@@ -946,6 +981,14 @@ void profileUpdateTimerModeData(Profile& S, uint32_t groupIndex, uint32_t timerI
 	float fFrameMsExclusive = profileUtilRoundFloatByPrecision(fToMs * (S.FrameExclusive[timerIndex]));
 	float fAverageExclusive = profileUtilRoundFloatByPrecision(fToMs * (S.AggregateExclusive[timerIndex] / nAggregateFrames));
 	float fMaxExclusive = profileUtilRoundFloatByPrecision(fToMs * (S.AggregateMaxExclusive[timerIndex]));
+	// Session histograms, see ProfileHistogramReset
+	const uint32_t* pHistogram = S.TimerHistogram[timerIndex];
+	uint32_t nHistogramCount = S.TimerHistogramCount[timerIndex];
+	float fP50 = profileUtilRoundFloatByPrecision(ProfileHistogramPercentile(pHistogram, nHistogramCount, 50.0f));
+	float fP90 = profileUtilRoundFloatByPrecision(ProfileHistogramPercentile(pHistogram, nHistogramCount, 90.0f));
+	float fP99 = profileUtilRoundFloatByPrecision(ProfileHistogramPercentile(pHistogram, nHistogramCount, 99.0f));
+	float fP999 = profileUtilRoundFloatByPrecision(ProfileHistogramPercentile(pHistogram, nHistogramCount, 99.9f));
+	uint32_t fSpikeCount = ProfileHistogramSpikes(pHistogram, nHistogramCount);
 
 	eastl::vector<char*>& timeCol = gTimerData[tableLocation];
 	eastl::vector<float4*> timeColor = gTimerColorData[tableLocation];
@@ -965,6 +1008,15 @@ void profileUpdateTimerModeData(Profile& S, uint32_t groupIndex, uint32_t timerI
 		strcpy(timeCol[8], profileUtilTrimFloatString(eastl::to_string(fMaxExclusive)).c_str());
 	}
 
+	if (nHistogramCount) // No histograms for GPU
+	{
+		strcpy(timeCol[9], profileUtilTrimFloatString(eastl::to_string(fP50)).c_str());
+		strcpy(timeCol[10], profileUtilTrimFloatString(eastl::to_string(fP90)).c_str());
+		strcpy(timeCol[11], profileUtilTrimFloatString(eastl::to_string(fP99)).c_str());
+		strcpy(timeCol[12], profileUtilTrimFloatString(eastl::to_string(fP999)).c_str());
+		strcpy(timeCol[13], profileUtilTrimFloatString(eastl::to_string(fSpikeCount)).c_str());
+	}
+
 	// Also add color coding to the times relative to the current selected reference time.
 	float criticalTime = CRITICAL_COLOR_THRESHOLD * profileUtilReferenceTimeFromEnum(gReferenceTime);
 	float warnTime = WARNING_COLOR_THRESHOLD * profileUtilReferenceTimeFromEnum(gReferenceTime);
@@ -981,6 +1033,11 @@ void profileUpdateTimerModeData(Profile& S, uint32_t groupIndex, uint32_t timerI
 	fFrameMsExclusive > warnTime ? *timeColor[6] = gWarningColor : *timeColor[6] = gNormalColor;
 	fAverageExclusive > warnTime ? *timeColor[7] = gWarningColor : *timeColor[7] = gNormalColor;
 	fMaxExclusive > warnTime ? *timeColor[8] = gWarningColor : *timeColor[8] = gNormalColor;
+	fP50 > warnTime ? *timeColor[9] = gWarningColor : *timeColor[9] = gNormalColor;
+	fP90 > warnTime ? *timeColor[10] = gWarningColor : *timeColor[10] = gNormalColor;
+	fP99 > warnTime ? *timeColor[11] = gWarningColor : *timeColor[11] = gNormalColor;
+	fP999 > warnTime ? *timeColor[12] = gWarningColor : *timeColor[12] = gNormalColor;
+	fSpikeCount > warnCount ? *timeColor[13] = gWarningColor : *timeColor[13] = gNormalColor;
 
 	fTime > criticalTime ? *timeColor[0] = gCriticalColor : float4(0.0f);
 	fAverage > criticalTime ? *timeColor[1] = gCriticalColor : float4(0.0f);
@@ -991,6 +1048,11 @@ void profileUpdateTimerModeData(Profile& S, uint32_t groupIndex, uint32_t timerI
 	fFrameMsExclusive > criticalTime ? *timeColor[6] = gCriticalColor : float4(0.0f);
 	fAverageExclusive > criticalTime ? *timeColor[7] = gCriticalColor : float4(0.0f);
 	fMaxExclusive > criticalTime ? *timeColor[8] = gCriticalColor : float4(0.0f);
+	fP50 > criticalTime ? *timeColor[9] = gCriticalColor : float4(0.0f);
+	fP90 > criticalTime ? *timeColor[10] = gCriticalColor : float4(0.0f);
+	fP99 > criticalTime ? *timeColor[11] = gCriticalColor : float4(0.0f);
+	fP999 > criticalTime ? *timeColor[12] = gCriticalColor : float4(0.0f);
+	fSpikeCount > criticalCount ? *timeColor[13] = gCriticalColor : float4(0.0f);
 }
 
 void resetProfilerUI()
@@ -1161,6 +1223,9 @@ void profileLoadWidgetUI(Profile& S)
 
 	topMenu.push_back(tf_placement_new<CheckboxWidget>(tf_calloc(1, sizeof(CheckboxWidget)), "Profiler Paused", &gProfilerPaused));
 	topMenu.back()->pOnEdited = profileCallbkPauseProfiler;
+	gProfileCaptureRunning = isProfileCaptureRunning();
+	topMenu.push_back(tf_placement_new<CheckboxWidget>(tf_calloc(1, sizeof(CheckboxWidget)), "Stream Capture To File", &gProfileCaptureRunning));
+	topMenu.back()->pOnEdited = profileCallbkStreamCapture;
 	pWidgetGuiComponent->AddWidget(ColumnWidget("topmenu", topMenu));
 	gWidgetTable.push_back(topMenu);
 	pWidgetGuiComponent->AddWidget(SeparatorWidget());
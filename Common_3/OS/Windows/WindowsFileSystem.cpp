@@ -61,6 +61,8 @@ static char gDocumentsPath[FS_MAX_PATH] = {};
 
 bool initFileSystem(FileSystemInitDesc* pDesc)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_FILESYSTEM);
+
 	if (gInitialized)
 	{
 		LOGF(LogLevel::eWARNING, "FileSystem already initialized.");
@@ -52,6 +52,9 @@ void _FailedAssert(const char* file, int line, const char* statement)
 {
 	static bool debug = true;
 
+	// Make sure queued log messages leading up to the assert are written out
+	Log::Flush();
+
 	if (debug)
 	{
 		WCHAR str[1024];
@@ -208,5 +208,8 @@ LONG WindowsStackTrace::Dump(EXCEPTION_POINTERS * pExceptionInfo)
 
 	SymCleanup(process);
 
+	// The process is about to go down, write out anything still sitting in the async log queue
+	Log::Flush();
+
 	return EXCEPTION_EXECUTE_HANDLER;
 }
\ No newline at end of file
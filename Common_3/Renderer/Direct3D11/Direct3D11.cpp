@@ -696,6 +696,22 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 	D3D11_MAPPED_SUBRESOURCE sub = {};
 	UINT subresource = D3D11CalcSubresource(pSubresourceDesc->mMipLevel, pSubresourceDesc->mArrayLayer, (uint32_t)pTexture->mMipLevels);
 
+	// The source may only hold a range of block rows or depth slices of the subresource
+	const TinyImageFormat fmt = (TinyImageFormat)pTexture->mFormat;
+	const uint32_t blockWidth = TinyImageFormat_WidthOfBlock(fmt);
+	const uint32_t blockHeight = TinyImageFormat_HeightOfBlock(fmt);
+	const uint32_t width = round_up(max(1u, (uint32_t)(pTexture->mWidth >> pSubresourceDesc->mMipLevel)), blockWidth);
+	const uint32_t height = round_up(max(1u, (uint32_t)(pTexture->mHeight >> pSubresourceDesc->mMipLevel)), blockHeight);
+	const uint32_t depth = max(1u, (uint32_t)(pTexture->mDepth >> pSubresourceDesc->mMipLevel));
+	D3D11_BOX box = {};
+	box.left = 0;
+	box.right = width;
+	box.top = pSubresourceDesc->mRowOffset * blockHeight;
+	box.bottom = min(height, (pSubresourceDesc->mRowOffset + pSubresourceDesc->mRowCount) * blockHeight);
+	box.front = pSubresourceDesc->mDepthOffset;
+	box.back = min(depth, pSubresourceDesc->mDepthOffset + pSubresourceDesc->mDepthCount);
+	const bool wholeSubresource = box.top == 0 && box.bottom == height && box.front == 0 && box.back == depth;
+
 	if (!pSrcBuffer->pCpuMappedAddress)
 	{
 		pContext->Map(pSrcBuffer->pDxResource, 0, D3D11_MAP_READ, 0, &sub);
@@ -706,7 +722,7 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 	}
 
 	pContext->UpdateSubresource(
-		pTexture->pDxResource, subresource, NULL, (uint8_t*)sub.pData + pSubresourceDesc->mSrcOffset,
+		pTexture->pDxResource, subresource, wholeSubresource ? NULL : &box, (uint8_t*)sub.pData + pSubresourceDesc->mSrcOffset,
 		pSubresourceDesc->mRowPitch, pSubresourceDesc->mSlicePitch);
 
 	if (!pSrcBuffer->pCpuMappedAddress)
@@ -1262,6 +1278,8 @@ static void remove_default_resources(Renderer* pRenderer)
 /************************************************************************/
 void initRenderer(const char* appName, const RendererDesc* settings, Renderer** ppRenderer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(ppRenderer);
 	ASSERT(settings);
 	ASSERT(settings->mShaderTarget <= shader_target_5_0);
@@ -1418,6 +1436,8 @@ void removeQueue(Renderer* pRenderer, Queue* pQueue)
 
 void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppSwapChain);
@@ -1624,6 +1644,8 @@ void removeCmd_n(Renderer* pRenderer, uint32_t cmdCount, Cmd** ppCmds)
 /************************************************************************/
 void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppRenderTarget);
@@ -1912,6 +1934,8 @@ void compileShader(
 
 void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mStages);
 	ASSERT(ppShaderProgram);
@@ -2086,6 +2110,8 @@ D3D11_USAGE util_to_dx_usage(ResourceMemoryUsage mem)
 
 void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	//verify renderer validity
 	ASSERT(pRenderer);
 	//verify adding at least 1 buffer
@@ -2254,6 +2280,8 @@ void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
 
 void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
 	ASSERT(ppTexture);
@@ -2611,6 +2639,8 @@ void removeTexture(Renderer* pRenderer, Texture* pTexture)
 /************************************************************************/
 void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatureDesc, RootSignature** ppRootSignature)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pRootSignatureDesc);
 	ASSERT(ppRootSignature);
@@ -2853,6 +2883,8 @@ void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
 
 void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipeline** ppPipeline)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(ppPipeline);
 	ASSERT(pDesc);
@@ -3092,6 +3124,15 @@ const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const
 	}
 }
 
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	ASSERT(pRootSignature);
+	ASSERT(pName);
+	using DescriptorNameToIndexMap = eastl::string_hash_map<uint32_t>;
+	DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap->mMap.find(pName);
+	return it != pRootSignature->pDescriptorNameToIndexMap->mMap.end() ? it->second : (uint32_t)-1;
+}
+
 typedef struct CBV
 {
 	ID3D11Buffer* pHandle;
@@ -3118,6 +3159,8 @@ typedef struct DescriptorDataArray
 
 void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppDescriptorSet);
@@ -4226,6 +4269,8 @@ void calculateMemoryStats(Renderer* pRenderer, char** stats) {}
 void calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* totalAllocatedBytes) {}
 
 void freeMemoryStats(Renderer* pRenderer, char* stats) {}
+
+void getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget) { *pBudget = {}; }
 /************************************************************************/
 // Debug Marker Implementation
 /************************************************************************/
@@ -247,6 +247,10 @@ struct SubresourceDataDesc
 	uint64_t mSrcOffset;
 	uint32_t mMipLevel;
 	uint32_t mArrayLayer;
+	uint32_t mRowOffset;
+	uint32_t mRowCount;
+	uint32_t mDepthOffset;
+	uint32_t mDepthCount;
 	uint32_t mRowPitch;
 	uint32_t mSlicePitch;
 };
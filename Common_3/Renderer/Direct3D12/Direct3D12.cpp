@@ -600,6 +600,14 @@ const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const
 		return NULL;
 	}
 }
+
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	ASSERT(pRootSignature);
+	ASSERT(pName);
+	DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap->mMap.find(pName);
+	return it != pRootSignature->pDescriptorNameToIndexMap->mMap.end() ? it->second : (uint32_t)-1;
+}
 /************************************************************************/
 // Globals
 /************************************************************************/
@@ -1671,6 +1679,18 @@ static bool AddDevice(Renderer* pRenderer)
 	LOGF(LogLevel::eINFO, "Revision id of selected gpu: %s", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mRevisionId);
 	LOGF(LogLevel::eINFO, "Preset of selected gpu: %s", presetLevelToString(pRenderer->pActiveGpuSettings->mGpuVendorPreset.mPresetLevel));
 
+#if !defined(XBOX)
+	// User mode driver version, the pipeline cache is only valid for the driver that produced it
+	LARGE_INTEGER umdVersion = {};
+	if (SUCCEEDED(pRenderer->pDxActiveGPU->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion)))
+	{
+		snprintf(
+			pRenderer->pActiveGpuSettings->mGpuVendorPreset.mGpuDriverVersion, MAX_GPU_VENDOR_STRING_LENGTH, "%u.%u.%u.%u",
+			HIWORD(umdVersion.HighPart), LOWORD(umdVersion.HighPart), HIWORD(umdVersion.LowPart), LOWORD(umdVersion.LowPart));
+		LOGF(LogLevel::eINFO, "Driver version of selected gpu: %s", pRenderer->pActiveGpuSettings->mGpuVendorPreset.mGpuDriverVersion);
+	}
+#endif
+
 	// Load functions
 	{
 		HMODULE module = hook_get_d3d12_module_handle();
@@ -1755,6 +1775,8 @@ static void RemoveDevice(Renderer* pRenderer)
 /************************************************************************/
 void initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppRenderer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(appName);
 	ASSERT(pDesc);
 	ASSERT(ppRenderer);
@@ -2250,6 +2272,8 @@ void toggleVSync(Renderer* pRenderer, SwapChain** ppSwapChain)
 
 void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppSwapChain);
@@ -2372,6 +2396,8 @@ void removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain)
 
 void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	//verify renderer validity
 	ASSERT(pRenderer);
 	//verify adding at least 1 buffer
@@ -2658,6 +2684,8 @@ void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
 
 void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
 	if (pDesc->mSampleCount > SAMPLE_COUNT_1 && pDesc->mMipLevels > 1)
@@ -3057,6 +3085,8 @@ void removeTexture(Renderer* pRenderer, Texture* pTexture)
 
 void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppRenderTarget);
@@ -3431,6 +3461,8 @@ void compileShader(
 
 void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mStages);
 	ASSERT(ppShaderProgram);
@@ -3551,6 +3583,8 @@ void removeShader(Renderer* pRenderer, Shader* pShaderProgram)
 /************************************************************************/
 void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatureDesc, RootSignature** ppRootSignature)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer->pActiveGpuSettings->mMaxRootSignatureDWORDS > 0);
 	ASSERT(ppRootSignature);
 
@@ -4066,6 +4100,8 @@ void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
 /************************************************************************/
 void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppDescriptorSet);
@@ -4857,6 +4893,8 @@ void addComputePipeline(Renderer* pRenderer, const PipelineDesc* pMainDesc, Pipe
 
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	switch (pDesc->mType)
 	{
 		case (PIPELINE_TYPE_COMPUTE):
@@ -5435,6 +5473,10 @@ typedef struct SubresourceDataDesc
 	uint64_t                           mSrcOffset;
 	uint32_t                           mMipLevel;
 	uint32_t                           mArrayLayer;
+	uint32_t                           mRowOffset;
+	uint32_t                           mRowCount;
+	uint32_t                           mDepthOffset;
+	uint32_t                           mDepthCount;
 } SubresourceDataDesc;
 
 void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pDesc)
@@ -5448,13 +5490,18 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 	src.pResource = pSrcBuffer->pDxResource;
 	pCmd->pRenderer->pDxDevice->GetCopyableFootprints(&resourceDesc, subresource, 1, pDesc->mSrcOffset, &src.PlacedFootprint, NULL, NULL, NULL);
 	src.PlacedFootprint.Offset = pDesc->mSrcOffset;
+	// The source may only hold a range of block rows or depth slices of the subresource
+	const UINT blockHeight = TinyImageFormat_HeightOfBlock((TinyImageFormat)pTexture->mFormat);
+	const UINT rowOffset = pDesc->mRowOffset * blockHeight;
+	src.PlacedFootprint.Footprint.Height = min(src.PlacedFootprint.Footprint.Height, (pDesc->mRowOffset + pDesc->mRowCount) * blockHeight) - rowOffset;
+	src.PlacedFootprint.Footprint.Depth = min(src.PlacedFootprint.Footprint.Depth - pDesc->mDepthOffset, pDesc->mDepthCount);
 	dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
 	dst.pResource = pTexture->pDxResource;
 	dst.SubresourceIndex = subresource;
 #if defined(XBOX)
-	pCmd->mDma.pDxCmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, NULL);
+	pCmd->mDma.pDxCmdList->CopyTextureRegion(&dst, 0, rowOffset, pDesc->mDepthOffset, &src, NULL);
 #else
-	pCmd->pDxCmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, NULL);
+	pCmd->pDxCmdList->CopyTextureRegion(&dst, 0, rowOffset, pDesc->mDepthOffset, &src, NULL);
 #endif
 }
 
@@ -5868,6 +5915,18 @@ void calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* tota
 }
 
 void freeMemoryStats(Renderer* pRenderer, char* stats) { tf_free(stats); }
+
+void getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget)
+{
+	ASSERT(pRenderer);
+	ASSERT(pBudget);
+
+	// Queried through IDXGIAdapter3::QueryVideoMemoryInfo by the allocator, refreshed every few allocations
+	D3D12MA::Budget gpuBudget = {};
+	pRenderer->pResourceAllocator->GetBudget(&gpuBudget, NULL);
+	pBudget->mUsage = gpuBudget.UsageBytes;
+	pBudget->mBudget = gpuBudget.BudgetBytes;
+}
 /************************************************************************/
 // Debug Marker Implementation
 /************************************************************************/
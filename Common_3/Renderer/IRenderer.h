@@ -626,6 +626,8 @@ typedef enum BufferCreationFlags
 	BUFFER_CREATION_FLAG_ESRAM = 0x08,
 	/// Flag to specify not to allocate descriptors for the resource
 	BUFFER_CREATION_FLAG_NO_DESCRIPTOR_VIEW_CREATION = 0x10,
+	/// GPU only buffer defragmentMemory may move (Vulkan only). Its native handle changes, so descriptor sets using it have to be updated again after a move
+	BUFFER_CREATION_FLAG_MOVABLE_BIT = 0x20,
     
 #ifdef METAL
     /* ICB Flags */
@@ -1460,6 +1462,7 @@ COMPILE_ASSERT(sizeof(RootSignature) <= 16 * sizeof(uint64_t));
 typedef struct DescriptorData
 {
 	/// User can either set name of descriptor or index (index in pRootSignature->pDescriptors array)
+	/// Resolve the index once with getDescriptorIndexFromName to skip the name lookup on every update
 	/// Name of descriptor
 	const char* pName;
 	union
@@ -1642,7 +1645,9 @@ typedef struct DEFINE_ALIGNED(Cmd, 64)
 	uint32_t                     mType : 3;
 	uint32_t                     mPadA;
 	CmdPool*                     pCmdPool;
-	uint64_t                     mPadB[9];
+	/// Barriers recorded by cmdResourceBarrier wait here until the next command that needs them
+	struct CmdBarrierBatch*      pBarrierBatch;
+	uint64_t                     mPadB[8];
 #endif
 #if defined(METAL)
 	id<MTLCommandBuffer>         mtlCommandBuffer;
@@ -1947,6 +1952,8 @@ typedef struct Shader
 	GLuint						  mProgram;
 	GLuint						  mVertexShader;
 	GLuint						  mFragmentShader;
+	/// Hash of the vertex and fragment source, keys the linked program in the PipelineCache
+	uint64_t					  mSourceHash;
 #endif
 	PipelineReflection*           pReflection;
 } Shader;
@@ -2173,6 +2180,11 @@ typedef struct DEFINE_ALIGNED(Pipeline, 64)
 	GLuint						mShaderProgram;
 	PipelineType				mType;
 	GLenum					    mGlPrimitiveTopology;
+	/// Bit per vertex attribute location used by pVertexLayout
+	uint32_t					mVertexAttribMask;
+	/// Locations of the vertexID / instanceID uniforms emulating gl_VertexID / gl_InstanceID, -1 if unused
+	GLint						mVertexIDLocation;
+	GLint						mInstanceIDLocation;
 #endif
 } Pipeline;
 #if defined(DIRECT3D11) || defined(ORBIS)
@@ -2210,6 +2222,10 @@ typedef struct PipelineCache
 #if defined(VULKAN)
 	VkPipelineCache        pCache;
 #endif
+#if defined(GLES)
+	/// Linked program binaries (GL_OES_get_program_binary) by shader source and vertex layout hash
+	struct GLProgramBinaryCache* pProgramBinaries;
+#endif
 } PipelineCache;
 
 typedef struct SwapChainDesc
@@ -2504,6 +2520,7 @@ typedef struct DEFINE_ALIGNED(Renderer, 64)
 	uint32_t**                      pUsedQueueCount;
 	struct DescriptorPool*          pDescriptorPool;
 	struct VmaAllocator_T*          pVmaAllocator;
+	struct MovableBufferRegistry*   pMovableBuffers;
 	uint32_t                        mRaytracingExtension : 1;
 	union
 	{
@@ -2606,6 +2623,32 @@ typedef struct DescriptorSetDesc
 	uint32_t                   mNodeIndex;
 } DescriptorSetDesc;
 
+#if defined(VULKAN)
+/// Transient descriptor sets for multi-threaded command recording. Every (thread, frame in flight) pair owns its own
+/// descriptor pools, so addTransientDescriptorSet never locks. Sets live until resetDescriptorSetAllocator for their frame
+typedef struct DescriptorSetAllocator DescriptorSetAllocator;
+
+#define DESCRIPTOR_SET_ALLOCATOR_DEFAULT_SETS_PER_POOL 256
+
+typedef struct DescriptorSetAllocatorDesc
+{
+	/// Number of threads recording at the same time, each one passes its own threadIndex
+	uint32_t mThreadCount;
+	/// Number of frames in flight
+	uint32_t mFrameCount;
+	/// Sets per descriptor pool, a thread chains another pool when it runs out. 0 uses DESCRIPTOR_SET_ALLOCATOR_DEFAULT_SETS_PER_POOL
+	uint32_t mSetsPerPool;
+} DescriptorSetAllocatorDesc;
+#endif
+
+typedef struct MemoryBudget
+{
+	/// Bytes of device local memory used by the process, 0 if the backend can't tell
+	uint64_t mUsage;
+	/// Bytes of device local memory the process can use before the OS starts paging or failing allocations, 0 if the backend can't tell
+	uint64_t mBudget;
+} MemoryBudget;
+
 typedef struct QueueSubmitDesc
 {
 	uint32_t    mCmdCount;
@@ -2686,6 +2729,16 @@ API_INTERFACE void FORGE_CALLCONV removePipelineCache(Renderer* pRenderer, Pipel
 API_INTERFACE void FORGE_CALLCONV addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** pDescriptorSet);
 API_INTERFACE void FORGE_CALLCONV removeDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet);
 API_INTERFACE void FORGE_CALLCONV updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDescriptorSet, uint32_t count, const DescriptorData* pParams);
+// Index of the descriptor in pRootSignature->pDescriptors for DescriptorData::mIndex and cmdBindPushConstantsByIndex, (uint32_t)-1 if the root signature has no such descriptor
+API_INTERFACE uint32_t FORGE_CALLCONV getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName);
+#if defined(VULKAN)
+API_INTERFACE void FORGE_CALLCONV addDescriptorSetAllocator(Renderer* pRenderer, const DescriptorSetAllocatorDesc* pDesc, DescriptorSetAllocator** ppAllocator);
+API_INTERFACE void FORGE_CALLCONV removeDescriptorSetAllocator(Renderer* pRenderer, DescriptorSetAllocator* pAllocator);
+// Call once the fence of frameIndex signaled. Releases every transient set of that frame at once, the pools are kept for reuse
+API_INTERFACE void FORGE_CALLCONV resetDescriptorSetAllocator(Renderer* pRenderer, DescriptorSetAllocator* pAllocator, uint32_t frameIndex);
+// Use like a set from addDescriptorSet but never pass it to removeDescriptorSet. Only threadIndex may call this for (threadIndex, frameIndex) until the next reset
+API_INTERFACE void FORGE_CALLCONV addTransientDescriptorSet(Renderer* pRenderer, DescriptorSetAllocator* pAllocator, uint32_t threadIndex, uint32_t frameIndex, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet);
+#endif
 
 // command buffer functions
 API_INTERFACE void FORGE_CALLCONV resetCmdPool(Renderer* pRenderer, CmdPool* pCmdPool);
@@ -2752,6 +2805,16 @@ API_INTERFACE void FORGE_CALLCONV cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPo
 API_INTERFACE void FORGE_CALLCONV calculateMemoryStats(Renderer* pRenderer, char** stats);
 API_INTERFACE void FORGE_CALLCONV calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* totalAllocatedBytes);
 API_INTERFACE void FORGE_CALLCONV freeMemoryStats(Renderer* pRenderer, char* stats);
+// Current usage and budget of device local memory, cheap enough to call every frame
+API_INTERFACE void FORGE_CALLCONV getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget);
+#if defined(VULKAN)
+// Load time compaction: moves up to maxBytesToMove of buffers created with BUFFER_CREATION_FLAG_MOVABLE_BIT to compact their memory
+// blocks, returns the number of buffers moved (at most maxMovedBuffers, written to ppMovedBuffers). Every call waits for pQueue to
+// idle and for the copies to finish, so call it where a stall is acceptable (level load, loading screen, after unloading a large set
+// of resources), not every frame. Other queues using movable buffers have to be idle as well. Update descriptor sets of the moved
+// buffers afterwards
+API_INTERFACE uint32_t FORGE_CALLCONV defragmentMemory(Renderer* pRenderer, Queue* pQueue, uint64_t maxBytesToMove, uint32_t maxMovedBuffers, Buffer** ppMovedBuffers);
+#endif
 /************************************************************************/
 // Debug Marker Interface
 /************************************************************************/
@@ -27,6 +27,8 @@
 #include "../Renderer/IRenderer.h"
 #include "../OS/Core/Atomics.h"
 
+struct ThreadSystem;
+
 typedef struct MappedMemoryRange
 {
 	uint8_t* pData;
@@ -57,6 +59,18 @@ typedef enum TextureContainerType
 
 // MARK: - Resource Loading
 
+/// Order in which the streamer processes texture and geometry loads, requests of the same priority are processed in the order they were added.
+/// Updates and barriers are always LOAD_PRIORITY_NORMAL.
+typedef enum LoadPriority
+{
+	LOAD_PRIORITY_NORMAL = 0,
+	/// Processed before everything else, e.g. textures close to the camera
+	LOAD_PRIORITY_HIGH,
+	/// Processed once nothing else is waiting, e.g. prefetching
+	LOAD_PRIORITY_LOW,
+	LOAD_PRIORITY_COUNT,
+} LoadPriority;
+
 typedef struct BufferLoadDesc
 {
 	Buffer**    ppBuffer;
@@ -79,6 +93,7 @@ typedef struct TextureLoadDesc
 	TextureCreationFlags mCreationFlag;
 	/// The texture file format (dds/ktx/...)
 	TextureContainerType mContainer;
+	LoadPriority         mPriority;
 } TextureLoadDesc;
 
 typedef struct Geometry
@@ -151,6 +166,7 @@ typedef struct GeometryLoadDesc
 	uint32_t          mNodeIndex;
 	/// Specifies how to arrange the vertex data loaded from the file into GPU memory
 	VertexLayout*     pVertexLayout;
+	LoadPriority      mPriority;
 } GeometryLoadDesc;
 
 typedef struct VirtualTexturePageInfo
@@ -268,6 +284,12 @@ typedef struct ResourceLoaderDesc
 	uint64_t mBufferSize;
 	uint32_t mBufferCount;
 	bool     mSingleThreaded;
+	/// Bytes the streamer uploads before submitting and leaving the remaining requests for its next iteration, 0 for no limit.
+	/// Bounds the copy work in flight so high priority requests added later do not wait behind a large batch. Ignored when single threaded.
+	uint64_t mIterationByteBudget;
+	/// Bytes of mips streaming textures may keep resident, 0 for no limit. See setStreamingTextureBudget.
+	/// Streaming never grows past STREAMING_TEXTURE_DEVICE_BUDGET_PERCENT of the getMemoryBudget budget either, and gives memory back above it.
+	uint64_t mStreamingTextureBudget;
 } ResourceLoaderDesc;
 
 extern ResourceLoaderDesc gDefaultResourceLoaderDesc;
@@ -318,10 +340,116 @@ void waitForAllResourceLoads();
 SyncToken getLastTokenCompleted();
 bool isTokenCompleted(const SyncToken* token);
 void waitForToken(const SyncToken* token);
+/// Cancels the load or update that set this token if the streamer has not started it yet, returns whether it was cancelled.
+/// Use a token that was zero before the addResource / endUpdateResource call, barriers can not be cancelled.
+/// A cancelled request counts as completed, its resource is neither created nor updated.
+bool cancelToken(const SyncToken* token);
+
+// MARK: Streaming Textures
+
+/// A texture loaded with only its smallest mips, the rest are streamed in from the file when requested and dropped again
+/// when no longer requested or over the budget. Streaming loads reuse the dds / ktx / basis path of addResource(TextureLoadDesc*).
+typedef struct StreamingTexture StreamingTexture;
+
+typedef struct StreamingTextureLoadDesc
+{
+	StreamingTexture**   ppStreamingTexture;
+	/// Filename without extension. Extension will be determined based on mContainer
+	const char*          pFileName;
+	/// The index of the GPU in SLI/Cross-Fire that owns this texture
+	uint32_t             mNodeIndex;
+	TextureCreationFlags mCreationFlag;
+	TextureContainerType mContainer;
+	/// Priority of the first load, later streaming loads use LOAD_PRIORITY_NORMAL for more mips and LOAD_PRIORITY_LOW for fewer
+	LoadPriority         mPriority;
+	/// Smallest mips loaded up front and never evicted, 0 for STREAMING_TEXTURE_DEFAULT_RESIDENT_MIPS
+	uint32_t             mMinResidentMips;
+} StreamingTextureLoadDesc;
+
+#define STREAMING_TEXTURE_DEFAULT_RESIDENT_MIPS 4
+
+/// The texture becomes available like with addResource(TextureLoadDesc*), the token covers the first load only.
+void addStreamingTexture(StreamingTextureLoadDesc* pDesc, SyncToken* token);
+/// Same requirements as removeResource(Texture*), the GPU must be done with every texture getStreamingTexture returned.
+void removeStreamingTexture(StreamingTexture* pStreamingTexture);
+
+/// Texture to bind for this frame, NULL until the first load completed. It only changes in updateStreamingTextures.
+/// Mip 0 of the returned texture is the most detailed mip resident, sampling with normalized coordinates needs no adjustment.
+Texture* getStreamingTexture(const StreamingTexture* pStreamingTexture);
+
+/// Requests mips down to (and including) mip for the next updateStreamingTextures, mip 0 being the full resolution of the file.
+/// Can be called from any thread, the most detailed request of the frame wins.
+void requestStreamingTextureMip(StreamingTexture* pStreamingTexture, uint32_t mip);
+/// Requests the mips needed to draw the texture over about screenSize pixels along its largest dimension.
+/// Ignored until the first load completed.
+void requestStreamingTextureScreenSize(StreamingTexture* pStreamingTexture, float screenSize);
+
+/// Call once per frame from the thread adding and removing streaming textures. Swaps in completed loads, evicts mips
+/// not requested for STREAMING_TEXTURE_EVICT_FRAMES calls or not fitting the budget and queues the loads for the rest.
+/// Evicting loads the smaller mip chain from the file again, the budget is exceeded while a load is in flight.
+/// Returns how many streaming textures changed what getStreamingTexture returns, their descriptors need to be updated.
+/// Replaced textures are kept alive for STREAMING_TEXTURE_RETIRE_FRAMES calls so frames in flight can finish with them.
+uint32_t updateStreamingTextures();
+
+#define STREAMING_TEXTURE_RETIRE_FRAMES 4
+#define STREAMING_TEXTURE_EVICT_FRAMES 120
+#define STREAMING_TEXTURE_DEVICE_BUDGET_PERCENT 90
+
+void setStreamingTextureBudget(uint64_t budget);
+
+// MARK: Statistics
+
+typedef struct ResourceLoaderStats
+{
+	/// Bytes suballocated from the copy engine staging buffers
+	uint64_t mStagingBytes;
+	/// Most of one staging buffer in use at once, and the size of a staging buffer
+	uint64_t mStagingPeakBytes;
+	uint64_t mStagingCapacityBytes;
+	/// Temporary upload buffers created because a request did not fit an empty staging buffer or came from beginUpdateResource
+	uint64_t mTempBufferCount;
+	uint64_t mTempBufferBytes;
+	/// Times an upload filled the staging buffer and the streamer submitted early to carry on in the next one
+	uint64_t mStagingFlushCount;
+	/// Times the streamer blocked on the fence of a copy engine set, and for how long
+	uint64_t mCopyEngineWaitCount;
+	uint64_t mCopyEngineWaitUs;
+	/// Times a caller blocked in waitForToken / waitForAllResourceLoads, and for how long
+	uint64_t mTokenWaitCount;
+	uint64_t mTokenWaitUs;
+	uint64_t mRequestsQueued;
+	uint64_t mRequestsProcessed;
+	uint64_t mRequestsCancelled;
+	/// Requests waiting for the streamer right now, and the most there have been
+	uint64_t mRequestQueueDepth;
+	uint64_t mRequestQueueDepthPeak;
+	/// Bytes of mips resident in streaming textures right now, including loads in flight, and the budget they were last held to
+	uint64_t mStreamingResidentBytes;
+	uint64_t mStreamingBudgetBytes;
+	/// Device local memory use of the process and its budget from getMemoryBudget, 0 if the backend can't tell
+	uint64_t mDeviceMemoryUsageBytes;
+	uint64_t mDeviceMemoryBudgetBytes;
+	/// Streaming loads queued for more mips, and for fewer mips to free memory
+	uint64_t mStreamingMipLoads;
+	uint64_t mStreamingMipEvictions;
+} ResourceLoaderStats;
+
+/// Always on counters summed over all threads since start or the last resetResourceLoaderStats.
+/// Also published as "ResourceLoader/..." and "FileSystem/..." profiler counters, file reads per directory come from fsGetStats.
+void getResourceLoaderStats(ResourceLoaderStats* pOutStats);
+void resetResourceLoaderStats();
 
 /// Either loads the cached shader bytecode or compiles the shader to create new bytecode depending on whether source is newer than binary
 void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** pShader);
 
 /// Save/Load pipeline cache from disk
+/// The file is keyed by the active GPU and driver version, a file written on another device or driver is ignored and the cache starts empty
 void addPipelineCache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, PipelineCache** ppPipelineCache);
 void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, PipelineCacheSaveDesc* pDesc);
+
+/// Creates ppPipelines[i] from pDescs[i] for a whole batch, e.g. all pipelines of a level, spread over the workers of pThreadSystem.
+/// The calling thread helps until the batch is done. Pass NULL to create them one after the other on the calling thread.
+/// Descs with the same content (shaders, root signature, states, formats) are created once and share the Pipeline, so
+/// release the batch with removePipelines instead of calling removePipeline for each entry
+void addPipelines(Renderer* pRenderer, ThreadSystem* pThreadSystem, uint32_t count, const PipelineDesc* pDescs, Pipeline** ppPipelines);
+void removePipelines(Renderer* pRenderer, uint32_t count, Pipeline** ppPipelines);
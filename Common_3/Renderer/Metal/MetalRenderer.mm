@@ -296,6 +296,14 @@ const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const
 		return NULL;
 	}
 }
+
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	ASSERT(pRootSignature);
+	ASSERT(pName);
+	decltype(pRootSignature->pDescriptorNameToIndexMap->mMap)::const_iterator it = pRootSignature->pDescriptorNameToIndexMap->mMap.find(pName);
+	return it != pRootSignature->pDescriptorNameToIndexMap->mMap.end() ? it->second : (uint32_t)-1;
+}
 /************************************************************************/
 // Misc
 /************************************************************************/
@@ -463,6 +471,8 @@ void cmdBindPushConstantsByIndex(Cmd* pCmd, RootSignature* pRootSignature, uint3
 //
 void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
     ASSERT(pRenderer);
     ASSERT(pDesc);
     ASSERT(ppDescriptorSet);
@@ -883,6 +893,21 @@ void freeMemoryStats(Renderer* pRenderer, char* pStats)
 {
 	vmaFreeStatsString(pRenderer->pVmaAllocator, pStats);
 }
+
+void getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget)
+{
+	ASSERT(pRenderer);
+	ASSERT(pBudget);
+
+	*pBudget = {};
+	if (@available(macOS 10.13, iOS 11.0, *))
+	{
+		pBudget->mUsage = [pRenderer->pDevice currentAllocatedSize];
+	}
+#if !defined(TARGET_IOS)
+	pBudget->mBudget = [pRenderer->pDevice recommendedMaxWorkingSetSize];
+#endif
+}
 /************************************************************************/
 // Pipeline state functions
 /************************************************************************/
@@ -1627,6 +1652,8 @@ static uint32_t util_find_heap_with_space(Renderer* pRenderer, ResourceMemoryUsa
 
 void initRenderer(const char* appName, const RendererDesc* settings, Renderer** ppRenderer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	Renderer* pRenderer = (Renderer*)tf_calloc_memalign(1, alignof(Renderer), sizeof(*pRenderer));
 	ASSERT(pRenderer);
 
@@ -2166,6 +2193,8 @@ void toggleVSync(Renderer* pRenderer, SwapChain** ppSwapchain)
 
 void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppSwapChain);
@@ -2252,6 +2281,8 @@ void removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain)
 
 void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(ppBuffer);
 	ASSERT(pDesc);
@@ -2433,6 +2464,8 @@ void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
 
 void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
 	if (pDesc->mSampleCount > SAMPLE_COUNT_1 && pDesc->mMipLevels > 1)
@@ -2480,6 +2513,8 @@ void removeTexture(Renderer* pRenderer, Texture* pTexture)
 
 void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppRenderTarget);
@@ -2725,6 +2760,8 @@ void addShader(Renderer* pRenderer, const ShaderDesc* pDesc, Shader** ppShaderPr
 
 void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mStages);
 	ASSERT(ppShaderProgram);
@@ -2829,6 +2866,8 @@ void removeShader(Renderer* pRenderer, Shader* pShaderProgram)
 
 void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatureDesc, RootSignature** ppRootSignature)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pRenderer->pDevice != nil);
 	ASSERT(ppRootSignature);
@@ -3339,6 +3378,8 @@ extern void removeRaytracingPipeline(RaytracingPipeline* pPipeline);
     
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
     ASSERT(pRenderer);
     ASSERT(pRenderer->pDevice != nil);
     
@@ -4296,16 +4337,26 @@ typedef struct SubresourceDataDesc
 	uint64_t mSrcOffset;
 	uint32_t mMipLevel;
 	uint32_t mArrayLayer;
+	uint32_t mRowOffset;
+	uint32_t mRowCount;
+	uint32_t mDepthOffset;
+	uint32_t mDepthCount;
 	uint32_t mRowPitch;
 	uint32_t mSlicePitch;
 } SubresourceDataDesc;
 
 void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pIntermediate, const SubresourceDataDesc* pSubresourceDesc)
 {
+	// The source may only hold a range of block rows or depth slices of the subresource
+	const uint32_t blockHeight = TinyImageFormat_HeightOfBlock((TinyImageFormat)pTexture->mFormat);
+	const uint32_t height = max(1u, (uint32_t)(pTexture->mHeight >> pSubresourceDesc->mMipLevel));
+	const uint32_t depth = max(1u, (uint32_t)(pTexture->mDepth >> pSubresourceDesc->mMipLevel));
+	const uint32_t rowOffset = pSubresourceDesc->mRowOffset * blockHeight;
+	MTLOrigin destinationOrigin = MTLOriginMake(0, rowOffset, pSubresourceDesc->mDepthOffset);
 	MTLSize sourceSize = MTLSizeMake(
-			max(1, pTexture->mWidth >> pSubresourceDesc->mMipLevel),
-			max(1, pTexture->mHeight >> pSubresourceDesc->mMipLevel),
-			max(1, pTexture->mDepth >> pSubresourceDesc->mMipLevel));
+			max(1u, (uint32_t)(pTexture->mWidth >> pSubresourceDesc->mMipLevel)),
+			min(height, (pSubresourceDesc->mRowOffset + pSubresourceDesc->mRowCount) * blockHeight) - rowOffset,
+			min(depth - pSubresourceDesc->mDepthOffset, pSubresourceDesc->mDepthCount));
 	
 #ifdef TARGET_IOS
     uint64_t formatNamespace = (TinyImageFormat_Code((TinyImageFormat)pTexture->mFormat) & ((1 << TinyImageFormat_NAMESPACE_REQUIRED_BITS) - 1));
@@ -4314,7 +4365,7 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pIntermediate, c
 	// PVRTC - replaceRegion is the most straightforward method
 	if (isPvrtc)
 	{
-		MTLRegion region = MTLRegionMake3D(0, 0, 0, sourceSize.width, sourceSize.height, sourceSize.depth);
+		MTLRegion region = MTLRegionMake3D(destinationOrigin.x, destinationOrigin.y, destinationOrigin.z, sourceSize.width, sourceSize.height, sourceSize.depth);
 		[pTexture->mtlTexture replaceRegion:region mipmapLevel:pSubresourceDesc->mMipLevel withBytes:(uint8_t*)pIntermediate->pCpuMappedAddress + pSubresourceDesc->mSrcOffset bytesPerRow:0];
 		return;
 	}
@@ -4335,7 +4386,7 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pIntermediate, c
 							   toTexture:pTexture->mtlTexture
 						destinationSlice:pSubresourceDesc->mArrayLayer
 						destinationLevel:pSubresourceDesc->mMipLevel
-					   destinationOrigin:MTLOriginMake(0, 0, 0)
+					   destinationOrigin:destinationOrigin
 								 options:MTLBlitOptionNone];
 }
 
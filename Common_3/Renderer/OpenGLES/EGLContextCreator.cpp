@@ -222,4 +222,9 @@ void getGLSurfaceSize(unsigned int* width, unsigned int* height)
 		*height = gSurfaceHeight;
 }
 
+void* getGLProcAddress(const char* pProcName)
+{
+	return (void*)eglGetProcAddress(pProcName);
+}
+
 #endif
\ No newline at end of file
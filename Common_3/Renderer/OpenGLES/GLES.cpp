@@ -27,15 +27,18 @@
 
 #include "../../ThirdParty/OpenSource/EASTL/functional.h"
 #include "../../ThirdParty/OpenSource/EASTL/string_hash_map.h"
+#include "../../ThirdParty/OpenSource/EASTL/hash_map.h"
 #include "../../ThirdParty/OpenSource/EASTL/sort.h"
 #include "../../OS/Interfaces/ILog.h"
 #include "../IRenderer.h"
 #include "../../OS/Core/RingBuffer.h"
+#include "../../OS/Core/Atomics.h"
 #include "../../ThirdParty/OpenSource/EASTL/functional.h"
 #include "../../OS/Core/GPUConfig.h"
 #include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
 #include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
 #include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_apis.h"
+#include "../../ThirdParty/OpenSource/murmurhash3/MurmurHash3_32.h"
 
 #include "GLESContextCreator.h"
 #include "GLESCapsBuilder.h"
@@ -359,6 +362,293 @@ static inline void util_gl_set_uniform(uint32_t location, uint8_t* data, GLenum
 	}
 }
 
+/************************************************************************/
+// GL state cache
+/************************************************************************/
+// GL state last set through the functions below, calls that would not change it are skipped.
+// GL state belongs to the context and every context is current on its own thread (the resource loader creates a
+// shared one for its thread), so the cache is thread local. It starts out unknown so the first call always goes through.
+#define GL_STATE_CACHE_MAX_TEXTURE_UNITS 32
+
+typedef enum GLStateCacheCap
+{
+	GL_STATE_CACHE_CAP_CULL_FACE = 0,
+	GL_STATE_CACHE_CAP_SCISSOR_TEST,
+	GL_STATE_CACHE_CAP_DEPTH_TEST,
+	GL_STATE_CACHE_CAP_STENCIL_TEST,
+	GL_STATE_CACHE_CAP_BLEND,
+	GL_STATE_CACHE_CAP_COUNT,
+} GLStateCacheCap;
+
+struct GLStateCache
+{
+	GLuint   mProgram;
+	GLuint   mArrayBuffer;
+	GLuint   mElementArrayBuffer;
+	/// gBufferDeleteGeneration the buffer bindings above were cached at
+	uint32_t mBufferGeneration;
+	GLuint   mActiveTexture;
+	/// Texture bound to GL_TEXTURE_2D / GL_TEXTURE_CUBE_MAP of every unit
+	GLuint   mTextures[GL_STATE_CACHE_MAX_TEXTURE_UNITS][2];
+	uint32_t mEnabledCaps;
+	uint32_t mKnownCaps;
+	uint32_t mEnabledVertexAttribs;
+	GLenum   mCullFace;
+	GLenum   mFrontFace;
+	GLint    mDepthMask;
+	GLenum   mDepthFunc;
+	GLuint   mStencilWriteMask;
+	/// Front and back stencil func and ops
+	GLenum   mStencilFunc[2];
+	GLenum   mStencilOp[2][3];
+	GLenum   mBlendFunc[4];
+	GLenum   mBlendEquation[2];
+	GLint    mViewport[4];
+	GLfloat  mDepthRange[2];
+	GLint    mScissor[4];
+	GLfloat  mClearColor[4];
+	GLfloat  mClearDepth;
+	GLint    mClearStencil;
+};
+
+static thread_local GLStateCache gStateCache;
+static thread_local bool         gStateCacheValid = false;
+// Bumped before a buffer is deleted. GL can hand the name out again right away, the caches of the other threads
+// (the loader has its own context) must not skip binding the new buffer because they still see the old one bound
+static tfrg_atomic32_t           gBufferDeleteGeneration = 0;
+
+/// Forgets all cached state, call when GL state was changed behind the cache
+static void util_gl_reset_state_cache()
+{
+	// All bits set never matches a real name or enum, and is NaN for the floats.
+	// mEnabledVertexAttribs then has every attribute enabled, so the first pipeline disables the ones it does not use
+	memset(&gStateCache, 0xFF, sizeof(gStateCache));
+	gStateCache.mKnownCaps = 0;
+	gStateCacheValid = true;
+}
+
+static inline GLStateCache* util_gl_state_cache()
+{
+	if (!gStateCacheValid)
+		util_gl_reset_state_cache();
+	return &gStateCache;
+}
+
+static inline void util_gl_use_program(GLuint program)
+{
+	GLStateCache* pCache = util_gl_state_cache();
+	if (pCache->mProgram != program)
+	{
+		CHECK_GLRESULT(glUseProgram(program));
+		pCache->mProgram = program;
+	}
+}
+
+static inline void util_gl_bind_buffer(GLenum target, GLuint buffer)
+{
+	GLStateCache*  pCache = util_gl_state_cache();
+	const uint32_t generation = tfrg_atomic32_load_acquire(&gBufferDeleteGeneration);
+	if (pCache->mBufferGeneration != generation)
+	{
+		pCache->mArrayBuffer = ~0u;
+		pCache->mElementArrayBuffer = ~0u;
+		pCache->mBufferGeneration = generation;
+	}
+	GLuint*        pBound = target == GL_ELEMENT_ARRAY_BUFFER ? &pCache->mElementArrayBuffer : &pCache->mArrayBuffer;
+	if (*pBound != buffer)
+	{
+		CHECK_GLRESULT(glBindBuffer(target, buffer));
+		*pBound = buffer;
+	}
+}
+
+/// Makes every thread forget its cached buffer bindings, the next util_gl_bind_buffer always binds
+static inline void util_gl_delete_buffer(GLuint buffer)
+{
+	tfrg_atomic32_add_relaxed(&gBufferDeleteGeneration, 1);
+	CHECK_GLRESULT(glDeleteBuffers(1, &buffer));
+}
+
+static inline void util_gl_active_texture(GLuint unit)
+{
+	GLStateCache* pCache = util_gl_state_cache();
+	if (pCache->mActiveTexture != unit)
+	{
+		CHECK_GLRESULT(glActiveTexture(GL_TEXTURE0 + unit));
+		pCache->mActiveTexture = unit;
+	}
+}
+
+/// Binds texture to target of the active texture unit
+static inline void util_gl_bind_texture(GLenum target, GLuint texture)
+{
+	GLStateCache* pCache = util_gl_state_cache();
+	GLuint*       pBound = NULL;
+	if (pCache->mActiveTexture < GL_STATE_CACHE_MAX_TEXTURE_UNITS)
+		pBound = &pCache->mTextures[pCache->mActiveTexture][target == GL_TEXTURE_CUBE_MAP ? 1 : 0];
+	if (!pBound || *pBound != texture)
+	{
+		CHECK_GLRESULT(glBindTexture(target, texture));
+		if (pBound)
+			*pBound = texture;
+	}
+}
+
+static inline void util_gl_set_cap(GLenum cap, GLStateCacheCap cacheCap, bool enable)
+{
+	GLStateCache*  pCache = util_gl_state_cache();
+	const uint32_t bit = 1u << cacheCap;
+	if (!(pCache->mKnownCaps & bit) || ((pCache->mEnabledCaps & bit) != 0) != enable)
+	{
+		CHECK_GLRESULT(enable ? glEnable(cap) : glDisable(cap));
+		pCache->mEnabledCaps = enable ? (pCache->mEnabledCaps | bit) : (pCache->mEnabledCaps & ~bit);
+		pCache->mKnownCaps |= bit;
+	}
+}
+
+/// Enables exactly the vertex attributes in mask
+static inline void util_gl_set_vertex_attribs(uint32_t mask)
+{
+	GLStateCache*  pCache = util_gl_state_cache();
+	const uint32_t changed = pCache->mEnabledVertexAttribs ^ mask;
+	for (uint32_t index = 0; index < MAX_VERTEX_ATTRIBS; ++index)
+	{
+		const uint32_t bit = 1u << index;
+		if (!(changed & bit))
+			continue;
+
+		if (mask & bit)
+		{
+			CHECK_GLRESULT(glEnableVertexAttribArray(index));
+		}
+		else
+		{
+			CHECK_GLRESULT(glDisableVertexAttribArray(index));
+		}
+	}
+	pCache->mEnabledVertexAttribs = mask;
+}
+
+static inline void util_gl_set_rasterizer_state(const GLRasterizerState* pState)
+{
+	GLStateCache* pCache = util_gl_state_cache();
+	util_gl_set_cap(GL_CULL_FACE, GL_STATE_CACHE_CAP_CULL_FACE, pState->mCullMode != GL_NONE);
+	if (pState->mCullMode != GL_NONE)
+	{
+		if (pCache->mCullFace != pState->mCullMode)
+		{
+			CHECK_GLRESULT(glCullFace(pState->mCullMode));
+			pCache->mCullFace = pState->mCullMode;
+		}
+		if (pCache->mFrontFace != pState->mFrontFace)
+		{
+			CHECK_GLRESULT(glFrontFace(pState->mFrontFace));
+			pCache->mFrontFace = pState->mFrontFace;
+		}
+	}
+
+	util_gl_set_cap(GL_SCISSOR_TEST, GL_STATE_CACHE_CAP_SCISSOR_TEST, pState->mScissorTest);
+}
+
+static inline void util_gl_set_depth_stencil_state(const GLDepthStencilState* pState)
+{
+	GLStateCache* pCache = util_gl_state_cache();
+	util_gl_set_cap(GL_DEPTH_TEST, GL_STATE_CACHE_CAP_DEPTH_TEST, pState->mDepthTest);
+	if (pState->mDepthTest)
+	{
+		if (pCache->mDepthMask != (GLint)pState->mDepthWrite)
+		{
+			CHECK_GLRESULT(glDepthMask(pState->mDepthWrite));
+			pCache->mDepthMask = pState->mDepthWrite;
+		}
+		if (pCache->mDepthFunc != pState->mDepthFunc)
+		{
+			CHECK_GLRESULT(glDepthFunc(pState->mDepthFunc));
+			pCache->mDepthFunc = pState->mDepthFunc;
+		}
+	}
+
+	util_gl_set_cap(GL_STENCIL_TEST, GL_STATE_CACHE_CAP_STENCIL_TEST, pState->mStencilTest);
+	if (pState->mStencilTest)
+	{
+		if (pCache->mStencilWriteMask != pState->mStencilWriteMask)
+		{
+			CHECK_GLRESULT(glStencilMask(pState->mStencilWriteMask));
+			pCache->mStencilWriteMask = pState->mStencilWriteMask;
+		}
+
+		const GLenum faces[2] = { GL_FRONT, GL_BACK };
+		const GLenum funcs[2] = { pState->mStencilFrontFunc, pState->mStencilBackFunc };
+		const GLenum ops[2][3] = {
+			{ pState->mStencilFrontFail, pState->mDepthFrontFail, pState->mStencilFrontPass },
+			{ pState->mStencilBackFail, pState->mDepthBackFail, pState->mStencilBackPass },
+		};
+		for (uint32_t face = 0; face < 2; ++face)
+		{
+			if (pCache->mStencilFunc[face] != funcs[face])
+			{
+				CHECK_GLRESULT(glStencilFuncSeparate(faces[face], funcs[face], 0, ~0));
+				pCache->mStencilFunc[face] = funcs[face];
+			}
+			if (memcmp(pCache->mStencilOp[face], ops[face], sizeof(ops[face])))
+			{
+				CHECK_GLRESULT(glStencilOpSeparate(faces[face], ops[face][0], ops[face][1], ops[face][2]));
+				memcpy(pCache->mStencilOp[face], ops[face], sizeof(ops[face]));
+			}
+		}
+	}
+}
+
+static inline void util_gl_set_blend_state(const GLBlendState* pState)
+{
+	GLStateCache* pCache = util_gl_state_cache();
+	util_gl_set_cap(GL_BLEND, GL_STATE_CACHE_CAP_BLEND, pState->mBlendEnable);
+	if (pState->mBlendEnable)
+	{
+		const GLenum blendFunc[4] = { pState->mSrcRGBFunc, pState->mDstRGBFunc, pState->mSrcAlphaFunc, pState->mDstAlphaFunc };
+		if (memcmp(pCache->mBlendFunc, blendFunc, sizeof(blendFunc)))
+		{
+			CHECK_GLRESULT(glBlendFuncSeparate(blendFunc[0], blendFunc[1], blendFunc[2], blendFunc[3]));
+			memcpy(pCache->mBlendFunc, blendFunc, sizeof(blendFunc));
+		}
+		if (pCache->mBlendEquation[0] != pState->mModeRGB || pCache->mBlendEquation[1] != pState->mModeAlpha)
+		{
+			CHECK_GLRESULT(glBlendEquationSeparate(pState->mModeRGB, pState->mModeAlpha));
+			pCache->mBlendEquation[0] = pState->mModeRGB;
+			pCache->mBlendEquation[1] = pState->mModeAlpha;
+		}
+	}
+}
+
+// Sampler state lives in the texture object on GL ES 2.0, so it is cached per texture name.
+// Texture objects are shared between contexts, only the thread recording commands sets sampler state
+typedef struct GLTextureSamplerState
+{
+	GLenum mMinFilter;
+	GLenum mMagFilter;
+	GLenum mAddressS;
+	GLenum mAddressT;
+} GLTextureSamplerState;
+
+typedef eastl::hash_map<GLuint, GLTextureSamplerState> GLTextureSamplerStateMap;
+
+static GLTextureSamplerStateMap* pTextureSamplerStates = NULL;
+
+/// Applies the sampler state to the texture bound to target of the active unit
+static inline void util_gl_set_texture_sampler(GLenum target, GLuint texture, const GLTextureSamplerState* pState)
+{
+	GLTextureSamplerState& cached = (*pTextureSamplerStates)[texture];
+	if (cached.mMinFilter != pState->mMinFilter)
+		CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, pState->mMinFilter));
+	if (cached.mMagFilter != pState->mMagFilter)
+		CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, pState->mMagFilter));
+	if (cached.mAddressS != pState->mAddressS)
+		CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_WRAP_S, pState->mAddressS));
+	if (cached.mAddressT != pState->mAddressT)
+		CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_WRAP_T, pState->mAddressT));
+	cached = *pState;
+}
+
 static GLint util_to_gl_usage(ResourceMemoryUsage mem)
 {
 	switch (mem)
@@ -623,6 +913,96 @@ bool util_link_and_validate_program(GLuint program)
 	return true;
 }
 
+/************************************************************************/
+// Program binary cache
+/************************************************************************/
+// GL_OES_get_program_binary entry points, NULL if the driver has no program binary format
+static PFNGLGETPROGRAMBINARYOESPROC pfnGetProgramBinary = NULL;
+static PFNGLPROGRAMBINARYOESPROC    pfnProgramBinary = NULL;
+
+typedef struct GLProgramBinary
+{
+	GLenum   mFormat;
+	uint32_t mSize;
+	void*    pData;
+} GLProgramBinary;
+
+struct GLProgramBinaryCache
+{
+	eastl::hash_map<uint64_t, GLProgramBinary> mBinaries;
+};
+
+// getPipelineCacheData writes every binary as an entry followed by mSize bytes of program binary
+typedef struct GLProgramBinaryCacheEntry
+{
+	uint64_t mKey;
+	uint32_t mFormat;
+	uint32_t mSize;
+} GLProgramBinaryCacheEntry;
+
+// Programs are linked in addShaderBinary already, which has no PipelineCache argument.
+// Those links go through the most recently added pipeline cache
+static PipelineCache* pDefaultPipelineCache = NULL;
+
+static uint64_t util_program_binary_hash(const void* pData, size_t size, uint64_t hash)
+{
+	uint32_t low = 0;
+	uint32_t high = 0;
+	MurmurHash3_x86_32(pData, (int)size, (uint32_t)hash, &low);
+	MurmurHash3_x86_32(pData, (int)size, (uint32_t)(hash >> 32) ^ 0x9E3779B9u, &high);
+	return ((uint64_t)high << 32) | low;
+}
+
+static void util_store_program_binary(PipelineCache* pCache, uint64_t key, GLuint program)
+{
+	GLint size = 0;
+	CHECK_GLRESULT(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &size));
+	if (size <= 0)
+		return;
+
+	GLProgramBinary binary = {};
+	binary.pData = tf_malloc(size);
+	GLsizei length = 0;
+	CHECK_GLRESULT(pfnGetProgramBinary(program, size, &length, &binary.mFormat, binary.pData));
+	binary.mSize = (uint32_t)length;
+
+	GLProgramBinary& entry = pCache->pProgramBinaries->mBinaries[key];
+	tf_free(entry.pData);
+	entry = binary;
+}
+
+static bool util_load_program_binary(PipelineCache* pCache, uint64_t key, GLuint program)
+{
+	eastl::hash_map<uint64_t, GLProgramBinary>::iterator it = pCache->pProgramBinaries->mBinaries.find(key);
+	if (it == pCache->pProgramBinaries->mBinaries.end())
+		return false;
+
+	// The driver rejects binaries of another driver version, the program is linked from source then and the entry replaced
+	pfnProgramBinary(program, it->second.mFormat, it->second.pData, (GLint)it->second.mSize);
+	GLint status = GL_FALSE;
+	if (glGetError() == GL_NO_ERROR)
+	{
+		CHECK_GLRESULT(glGetProgramiv(program, GL_LINK_STATUS, &status));
+	}
+	return status == GL_TRUE;
+}
+
+/// Links program from the binary stored for key in pCache, or from its attached shaders storing the result.
+/// The program has to be relinked from source when the attached shaders or attribute bindings change the key
+static bool util_link_program(PipelineCache* pCache, uint64_t key, GLuint program)
+{
+	const bool cacheBinaries = pCache && pfnGetProgramBinary;
+	if (cacheBinaries && util_load_program_binary(pCache, key, program))
+		return true;
+
+	if (!util_link_and_validate_program(program))
+		return false;
+
+	if (cacheBinaries)
+		util_store_program_binary(pCache, key, program);
+	return true;
+}
+
 /************************************************************************/
 // Functions not exposed in IRenderer but still need to be exported in dll
 /************************************************************************/
@@ -721,6 +1101,24 @@ static bool addDevice(Renderer* pRenderer, const RendererDesc* pDesc)
 	LOGF(LogLevel::eINFO, "Glsl version: %s", glSLVersion);
 	LOGF(LogLevel::eINFO, "Extensions: %s", glExtensions);
 
+	// Linked programs are only cached when the driver can give them back in at least one binary format
+	GLint programBinaryFormatCount = 0;
+	if (strstr(glExtensions, "GL_OES_get_program_binary"))
+	{
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &programBinaryFormatCount);
+	}
+	if (programBinaryFormatCount > 0)
+	{
+		pfnGetProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC)getGLProcAddress("glGetProgramBinaryOES");
+		pfnProgramBinary = (PFNGLPROGRAMBINARYOESPROC)getGLProcAddress("glProgramBinaryOES");
+	}
+	if (!pfnGetProgramBinary || !pfnProgramBinary)
+	{
+		pfnGetProgramBinary = NULL;
+		pfnProgramBinary = NULL;
+	}
+	LOGF(LogLevel::eINFO, "Program binary cache: %s", pfnGetProgramBinary ? "supported" : "not supported");
+
 	// Validate requested device extensions
 	uint32_t supportedExtensions = 0;
 	const char* ptr = strtok(glExtensions, " ");
@@ -793,6 +1191,8 @@ static void add_default_resources(Renderer* pRenderer)
 /************************************************************************/
 void initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppRenderer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(ppRenderer);
 	ASSERT(pDesc);
 
@@ -817,6 +1217,10 @@ void initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppR
 	pRenderer->mEnableGpuBasedValidation = pDesc->mEnableGPUBasedValidation;
 	pRenderer->mApi = RENDERER_API_GLES;
 
+	// The context just became current on this thread
+	util_gl_reset_state_cache();
+	pTextureSamplerStates = tf_new(GLTextureSamplerStateMap);
+
 	pRenderer->pName = (char*)tf_calloc(strlen(appName) + 1, sizeof(char));
 	strcpy(pRenderer->pName, appName);
 
@@ -836,6 +1240,10 @@ void removeRenderer(Renderer* pRenderer)
 	
 	removeDevice(pRenderer);
 
+	tf_delete(pTextureSamplerStates);
+	pTextureSamplerStates = NULL;
+	gStateCacheValid = false;
+
 	removeGLContext(&pRenderer->pContext);
 
 	removeGL(&pRenderer->pConfig);
@@ -927,6 +1335,8 @@ void removeQueue(Renderer* pRenderer, Queue* pQueue)
 
 void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppSwapChain);
@@ -1081,6 +1491,8 @@ void removeCmd_n(Renderer* pRenderer, uint32_t cmdCount, Cmd** ppCmds)
 /************************************************************************/
 void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppRenderTarget);
@@ -1219,6 +1631,8 @@ void gl_compileShader(
 
 void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mStages);
 	ASSERT(ppShaderProgram);
@@ -1233,6 +1647,8 @@ void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader*
 
 	pShaderProgram->mStages = pDesc->mStages;
 	pShaderProgram->pReflection = (PipelineReflection*)(pShaderProgram + 1);
+	pShaderProgram->mSourceHash = util_program_binary_hash(pDesc->mVert.pByteCode, pDesc->mVert.mByteCodeSize, 0);
+	pShaderProgram->mSourceHash = util_program_binary_hash(pDesc->mFrag.pByteCode, pDesc->mFrag.mByteCodeSize, pShaderProgram->mSourceHash);
 	
 	for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
 	{
@@ -1258,7 +1674,7 @@ void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader*
 	}
 
 	// Validate GL shader program
-	if (!util_link_and_validate_program(pShaderProgram->mProgram))
+	if (!util_link_program(pDefaultPipelineCache, pShaderProgram->mSourceHash, pShaderProgram->mProgram))
 	{
 		glDeleteProgram(pShaderProgram->mProgram);
 		ASSERT(false);
@@ -1286,6 +1702,8 @@ void removeShader(Renderer* pRenderer, Shader* pShaderProgram)
 
 void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(pDesc->mSize > 0);
@@ -1300,13 +1718,12 @@ void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
 	{
 		pBuffer->mTarget = (pDesc->mDescriptors & DESCRIPTOR_TYPE_INDEX_BUFFER) ? GL_ELEMENT_ARRAY_BUFFER :  GL_ARRAY_BUFFER;
 		CHECK_GLRESULT(glGenBuffers(1, &pBuffer->mBuffer));
-		CHECK_GLRESULT(glBindBuffer(pBuffer->mTarget, pBuffer->mBuffer));
+		util_gl_bind_buffer(pBuffer->mTarget, pBuffer->mBuffer);
 		GLint usage = util_to_gl_usage(pDesc->mMemoryUsage);
 		if (usage != GL_NONE)
 		{
 			CHECK_GLRESULT(glBufferData(pBuffer->mTarget, pDesc->mSize, NULL, usage));
 		}
-		CHECK_GLRESULT(glBindBuffer(pBuffer->mTarget, GL_NONE));
 		pBuffer->mMemoryUsage = pDesc->mMemoryUsage;
 
 		if (pBuffer->mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY)
@@ -1347,7 +1764,7 @@ void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
 
 	if((pBuffer->mDescriptors & DESCRIPTOR_TYPE_INDEX_BUFFER) || (pBuffer->mDescriptors & DESCRIPTOR_TYPE_VERTEX_BUFFER))
 	{
-		CHECK_GLRESULT(glDeleteBuffers(1, &pBuffer->mBuffer));
+		util_gl_delete_buffer(pBuffer->mBuffer);
 	}
 
 	if (pBuffer->mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY)
@@ -1370,9 +1787,8 @@ void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
 {
 	if (pBuffer->mTarget != GL_NONE)
 	{
-		CHECK_GLRESULT(glBindBuffer(pBuffer->mTarget, pBuffer->mBuffer));
+		util_gl_bind_buffer(pBuffer->mTarget, pBuffer->mBuffer);
 		CHECK_GLRESULT(glBufferSubData(pBuffer->mTarget, 0, pBuffer->mSize, pBuffer->pGLCpuMappedAddress));
-		CHECK_GLRESULT(glBindBuffer(pBuffer->mTarget, GL_NONE));
 	}
 
 	pBuffer->pCpuMappedAddress = nullptr;
@@ -1380,6 +1796,8 @@ void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
 
 void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
 	ASSERT(ppTexture);
@@ -1439,6 +1857,8 @@ void removeTexture(Renderer* pRenderer, Texture* pTexture)
 	ASSERT(pRenderer);
 	ASSERT(pTexture);
 
+	pTextureSamplerStates->erase(pTexture->mTexture);
+
 	SAFE_FREE(pTexture);
 }
 
@@ -1485,6 +1905,8 @@ bool util_compare_shader_variable(const ShaderVariable& a, const ShaderVariable&
 
 void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatureDesc, RootSignature** ppRootSignature)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pRootSignatureDesc);
 	ASSERT(ppRootSignature);
@@ -1738,8 +2160,10 @@ typedef struct GlVertexAttrib
 	GLuint	mOffset;
 } GlVertexAttrib;
 
-void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipeline** ppPipeline)
+void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, PipelineCache* pCache, Pipeline** ppPipeline)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(ppPipeline);
 	ASSERT(pDesc);
@@ -1774,6 +2198,8 @@ void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipelin
 	attrib_count = 0;
 	if (pVertexLayout != NULL)
 	{
+		// The binary linked with these attribute locations is cached separately from the one of addShaderBinary
+		uint64_t programKey = pShaderProgram->mSourceHash;
 		for (uint32_t attrib_index = 0; attrib_index < pVertexLayout->mAttribCount; ++attrib_index)
 		{
 			// Add vertex layouts
@@ -1813,6 +2239,9 @@ void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipelin
 			// Set the desired vertex input location in the shader program for given semantic name
 			// NOTE: Semantic names much match the attribute name in the .vert shader!
 			CHECK_GLRESULT(glBindAttribLocation(pPipeline->mShaderProgram, attrib->mLocation, semanticName));
+			programKey = util_program_binary_hash(&attrib->mLocation, sizeof(attrib->mLocation), programKey);
+			programKey = util_program_binary_hash(semanticName, strlen(semanticName), programKey);
+			pPipeline->mVertexAttribMask |= 1u << attrib->mLocation;
 
 			GlVertexAttrib* vertexAttrib = &pPipeline->pVertexLayout[attrib_index];
 			uint32_t glFormat, glInternalFormat, typeSize;
@@ -1845,11 +2274,14 @@ void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipelin
 		}
 
 		// Re-link the shader program to apply changed vertex input locations.
-		util_link_and_validate_program(pPipeline->mShaderProgram);
+		util_link_program(pCache ? pCache : pDefaultPipelineCache, programKey, pPipeline->mShaderProgram);
 	}
 
+	CHECK_GL_RETURN_RESULT(pPipeline->mVertexIDLocation, glGetUniformLocation(pPipeline->mShaderProgram, "vertexID"));
+	CHECK_GL_RETURN_RESULT(pPipeline->mInstanceIDLocation, glGetUniformLocation(pPipeline->mShaderProgram, "instanceID"));
+
 	// Set texture units of current used shader program
-	CHECK_GLRESULT(glUseProgram(pPipeline->mShaderProgram));
+	util_gl_use_program(pPipeline->mShaderProgram);
 	uint32_t uniqueTextureID = 0;
 	for (uint32_t i = 0; i < pDesc->pRootSignature->mDescriptorCount; ++i)
 	{
@@ -1868,7 +2300,6 @@ void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipelin
 			uniqueTextureID += descInfo->mSize;
 		}
 	}
-	CHECK_GLRESULT(glUseProgram(GL_NONE));
 	
 	pPipeline->pRasterizerState = (GLRasterizerState*)tf_calloc(1, sizeof(GLRasterizerState));
 	ASSERT(pPipeline->pRasterizerState);
@@ -1910,7 +2341,7 @@ void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPi
 		return;
 	}
 
-	addPipeline(pRenderer, &pDesc->mGraphicsDesc, ppPipeline);
+	addPipeline(pRenderer, &pDesc->mGraphicsDesc, pDesc->pCache, ppPipeline);
 }
 
 void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
@@ -1923,16 +2354,85 @@ void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
 	SAFE_FREE(pPipeline);
 }
 
-void addPipelineCache(Renderer*, const PipelineCacheDesc*, PipelineCache**)
+void addPipelineCache(Renderer* pRenderer, const PipelineCacheDesc* pDesc, PipelineCache** ppPipelineCache)
 {
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppPipelineCache);
+
+	PipelineCache* pPipelineCache = (PipelineCache*)tf_calloc(1, sizeof(PipelineCache));
+	ASSERT(pPipelineCache);
+	pPipelineCache->pProgramBinaries = tf_new(GLProgramBinaryCache);
+
+	// Entries are only trusted as far as the data goes, a truncated entry ends the cache
+	const uint8_t* pData = (const uint8_t*)pDesc->pData;
+	size_t         offset = 0;
+	while (pData && offset + sizeof(GLProgramBinaryCacheEntry) <= pDesc->mSize)
+	{
+		GLProgramBinaryCacheEntry entry = {};
+		memcpy(&entry, pData + offset, sizeof(entry));
+		offset += sizeof(entry);
+		if (!entry.mSize || entry.mSize > pDesc->mSize - offset)
+		{
+			LOGF(LogLevel::eWARNING, "Pipeline cache data is truncated, dropping the remaining program binaries");
+			break;
+		}
+
+		GLProgramBinary& binary = pPipelineCache->pProgramBinaries->mBinaries[entry.mKey];
+		tf_free(binary.pData);
+		binary.mFormat = entry.mFormat;
+		binary.mSize = entry.mSize;
+		binary.pData = tf_malloc(entry.mSize);
+		memcpy(binary.pData, pData + offset, entry.mSize);
+		offset += entry.mSize;
+	}
+
+	pDefaultPipelineCache = pPipelineCache;
+
+	*ppPipelineCache = pPipelineCache;
 }
 
-void removePipelineCache(Renderer*, PipelineCache*)
+void removePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache)
 {
+	ASSERT(pRenderer);
+	ASSERT(pPipelineCache);
+
+	if (pDefaultPipelineCache == pPipelineCache)
+		pDefaultPipelineCache = NULL;
+
+	for (eastl::hash_map<uint64_t, GLProgramBinary>::iterator it = pPipelineCache->pProgramBinaries->mBinaries.begin();
+		 it != pPipelineCache->pProgramBinaries->mBinaries.end(); ++it)
+	{
+		tf_free(it->second.pData);
+	}
+	tf_delete(pPipelineCache->pProgramBinaries);
+	SAFE_FREE(pPipelineCache);
 }
 
-void getPipelineCacheData(Renderer*, PipelineCache*, size_t*, void*)
+void getPipelineCacheData(Renderer* pRenderer, PipelineCache* pPipelineCache, size_t* pSize, void* pData)
 {
+	ASSERT(pRenderer);
+	ASSERT(pPipelineCache);
+	ASSERT(pSize);
+
+	size_t size = 0;
+	for (eastl::hash_map<uint64_t, GLProgramBinary>::iterator it = pPipelineCache->pProgramBinaries->mBinaries.begin();
+		 it != pPipelineCache->pProgramBinaries->mBinaries.end(); ++it)
+	{
+		if (pData)
+		{
+			ASSERT(size + sizeof(GLProgramBinaryCacheEntry) + it->second.mSize <= *pSize);
+			GLProgramBinaryCacheEntry entry = {};
+			entry.mKey = it->first;
+			entry.mFormat = it->second.mFormat;
+			entry.mSize = it->second.mSize;
+			memcpy((uint8_t*)pData + size, &entry, sizeof(entry));
+			memcpy((uint8_t*)pData + size + sizeof(entry), it->second.pData, it->second.mSize);
+		}
+		size += sizeof(GLProgramBinaryCacheEntry) + it->second.mSize;
+	}
+
+	*pSize = size;
 }
 /************************************************************************/
 // Descriptor Set Implementation
@@ -1952,6 +2452,15 @@ const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const
 	}
 }
 
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	ASSERT(pRootSignature);
+	ASSERT(pName);
+	using DescriptorNameToIndexMap = eastl::string_hash_map<uint32_t>;
+	DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap->mMap.find(pName);
+	return it != pRootSignature->pDescriptorNameToIndexMap->mMap.end() ? it->second : (uint32_t)-1;
+}
+
 typedef struct TextureDescriptorHandle
 {
 	bool hasMips;
@@ -1975,6 +2484,8 @@ typedef struct DescriptorDataArray
 
 void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppDescriptorSet);
@@ -2180,6 +2691,7 @@ void cmdBindRenderTargets(
 		return;
 
 	//CHECK_GLRESULT(glBindFramebuffer(GL_FRAMEBUFFER, pCmd->mFramebuffer));
+	GLStateCache* pStateCache = util_gl_state_cache();
 	uint32_t clearMask = 0;
 
 	for (uint32_t rtIndex = 0; rtIndex < renderTargetCount; ++rtIndex)
@@ -2191,7 +2703,13 @@ void cmdBindRenderTargets(
 
 		if (pLoadActions && pLoadActions->mLoadActionsColor[rtIndex] == LOAD_ACTION_CLEAR)
 		{
-			CHECK_GLRESULT(glClearColor(pLoadActions->mClearColorValues[rtIndex].r, pLoadActions->mClearColorValues[rtIndex].g, pLoadActions->mClearColorValues[rtIndex].b, pLoadActions->mClearColorValues[rtIndex].a));
+			const ClearValue* pClearValue = &pLoadActions->mClearColorValues[rtIndex];
+			const GLfloat clearColor[4] = { pClearValue->r, pClearValue->g, pClearValue->b, pClearValue->a };
+			if (memcmp(pStateCache->mClearColor, clearColor, sizeof(clearColor)))
+			{
+				CHECK_GLRESULT(glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]));
+				memcpy(pStateCache->mClearColor, clearColor, sizeof(clearColor));
+			}
 			clearMask |= GL_COLOR_BUFFER_BIT;
 		}
 		glBindRenderbuffer(GL_RENDERBUFFER, GL_NONE);
@@ -2206,7 +2724,11 @@ void cmdBindRenderTargets(
 
 		if (pLoadActions && pLoadActions->mLoadActionDepth == LOAD_ACTION_CLEAR)
 		{
-			CHECK_GLRESULT(glClearDepthf(pLoadActions->mClearDepth.depth));
+			if (pStateCache->mClearDepth != pLoadActions->mClearDepth.depth)
+			{
+				CHECK_GLRESULT(glClearDepthf(pLoadActions->mClearDepth.depth));
+				pStateCache->mClearDepth = pLoadActions->mClearDepth.depth;
+			}
 			clearMask |= GL_DEPTH_BUFFER_BIT;
 		}
 		glBindRenderbuffer(GL_RENDERBUFFER, GL_NONE);
@@ -2221,7 +2743,11 @@ void cmdBindRenderTargets(
 
 		if (pLoadActions && pLoadActions->mLoadActionStencil == LOAD_ACTION_CLEAR)
 		{
-			CHECK_GLRESULT(glClearStencil(pLoadActions->mClearDepth.stencil));
+			if (pStateCache->mClearStencil != (GLint)pLoadActions->mClearDepth.stencil)
+			{
+				CHECK_GLRESULT(glClearStencil(pLoadActions->mClearDepth.stencil));
+				pStateCache->mClearStencil = pLoadActions->mClearDepth.stencil;
+			}
 			clearMask |= GL_STENCIL_BUFFER_BIT;
 		}
 		glBindRenderbuffer(GL_RENDERBUFFER, GL_NONE);
@@ -2247,8 +2773,19 @@ void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, floa
 	uint32_t surfaceHeight;
 	getGLSurfaceSize(nullptr, &surfaceHeight);
 	uint32_t yOffset = surfaceHeight - y - height;
-	CHECK_GLRESULT(glViewport(x, yOffset, width, height));
-	CHECK_GLRESULT(glDepthRangef(minDepth, maxDepth));
+	GLStateCache* pStateCache = util_gl_state_cache();
+	const GLint viewport[4] = { (GLint)x, (GLint)yOffset, (GLint)width, (GLint)height };
+	if (memcmp(pStateCache->mViewport, viewport, sizeof(viewport)))
+	{
+		CHECK_GLRESULT(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+		memcpy(pStateCache->mViewport, viewport, sizeof(viewport));
+	}
+	if (pStateCache->mDepthRange[0] != minDepth || pStateCache->mDepthRange[1] != maxDepth)
+	{
+		CHECK_GLRESULT(glDepthRangef(minDepth, maxDepth));
+		pStateCache->mDepthRange[0] = minDepth;
+		pStateCache->mDepthRange[1] = maxDepth;
+	}
 }
 
 void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
@@ -2260,7 +2797,13 @@ void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t h
 	uint32_t surfaceHeight;
 	getGLSurfaceSize(nullptr, &surfaceHeight);
 	uint32_t yOffset = surfaceHeight - y - height;
-	CHECK_GLRESULT(glScissor(x, yOffset, width, height));
+	GLStateCache* pStateCache = util_gl_state_cache();
+	const GLint scissor[4] = { (GLint)x, (GLint)yOffset, (GLint)width, (GLint)height };
+	if (memcmp(pStateCache->mScissor, scissor, sizeof(scissor)))
+	{
+		CHECK_GLRESULT(glScissor(scissor[0], scissor[1], scissor[2], scissor[3]));
+		memcpy(pStateCache->mScissor, scissor, sizeof(scissor));
+	}
 }
 
 void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
@@ -2271,66 +2814,15 @@ void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
 
 	pCmd->pCmdPool->pCmdCache->pPipeline = pPipeline;
 
-	CHECK_GLRESULT(glUseProgram(pPipeline->mShaderProgram));
+	util_gl_use_program(pPipeline->mShaderProgram);
 
 	if (pPipeline->mType == PIPELINE_TYPE_GRAPHICS)
 	{
-		// Disable all vertex attributes on start
-		for (uint32_t vertexLayoutIndex = 0; vertexLayoutIndex < MAX_VERTEX_ATTRIBS; ++vertexLayoutIndex)
-		{
-			CHECK_GLRESULT(glDisableVertexAttribArray(vertexLayoutIndex));
-		}
-
-		if (pPipeline->pRasterizerState->mCullMode != GL_NONE)
-		{
-			CHECK_GLRESULT(glEnable(GL_CULL_FACE));
-			CHECK_GLRESULT(glCullFace(pPipeline->pRasterizerState->mCullMode));
-			CHECK_GLRESULT(glFrontFace(pPipeline->pRasterizerState->mFrontFace));
-		}
-		else
-		{
-			CHECK_GLRESULT(glDisable(GL_CULL_FACE));
-		}
-
-		CHECK_GLRESULT(pPipeline->pRasterizerState->mScissorTest ? glEnable(GL_SCISSOR_TEST) : glDisable(GL_SCISSOR_TEST));
-
-		if (pPipeline->pDepthStencilState->mDepthTest)
-		{
-			CHECK_GLRESULT(glEnable(GL_DEPTH_TEST));
-			CHECK_GLRESULT(glDepthMask(pPipeline->pDepthStencilState->mDepthWrite));
-			CHECK_GLRESULT(glDepthFunc(pPipeline->pDepthStencilState->mDepthFunc));
-		}
-		else
-		{
-			CHECK_GLRESULT(glDisable(GL_DEPTH_TEST));
-		}
-
-		if (pPipeline->pDepthStencilState->mStencilTest)
-		{
-			CHECK_GLRESULT(glEnable(GL_STENCIL_TEST));
-			CHECK_GLRESULT(glStencilMask(pPipeline->pDepthStencilState->mStencilWriteMask));
-
-			CHECK_GLRESULT(glStencilFuncSeparate(GL_FRONT, pPipeline->pDepthStencilState->mStencilFrontFunc, 0, ~0));
-			CHECK_GLRESULT(glStencilOpSeparate(GL_FRONT, pPipeline->pDepthStencilState->mStencilFrontFail, pPipeline->pDepthStencilState->mDepthFrontFail, pPipeline->pDepthStencilState->mStencilFrontPass));
-
-			CHECK_GLRESULT(glStencilFuncSeparate(GL_BACK, pPipeline->pDepthStencilState->mStencilBackFunc, 0, ~0));
-			CHECK_GLRESULT(glStencilOpSeparate(GL_BACK, pPipeline->pDepthStencilState->mStencilBackFail, pPipeline->pDepthStencilState->mDepthBackFail, pPipeline->pDepthStencilState->mStencilBackPass));
-		}
-		else
-		{
-			CHECK_GLRESULT(glDisable(GL_STENCIL_TEST));
-		}
-
-		if (pPipeline->pBlendState->mBlendEnable)
-		{
-			CHECK_GLRESULT(glEnable(GL_BLEND));
-			CHECK_GLRESULT(glBlendFuncSeparate(pPipeline->pBlendState->mSrcRGBFunc, pPipeline->pBlendState->mDstRGBFunc, pPipeline->pBlendState->mSrcAlphaFunc, pPipeline->pBlendState->mDstAlphaFunc));
-			CHECK_GLRESULT(glBlendEquationSeparate(pPipeline->pBlendState->mModeRGB, pPipeline->pBlendState->mModeAlpha));
-		}
-		else
-		{
-			CHECK_GLRESULT(glDisable(GL_BLEND));
-		}
+		// Only the attributes of this pipeline stay enabled, cmdBindVertexBuffer points them at the buffer
+		util_gl_set_vertex_attribs(pPipeline->mVertexAttribMask);
+		util_gl_set_rasterizer_state(pPipeline->pRasterizerState);
+		util_gl_set_depth_stencil_state(pPipeline->pDepthStencilState);
+		util_gl_set_blend_state(pPipeline->pBlendState);
 	}
 }
 
@@ -2345,7 +2837,7 @@ void cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorS
 	for (uint32_t sh = 0; sh < pRootSignature->mProgramCount; ++sh)
 	{
 		GLuint textureIndex = 0;
-		CHECK_GLRESULT(glUseProgram(pRootSignature->pProgramTargets[sh]));
+		util_gl_use_program(pRootSignature->pProgramTargets[sh]);
 		for (uint32_t i = 0; i < pRootSignature->mDescriptorCount; ++i)
 		{
 			DescriptorInfo* descInfo = &pRootSignature->pDescriptors[i];
@@ -2382,14 +2874,16 @@ void cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorS
 						TextureDescriptorHandle* textureHandle = &pDescriptorSet->pHandles[index].pData[i].pTextures[arr];
 						if (textureHandle->mTexture != GL_NONE)
 						{
-							CHECK_GLRESULT(glActiveTexture(GL_TEXTURE0 + textureIndex));
-							CHECK_GLRESULT(glBindTexture(target, textureHandle->mTexture));
+							util_gl_active_texture(textureIndex);
+							util_gl_bind_texture(target, textureHandle->mTexture);
 							if (pSampler)
 							{
-								CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, textureHandle->hasMips ? pSampler->mMipMapMode : pSampler->mMinFilter));
-								CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, pSampler->mMagFilter));
-								CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_WRAP_S, pSampler->mAddressS));
-								CHECK_GLRESULT(glTexParameteri(target, GL_TEXTURE_WRAP_T, pSampler->mAddressT));
+								GLTextureSamplerState samplerState = {};
+								samplerState.mMinFilter = textureHandle->hasMips ? pSampler->mMipMapMode : pSampler->mMinFilter;
+								samplerState.mMagFilter = pSampler->mMagFilter;
+								samplerState.mAddressS = pSampler->mAddressS;
+								samplerState.mAddressT = pSampler->mAddressT;
+								util_gl_set_texture_sampler(target, textureHandle->mTexture, &samplerState);
 							}
 						}
 						++textureIndex;
@@ -2421,14 +2915,14 @@ void cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorS
 		}
 	}
 
-	CHECK_GLRESULT(glUseProgram(pCmd->pCmdPool->pCmdCache->pPipeline->mShaderProgram));
+	util_gl_use_program(pCmd->pCmdPool->pCmdCache->pPipeline->mShaderProgram);
 }
 
 void util_gl_set_constant(const Cmd* pCmd, const RootSignature* pRootSignature, const DescriptorInfo* pDesc, const void* pData)
 {
 	for (uint32_t program = 0; program < pRootSignature->mProgramCount; ++program)
 	{
-		CHECK_GLRESULT(glUseProgram(pRootSignature->pProgramTargets[program]));
+		util_gl_use_program(pRootSignature->pProgramTargets[program]);
 
 		uint32_t locationIndex = pDesc->mHandleIndex + program * pRootSignature->mDescriptorCount;
 		GLint location = pRootSignature->pDescriptorGlLocations[locationIndex];
@@ -2458,7 +2952,7 @@ void util_gl_set_constant(const Cmd* pCmd, const RootSignature* pRootSignature,
 			break;
 		}
 	}
-	CHECK_GLRESULT(glUseProgram(pCmd->pCmdPool->pCmdCache->pPipeline->mShaderProgram));
+	util_gl_use_program(pCmd->pCmdPool->pCmdCache->pPipeline->mShaderProgram);
 }
 
 void cmdBindPushConstants(Cmd* pCmd, RootSignature* pRootSignature, const char* pName, const void* pConstants)
@@ -2500,7 +2994,7 @@ void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer, uint32_t indexType, uint64_t
 	ASSERT(pBuffer->mTarget == GL_ELEMENT_ARRAY_BUFFER);
 
 	pCmd->pCmdPool->pCmdCache->mIndexBufferOffset = offset;
-	CHECK_GLRESULT(glBindBuffer(pBuffer->mTarget, pBuffer->mBuffer));
+	util_gl_bind_buffer(pBuffer->mTarget, pBuffer->mBuffer);
 }
 
 void cmdBindVertexBuffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers, const uint32_t* pStrides, const uint64_t* pOffsets)
@@ -2523,7 +3017,7 @@ void cmdBindVertexBuffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers, co
 	for (uint32_t bufferIndex = 0; bufferIndex < bufferCount; ++bufferIndex)
 	{
 		ASSERT(ppBuffers[bufferIndex]->mTarget == GL_ARRAY_BUFFER);
-		CHECK_GLRESULT(glBindBuffer(ppBuffers[bufferIndex]->mTarget, ppBuffers[bufferIndex]->mBuffer));
+		util_gl_bind_buffer(ppBuffers[bufferIndex]->mTarget, ppBuffers[bufferIndex]->mBuffer);
 		pCmd->pCmdPool->pCmdCache->mVertexBufferOffset = pOffsets ? pOffsets[bufferIndex] : 0;
 		pCmd->pCmdPool->pCmdCache->mVertexBufferStride = pStrides[bufferIndex];
 	}
@@ -2535,7 +3029,6 @@ void cmdBindVertexBuffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers, co
 		uint32_t offset = vertexAttrib->mOffset + cmdCache->mVertexBufferOffset;
 		CHECK_GLRESULT(glVertexAttribPointer(vertexAttrib->mIndex, vertexAttrib->mSize, vertexAttrib->mType, vertexAttrib->mNormalized,
 			cmdCache->mVertexBufferStride, (void*)(offset)));
-		CHECK_GLRESULT(glEnableVertexAttribArray(vertexAttrib->mIndex));
 	}
 }
 
@@ -2545,8 +3038,7 @@ void cmdDraw(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex)
 	CmdCache* cmdCache = pCmd->pCmdPool->pCmdCache;
 	ASSERT(cmdCache->isStarted);
 
-	GLint vertexIDLocation;
-	CHECK_GL_RETURN_RESULT(vertexIDLocation, glGetUniformLocation(cmdCache->pPipeline->mShaderProgram, "vertexID"));
+	const GLint vertexIDLocation = cmdCache->pPipeline->mVertexIDLocation;
 	if (vertexIDLocation != -1)
 	{
 		for (uint32_t vertexID = firstVertex; vertexID < vertexCount + firstVertex; ++vertexID)
@@ -2569,8 +3061,7 @@ void cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex, uin
 
 	// GLES 2.0 with glsl #version 100 does not support instancing
 	// Simulate instancing
-	GLint instanceLocation;
-	CHECK_GL_RETURN_RESULT(instanceLocation, glGetUniformLocation(cmdCache->pPipeline->mShaderProgram, "instanceID"));
+	const GLint instanceLocation = cmdCache->pPipeline->mInstanceIDLocation;
 	for (uint32_t instanceIndex = firstInstance; instanceIndex < firstInstance + instanceCount; ++instanceIndex)
 	{
 		util_gl_set_uniform(instanceLocation, (uint8_t*)&instanceIndex, GL_INT, 1);
@@ -2596,7 +3087,6 @@ void cmdDrawIndexed(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_
 			uint32_t vertexOffset = vertexAttrib->mOffset + vertexBufferOffset;
 			CHECK_GLRESULT(glVertexAttribPointer(vertexAttrib->mIndex, vertexAttrib->mSize, vertexAttrib->mType, vertexAttrib->mNormalized,
 				cmdCache->mVertexBufferStride, (void*)(vertexOffset)));
-			CHECK_GLRESULT(glEnableVertexAttribArray(vertexAttrib->mIndex));
 		}
 	}
 
@@ -2623,7 +3113,6 @@ void cmdDrawIndexedInstanced(
 			uint32_t vertexOffset = vertexAttrib->mOffset + vertexBufferOffset;
 			CHECK_GLRESULT(glVertexAttribPointer(vertexAttrib->mIndex, vertexAttrib->mSize, vertexAttrib->mType, vertexAttrib->mNormalized,
 				cmdCache->mVertexBufferStride, (void*)(vertexOffset)));
-			CHECK_GLRESULT(glEnableVertexAttribArray(vertexAttrib->mIndex));
 		}
 	}
 
@@ -2631,8 +3120,7 @@ void cmdDrawIndexedInstanced(
 
 	// GLES 2.0 with glsl #version 100 does not support instancing
 	// Simulate instancing
-	GLint instanceLocation;
-	CHECK_GL_RETURN_RESULT(instanceLocation, glGetUniformLocation(cmdCache->pPipeline->mShaderProgram, "instanceID"));
+	const GLint instanceLocation = cmdCache->pPipeline->mInstanceIDLocation;
 	for (uint32_t instanceIndex = firstInstance; instanceIndex < firstInstance + instanceCount; ++instanceIndex)
 	{
 		util_gl_set_uniform(instanceLocation, (uint8_t*)&instanceIndex, GL_INT, 1);
@@ -2655,9 +3143,8 @@ void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSr
 	ASSERT(pBuffer);
 	ASSERT(pCmd->pCmdPool->pCmdCache->isStarted);
 
-	CHECK_GLRESULT(glBindBuffer(pBuffer->mTarget, pBuffer->mBuffer));
+	util_gl_bind_buffer(pBuffer->mTarget, pBuffer->mBuffer);
 	CHECK_GLRESULT(glBufferSubData(pBuffer->mTarget, dstOffset, size, (uint8_t*)pSrcBuffer->pCpuMappedAddress + srcOffset));
-	CHECK_GLRESULT(glBindBuffer(pBuffer->mTarget, GL_NONE));
 }
 
 typedef struct SubresourceDataDesc
@@ -2693,7 +3180,7 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 		}
 	}
 
-	CHECK_GLRESULT(glBindTexture(pTexture->mTarget, pTexture->mTexture));
+	util_gl_bind_texture(pTexture->mTarget, pTexture->mTexture);
 	if (pTexture->mType == GL_NONE) // Compressed image
 	{
 		GLsizei imageByteSize = util_get_compressed_texture_size(pTexture->mInternalFormat, width, height);
@@ -2705,7 +3192,6 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 		CHECK_GLRESULT(glTexImage2D(target, pSubresourceDesc->mMipLevel, pTexture->mGlFormat,
 			width, height, 0, pTexture->mGlFormat, pTexture->mType, (uint8_t*)pSrcBuffer->pCpuMappedAddress + pSubresourceDesc->mSrcOffset));
 	}
-	CHECK_GLRESULT(glBindTexture(pTexture->mTarget, GL_NONE));
 }
 
 /************************************************************************/
@@ -2800,7 +3286,7 @@ PresentStatus queuePresent(Queue* pQueue, const QueuePresentDesc* pDesc)
 	util_handle_wait_sempahores(pDesc->ppWaitSemaphores, pDesc->mWaitSemaphoreCount);
 
 	// Disable scissor test, so we draw full screen and not latest set scissor location
-	CHECK_GLRESULT(glDisable(GL_SCISSOR_TEST));
+	util_gl_set_cap(GL_SCISSOR_TEST, GL_STATE_CACHE_CAP_SCISSOR_TEST, false);
 
 	return swapGLBuffers(pDesc->pSwapChain->pSurface) ? PRESENT_STATUS_SUCCESS : PRESENT_STATUS_FAILED;
 }
@@ -2944,6 +3430,8 @@ void calculateMemoryStats(Renderer* pRenderer, char** stats) {}
 void calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* totalAllocatedBytes) {}
 
 void freeMemoryStats(Renderer* pRenderer, char* stats) {}
+
+void getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget) { *pBudget = {}; }
 /************************************************************************/
 // Debug Marker Implementation
 /************************************************************************/
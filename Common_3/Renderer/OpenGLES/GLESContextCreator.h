@@ -24,4 +24,6 @@ void setGLSwapInterval(bool enableVsync);
 
 void getGLSurfaceSize(unsigned int* width, unsigned int* height);
 
+void* getGLProcAddress(const char* pProcName);
+
 #endif
\ No newline at end of file
@@ -39,6 +39,8 @@
 #include "IResourceLoader.h"
 #include "../OS/Interfaces/ILog.h"
 #include "../OS/Interfaces/IThread.h"
+#include "../OS/Interfaces/ITime.h"
+#include "../OS/Profiler/ProfilerBase.h"
 
 #if defined(__ANDROID__) && defined(VULKAN)
 #include <shaderc/shaderc.h>
@@ -49,24 +51,42 @@
 #endif
 
 #include "../OS/Core/TextureContainers.h"
+#include "../OS/Core/VertexPacking.h"
+#include "../OS/Core/ShardedCounters.h"
+#include "../OS/Core/ThreadSystem.h"
 
-#include "../OS/Interfaces/IMemory.h"
-
-#ifdef NX64
+#include "../ThirdParty/OpenSource/EASTL/heap.h"
+#include "../ThirdParty/OpenSource/EASTL/hash_map.h"
+#include "../ThirdParty/OpenSource/EASTL/hash_set.h"
 #include "../ThirdParty/OpenSource/murmurhash3/MurmurHash3_32.h"
-#endif
+
+#include "../OS/Interfaces/IMemory.h"
 
 struct SubresourceDataDesc
 {
 	uint64_t                           mSrcOffset;
 	uint32_t                           mMipLevel;
 	uint32_t                           mArrayLayer;
+#if defined(DIRECT3D12) || defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+	// Part of the subresource the source data covers, in block rows and depth slices
+	uint32_t                           mRowOffset;
+	uint32_t                           mRowCount;
+	uint32_t                           mDepthOffset;
+	uint32_t                           mDepthCount;
+#endif
 #if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
 	uint32_t                           mRowPitch;
 	uint32_t                           mSlicePitch;
 #endif
 };
 
+// Backends whose cmdUpdateSubresource can copy part of a subresource, so big subresources can be streamed through the staging buffer in pieces
+#if defined(DIRECT3D12) || defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+#define SUBRESOURCE_REGION_UPDATE 1
+#else
+#define SUBRESOURCE_REGION_UPDATE 0
+#endif
+
 #define MIP_REDUCE(s, mip) (max(1u, (uint32_t)((s) >> (mip))))
 
 enum
@@ -216,94 +236,6 @@ static inline constexpr TinyImageFormat util_cgltf_type_to_image_format(cgltf_ty
 	}
 }
 
-#define F16_EXPONENT_BITS 0x1F
-#define F16_EXPONENT_SHIFT 10
-#define F16_EXPONENT_BIAS 15
-#define F16_MANTISSA_BITS 0x3ff
-#define F16_MANTISSA_SHIFT (23 - F16_EXPONENT_SHIFT)
-#define F16_MAX_EXPONENT (F16_EXPONENT_BITS << F16_EXPONENT_SHIFT)
-
-static inline uint16_t util_float_to_half(float val)
-{
-	uint32_t           f32 = (*(uint32_t*)&val);
-	uint16_t           f16 = 0;
-	/* Decode IEEE 754 little-endian 32-bit floating-point value */
-	int sign = (f32 >> 16) & 0x8000;
-	/* Map exponent to the range [-127,128] */
-	int exponent = ((f32 >> 23) & 0xff) - 127;
-	int mantissa = f32 & 0x007fffff;
-	if (exponent == 128)
-	{ /* Infinity or NaN */
-		f16 = (uint16_t)(sign | F16_MAX_EXPONENT);
-		if (mantissa)
-			f16 |= (mantissa & F16_MANTISSA_BITS);
-	}
-	else if (exponent > 15)
-	{ /* Overflow - flush to Infinity */
-		f16 = (unsigned short)(sign | F16_MAX_EXPONENT);
-	}
-	else if (exponent > -15)
-	{ /* Representable value */
-		exponent += F16_EXPONENT_BIAS;
-		mantissa >>= F16_MANTISSA_SHIFT;
-		f16 = (unsigned short)(sign | exponent << F16_EXPONENT_SHIFT | mantissa);
-	}
-	else
-	{
-		f16 = (unsigned short)sign;
-	}
-	return f16;
-}
-
-static inline void util_pack_float2_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
-{
-	struct f2 { float x; float y; };
-	f2* f = (f2*)src;
-	for (uint32_t e = 0; e < count; ++e)
-	{
-		*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = (
-			(util_float_to_half(f[e].x) & 0x0000FFFF) | ((util_float_to_half(f[e].y) << 16) & 0xFFFF0000));
-	}
-}
-
-static inline uint32_t util_float2_to_unorm2x16(const float* v)
-{
-	uint32_t x = (uint32_t)round(clamp(v[0], 0, 1) * 65535.0f);
-	uint32_t y = (uint32_t)round(clamp(v[1], 0, 1) * 65535.0f);
-	return ((uint32_t)0x0000FFFF & x) | ((y << 16) & (uint32_t)0xFFFF0000);
-}
-
-#define OCT_WRAP(v, w) ((1.0f - abs((w))) * ((v) >= 0.0f ? 1.0f : -1.0f))
-
-static inline void util_pack_float3_direction_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
-{
-	struct f3 { float x; float y; float z; };
-	for (uint32_t e = 0; e < count; ++e)
-	{
-		f3 f = *(f3*)(src + e * stride);
-		float absLength = (abs(f.x) + abs(f.y) + abs(f.z));
-		f3 enc = {};
-		if (absLength)
-		{
-			enc.x = f.x / absLength;
-			enc.y = f.y / absLength;
-			enc.z = f.z / absLength;
-			if (enc.z < 0)
-			{
-				float oldX = enc.x;
-				enc.x = OCT_WRAP(enc.x, enc.y);
-				enc.y = OCT_WRAP(enc.y, oldX);
-			}
-			enc.x = enc.x * 0.5f + 0.5f;
-			enc.y = enc.y * 0.5f + 0.5f;
-			*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = util_float2_to_unorm2x16(&enc.x);
-		}
-		else
-		{
-			*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = 0;
-		}
-	}
-}
 /************************************************************************/
 // Internal Structures
 /************************************************************************/
@@ -320,8 +252,23 @@ typedef struct TextureUpdateDescInternal
 	uint32_t          mLayerCount;
 	PreMipStepFn      pPreMipFunc;
 	bool              mMipsAfterSlice;
+	/// Most detailed mips in the stream that the texture was created without (streaming textures), they are skipped while reading.
+	/// mSrcWidth / mSrcHeight / mSrcDepth are the dimensions of mip 0 in the stream. Requires mBaseMipLevel == 0
+	uint32_t          mSkipMipLevels;
+	uint32_t          mSrcWidth;
+	uint32_t          mSrcHeight;
+	uint32_t          mSrcDepth;
 } TextureUpdateDescInternal;
 
+typedef struct StreamingTextureLoadRequest
+{
+	StreamingTexture* pStreamingTexture;
+	/// Receives the new texture, and the mip chain stored in the file on the first load
+	Texture**         ppTexture;
+	TextureDesc*      pOutFileDesc;
+	uint32_t          mResidentMips;
+} StreamingTextureLoadRequest;
+
 typedef struct CopyResourceSet
 {
 #if !defined(DIRECT3D11)
@@ -332,7 +279,7 @@ typedef struct CopyResourceSet
 	Buffer*                mBuffer;
 	uint64_t               mAllocatedSpace;
 
-	/// Buffers created in case we ran out of space in the original staging buffer
+	/// Upload buffers from beginUpdateResource, and temporary staging for the rare upload that does not fit an empty staging buffer
 	/// Will be cleaned up after the fence for this set is complete
 	eastl::vector<Buffer*> mTempBuffers;
 } CopyResourceSet;
@@ -355,13 +302,13 @@ typedef enum UpdateRequestType
 	UPDATE_REQUEST_TEXTURE_BARRIER,
 	UPDATE_REQUEST_LOAD_TEXTURE,
 	UPDATE_REQUEST_LOAD_GEOMETRY,
+	UPDATE_REQUEST_LOAD_STREAMING_TEXTURE,
 	UPDATE_REQUEST_INVALID,
 } UpdateRequestType;
 
 typedef enum UploadFunctionResult
 {
 	UPLOAD_FUNCTION_RESULT_COMPLETED,
-	UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL,
 	UPLOAD_FUNCTION_RESULT_INVALID_REQUEST
 } UploadFunctionResult;
 
@@ -371,6 +318,7 @@ struct UpdateRequest
 	UpdateRequest(const TextureLoadDesc& texture) :           mType(UPDATE_REQUEST_LOAD_TEXTURE), texLoadDesc(texture) {}
 	UpdateRequest(const TextureUpdateDescInternal& texture) : mType(UPDATE_REQUEST_UPDATE_TEXTURE), texUpdateDesc(texture) {}
 	UpdateRequest(const GeometryLoadDesc& geom) :             mType(UPDATE_REQUEST_LOAD_GEOMETRY), geomLoadDesc(geom) {}
+	UpdateRequest(const StreamingTextureLoadRequest& load) :  mType(UPDATE_REQUEST_LOAD_STREAMING_TEXTURE), streamingLoad(load) {}
 	UpdateRequest(const BufferBarrier& barrier) :             mType(UPDATE_REQUEST_BUFFER_BARRIER), bufferBarrier(barrier) {}
 	UpdateRequest(const TextureBarrier& barrier) :            mType(UPDATE_REQUEST_TEXTURE_BARRIER), textureBarrier(barrier) {}
 
@@ -383,11 +331,57 @@ struct UpdateRequest
 		TextureUpdateDescInternal texUpdateDesc;
 		TextureLoadDesc           texLoadDesc;
 		GeometryLoadDesc          geomLoadDesc;
+		StreamingTextureLoadRequest streamingLoad;
 		BufferBarrier             bufferBarrier;
 		TextureBarrier            textureBarrier;
 	};
 };
 
+struct StreamingTexture
+{
+	char                 mFileName[FS_MAX_PATH];
+	uint32_t             mNodeIndex;
+	TextureCreationFlags mCreationFlag;
+	TextureContainerType mContainer;
+
+	/// Mip chain stored in the file, written by the streamer before the token of the first load is signaled
+	TextureDesc          mFileDesc;
+	/// Texture bound this frame, and the one the streaming load in flight creates
+	Texture*             pTexture;
+	Texture*             pPendingTexture;
+	SyncToken            mPendingToken;
+
+	/// Mips in pTexture (0 until the first load completed), in the load in flight (0 if none),
+	/// the residency requests ask for and the mips that are never evicted
+	uint32_t             mResidentMips;
+	uint32_t             mPendingMips;
+	uint32_t             mTargetMips;
+	uint32_t             mMinResidentMips;
+	/// Frame mTargetMips was last requested in
+	uint32_t             mLastRequestFrame;
+
+	/// Most detailed mip requested since the last updateStreamingTextures, UINT32_MAX if none
+	tfrg_atomic32_t      mRequestedMip;
+	/// Largest dimension of mip 0 in the file, 0 until the first load completed
+	tfrg_atomic32_t      mMaxDimension;
+
+	/// A load failed or the container does not support loading part of the mip chain, the texture keeps what it has
+	bool                 mStreamingDisabled;
+};
+
+typedef struct RetiredStreamingTexture
+{
+	Texture* pTexture;
+	uint32_t mFrame;
+} RetiredStreamingTexture;
+
+typedef struct StreamingEvictCandidate
+{
+	uint64_t mTopMipBytes;
+	uint32_t mLastRequestFrame;
+	uint32_t mIndex;
+} StreamingEvictCandidate;
+
 struct ResourceLoader
 {
 	Renderer*                    pRenderer;
@@ -402,7 +396,7 @@ struct ResourceLoader
 	ConditionVariable            mQueueCond;
 	Mutex                        mTokenMutex;
 	ConditionVariable            mTokenCond;
-	eastl::vector<UpdateRequest> mRequestQueue[MAX_LINKED_GPUS];
+	eastl::vector<UpdateRequest> mRequestQueue[MAX_LINKED_GPUS][LOAD_PRIORITY_COUNT];
 
 	tfrg_atomic64_t              mTokenCompleted;
 	tfrg_atomic64_t              mTokenCounter;
@@ -412,6 +406,24 @@ struct ResourceLoader
 	CopyEngine                   pCopyEngines[MAX_LINKED_GPUS];
 	uint32_t                     mNextSet;
 	uint32_t                     mSubmittedSets;
+	// Every token up to this one has its request recorded or cancelled, the sets submitted by the streamer signal up to it
+	SyncToken                    mRecordedToken;
+	// Bytes uploaded in the current streamer iteration, see ResourceLoaderDesc::mIterationByteBudget
+	uint64_t                     mIterationBytes;
+
+	// Scratch memory for the streamer, only touched by the thread running streamerThreadFunc
+	LinearAllocator              mStreamerArena;
+	// Copies of the vertex layouts of queued geometry loads. Allocated by addResource, returned by the streamer
+	// or by cancelToken, hence the lock.
+	Mutex                        mVertexLayoutPoolMutex;
+	PoolAllocator                mVertexLayoutPool;
+
+	// Streaming textures, only touched by the thread calling updateStreamingTextures
+	eastl::vector<StreamingTexture*>        mStreamingTextures;
+	eastl::vector<RetiredStreamingTexture>  mRetiredStreamingTextures;
+	eastl::vector<uint32_t>                 mStreamingWantedMips;
+	eastl::vector<StreamingEvictCandidate>  mStreamingEvictCandidates;
+	uint32_t                                mStreamingFrame;
 
 #if defined(NX64)
 	ThreadTypeNX                 mThreadType;
@@ -421,6 +433,43 @@ struct ResourceLoader
 
 static ResourceLoader* pResourceLoader = NULL;
 
+// Always on loader statistics, see getResourceLoaderStats. Kept outside ResourceLoader so they survive re-init.
+typedef struct ResourceLoaderStatsShard
+{
+	tfrg_atomic64_t mStagingBytes;
+	tfrg_atomic64_t mTempBufferCount;
+	tfrg_atomic64_t mTempBufferBytes;
+	tfrg_atomic64_t mStagingFlushCount;
+	tfrg_atomic64_t mCopyEngineWaitCount;
+	tfrg_atomic64_t mCopyEngineWaitUs;
+	tfrg_atomic64_t mTokenWaitCount;
+	tfrg_atomic64_t mTokenWaitUs;
+	tfrg_atomic64_t mRequestsQueued;
+	tfrg_atomic64_t mRequestsProcessed;
+	tfrg_atomic64_t mRequestsCancelled;
+	tfrg_atomic64_t mStreamingMipLoads;
+	tfrg_atomic64_t mStreamingMipEvictions;
+	uint8_t         mPadding[COUNTER_SHARD_PADDING];
+} ResourceLoaderStatsShard;
+
+static ResourceLoaderStatsShard gResourceLoaderStats[COUNTER_SHARD_COUNT] = {};
+// Gauges rather than totals, not sharded
+static tfrg_atomic64_t gStagingPeakBytes = 0;
+static tfrg_atomic64_t gRequestQueueDepth = 0;
+static tfrg_atomic64_t gRequestQueueDepthPeak = 0;
+static tfrg_atomic64_t gStreamingResidentBytes = 0;
+static tfrg_atomic64_t gStreamingBudgetBytes = 0;
+
+#define RESOURCE_LOADER_STAT_ADD(name, value) tfrg_atomic64_add_relaxed(&gResourceLoaderStats[getCounterShard()].name, (value))
+#define RESOURCE_LOADER_STAT_SUM(name) sumCounterShards(&gResourceLoaderStats[0].name, sizeof(ResourceLoaderStatsShard))
+
+// Called with mQueueMutex held after a request was pushed to one of the mRequestQueue
+static void onRequestQueued()
+{
+	RESOURCE_LOADER_STAT_ADD(mRequestsQueued, 1);
+	tfrg_atomic64_max_relaxed(&gRequestQueueDepthPeak, tfrg_atomic64_add_relaxed(&gRequestQueueDepth, 1) + 1);
+}
+
 static uint32_t util_get_texture_row_alignment(Renderer* pRenderer)
 {
 	return max(1u, pRenderer->pActiveGpuSettings->mUploadBufferTextureRowAlignment);
@@ -432,6 +481,80 @@ static uint32_t util_get_texture_subresource_alignment(Renderer* pRenderer, Tiny
 	uint32_t alignment = round_up(pRenderer->pActiveGpuSettings->mUploadBufferTextureAlignment, blockSize);
 	return round_up(alignment, util_get_texture_row_alignment(pRenderer));
 }
+
+// Whether subresources of this format can be uploaded in ranges of block rows or depth slices
+static bool util_can_split_subresource(TinyImageFormat fmt)
+{
+#if SUBRESOURCE_REGION_UPDATE
+	// Planar formats are copied a whole plane at a time and PVRTC can only be replaced as a whole
+	const bool isPvrtc = (TinyImageFormat_Code(fmt) & TinyImageFormat_NAMESPACE_MASK) == TinyImageFormat_NAMESPACE_PVRTC;
+	return TinyImageFormat_IsSinglePlane(fmt) && !isPvrtc;
+#else
+	UNREF_PARAM(fmt);
+	return false;
+#endif
+}
+
+static SubresourceDataDesc util_get_subresource_desc(uint32_t mip, uint32_t layer, uint64_t srcOffset,
+	uint32_t rowOffset, uint32_t rowCount, uint32_t depthOffset, uint32_t depthCount, uint32_t rowPitch, uint32_t slicePitch)
+{
+	SubresourceDataDesc subresourceDesc = {};
+	subresourceDesc.mArrayLayer = layer;
+	subresourceDesc.mMipLevel = mip;
+	subresourceDesc.mSrcOffset = srcOffset;
+#if SUBRESOURCE_REGION_UPDATE
+	subresourceDesc.mRowOffset = rowOffset;
+	subresourceDesc.mRowCount = rowCount;
+	subresourceDesc.mDepthOffset = depthOffset;
+	subresourceDesc.mDepthCount = depthCount;
+#else
+	UNREF_PARAM(rowOffset);
+	UNREF_PARAM(rowCount);
+	UNREF_PARAM(depthOffset);
+	UNREF_PARAM(depthCount);
+#endif
+#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+	subresourceDesc.mRowPitch = rowPitch;
+	subresourceDesc.mSlicePitch = slicePitch;
+#else
+	UNREF_PARAM(rowPitch);
+	UNREF_PARAM(slicePitch);
+#endif
+	return subresourceDesc;
+}
+
+// Most detailed mips of the file left out of a texture that only keeps residentMips of them
+static uint32_t util_get_skipped_mips(const TextureDesc* pFileDesc, uint32_t residentMips)
+{
+	if (!residentMips || residentMips >= pFileDesc->mMipLevels)
+	{
+		return 0;
+	}
+
+	// Mip 0 of a block compressed texture has to be a whole number of blocks
+	const TinyImageFormat fmt = pFileDesc->mFormat;
+	const uint32_t blockWidth = TinyImageFormat_WidthOfBlock(fmt);
+	const uint32_t blockHeight = TinyImageFormat_HeightOfBlock(fmt);
+	uint32_t skip = pFileDesc->mMipLevels - residentMips;
+	while (skip && ((MIP_REDUCE(pFileDesc->mWidth, skip) % blockWidth) || (MIP_REDUCE(pFileDesc->mHeight, skip) % blockHeight)))
+	{
+		--skip;
+	}
+	return skip;
+}
+
+// Bytes of the residentMips smallest mips of the file, what the texture data takes before any padding of the API
+static uint64_t util_get_resident_mip_size(const TextureDesc* pFileDesc, uint32_t residentMips)
+{
+	uint64_t size = 0;
+	for (uint32_t mip = pFileDesc->mMipLevels - min(residentMips, pFileDesc->mMipLevels); mip < pFileDesc->mMipLevels; ++mip)
+	{
+		uint32_t numBytes = 0;
+		util_get_surface_info(MIP_REDUCE(pFileDesc->mWidth, mip), MIP_REDUCE(pFileDesc->mHeight, mip), pFileDesc->mFormat, &numBytes, NULL, NULL);
+		size += (uint64_t)numBytes * MIP_REDUCE(pFileDesc->mDepth, mip);
+	}
+	return size * pFileDesc->mArraySize;
+}
 /************************************************************************/
 // Internal Functions
 /************************************************************************/
@@ -528,7 +651,10 @@ static bool waitCopyEngineSet(Renderer* pRenderer, CopyEngine* pCopyEngine, size
 	completed = status != FENCE_STATUS_INCOMPLETE;
 	if (wait && !completed)
 	{
+		const int64_t waitStart = getUSec();
 		waitForFences(pRenderer, 1, &resourceSet.pFence);
+		RESOURCE_LOADER_STAT_ADD(mCopyEngineWaitCount, 1);
+		RESOURCE_LOADER_STAT_ADD(mCopyEngineWaitUs, getUSec() - waitStart);
 	}
 #else
 	UNREF_PARAM(pRenderer);
@@ -582,7 +708,28 @@ static void streamerFlush(CopyEngine* pCopyEngine, size_t activeSet)
 	}
 }
 
-/// Return memory from pre-allocated staging buffer or create a temporary buffer if the streamer ran out of memory
+/// Bytes left in the staging buffer of the current set once the next allocation is aligned
+static uint64_t getStagingSpaceLeft(uint32_t alignment)
+{
+	// Use the copy engine for GPU 0.
+	CopyResourceSet* pResourceSet = &pResourceLoader->pCopyEngines[0].resourceSets[pResourceLoader->mNextSet];
+	uint64_t offset = pResourceSet->mAllocatedSpace;
+	if (alignment != 0)
+	{
+		offset = round_up_64(offset, alignment);
+	}
+
+	uint64_t size = (uint64_t)pResourceSet->mBuffer->mSize;
+	return offset < size ? size - offset : 0;
+}
+
+static bool isStagingBufferEmpty()
+{
+	return pResourceLoader->pCopyEngines[0].resourceSets[pResourceLoader->mNextSet].mAllocatedSpace == 0;
+}
+
+/// Return memory from the staging buffer of the current set, pData is NULL if what is left of it is too small.
+/// Callers then either split the upload or call streamerSubmitAndAdvance to continue in the next set.
 static MappedMemoryRange allocateStagingMemory(uint64_t memoryRequirement, uint32_t alignment)
 {
 	// Use the copy engine for GPU 0.
@@ -603,34 +750,75 @@ static MappedMemoryRange allocateStagingMemory(uint64_t memoryRequirement, uint3
 		ASSERT(buffer->pCpuMappedAddress);
 		uint8_t* pDstData = (uint8_t*)buffer->pCpuMappedAddress + offset;
 		pCopyEngine->resourceSets[pResourceLoader->mNextSet].mAllocatedSpace = offset + memoryRequirement;
+		pResourceLoader->mIterationBytes += memoryRequirement;
+		RESOURCE_LOADER_STAT_ADD(mStagingBytes, memoryRequirement);
+		tfrg_atomic64_max_relaxed(&gStagingPeakBytes, offset + memoryRequirement);
 		return { pDstData, buffer, offset, memoryRequirement };
 	}
-	else
-	{
-		if (pCopyEngine->bufferSize < memoryRequirement)
-		{
-			MappedMemoryRange range = allocateUploadMemory(pResourceLoader->pRenderer, memoryRequirement, alignment);
-			//LOGF(LogLevel::eINFO, "Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu", memoryRequirement, size);
-			pResourceSet->mTempBuffers.emplace_back(range.pBuffer);
-			return range;
-		}
-	}
+
+	return {};
+}
+
+/// Temporary staging buffer for an upload that can not be split and does not fit an empty staging buffer, freed with the current set
+static MappedMemoryRange allocateTempStagingMemory(uint64_t memoryRequirement, uint32_t alignment)
+{
+	pResourceLoader->mIterationBytes += memoryRequirement;
+	RESOURCE_LOADER_STAT_ADD(mTempBufferCount, 1);
+	RESOURCE_LOADER_STAT_ADD(mTempBufferBytes, memoryRequirement);
+	LOGF(eINFO, "Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu",
+		(unsigned long long)memoryRequirement, (unsigned long long)pResourceLoader->pCopyEngines[0].bufferSize);
 
 	MappedMemoryRange range = allocateUploadMemory(pResourceLoader->pRenderer, memoryRequirement, alignment);
-	//LOGF(LogLevel::eINFO, "Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu", memoryRequirement, size);
-	pResourceSet->mTempBuffers.emplace_back(range.pBuffer);
+	pResourceLoader->pCopyEngines[0].resourceSets[pResourceLoader->mNextSet].mTempBuffers.emplace_back(range.pBuffer);
 	return range;
 }
 
+/// Move the streamer to the next copy engine set once the GPU is done with it, and signal the tokens that set covered
+static void streamerActivateNextSet(ResourceLoader* pLoader)
+{
+	uint32_t linkedGPUCount = pLoader->pRenderer->mLinkedNodeCount;
+
+	pLoader->mNextSet = (pLoader->mNextSet + 1) % pLoader->mDesc.mBufferCount;
+	for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+	{
+		waitCopyEngineSet(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet, true);
+		resetCopyEngineSet(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet);
+	}
+
+	// Signal pending tokens from previous frames
+	pLoader->mTokenMutex.Acquire();
+	tfrg_atomic64_store_release(&pLoader->mTokenCompleted, pLoader->mCurrentTokenState[pLoader->mNextSet]);
+	pLoader->mTokenMutex.Release();
+	pLoader->mTokenCond.WakeAll();
+}
+
+/// Called when an upload ran out of staging memory: submit what was recorded so far and carry on in the next set.
+/// Big resources stream through the fixed staging buffers over several submissions instead of needing temporary buffers.
+static void streamerSubmitAndAdvance(ResourceLoader* pLoader)
+{
+	uint32_t linkedGPUCount = pLoader->pRenderer->mLinkedNodeCount;
+	for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
+	{
+		streamerFlush(&pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet);
+	}
+	pLoader->mCurrentTokenState[pLoader->mNextSet] = max(pLoader->mRecordedToken, getLastTokenCompleted());
+
+	streamerActivateNextSet(pLoader);
+	RESOURCE_LOADER_STAT_ADD(mStagingFlushCount, 1);
+}
+
 static void freeAllUploadMemory()
 {
 	for (size_t i = 0; i < MAX_LINKED_GPUS; ++i)
 	{
-		for (UpdateRequest& request : pResourceLoader->mRequestQueue[i])
+		for (uint32_t priority = 0; priority < LOAD_PRIORITY_COUNT; ++priority)
 		{
-			if (request.pUploadBuffer)
+			for (UpdateRequest& request : pResourceLoader->mRequestQueue[i][priority])
 			{
-				removeBuffer(pResourceLoader->pRenderer, request.pUploadBuffer);
+				if (request.pUploadBuffer)
+				{
+					removeBuffer(pResourceLoader->pRenderer, request.pUploadBuffer);
+				}
 			}
 		}
 	}
@@ -650,18 +838,14 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 
 	const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
 	const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
-	const uint64_t requiredSize = util_get_surface_size(fmt, texture->mWidth, texture->mHeight, texture->mDepth,
-		rowAlignment,
-		sliceAlignment,
-		texUpdateDesc.mBaseMipLevel, texUpdateDesc.mMipLevels,
-		texUpdateDesc.mBaseArrayLayer, texUpdateDesc.mLayerCount);
+	const bool splitSubresources = util_can_split_subresource(fmt);
 
 #if defined(VULKAN)
 	TextureBarrier barrier = { texture, RESOURCE_STATE_UNDEFINED, RESOURCE_STATE_COPY_DEST };
 	cmdResourceBarrier(cmd, 0, NULL, 1, &barrier, 0, NULL);
 #endif
 
-	MappedMemoryRange upload = dataAlreadyFilled ? texUpdateDesc.mRange : allocateStagingMemory(requiredSize, sliceAlignment);
+	MappedMemoryRange upload = dataAlreadyFilled ? texUpdateDesc.mRange : MappedMemoryRange{};
 	uint64_t offset = 0;
 
 	// #TODO: Investigate - fsRead crashes if we pass the upload buffer mapped address. Allocating temporary buffer as a workaround. Does NX support loading from disk to GPU shared memory?
@@ -684,15 +868,18 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 	}
 #endif
 
-	if (!upload.pData)
-	{
-		return UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
-	}
+	// Mips are iterated in the order of the stream, the skipped ones come first
+	const uint32_t skipMips = texUpdateDesc.mSkipMipLevels;
+	ASSERT(!skipMips || (!dataAlreadyFilled && !texUpdateDesc.mBaseMipLevel));
+	const uint32_t srcWidth = skipMips ? texUpdateDesc.mSrcWidth : (uint32_t)texture->mWidth;
+	const uint32_t srcHeight = skipMips ? texUpdateDesc.mSrcHeight : (uint32_t)texture->mHeight;
+	const uint32_t srcDepth = skipMips ? texUpdateDesc.mSrcDepth : (uint32_t)texture->mDepth;
+	const uint32_t mipEnd = texUpdateDesc.mBaseMipLevel + skipMips + texUpdateDesc.mMipLevels;
 
 	uint32_t firstStart = texUpdateDesc.mMipsAfterSlice ? texUpdateDesc.mBaseMipLevel : texUpdateDesc.mBaseArrayLayer;
-	uint32_t firstEnd = texUpdateDesc.mMipsAfterSlice ? (texUpdateDesc.mBaseMipLevel + texUpdateDesc.mMipLevels) : (texUpdateDesc.mBaseArrayLayer + texUpdateDesc.mLayerCount);
+	uint32_t firstEnd = texUpdateDesc.mMipsAfterSlice ? mipEnd : (texUpdateDesc.mBaseArrayLayer + texUpdateDesc.mLayerCount);
 	uint32_t secondStart = texUpdateDesc.mMipsAfterSlice ? texUpdateDesc.mBaseArrayLayer : texUpdateDesc.mBaseMipLevel;
-	uint32_t secondEnd = texUpdateDesc.mMipsAfterSlice ? (texUpdateDesc.mBaseArrayLayer + texUpdateDesc.mLayerCount) : (texUpdateDesc.mBaseMipLevel + texUpdateDesc.mMipLevels);
+	uint32_t secondEnd = texUpdateDesc.mMipsAfterSlice ? (texUpdateDesc.mBaseArrayLayer + texUpdateDesc.mLayerCount) : mipEnd;
 
 	for (uint32_t p = 0; p < 1; ++p)
 	{
@@ -713,9 +900,9 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 				uint32_t mip = texUpdateDesc.mMipsAfterSlice ? j : i;
 				uint32_t layer = texUpdateDesc.mMipsAfterSlice ? i : j;
 
-				uint32_t w = MIP_REDUCE(texture->mWidth, mip);
-				uint32_t h = MIP_REDUCE(texture->mHeight, mip);
-				uint32_t d = MIP_REDUCE(texture->mDepth, mip);
+				uint32_t w = MIP_REDUCE(srcWidth, mip);
+				uint32_t h = MIP_REDUCE(srcHeight, mip);
+				uint32_t d = MIP_REDUCE(srcDepth, mip);
 
 				uint32_t numBytes = 0;
 				uint32_t rowBytes = 0;
@@ -727,19 +914,82 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 					return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 				}
 
+				if (mip < skipMips)
+				{
+					if (!fsSeekStream(&stream, SBO_CURRENT_POSITION, (ssize_t)rowBytes * numRows * d))
+					{
+						return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+					}
+					continue;
+				}
+				mip -= skipMips;
+
 				uint32_t subRowPitch = round_up(rowBytes, rowAlignment);
 				uint32_t subSlicePitch = round_up(subRowPitch * numRows, sliceAlignment);
 				uint32_t subNumRows = numRows;
 				uint32_t subDepth = d;
 				uint32_t subRowSize = rowBytes;
-				uint8_t* data = upload.pData + offset;
 
-				if (!dataAlreadyFilled)
+				if (dataAlreadyFilled)
+				{
+					SubresourceDataDesc subresourceDesc = util_get_subresource_desc(mip, layer, upload.mOffset + offset, 0, subNumRows, 0, subDepth, subRowPitch, subSlicePitch);
+					cmdUpdateSubresource(cmd, texture, upload.pBuffer, &subresourceDesc);
+					offset += subDepth * subSlicePitch;
+					continue;
+				}
+
+				// Stream the subresource through the staging buffer: whole if it fits in what is left,
+				// otherwise in ranges of depth slices or block rows, submitting and moving to the next set when it is full
+				uint32_t z = 0;
+				uint32_t row = 0;
+				while (z < subDepth)
 				{
-					for (uint32_t z = 0; z < subDepth; ++z)
+					const uint64_t spaceLeft = getStagingSpaceLeft(sliceAlignment);
+					uint32_t depthCount = 0;
+					uint32_t rowCount = subNumRows;
+					// Range of rows within one slice, only needs rowCount * subRowPitch even when it covers all rows
+					// (the slice pitch can be padded past that for sliceAlignment)
+					bool rowRange = false;
+					if (0 == row)
+					{
+						depthCount = (uint32_t)min<uint64_t>(subDepth - z, spaceLeft / subSlicePitch);
+						if (!splitSubresources && depthCount < subDepth)
+						{
+							depthCount = 0;
+						}
+					}
+					if (!depthCount && splitSubresources)
+					{
+						rowCount = (uint32_t)min<uint64_t>(subNumRows - row, spaceLeft / subRowPitch);
+						depthCount = rowCount ? 1 : 0;
+						rowRange = true;
+					}
+
+					MappedMemoryRange range = {};
+					if (depthCount)
+					{
+						range = allocateStagingMemory(rowRange ? (uint64_t)rowCount * subRowPitch : (uint64_t)depthCount * subSlicePitch, sliceAlignment);
+						ASSERT(range.pData);
+					}
+					else if (isStagingBufferEmpty())
+					{
+						// Not even a row fits an empty staging buffer, or the subresource can not be split
+						depthCount = row ? 1 : subDepth - z;
+						rowCount = subNumRows - row;
+						range = allocateTempStagingMemory(rowCount < subNumRows ? (uint64_t)rowCount * subRowPitch : (uint64_t)depthCount * subSlicePitch, sliceAlignment);
+					}
+					else
 					{
-						uint8_t* dstData = data + subSlicePitch * z;
-						for (uint32_t r = 0; r < subNumRows; ++r)
+						streamerSubmitAndAdvance(pResourceLoader);
+						activeSet = pResourceLoader->mNextSet;
+						cmd = acquireCmd(pCopyEngine, activeSet);
+						continue;
+					}
+
+					for (uint32_t slice = 0; slice < depthCount; ++slice)
+					{
+						uint8_t* dstData = range.pData + subSlicePitch * slice;
+						for (uint32_t r = 0; r < rowCount; ++r)
 						{
 							ssize_t bytesRead = fsReadFromStream(&stream, dstData + r * subRowPitch, subRowSize);
 							if (bytesRead != subRowSize)
@@ -748,17 +998,24 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 							}
 						}
 					}
+
+					SubresourceDataDesc subresourceDesc = util_get_subresource_desc(mip, layer, range.mOffset, row, rowCount, z, depthCount, subRowPitch, subSlicePitch);
+					cmdUpdateSubresource(cmd, texture, range.pBuffer, &subresourceDesc);
+
+					if (0 == row && rowCount == subNumRows)
+					{
+						z += depthCount;
+					}
+					else
+					{
+						row += rowCount;
+						if (row == subNumRows)
+						{
+							row = 0;
+							++z;
+						}
+					}
 				}
-				SubresourceDataDesc subresourceDesc = {};
-				subresourceDesc.mArrayLayer = layer;
-				subresourceDesc.mMipLevel = mip;
-				subresourceDesc.mSrcOffset = upload.mOffset + offset;
-#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
-				subresourceDesc.mRowPitch = subRowPitch;
-				subresourceDesc.mSlicePitch = subSlicePitch;
-#endif
-				cmdUpdateSubresource(cmd, texture, upload.pBuffer, &subresourceDesc);
-				offset += subDepth * subSlicePitch;
 			}
 		}
 	}
@@ -776,10 +1033,11 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
 	return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
-static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const UpdateRequest& pTextureUpdate)
+// residentMips limits the texture to the smallest mips of the file (0 for all of them), pOutFileDesc receives the mip chain of the file.
+// Containers loaded by the platform (xdds, gnf) and sparse textures always get every mip and leave pOutFileDesc alone.
+static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const TextureLoadDesc* pTextureDesc,
+	uint32_t residentMips = 0, TextureDesc* pOutFileDesc = NULL)
 {
-	const TextureLoadDesc* pTextureDesc = &pTextureUpdate.texLoadDesc;
-
 	if (pTextureDesc->pFileName)
 	{
 		FileStream stream = {};
@@ -898,6 +1156,25 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 			if (NULL != pTextureDesc->pDesc)
 				textureDesc.pVkSamplerYcbcrConversionInfo = pTextureDesc->pDesc->pVkSamplerYcbcrConversionInfo;
 #endif
+			if (pOutFileDesc)
+			{
+				*pOutFileDesc = textureDesc;
+			}
+
+			// Leave out the most detailed mips, the stream still contains them
+			const uint32_t skipMips = util_get_skipped_mips(&textureDesc, residentMips);
+			if (skipMips)
+			{
+				updateDesc.mSkipMipLevels = skipMips;
+				updateDesc.mSrcWidth = textureDesc.mWidth;
+				updateDesc.mSrcHeight = textureDesc.mHeight;
+				updateDesc.mSrcDepth = textureDesc.mDepth;
+				textureDesc.mWidth = MIP_REDUCE(textureDesc.mWidth, skipMips);
+				textureDesc.mHeight = MIP_REDUCE(textureDesc.mHeight, skipMips);
+				textureDesc.mDepth = MIP_REDUCE(textureDesc.mDepth, skipMips);
+				textureDesc.mMipLevels -= skipMips;
+			}
+
 			addTexture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
 
 			updateDesc.mStream = stream;
@@ -1023,6 +1300,19 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 	return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 }
 
+static UploadFunctionResult loadStreamingTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const StreamingTextureLoadRequest& request)
+{
+	const StreamingTexture* pStreamingTexture = request.pStreamingTexture;
+
+	TextureLoadDesc loadDesc = {};
+	loadDesc.ppTexture = request.ppTexture;
+	loadDesc.pFileName = pStreamingTexture->mFileName;
+	loadDesc.mNodeIndex = pStreamingTexture->mNodeIndex;
+	loadDesc.mCreationFlag = pStreamingTexture->mCreationFlag;
+	loadDesc.mContainer = pStreamingTexture->mContainer;
+	return loadTexture(pRenderer, pCopyEngine, activeSet, &loadDesc, request.mResidentMips, request.pOutFileDesc);
+}
+
 static UploadFunctionResult updateBuffer(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const BufferUpdateDesc& bufUpdateDesc)
 {
 	ASSERT(pCopyEngine->pQueue->mNodeIndex == bufUpdateDesc.pBuffer->mNodeIndex);
@@ -1037,6 +1327,46 @@ static UploadFunctionResult updateBuffer(Renderer* pRenderer, CopyEngine* pCopyE
 	return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
+/// Copy CPU memory into a GPU buffer through the staging buffer, in as many pieces and submissions as it takes
+static void streamBufferData(CopyEngine* pCopyEngine, Buffer* pBuffer, uint64_t dstOffset, const uint8_t* pSrcData, uint64_t size)
+{
+	while (size)
+	{
+		uint64_t chunkSize = min(size, getStagingSpaceLeft(RESOURCE_BUFFER_ALIGNMENT) & ~(uint64_t)(RESOURCE_BUFFER_ALIGNMENT - 1));
+		if (!chunkSize)
+		{
+			streamerSubmitAndAdvance(pResourceLoader);
+			continue;
+		}
+
+		MappedMemoryRange range = allocateStagingMemory(chunkSize, RESOURCE_BUFFER_ALIGNMENT);
+		ASSERT(range.pData);
+		memcpy(range.pData, pSrcData, chunkSize);
+		cmdUpdateBuffer(acquireCmd(pCopyEngine, pResourceLoader->mNextSet), pBuffer, dstOffset, range.pBuffer, range.mOffset, chunkSize);
+
+		pSrcData += chunkSize;
+		dstOffset += chunkSize;
+		size -= chunkSize;
+	}
+}
+
+static VertexLayout* allocVertexLayoutCopy(ResourceLoader* pLoader, const VertexLayout* pVertexLayout)
+{
+	VertexLayout* pCopy = NULL;
+	{
+		MutexLock lock(pLoader->mVertexLayoutPoolMutex);
+		pCopy = (VertexLayout*)poolAlloc(&pLoader->mVertexLayoutPool);
+	}
+	memcpy(pCopy, pVertexLayout, sizeof(VertexLayout));
+	return pCopy;
+}
+
+static void freeVertexLayoutCopy(ResourceLoader* pLoader, VertexLayout* pVertexLayout)
+{
+	MutexLock lock(pLoader->mVertexLayoutPoolMutex);
+	poolFree(&pLoader->mVertexLayoutPool, pVertexLayout);
+}
+
 static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pGeometryLoad)
 {
 	GeometryLoadDesc* pDesc = &pGeometryLoad.geomLoadDesc;
@@ -1216,6 +1546,21 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		// since gltf assumes we have index buffer per primitive which is non optimal
 		const uint32_t indexStride = vertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
 
+#if !UMA
+		// Buffers get filled in place in the staging buffer when they fit in it, if not in what is left of it then in the next set.
+		// Meshes bigger than a whole staging buffer are built in CPU memory and streamed through it in pieces.
+		uint64_t stagingSize = round_up_64((uint64_t)indexCount * indexStride, RESOURCE_BUFFER_ALIGNMENT);
+		for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
+			stagingSize += round_up_64((uint64_t)vertexStrides[i] * vertexCount, RESOURCE_BUFFER_ALIGNMENT);
+
+		const bool streamFromCpu = stagingSize > pCopyEngine->bufferSize;
+		if (!streamFromCpu && getStagingSpaceLeft(RESOURCE_BUFFER_ALIGNMENT) < stagingSize)
+		{
+			streamerSubmitAndAdvance(pResourceLoader);
+			activeSet = pResourceLoader->mNextSet;
+		}
+#endif
+
 		uint32_t totalSize = 0;
 		totalSize += round_up(sizeof(Geometry), 16);
 		totalSize += round_up(drawCount * sizeof(IndirectDrawIndexArguments), 16);
@@ -1271,7 +1616,8 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 #if UMA
 		indexUpdateDesc.mInternal.mMappedRange = { (uint8_t*)geom->pIndexBuffer->pCpuMappedAddress };
 #else
-		indexUpdateDesc.mInternal.mMappedRange = allocateStagingMemory(indexUpdateDesc.mSize, RESOURCE_BUFFER_ALIGNMENT);
+		indexUpdateDesc.mInternal.mMappedRange = streamFromCpu ? MappedMemoryRange{ (uint8_t*)tf_malloc(indexUpdateDesc.mSize) } :
+			allocateStagingMemory(indexUpdateDesc.mSize, RESOURCE_BUFFER_ALIGNMENT);
 #endif
 		indexUpdateDesc.pMappedData = indexUpdateDesc.mInternal.mMappedRange.pData;
 
@@ -1299,7 +1645,8 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 #if UMA
 			vertexUpdateDesc[i].mInternal.mMappedRange = { (uint8_t*)geom->pVertexBuffers[bufferCounter]->pCpuMappedAddress, 0 };
 #else
-			vertexUpdateDesc[i].mInternal.mMappedRange = allocateStagingMemory(vertexUpdateDesc[i].mSize, RESOURCE_BUFFER_ALIGNMENT);
+			vertexUpdateDesc[i].mInternal.mMappedRange = streamFromCpu ? MappedMemoryRange{ (uint8_t*)tf_malloc(vertexUpdateDesc[i].mSize) } :
+				allocateStagingMemory(vertexUpdateDesc[i].mSize, RESOURCE_BUFFER_ALIGNMENT);
 #endif
 			vertexUpdateDesc[i].pMappedData = vertexUpdateDesc[i].mInternal.mMappedRange.pData;
 			++bufferCounter;
@@ -1388,13 +1735,30 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 
 		UploadFunctionResult uploadResult = UPLOAD_FUNCTION_RESULT_COMPLETED;
 #if !UMA
-		uploadResult = updateBuffer(pRenderer, pCopyEngine, activeSet, indexUpdateDesc);
+		if (streamFromCpu)
+		{
+			streamBufferData(pCopyEngine, indexUpdateDesc.pBuffer, 0, (uint8_t*)indexUpdateDesc.pMappedData, indexUpdateDesc.mSize);
+			tf_free(indexUpdateDesc.pMappedData);
 
-		for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
+			for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
+			{
+				if (vertexUpdateDesc[i].pMappedData)
+				{
+					streamBufferData(pCopyEngine, vertexUpdateDesc[i].pBuffer, 0, (uint8_t*)vertexUpdateDesc[i].pMappedData, vertexUpdateDesc[i].mSize);
+					tf_free(vertexUpdateDesc[i].pMappedData);
+				}
+			}
+		}
+		else
 		{
-			if (vertexUpdateDesc[i].pMappedData)
+			uploadResult = updateBuffer(pRenderer, pCopyEngine, activeSet, indexUpdateDesc);
+
+			for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
 			{
-				uploadResult = updateBuffer(pRenderer, pCopyEngine, activeSet, vertexUpdateDesc[i]);
+				if (vertexUpdateDesc[i].pMappedData)
+				{
+					uploadResult = updateBuffer(pRenderer, pCopyEngine, activeSet, vertexUpdateDesc[i]);
+				}
 			}
 		}
 #endif
@@ -1480,7 +1844,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		data->file_data = fileData;
 		cgltf_free(data);
 
-		tf_free(pDesc->pVertexLayout);
+		freeVertexLayoutCopy(pResourceLoader, pDesc->pVertexLayout);
 
 		*pDesc->ppGeometry = geom;
 
@@ -1492,24 +1856,147 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 /************************************************************************/
 // Internal Resource Loader Implementation
 /************************************************************************/
+// Order in which the streamer takes requests out of the priority queues
+static const LoadPriority gLoadPriorityOrder[LOAD_PRIORITY_COUNT] = { LOAD_PRIORITY_HIGH, LOAD_PRIORITY_NORMAL, LOAD_PRIORITY_LOW };
+
 static bool areTasksAvailable(ResourceLoader* pLoader)
 {
 	for (size_t i = 0; i < MAX_LINKED_GPUS; ++i)
 	{
-		if (!pLoader->mRequestQueue[i].empty())
+		for (uint32_t priority = 0; priority < LOAD_PRIORITY_COUNT; ++priority)
 		{
-			return true;
+			if (!pLoader->mRequestQueue[i][priority].empty())
+			{
+				return true;
+			}
 		}
 	}
 
 	return false;
 }
 
+// Requests are taken out of order across priorities, so the tokens that can be signaled are the ones below the oldest request still queued.
+// Each queue is in token order, its oldest request is at the front. Called with mQueueMutex held.
+static SyncToken getRecordedToken(ResourceLoader* pLoader)
+{
+	SyncToken oldestPending = tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter) + 1;
+	for (size_t i = 0; i < MAX_LINKED_GPUS; ++i)
+	{
+		for (uint32_t priority = 0; priority < LOAD_PRIORITY_COUNT; ++priority)
+		{
+			const eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[i][priority];
+			if (!requestQueue.empty())
+			{
+				oldestPending = min(oldestPending, requestQueue.front().mWaitIndex);
+			}
+		}
+	}
+	return oldestPending - 1;
+}
+
+static void releaseCancelledRequest(ResourceLoader* pLoader, UpdateRequest& request)
+{
+	if (request.pUploadBuffer)
+	{
+		removeBuffer(pLoader->pRenderer, request.pUploadBuffer);
+	}
+	if (UPDATE_REQUEST_LOAD_GEOMETRY == request.mType)
+	{
+		freeVertexLayoutCopy(pLoader, request.geomLoadDesc.pVertexLayout);
+	}
+}
+
+// Mirrors the loader and file system statistics into profiler counters, once per streamer iteration
+static void publishResourceLoaderCounters()
+{
+#if PROFILE_ENABLED
+	static bool countersConfigured = false;
+	if (!countersConfigured)
+	{
+		PROFILE_COUNTER_CONFIG("ResourceLoader/Staging/Bytes", PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+		PROFILE_COUNTER_CONFIG("ResourceLoader/Staging/PeakBytes", PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+		PROFILE_COUNTER_CONFIG("ResourceLoader/Staging/TempBufferBytes", PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+		PROFILE_COUNTER_CONFIG("ResourceLoader/Streaming/ResidentBytes", PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+		PROFILE_COUNTER_CONFIG("ResourceLoader/Streaming/BudgetBytes", PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+		PROFILE_COUNTER_CONFIG("ResourceLoader/DeviceMemory/UsageBytes", PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+		PROFILE_COUNTER_CONFIG("ResourceLoader/DeviceMemory/BudgetBytes", PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+		countersConfigured = true;
+	}
+
+	ResourceLoaderStats stats = {};
+	getResourceLoaderStats(&stats);
+	PROFILE_COUNTER_SET("ResourceLoader/Staging/Bytes", (int64_t)stats.mStagingBytes);
+	PROFILE_COUNTER_SET("ResourceLoader/Staging/PeakBytes", (int64_t)stats.mStagingPeakBytes);
+	PROFILE_COUNTER_SET("ResourceLoader/Staging/TempBuffers", (int64_t)stats.mTempBufferCount);
+	PROFILE_COUNTER_SET("ResourceLoader/Staging/TempBufferBytes", (int64_t)stats.mTempBufferBytes);
+	PROFILE_COUNTER_SET("ResourceLoader/Staging/Flushes", (int64_t)stats.mStagingFlushCount);
+	PROFILE_COUNTER_SET("ResourceLoader/CopyEngineWait/Count", (int64_t)stats.mCopyEngineWaitCount);
+	PROFILE_COUNTER_SET("ResourceLoader/CopyEngineWait/Us", (int64_t)stats.mCopyEngineWaitUs);
+	PROFILE_COUNTER_SET("ResourceLoader/TokenWait/Count", (int64_t)stats.mTokenWaitCount);
+	PROFILE_COUNTER_SET("ResourceLoader/TokenWait/Us", (int64_t)stats.mTokenWaitUs);
+	PROFILE_COUNTER_SET("ResourceLoader/Requests/Queued", (int64_t)stats.mRequestsQueued);
+	PROFILE_COUNTER_SET("ResourceLoader/Requests/Processed", (int64_t)stats.mRequestsProcessed);
+	PROFILE_COUNTER_SET("ResourceLoader/Requests/Cancelled", (int64_t)stats.mRequestsCancelled);
+	PROFILE_COUNTER_SET("ResourceLoader/Requests/QueueDepth", (int64_t)stats.mRequestQueueDepth);
+	PROFILE_COUNTER_SET("ResourceLoader/Requests/QueueDepthPeak", (int64_t)stats.mRequestQueueDepthPeak);
+	PROFILE_COUNTER_SET("ResourceLoader/Streaming/ResidentBytes", (int64_t)stats.mStreamingResidentBytes);
+	PROFILE_COUNTER_SET("ResourceLoader/Streaming/BudgetBytes", (int64_t)stats.mStreamingBudgetBytes);
+	PROFILE_COUNTER_SET("ResourceLoader/Streaming/MipLoads", (int64_t)stats.mStreamingMipLoads);
+	PROFILE_COUNTER_SET("ResourceLoader/Streaming/MipEvictions", (int64_t)stats.mStreamingMipEvictions);
+	PROFILE_COUNTER_SET("ResourceLoader/DeviceMemory/UsageBytes", (int64_t)stats.mDeviceMemoryUsageBytes);
+	PROFILE_COUNTER_SET("ResourceLoader/DeviceMemory/BudgetBytes", (int64_t)stats.mDeviceMemoryBudgetBytes);
+
+	// One counter group per directory, created the first time a directory is read from
+	static const char* directoryNames[RD_MIDDLEWARE_0] = {
+		"ShaderBinaries", "ShaderSources", "PipelineCache", "Textures", "Meshes", "Fonts", "Animations",
+		"Audio", "GpuConfig", "Log", "Scripts", "Screenshots", "OtherFiles",
+	};
+	static bool         tokensCreated[RD_COUNT] = {};
+	static ProfileToken bytesTokens[RD_COUNT] = {};
+	static ProfileToken timeTokens[RD_COUNT] = {};
+	static ProfileToken countTokens[RD_COUNT] = {};
+	// Only touched by the streamer thread, so one static snapshot avoids a heap allocation every iteration
+	static FileSystemStats fsStats = {};
+	FileSystemStats* pFsStats = &fsStats;
+	fsGetStats(pFsStats);
+	for (uint32_t i = 0; i < RD_COUNT; ++i)
+	{
+		if (!pFsStats->mReadCount[i])
+		{
+			continue;
+		}
+		if (!tokensCreated[i])
+		{
+			char directoryName[32];
+			if (i < RD_MIDDLEWARE_0)
+				snprintf(directoryName, sizeof(directoryName), "%s", directoryNames[i]);
+			else
+				snprintf(directoryName, sizeof(directoryName), "Middleware%u", i - RD_MIDDLEWARE_0);
+
+			char counterName[64];
+			snprintf(counterName, sizeof(counterName), "FileSystem/%s/ReadBytes", directoryName);
+			bytesTokens[i] = ProfileGetCounterToken(counterName);
+			ProfileCounterConfig(counterName, PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+			snprintf(counterName, sizeof(counterName), "FileSystem/%s/ReadUs", directoryName);
+			timeTokens[i] = ProfileGetCounterToken(counterName);
+			snprintf(counterName, sizeof(counterName), "FileSystem/%s/Reads", directoryName);
+			countTokens[i] = ProfileGetCounterToken(counterName);
+			tokensCreated[i] = true;
+		}
+		ProfileCounterSet(bytesTokens[i], (int64_t)pFsStats->mBytesRead[i]);
+		ProfileCounterSet(timeTokens[i], (int64_t)pFsStats->mReadTimeUs[i]);
+		ProfileCounterSet(countTokens[i], (int64_t)pFsStats->mReadCount[i]);
+	}
+#endif
+}
+
 static void streamerThreadFunc(void* pThreadData)
 {
 	ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
 	ASSERT(pLoader);
 
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RESOURCE_LOADER);
+
 #if defined(GLES)
 	GLContext localContext;
 	if (!pLoader->mDesc.mSingleThreaded)
@@ -1518,8 +2005,6 @@ static void streamerThreadFunc(void* pThreadData)
 
 	uint32_t linkedGPUCount = pLoader->pRenderer->mLinkedNodeCount;
 
-	SyncToken      maxToken = {};
-
 	while (pLoader->mRun)
 	{
 		pLoader->mQueueMutex.Acquire();
@@ -1541,18 +2026,9 @@ static void streamerThreadFunc(void* pThreadData)
 
 		pLoader->mQueueMutex.Release();
 
-		pLoader->mNextSet = (pLoader->mNextSet + 1) % pLoader->mDesc.mBufferCount;
-		for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
-		{
-			waitCopyEngineSet(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet, true);
-			resetCopyEngineSet(pLoader->pRenderer, &pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet);
-		}
-
-		// Signal pending tokens from previous frames
-		pLoader->mTokenMutex.Acquire();
-		tfrg_atomic64_store_release(&pLoader->mTokenCompleted, pLoader->mCurrentTokenState[pLoader->mNextSet]);
-		pLoader->mTokenMutex.Release();
-		pLoader->mTokenCond.WakeAll();
+		streamerActivateNextSet(pLoader);
+		pLoader->mIterationBytes = 0;
+		const uint64_t byteBudget = pLoader->mDesc.mSingleThreaded ? 0 : pLoader->mDesc.mIterationByteBudget;
 
 		for (uint32_t nodeIndex = 0; nodeIndex < linkedGPUCount; ++nodeIndex)
 		{
@@ -1560,23 +2036,48 @@ static void streamerThreadFunc(void* pThreadData)
 
 			pLoader->mQueueMutex.Acquire();
 
-			eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex];
+			eastl::vector<UpdateRequest>* requestQueues = pLoader->mRequestQueue[nodeIndex];
 			CopyEngine& copyEngine = pLoader->pCopyEngines[nodeIndex];
 
-			if (!requestQueue.size())
+			if (byteBudget && pLoader->mIterationBytes >= byteBudget)
 			{
 				pLoader->mQueueMutex.Release();
-				continue;
+				break;
 			}
 
-			eastl::vector<UpdateRequest> activeQueue;
-			eastl::swap(requestQueue, activeQueue);
-			pLoader->mQueueMutex.Release();
+			// Sets submitted while these requests are recorded may only signal the tokens below the oldest of them
+			pLoader->mRecordedToken = getRecordedToken(pLoader);
 
-			size_t requestCount = activeQueue.size();
+			// Copy out into the arena in priority order so the queues keep their capacity and neither side hits the heap in steady state
+			resetLinearAllocator(&pLoader->mStreamerArena);
+			eastl::vector<UpdateRequest, LinearEASTLAllocator> activeQueue(LinearEASTLAllocator(&pLoader->mStreamerArena));
+			size_t priorityEnd[LOAD_PRIORITY_COUNT] = {};
+			for (uint32_t p = 0; p < LOAD_PRIORITY_COUNT; ++p)
+			{
+				eastl::vector<UpdateRequest>& requestQueue = requestQueues[gLoadPriorityOrder[p]];
+				activeQueue.insert(activeQueue.end(), requestQueue.begin(), requestQueue.end());
+				requestQueue.clear();
+				priorityEnd[p] = activeQueue.size();
+			}
+			pLoader->mQueueMutex.Release();
 
-			for (size_t j = 0; j < requestCount; ++j)
+			if (activeQueue.empty())
 			{
+				continue;
+			}
+
+			size_t requestCount = activeQueue.size();
+			size_t processedCount = 0;
+
+			for (size_t j = 0; j < requestCount; ++j)
+			{
+				// Leave the rest for the next iteration once the budget is used up, at least one request always gets through
+				if (byteBudget && j && pLoader->mIterationBytes >= byteBudget)
+				{
+					break;
+				}
+				++processedCount;
+
 				UpdateRequest updateState = activeQueue[j];
 
 				UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
@@ -1597,11 +2098,14 @@ static void streamerThreadFunc(void* pThreadData)
 					result = UPLOAD_FUNCTION_RESULT_COMPLETED;
 					break;
 				case UPDATE_REQUEST_LOAD_TEXTURE:
-					result = loadTexture(pLoader->pRenderer, &copyEngine, pLoader->mNextSet, updateState);
+					result = loadTexture(pLoader->pRenderer, &copyEngine, pLoader->mNextSet, &updateState.texLoadDesc);
 					break;
 				case UPDATE_REQUEST_LOAD_GEOMETRY:
 					result = loadGeometry(pLoader->pRenderer, &copyEngine, pLoader->mNextSet, updateState);
 					break;
+				case UPDATE_REQUEST_LOAD_STREAMING_TEXTURE:
+					result = loadStreamingTexture(pLoader->pRenderer, &copyEngine, pLoader->mNextSet, updateState.streamingLoad);
+					break;
 				case UPDATE_REQUEST_INVALID:
 					break;
 				}
@@ -1612,17 +2116,35 @@ static void streamerThreadFunc(void* pThreadData)
 					resourceSet.mTempBuffers.push_back(updateState.pUploadBuffer);
 				}
 
+				// Uploads from beginUpdateResource count against the budget as well
+				if (UPDATE_REQUEST_UPDATE_BUFFER == updateState.mType)
+					pLoader->mIterationBytes += updateState.bufUpdateDesc.mInternal.mMappedRange.mSize;
+				else if (UPDATE_REQUEST_UPDATE_TEXTURE == updateState.mType)
+					pLoader->mIterationBytes += updateState.texUpdateDesc.mRange.mSize;
+
 				bool completed = result == UPLOAD_FUNCTION_RESULT_COMPLETED || result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 
 				completionMask |= completed << nodeIndex;
+			}
+			tfrg_atomic64_add_relaxed(&gRequestQueueDepth, -(int64_t)processedCount);
+			RESOURCE_LOADER_STAT_ADD(mRequestsProcessed, processedCount);
 
-				if (updateState.mWaitIndex && completed)
+			// Put what the budget did not allow back in front of the requests queued in the meantime
+			if (processedCount < requestCount)
+			{
+				pLoader->mQueueMutex.Acquire();
+				size_t priorityStart = 0;
+				for (uint32_t p = 0; p < LOAD_PRIORITY_COUNT; ++p)
 				{
-					ASSERT(maxToken < updateState.mWaitIndex);
-					maxToken = updateState.mWaitIndex;
+					size_t first = max(priorityStart, processedCount);
+					if (first < priorityEnd[p])
+					{
+						eastl::vector<UpdateRequest>& requestQueue = requestQueues[gLoadPriorityOrder[p]];
+						requestQueue.insert(requestQueue.begin(), activeQueue.begin() + first, activeQueue.begin() + priorityEnd[p]);
+					}
+					priorityStart = priorityEnd[p];
 				}
-
-				ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
+				pLoader->mQueueMutex.Release();
 			}
 
 			if (completionMask != 0)
@@ -1634,8 +2156,14 @@ static void streamerThreadFunc(void* pThreadData)
 			}
 		}
 
-		SyncToken nextToken = max(maxToken, getLastTokenCompleted());
+		pLoader->mQueueMutex.Acquire();
+		pLoader->mRecordedToken = getRecordedToken(pLoader);
+		pLoader->mQueueMutex.Release();
+
+		SyncToken nextToken = max(pLoader->mRecordedToken, getLastTokenCompleted());
 		pLoader->mCurrentTokenState[pLoader->mNextSet] = nextToken;
+
+		publishResourceLoaderCounters();
 		if (pResourceLoader->mDesc.mSingleThreaded)
 		{
 			return;
@@ -1674,6 +2202,11 @@ static void addResourceLoader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, Re
 
 	pLoader->mTokenCounter = 0;
 	pLoader->mTokenCompleted = 0;
+	pLoader->mRecordedToken = 0;
+
+	initLinearAllocator(&pLoader->mStreamerArena, 64 * 1024);
+	pLoader->mVertexLayoutPoolMutex.Init();
+	initPoolAllocator(&pLoader->mVertexLayoutPool, sizeof(VertexLayout), alignof(VertexLayout), 32);
 
 	uint32_t linkedGPUCount = pLoader->pRenderer->mLinkedNodeCount;
 	for (uint32_t i = 0; i < linkedGPUCount; ++i)
@@ -1723,21 +2256,46 @@ static void removeResourceLoader(ResourceLoader* pLoader)
 	pLoader->mQueueMutex.Destroy();
 	pLoader->mTokenMutex.Destroy();
 
+	for (RetiredStreamingTexture& retired : pLoader->mRetiredStreamingTextures)
+	{
+		removeTexture(pLoader->pRenderer, retired.pTexture);
+	}
+	if (!pLoader->mStreamingTextures.empty())
+	{
+		LOGF(eWARNING, "%u streaming textures were not removed before exitResourceLoaderInterface", (uint32_t)pLoader->mStreamingTextures.size());
+	}
+	for (StreamingTexture* pStreamingTexture : pLoader->mStreamingTextures)
+	{
+		if (pStreamingTexture->pTexture)
+			removeTexture(pLoader->pRenderer, pStreamingTexture->pTexture);
+		if (pStreamingTexture->pPendingTexture)
+			removeTexture(pLoader->pRenderer, pStreamingTexture->pPendingTexture);
+		tf_delete(pStreamingTexture);
+	}
+	tfrg_atomic64_store_relaxed(&gStreamingResidentBytes, 0);
+	tfrg_atomic64_store_relaxed(&gStreamingBudgetBytes, 0);
+
+	exitLinearAllocator(&pLoader->mStreamerArena);
+	exitPoolAllocator(&pLoader->mVertexLayoutPool);
+	pLoader->mVertexLayoutPoolMutex.Destroy();
+
 	tf_delete(pLoader);
 }
 
 static void queueBufferUpdate(ResourceLoader* pLoader, BufferUpdateDesc* pBufferUpdate, SyncToken* token)
 {
 	uint32_t nodeIndex = pBufferUpdate->pBuffer->mNodeIndex;
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][LOAD_PRIORITY_NORMAL];
 	pLoader->mQueueMutex.Acquire();
 
 	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pBufferUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
-	pLoader->mRequestQueue[nodeIndex].back().pUploadBuffer =
+	requestQueue.emplace_back(UpdateRequest(*pBufferUpdate));
+	requestQueue.back().mWaitIndex = t;
+	requestQueue.back().pUploadBuffer =
 		(pBufferUpdate->mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER) ? pBufferUpdate->mInternal.mMappedRange.pBuffer
 																					   : NULL;
+	onRequestQueued();
 	pLoader->mQueueMutex.Release();
 	pLoader->mQueueCond.WakeOne();
 	if (token) *token = max(t, *token);
@@ -1746,12 +2304,15 @@ static void queueBufferUpdate(ResourceLoader* pLoader, BufferUpdateDesc* pBuffer
 static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDesc* pTextureUpdate, SyncToken* token)
 {
 	uint32_t nodeIndex = pTextureUpdate->mNodeIndex;
+	ASSERT(pTextureUpdate->mPriority < LOAD_PRIORITY_COUNT);
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][pTextureUpdate->mPriority];
 	pLoader->mQueueMutex.Acquire();
 
 	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	requestQueue.emplace_back(UpdateRequest(*pTextureUpdate));
+	requestQueue.back().mWaitIndex = t;
+	onRequestQueued();
 	pLoader->mQueueMutex.Release();
 	pLoader->mQueueCond.WakeOne();
 	if (token) *token = max(t, *token);
@@ -1760,12 +2321,32 @@ static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDesc* pTextureU
 static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
 {
 	uint32_t nodeIndex = pGeometryLoad->mNodeIndex;
+	ASSERT(pGeometryLoad->mPriority < LOAD_PRIORITY_COUNT);
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][pGeometryLoad->mPriority];
+	pLoader->mQueueMutex.Acquire();
+
+	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+
+	requestQueue.emplace_back(UpdateRequest(*pGeometryLoad));
+	requestQueue.back().mWaitIndex = t;
+	onRequestQueued();
+	pLoader->mQueueMutex.Release();
+	pLoader->mQueueCond.WakeOne();
+	if (token) *token = max(t, *token);
+}
+
+static void queueStreamingTextureLoad(ResourceLoader* pLoader, StreamingTextureLoadRequest* pLoad, LoadPriority priority, SyncToken* token)
+{
+	uint32_t nodeIndex = pLoad->pStreamingTexture->mNodeIndex;
+	ASSERT(priority < LOAD_PRIORITY_COUNT);
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][priority];
 	pLoader->mQueueMutex.Acquire();
 
 	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pGeometryLoad));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	requestQueue.emplace_back(UpdateRequest(*pLoad));
+	requestQueue.back().mWaitIndex = t;
+	onRequestQueued();
 	pLoader->mQueueMutex.Release();
 	pLoader->mQueueCond.WakeOne();
 	if (token) *token = max(t, *token);
@@ -1776,14 +2357,16 @@ static void queueTextureUpdate(ResourceLoader* pLoader, TextureUpdateDescInterna
 	ASSERT(pTextureUpdate->mRange.pBuffer);
 
 	uint32_t nodeIndex = pTextureUpdate->pTexture->mNodeIndex;
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][LOAD_PRIORITY_NORMAL];
 	pLoader->mQueueMutex.Acquire();
 
 	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
-	pLoader->mRequestQueue[nodeIndex].back().pUploadBuffer =
+	requestQueue.emplace_back(UpdateRequest(*pTextureUpdate));
+	requestQueue.back().mWaitIndex = t;
+	requestQueue.back().pUploadBuffer =
 		(pTextureUpdate->mRange.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER) ? pTextureUpdate->mRange.pBuffer : NULL;
+	onRequestQueued();
 	pLoader->mQueueMutex.Release();
 	pLoader->mQueueCond.WakeOne();
 	if (token) *token = max(t, *token);
@@ -1792,12 +2375,14 @@ static void queueTextureUpdate(ResourceLoader* pLoader, TextureUpdateDescInterna
 static void queueBufferBarrier(ResourceLoader* pLoader, Buffer* pBuffer, ResourceState state, SyncToken* token)
 {
 	uint32_t nodeIndex = pBuffer->mNodeIndex;
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][LOAD_PRIORITY_NORMAL];
 	pLoader->mQueueMutex.Acquire();
 
 	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest{ BufferBarrier{ pBuffer, RESOURCE_STATE_UNDEFINED, state } });
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	requestQueue.emplace_back(UpdateRequest{ BufferBarrier{ pBuffer, RESOURCE_STATE_UNDEFINED, state } });
+	requestQueue.back().mWaitIndex = t;
+	onRequestQueued();
 	pLoader->mQueueMutex.Release();
 	pLoader->mQueueCond.WakeOne();
 	if (token) *token = max(t, *token);
@@ -1806,12 +2391,14 @@ static void queueBufferBarrier(ResourceLoader* pLoader, Buffer* pBuffer, Resourc
 static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, SyncToken* token)
 {
 	uint32_t nodeIndex = pTexture->mNodeIndex;
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][LOAD_PRIORITY_NORMAL];
 	pLoader->mQueueMutex.Acquire();
 
 	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest{ TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state } });
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	requestQueue.emplace_back(UpdateRequest{ TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state } });
+	requestQueue.back().mWaitIndex = t;
+	onRequestQueued();
 	pLoader->mQueueMutex.Release();
 	pLoader->mQueueCond.WakeOne();
 	if (token) *token = max(t, *token);
@@ -1823,18 +2410,27 @@ static void waitForToken(ResourceLoader* pLoader, const SyncToken* token)
 	{
 		return;
 	}
+	if (isTokenCompleted(token))
+	{
+		return;
+	}
+
+	const int64_t waitStart = getUSec();
 	pLoader->mTokenMutex.Acquire();
 	while (!isTokenCompleted(token))
 	{
 		pLoader->mTokenCond.Wait(pLoader->mTokenMutex);
 	}
 	pLoader->mTokenMutex.Release();
+	RESOURCE_LOADER_STAT_ADD(mTokenWaitCount, 1);
+	RESOURCE_LOADER_STAT_ADD(mTokenWaitUs, getUSec() - waitStart);
 }
 /************************************************************************/
 // Resource Loader Interfae Implementation
 /************************************************************************/
 void initResourceLoaderInterface(Renderer* pRenderer, ResourceLoaderDesc* pDesc)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RESOURCE_LOADER);
 	addResourceLoader(pRenderer, pDesc, &pResourceLoader);
 }
 
@@ -1958,8 +2554,7 @@ void addResource(GeometryLoadDesc* pDesc, SyncToken* token)
 
 	GeometryLoadDesc updateDesc = *pDesc;
 	updateDesc.pFileName = pDesc->pFileName;
-	updateDesc.pVertexLayout = (VertexLayout*)tf_calloc(1, sizeof(VertexLayout));
-	memcpy(updateDesc.pVertexLayout, pDesc->pVertexLayout, sizeof(VertexLayout));
+	updateDesc.pVertexLayout = allocVertexLayoutCopy(pResourceLoader, pDesc->pVertexLayout);
 	queueGeometryLoad(pResourceLoader, &updateDesc, token);
 	if (pResourceLoader->mDesc.mSingleThreaded)
 	{
@@ -2012,6 +2607,8 @@ void beginUpdateResource(BufferUpdateDesc* pBufferUpdate)
 	{
 		// We need to use a staging buffer.
 		MappedMemoryRange range = allocateUploadMemory(pResourceLoader->pRenderer, size, RESOURCE_BUFFER_ALIGNMENT);
+		RESOURCE_LOADER_STAT_ADD(mTempBufferCount, 1);
+		RESOURCE_LOADER_STAT_ADD(mTempBufferBytes, size);
 		pBufferUpdate->pMappedData = range.pData;
 
 		pBufferUpdate->mInternal.mMappedRange = range;
@@ -2066,6 +2663,8 @@ void beginUpdateResource(TextureUpdateDesc* pTextureUpdate)
 
 	// We need to use a staging buffer.
 	pTextureUpdate->mInternal.mMappedRange = allocateUploadMemory(pResourceLoader->pRenderer, requiredSize, alignment);
+	RESOURCE_LOADER_STAT_ADD(mTempBufferCount, 1);
+	RESOURCE_LOADER_STAT_ADD(mTempBufferBytes, requiredSize);
 	pTextureUpdate->mInternal.mMappedRange.mFlags = MAPPED_RANGE_FLAG_TEMP_BUFFER;
 	pTextureUpdate->pMappedData = pTextureUpdate->mInternal.mMappedRange.pData;
 }
@@ -2105,6 +2704,46 @@ void waitForToken(const SyncToken* token)
 	waitForToken(pResourceLoader, token);
 }
 
+bool cancelToken(const SyncToken* token)
+{
+	ASSERT(token);
+	bool cancelled = false;
+
+	pResourceLoader->mQueueMutex.Acquire();
+	for (uint32_t i = 0; i < MAX_LINKED_GPUS && !cancelled; ++i)
+	{
+		for (uint32_t priority = 0; priority < LOAD_PRIORITY_COUNT && !cancelled; ++priority)
+		{
+			eastl::vector<UpdateRequest>& requestQueue = pResourceLoader->mRequestQueue[i][priority];
+			for (UpdateRequest* pRequest = requestQueue.begin(); pRequest != requestQueue.end(); ++pRequest)
+			{
+				if (pRequest->mWaitIndex != *token)
+				{
+					continue;
+				}
+				// Barriers are left alone, later work relies on the state they transition to
+				if (UPDATE_REQUEST_BUFFER_BARRIER != pRequest->mType && UPDATE_REQUEST_TEXTURE_BARRIER != pRequest->mType)
+				{
+					releaseCancelledRequest(pResourceLoader, *pRequest);
+					requestQueue.erase(pRequest);
+					cancelled = true;
+				}
+				break;
+			}
+		}
+	}
+	pResourceLoader->mQueueMutex.Release();
+
+	if (cancelled)
+	{
+		tfrg_atomic64_add_relaxed(&gRequestQueueDepth, -1);
+		RESOURCE_LOADER_STAT_ADD(mRequestsCancelled, 1);
+		// Wake the streamer so the token gets signaled even if nothing else is queued
+		pResourceLoader->mQueueCond.WakeOne();
+	}
+	return cancelled;
+}
+
 bool allResourceLoadsCompleted()
 {
 	SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter);
@@ -2116,6 +2755,396 @@ void waitForAllResourceLoads()
 	SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter);
 	waitForToken(pResourceLoader, &token);
 }
+
+/************************************************************************/
+// Streaming Textures
+/************************************************************************/
+// Streaming loads in flight at once, limits the memory held twice while a texture is replaced
+#define STREAMING_TEXTURE_MAX_PENDING_LOADS 16
+
+// Smallest residency of at least mips the texture can be created with
+static uint32_t util_get_streaming_mips(const StreamingTexture* pStreamingTexture, uint32_t mips)
+{
+	return pStreamingTexture->mFileDesc.mMipLevels - util_get_skipped_mips(&pStreamingTexture->mFileDesc, mips);
+}
+
+// Next residency below mips the texture can be created with, the block alignment of mip 0 rules some out
+static uint32_t util_get_lower_streaming_mips(const StreamingTexture* pStreamingTexture, uint32_t mips)
+{
+	uint32_t lower = mips - 1;
+	while (lower > pStreamingTexture->mMinResidentMips && util_get_streaming_mips(pStreamingTexture, lower) != lower)
+	{
+		--lower;
+	}
+	return max(lower, pStreamingTexture->mMinResidentMips);
+}
+
+static bool compareStreamingEvictCandidates(const StreamingEvictCandidate& a, const StreamingEvictCandidate& b)
+{
+	// Max heap, the top is the texture requested longest ago, then the one whose most detailed mip frees the most
+	if (a.mLastRequestFrame != b.mLastRequestFrame)
+		return a.mLastRequestFrame > b.mLastRequestFrame;
+	return a.mTopMipBytes < b.mTopMipBytes;
+}
+
+// Budget of this updateStreamingTextures, the configured one clamped to what the device has left: streaming may keep what
+// it has plus the unused part of the device budget, and has to give back what the process is over it
+static uint64_t util_get_streaming_budget(ResourceLoader* pLoader)
+{
+	const uint64_t budget = pLoader->mDesc.mStreamingTextureBudget;
+	MemoryBudget   memoryBudget = {};
+	getMemoryBudget(pLoader->pRenderer, &memoryBudget);
+	if (!memoryBudget.mBudget)
+	{
+		return budget;
+	}
+
+	const uint64_t deviceBudget = memoryBudget.mBudget / 100 * STREAMING_TEXTURE_DEVICE_BUDGET_PERCENT;
+	const uint64_t residentBytes = tfrg_atomic64_load_relaxed(&gStreamingResidentBytes);
+	uint64_t       deviceLimit = 0;
+	if (memoryBudget.mUsage <= deviceBudget)
+	{
+		deviceLimit = residentBytes + (deviceBudget - memoryBudget.mUsage);
+	}
+	else
+	{
+		deviceLimit = residentBytes - min(residentBytes, memoryBudget.mUsage - deviceBudget);
+	}
+	// 0 means no limit, keep at least the minimum resident mips instead
+	deviceLimit = max(deviceLimit, (uint64_t)1);
+	return budget ? min(budget, deviceLimit) : deviceLimit;
+}
+
+// Takes the result of the load in flight, returns whether getStreamingTexture changed
+static bool finishStreamingTextureLoad(ResourceLoader* pLoader, StreamingTexture* pStreamingTexture, uint32_t frame)
+{
+	bool changed = false;
+	if (!pStreamingTexture->mResidentMips)
+	{
+		// First load, nothing to retire
+		pStreamingTexture->pTexture = pStreamingTexture->pPendingTexture;
+		pStreamingTexture->pPendingTexture = NULL;
+		changed = pStreamingTexture->pTexture != NULL;
+		if (!pStreamingTexture->pTexture || !pStreamingTexture->mFileDesc.mMipLevels)
+		{
+			pStreamingTexture->mStreamingDisabled = true;
+		}
+		else
+		{
+			const TextureDesc& fileDesc = pStreamingTexture->mFileDesc;
+			pStreamingTexture->mMinResidentMips = pStreamingTexture->pTexture->mMipLevels;
+			pStreamingTexture->mTargetMips = pStreamingTexture->mMinResidentMips;
+			pStreamingTexture->mLastRequestFrame = frame;
+			tfrg_atomic32_store_release(&pStreamingTexture->mMaxDimension, max(fileDesc.mWidth, fileDesc.mHeight));
+		}
+		pStreamingTexture->mResidentMips = pStreamingTexture->pTexture ? pStreamingTexture->pTexture->mMipLevels : 0;
+	}
+	else if (pStreamingTexture->pPendingTexture)
+	{
+		pLoader->mRetiredStreamingTextures.push_back({ pStreamingTexture->pTexture, frame });
+		pStreamingTexture->pTexture = pStreamingTexture->pPendingTexture;
+		pStreamingTexture->pPendingTexture = NULL;
+		pStreamingTexture->mResidentMips = pStreamingTexture->pTexture->mMipLevels;
+		changed = true;
+	}
+	else
+	{
+		LOGF(eWARNING, "Streaming load of %u mips of %s failed, keeping the %u resident ones", pStreamingTexture->mPendingMips,
+			pStreamingTexture->mFileName, pStreamingTexture->mResidentMips);
+		pStreamingTexture->mStreamingDisabled = true;
+	}
+
+	pStreamingTexture->mPendingMips = 0;
+	return changed;
+}
+
+void addStreamingTexture(StreamingTextureLoadDesc* pDesc, SyncToken* token)
+{
+	ASSERT(pDesc->ppStreamingTexture);
+	ASSERT(pDesc->pFileName);
+
+	StreamingTexture* pStreamingTexture = tf_new(StreamingTexture);
+	snprintf(pStreamingTexture->mFileName, sizeof(pStreamingTexture->mFileName), "%s", pDesc->pFileName);
+	pStreamingTexture->mNodeIndex = pDesc->mNodeIndex;
+	pStreamingTexture->mCreationFlag = pDesc->mCreationFlag;
+	pStreamingTexture->mContainer = pDesc->mContainer;
+	pStreamingTexture->mMinResidentMips = pDesc->mMinResidentMips ? pDesc->mMinResidentMips : STREAMING_TEXTURE_DEFAULT_RESIDENT_MIPS;
+	pStreamingTexture->mPendingMips = pStreamingTexture->mMinResidentMips;
+	pStreamingTexture->mRequestedMip = UINT32_MAX;
+	pResourceLoader->mStreamingTextures.push_back(pStreamingTexture);
+	*pDesc->ppStreamingTexture = pStreamingTexture;
+
+	// Published to pTexture by updateStreamingTextures once the upload completed
+	StreamingTextureLoadRequest load = { pStreamingTexture, &pStreamingTexture->pPendingTexture, &pStreamingTexture->mFileDesc, pStreamingTexture->mMinResidentMips };
+	queueStreamingTextureLoad(pResourceLoader, &load, pDesc->mPriority, &pStreamingTexture->mPendingToken);
+	if (token) *token = max(pStreamingTexture->mPendingToken, *token);
+	if (pResourceLoader->mDesc.mSingleThreaded)
+	{
+		streamerThreadFunc(pResourceLoader);
+	}
+}
+
+void removeStreamingTexture(StreamingTexture* pStreamingTexture)
+{
+	ASSERT(pStreamingTexture);
+
+	if (pStreamingTexture->mPendingMips && !cancelToken(&pStreamingTexture->mPendingToken))
+	{
+		waitForToken(pResourceLoader, &pStreamingTexture->mPendingToken);
+	}
+	if (pStreamingTexture->pTexture)
+	{
+		removeTexture(pResourceLoader->pRenderer, pStreamingTexture->pTexture);
+	}
+	if (pStreamingTexture->pPendingTexture)
+	{
+		removeTexture(pResourceLoader->pRenderer, pStreamingTexture->pPendingTexture);
+	}
+
+	eastl::vector<StreamingTexture*>& textures = pResourceLoader->mStreamingTextures;
+	StreamingTexture** ppFound = eastl::find(textures.begin(), textures.end(), pStreamingTexture);
+	ASSERT(ppFound != textures.end());
+	*ppFound = textures.back();
+	textures.pop_back();
+
+	tf_delete(pStreamingTexture);
+}
+
+Texture* getStreamingTexture(const StreamingTexture* pStreamingTexture)
+{
+	return pStreamingTexture->pTexture;
+}
+
+void requestStreamingTextureMip(StreamingTexture* pStreamingTexture, uint32_t mip)
+{
+	uint32_t requested = tfrg_atomic32_load_relaxed(&pStreamingTexture->mRequestedMip);
+	while (mip < requested)
+	{
+		const uint32_t previous = tfrg_atomic32_cas_relaxed(&pStreamingTexture->mRequestedMip, requested, mip);
+		if (previous == requested)
+		{
+			break;
+		}
+		requested = previous;
+	}
+}
+
+void requestStreamingTextureScreenSize(StreamingTexture* pStreamingTexture, float screenSize)
+{
+	const uint32_t maxDimension = tfrg_atomic32_load_acquire(&pStreamingTexture->mMaxDimension);
+	if (!maxDimension)
+	{
+		return;
+	}
+
+	const float texelsPerPixel = (float)maxDimension / max(screenSize, 1.0f);
+	requestStreamingTextureMip(pStreamingTexture, texelsPerPixel > 1.0f ? (uint32_t)log2f(texelsPerPixel) : 0);
+}
+
+uint32_t updateStreamingTextures()
+{
+	ResourceLoader* pLoader = pResourceLoader;
+	const uint32_t frame = ++pLoader->mStreamingFrame;
+
+	// Textures replaced STREAMING_TEXTURE_RETIRE_FRAMES updates ago are no longer used by a frame in flight
+	eastl::vector<RetiredStreamingTexture>& retired = pLoader->mRetiredStreamingTextures;
+	uint32_t retiredCount = 0;
+	while (retiredCount < (uint32_t)retired.size() && frame - retired[retiredCount].mFrame >= STREAMING_TEXTURE_RETIRE_FRAMES)
+	{
+		removeTexture(pLoader->pRenderer, retired[retiredCount].pTexture);
+		++retiredCount;
+	}
+	retired.erase(retired.begin(), retired.begin() + retiredCount);
+
+	eastl::vector<StreamingTexture*>& textures = pLoader->mStreamingTextures;
+	eastl::vector<uint32_t>& wantedMips = pLoader->mStreamingWantedMips;
+	const uint32_t textureCount = (uint32_t)textures.size();
+	wantedMips.resize(textureCount);
+
+	// Finish completed loads and work out the residency every texture asks for
+	uint32_t changedCount = 0;
+	uint32_t pendingCount = 0;
+	uint64_t wantedBytes = 0;
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		StreamingTexture* pStreamingTexture = textures[i];
+		wantedMips[i] = pStreamingTexture->mResidentMips;
+
+		if (pStreamingTexture->mPendingMips)
+		{
+			if (!isTokenCompleted(&pStreamingTexture->mPendingToken))
+			{
+				// Charged for what it settles at, the file is unknown until the first load completed
+				++pendingCount;
+				if (pStreamingTexture->mResidentMips)
+				{
+					wantedBytes += util_get_resident_mip_size(&pStreamingTexture->mFileDesc, pStreamingTexture->mPendingMips);
+				}
+				continue;
+			}
+			changedCount += finishStreamingTextureLoad(pLoader, pStreamingTexture, frame) ? 1 : 0;
+			wantedMips[i] = pStreamingTexture->mResidentMips;
+		}
+
+		if (pStreamingTexture->mStreamingDisabled)
+		{
+			continue;
+		}
+
+		// Follow requests for more mips right away, requests for fewer and no requests at all once the last
+		// request for the current residency is STREAMING_TEXTURE_EVICT_FRAMES old
+		const uint32_t requestedMip = tfrg_atomic32_store_relaxed(&pStreamingTexture->mRequestedMip, UINT32_MAX);
+		const bool expired = frame - pStreamingTexture->mLastRequestFrame > STREAMING_TEXTURE_EVICT_FRAMES;
+		if (requestedMip != UINT32_MAX)
+		{
+			const uint32_t mipLevels = pStreamingTexture->mFileDesc.mMipLevels;
+			const uint32_t requestedMips = mipLevels - min(requestedMip, mipLevels - 1);
+			const uint32_t targetMips = util_get_streaming_mips(pStreamingTexture, max(requestedMips, pStreamingTexture->mMinResidentMips));
+			if (targetMips >= pStreamingTexture->mTargetMips || expired)
+			{
+				pStreamingTexture->mTargetMips = targetMips;
+				pStreamingTexture->mLastRequestFrame = frame;
+			}
+		}
+		else if (expired)
+		{
+			pStreamingTexture->mTargetMips = pStreamingTexture->mMinResidentMips;
+		}
+
+		wantedMips[i] = pStreamingTexture->mTargetMips;
+		wantedBytes += util_get_resident_mip_size(&pStreamingTexture->mFileDesc, wantedMips[i]);
+	}
+
+	// Over budget, drop the most detailed mip of the texture requested longest ago (the largest mip among equals) until it fits
+	const uint64_t budget = util_get_streaming_budget(pLoader);
+	tfrg_atomic64_store_relaxed(&gStreamingBudgetBytes, budget);
+	if (budget && wantedBytes > budget)
+	{
+		eastl::vector<StreamingEvictCandidate>& candidates = pLoader->mStreamingEvictCandidates;
+		candidates.clear();
+		for (uint32_t i = 0; i < textureCount; ++i)
+		{
+			const StreamingTexture* pStreamingTexture = textures[i];
+			if (pStreamingTexture->mPendingMips || pStreamingTexture->mStreamingDisabled || wantedMips[i] <= pStreamingTexture->mMinResidentMips)
+			{
+				continue;
+			}
+			const uint64_t topMipBytes = util_get_resident_mip_size(&pStreamingTexture->mFileDesc, wantedMips[i]) -
+				util_get_resident_mip_size(&pStreamingTexture->mFileDesc, util_get_lower_streaming_mips(pStreamingTexture, wantedMips[i]));
+			candidates.push_back({ topMipBytes, pStreamingTexture->mLastRequestFrame, i });
+		}
+		eastl::make_heap(candidates.begin(), candidates.end(), compareStreamingEvictCandidates);
+
+		while (wantedBytes > budget && !candidates.empty())
+		{
+			eastl::pop_heap(candidates.begin(), candidates.end(), compareStreamingEvictCandidates);
+			StreamingEvictCandidate candidate = candidates.back();
+			candidates.pop_back();
+
+			const StreamingTexture* pStreamingTexture = textures[candidate.mIndex];
+			wantedBytes -= candidate.mTopMipBytes;
+			wantedMips[candidate.mIndex] = util_get_lower_streaming_mips(pStreamingTexture, wantedMips[candidate.mIndex]);
+			if (wantedMips[candidate.mIndex] > pStreamingTexture->mMinResidentMips)
+			{
+				const uint32_t lowerMips = util_get_lower_streaming_mips(pStreamingTexture, wantedMips[candidate.mIndex]);
+				candidate.mTopMipBytes = util_get_resident_mip_size(&pStreamingTexture->mFileDesc, wantedMips[candidate.mIndex]) -
+					util_get_resident_mip_size(&pStreamingTexture->mFileDesc, lowerMips);
+				candidates.push_back(candidate);
+				eastl::push_heap(candidates.begin(), candidates.end(), compareStreamingEvictCandidates);
+			}
+		}
+	}
+
+	// Queue the evictions first so their memory comes back before the loads for more mips need it
+	uint32_t queuedCount = 0;
+	for (uint32_t pass = 0; pass < 2; ++pass)
+	{
+		const bool evict = 0 == pass;
+		for (uint32_t i = 0; i < textureCount && pendingCount < STREAMING_TEXTURE_MAX_PENDING_LOADS; ++i)
+		{
+			StreamingTexture* pStreamingTexture = textures[i];
+			if (pStreamingTexture->mPendingMips || pStreamingTexture->mStreamingDisabled || wantedMips[i] == pStreamingTexture->mResidentMips ||
+				evict != (wantedMips[i] < pStreamingTexture->mResidentMips))
+			{
+				continue;
+			}
+
+			StreamingTextureLoadRequest load = { pStreamingTexture, &pStreamingTexture->pPendingTexture, NULL, wantedMips[i] };
+			pStreamingTexture->mPendingToken = 0;
+			pStreamingTexture->mPendingMips = wantedMips[i];
+			queueStreamingTextureLoad(pLoader, &load, evict ? LOAD_PRIORITY_LOW : LOAD_PRIORITY_NORMAL, &pStreamingTexture->mPendingToken);
+			if (evict)
+				RESOURCE_LOADER_STAT_ADD(mStreamingMipEvictions, 1);
+			else
+				RESOURCE_LOADER_STAT_ADD(mStreamingMipLoads, 1);
+			++pendingCount;
+			++queuedCount;
+		}
+	}
+
+	// Both textures of a load in flight are alive until it completes
+	uint64_t residentBytes = 0;
+	for (const StreamingTexture* pStreamingTexture : textures)
+	{
+		if (pStreamingTexture->mResidentMips)
+		{
+			residentBytes += util_get_resident_mip_size(&pStreamingTexture->mFileDesc, pStreamingTexture->mResidentMips);
+			residentBytes += util_get_resident_mip_size(&pStreamingTexture->mFileDesc, pStreamingTexture->mPendingMips);
+		}
+	}
+	tfrg_atomic64_store_relaxed(&gStreamingResidentBytes, residentBytes);
+
+	if (queuedCount && pLoader->mDesc.mSingleThreaded)
+	{
+		streamerThreadFunc(pLoader);
+	}
+
+	return changedCount;
+}
+
+void setStreamingTextureBudget(uint64_t budget)
+{
+	pResourceLoader->mDesc.mStreamingTextureBudget = budget;
+}
+
+void getResourceLoaderStats(ResourceLoaderStats* pOutStats)
+{
+	ASSERT(pOutStats);
+	pOutStats->mStagingBytes = RESOURCE_LOADER_STAT_SUM(mStagingBytes);
+	pOutStats->mStagingPeakBytes = tfrg_atomic64_load_relaxed(&gStagingPeakBytes);
+	pOutStats->mStagingCapacityBytes = pResourceLoader ? pResourceLoader->pCopyEngines[0].bufferSize : 0;
+	pOutStats->mTempBufferCount = RESOURCE_LOADER_STAT_SUM(mTempBufferCount);
+	pOutStats->mTempBufferBytes = RESOURCE_LOADER_STAT_SUM(mTempBufferBytes);
+	pOutStats->mStagingFlushCount = RESOURCE_LOADER_STAT_SUM(mStagingFlushCount);
+	pOutStats->mCopyEngineWaitCount = RESOURCE_LOADER_STAT_SUM(mCopyEngineWaitCount);
+	pOutStats->mCopyEngineWaitUs = RESOURCE_LOADER_STAT_SUM(mCopyEngineWaitUs);
+	pOutStats->mTokenWaitCount = RESOURCE_LOADER_STAT_SUM(mTokenWaitCount);
+	pOutStats->mTokenWaitUs = RESOURCE_LOADER_STAT_SUM(mTokenWaitUs);
+	pOutStats->mRequestsQueued = RESOURCE_LOADER_STAT_SUM(mRequestsQueued);
+	pOutStats->mRequestsProcessed = RESOURCE_LOADER_STAT_SUM(mRequestsProcessed);
+	pOutStats->mRequestsCancelled = RESOURCE_LOADER_STAT_SUM(mRequestsCancelled);
+	pOutStats->mRequestQueueDepth = tfrg_atomic64_load_relaxed(&gRequestQueueDepth);
+	pOutStats->mRequestQueueDepthPeak = tfrg_atomic64_load_relaxed(&gRequestQueueDepthPeak);
+	pOutStats->mStreamingResidentBytes = tfrg_atomic64_load_relaxed(&gStreamingResidentBytes);
+	pOutStats->mStreamingBudgetBytes = tfrg_atomic64_load_relaxed(&gStreamingBudgetBytes);
+	pOutStats->mStreamingMipLoads = RESOURCE_LOADER_STAT_SUM(mStreamingMipLoads);
+	pOutStats->mStreamingMipEvictions = RESOURCE_LOADER_STAT_SUM(mStreamingMipEvictions);
+
+	MemoryBudget memoryBudget = {};
+	if (pResourceLoader)
+	{
+		getMemoryBudget(pResourceLoader->pRenderer, &memoryBudget);
+	}
+	pOutStats->mDeviceMemoryUsageBytes = memoryBudget.mUsage;
+	pOutStats->mDeviceMemoryBudgetBytes = memoryBudget.mBudget;
+}
+
+void resetResourceLoaderStats()
+{
+	memset((void*)gResourceLoaderStats, 0, sizeof(gResourceLoaderStats));
+	tfrg_atomic64_store_relaxed(&gStagingPeakBytes, 0);
+	tfrg_atomic64_store_relaxed(&gRequestQueueDepthPeak, tfrg_atomic64_load_relaxed(&gRequestQueueDepth));
+}
 /************************************************************************/
 // Shader loading
 /************************************************************************/
@@ -2932,15 +3961,20 @@ void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShad
 			if (find_shader_stage(ext, &binaryDesc, &pStage, &stage))
 			{
 				const uint32_t macroCount = pDesc->mStages[i].mMacroCount + pRenderer->mBuiltinShaderDefinesCount;
-				eastl::vector<ShaderMacro> macros(macroCount);
+				// Macro lists are short lived, keep them on the stack unless there are a lot of them
+				unsigned char macroBuffer[64 * sizeof(ShaderMacro)];
+				LinearAllocator macroArena;
+				initLinearAllocator(&macroArena, macroCount * sizeof(ShaderMacro) + alignof(ShaderMacro), macroBuffer, sizeof(macroBuffer));
+				ShaderMacro* pMacros = (ShaderMacro*)linearAlloc(&macroArena, macroCount * sizeof(ShaderMacro), alignof(ShaderMacro));
 				for (uint32_t macro = 0; macro < pRenderer->mBuiltinShaderDefinesCount; ++macro)
-					macros[macro] = pRenderer->pBuiltinShaderDefines[macro];
+					pMacros[macro] = pRenderer->pBuiltinShaderDefines[macro];
 				for (uint32_t macro = 0; macro < pDesc->mStages[i].mMacroCount; ++macro)
-					macros[pRenderer->mBuiltinShaderDefinesCount + macro] = pDesc->mStages[i].pMacros[macro];
+					pMacros[pRenderer->mBuiltinShaderDefinesCount + macro] = pDesc->mStages[i].pMacros[macro];
 
-				if (!load_shader_stage_byte_code(
-					pRenderer, pDesc->mTarget, stage, stages, pDesc->mStages[i], macroCount, macros.data(),
-					pStage))
+				const bool loaded = load_shader_stage_byte_code(
+					pRenderer, pDesc->mTarget, stage, stages, pDesc->mStages[i], macroCount, pMacros, pStage);
+				exitLinearAllocator(&macroArena);
+				if (!loaded)
 					return;
 
 				binaryDesc.mStages |= stage;
@@ -3055,21 +4089,85 @@ void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShad
 /************************************************************************/
 // Pipeline cache save, load
 /************************************************************************/
+static uint32_t util_hash(const void* pData, size_t size, uint32_t seed)
+{
+	uint32_t hash = 0;
+	MurmurHash3_x86_32(pData, (int)size, seed, &hash);
+	return hash;
+}
+
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(GLES)
+#define PIPELINE_CACHE_FILE_MAGIC 0x43505446u // 'TFPC'
+#define PIPELINE_CACHE_FILE_VERSION 1u
+
+// Written in front of the driver blob. A cache is only handed to the driver on the device and driver that produced it
+typedef struct PipelineCacheFileHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint32_t mDeviceHash;
+	uint32_t mDataHash;
+	uint64_t mDataSize;
+} PipelineCacheFileHeader;
+
+static uint32_t util_pipeline_cache_device_hash(Renderer* pRenderer)
+{
+	const GPUVendorPreset* pPreset = &pRenderer->pActiveGpuSettings->mGpuVendorPreset;
+#if defined(DIRECT3D12)
+	uint32_t hash = util_hash("DIRECT3D12", 10, 0);
+#elif defined(VULKAN)
+	uint32_t hash = util_hash("VULKAN", 6, 0);
+#else
+	uint32_t hash = util_hash("GLES", 4, 0);
+#endif
+	hash = util_hash(pPreset->mVendorId, strlen(pPreset->mVendorId), hash);
+	hash = util_hash(pPreset->mModelId, strlen(pPreset->mModelId), hash);
+	hash = util_hash(pPreset->mRevisionId, strlen(pPreset->mRevisionId), hash);
+	hash = util_hash(pPreset->mGpuDriverVersion, strlen(pPreset->mGpuDriverVersion), hash);
+#if defined(VULKAN)
+	// Identifies the driver build, changes with driver updates that keep the reported version
+	const VkPhysicalDeviceProperties* pProperties = &pRenderer->pVkActiveGPUProperties->properties;
+	hash = util_hash(pProperties->pipelineCacheUUID, VK_UUID_SIZE, hash);
+#endif
+	return hash;
+}
+#endif
+
 void addPipelineCache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, PipelineCache** ppPipelineCache)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(GLES)
 	FileStream stream = {};
 	bool success = fsOpenStreamFromPath(RD_PIPELINE_CACHE, pDesc->pFileName, FM_READ_BINARY, &stream);
 	ssize_t dataSize = 0;
 	void* data = NULL;
 	if (success)
 	{
-		dataSize = fsGetStreamFileSize(&stream);
-		data = NULL;
-		if (dataSize)
+		const ssize_t fileSize = fsGetStreamFileSize(&stream);
+		PipelineCacheFileHeader header = {};
+		if (fileSize >= (ssize_t)sizeof(header) && fsReadFromStream(&stream, &header, sizeof(header)) == sizeof(header) &&
+			PIPELINE_CACHE_FILE_MAGIC == header.mMagic && PIPELINE_CACHE_FILE_VERSION == header.mVersion &&
+			(ssize_t)header.mDataSize == fileSize - (ssize_t)sizeof(header))
 		{
-			data = tf_malloc(dataSize);
-			fsReadFromStream(&stream, data, dataSize);
+			if (header.mDeviceHash != util_pipeline_cache_device_hash(pRenderer))
+			{
+				LOGF(LogLevel::eINFO, "Pipeline cache %s was written on another GPU or driver, starting with an empty cache", pDesc->pFileName);
+			}
+			else if (header.mDataSize)
+			{
+				dataSize = (ssize_t)header.mDataSize;
+				data = tf_malloc(dataSize);
+				if (fsReadFromStream(&stream, data, dataSize) != (size_t)dataSize || util_hash(data, dataSize, 0) != header.mDataHash)
+				{
+					LOGF(LogLevel::eWARNING, "Pipeline cache %s is corrupt, starting with an empty cache", pDesc->pFileName);
+					tf_free(data);
+					data = NULL;
+					dataSize = 0;
+				}
+			}
+		}
+		else
+		{
+			LOGF(LogLevel::eINFO, "Pipeline cache %s has an unknown format, starting with an empty cache", pDesc->pFileName);
 		}
 
 		fsCloseStream(&stream);
@@ -3090,7 +4188,7 @@ void addPipelineCache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, P
 
 void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, PipelineCacheSaveDesc* pDesc)
 {
-#if defined(DIRECT3D12) || defined(VULKAN)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(GLES)
 	FileStream stream = {};
 	if (fsOpenStreamFromPath(RD_PIPELINE_CACHE, pDesc->pFileName, FM_WRITE_BINARY, &stream))
 	{
@@ -3100,6 +4198,14 @@ void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, Pipel
 		{
 			void* data = tf_malloc(dataSize);
 			getPipelineCacheData(pRenderer, pPipelineCache, &dataSize, data);
+
+			PipelineCacheFileHeader header = {};
+			header.mMagic = PIPELINE_CACHE_FILE_MAGIC;
+			header.mVersion = PIPELINE_CACHE_FILE_VERSION;
+			header.mDeviceHash = util_pipeline_cache_device_hash(pRenderer);
+			header.mDataHash = util_hash(data, dataSize, 0);
+			header.mDataSize = dataSize;
+			fsWriteToStream(&stream, &header, sizeof(header));
 			fsWriteToStream(&stream, data, dataSize);
 			tf_free(data);
 		}
@@ -3109,4 +4215,172 @@ void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, Pipel
 #endif
 }
 /************************************************************************/
+// Batch pipeline creation
+/************************************************************************/
+// Descs with extensions or raytracing descs are never shared, their content can't be compared
+static bool util_pipeline_desc_shareable(const PipelineDesc* pDesc)
+{
+	return !pDesc->mExtensionCount && (PIPELINE_TYPE_GRAPHICS == pDesc->mType || PIPELINE_TYPE_COMPUTE == pDesc->mType);
+}
+
+template <typename T>
+static bool util_equal_or_null(const T* pA, const T* pB)
+{
+	return pA == pB || (pA && pB && !memcmp(pA, pB, sizeof(T)));
+}
+
+static uint32_t util_pipeline_desc_hash(const PipelineDesc* pDesc)
+{
+	uint32_t hash = util_hash(&pDesc->mType, sizeof(pDesc->mType), 0);
+	hash = util_hash(&pDesc->pCache, sizeof(pDesc->pCache), hash);
+	if (PIPELINE_TYPE_COMPUTE == pDesc->mType)
+	{
+		const ComputePipelineDesc* pCompute = &pDesc->mComputeDesc;
+		hash = util_hash(&pCompute->pShaderProgram, sizeof(pCompute->pShaderProgram), hash);
+		return util_hash(&pCompute->pRootSignature, sizeof(pCompute->pRootSignature), hash);
+	}
+
+	// Pointers and scalars only, the full state structs are compared on hash hits
+	const GraphicsPipelineDesc* pGraphics = &pDesc->mGraphicsDesc;
+	hash = util_hash(&pGraphics->pShaderProgram, sizeof(pGraphics->pShaderProgram), hash);
+	hash = util_hash(&pGraphics->pRootSignature, sizeof(pGraphics->pRootSignature), hash);
+	hash = util_hash(&pGraphics->mRenderTargetCount, sizeof(pGraphics->mRenderTargetCount), hash);
+	if (pGraphics->mRenderTargetCount)
+		hash = util_hash(pGraphics->pColorFormats, pGraphics->mRenderTargetCount * sizeof(TinyImageFormat), hash);
+	hash = util_hash(&pGraphics->mSampleCount, sizeof(pGraphics->mSampleCount), hash);
+	hash = util_hash(&pGraphics->mDepthStencilFormat, sizeof(pGraphics->mDepthStencilFormat), hash);
+	hash = util_hash(&pGraphics->mPrimitiveTopo, sizeof(pGraphics->mPrimitiveTopo), hash);
+	if (pGraphics->pVertexLayout)
+		hash = util_hash(&pGraphics->pVertexLayout->mAttribCount, sizeof(pGraphics->pVertexLayout->mAttribCount), hash);
+	return hash;
+}
+
+static bool util_pipeline_desc_equal(const PipelineDesc* pA, const PipelineDesc* pB)
+{
+	if (pA->mType != pB->mType || pA->pCache != pB->pCache)
+		return false;
+
+	if (PIPELINE_TYPE_COMPUTE == pA->mType)
+		return pA->mComputeDesc.pShaderProgram == pB->mComputeDesc.pShaderProgram &&
+			   pA->mComputeDesc.pRootSignature == pB->mComputeDesc.pRootSignature;
+
+	const GraphicsPipelineDesc* pGa = &pA->mGraphicsDesc;
+	const GraphicsPipelineDesc* pGb = &pB->mGraphicsDesc;
+	if (pGa->pShaderProgram != pGb->pShaderProgram || pGa->pRootSignature != pGb->pRootSignature ||
+		pGa->mRenderTargetCount != pGb->mRenderTargetCount || pGa->mSampleCount != pGb->mSampleCount ||
+		pGa->mSampleQuality != pGb->mSampleQuality || pGa->mDepthStencilFormat != pGb->mDepthStencilFormat ||
+		pGa->mPrimitiveTopo != pGb->mPrimitiveTopo || pGa->mSupportIndirectCommandBuffer != pGb->mSupportIndirectCommandBuffer)
+		return false;
+
+	if (pGa->mRenderTargetCount && memcmp(pGa->pColorFormats, pGb->pColorFormats, pGa->mRenderTargetCount * sizeof(TinyImageFormat)))
+		return false;
+
+	if (pGa->pVertexLayout != pGb->pVertexLayout)
+	{
+		if (!pGa->pVertexLayout || !pGb->pVertexLayout || pGa->pVertexLayout->mAttribCount != pGb->pVertexLayout->mAttribCount ||
+			memcmp(pGa->pVertexLayout->mAttribs, pGb->pVertexLayout->mAttribs, pGa->pVertexLayout->mAttribCount * sizeof(VertexAttrib)))
+			return false;
+	}
+
+	return util_equal_or_null(pGa->pBlendState, pGb->pBlendState) && util_equal_or_null(pGa->pDepthState, pGb->pDepthState) &&
+		   util_equal_or_null(pGa->pRasterizerState, pGb->pRasterizerState);
+}
+
+typedef struct PipelineBatch
+{
+	Renderer*           pRenderer;
+	const PipelineDesc* pDescs;
+	Pipeline**          ppPipelines;
+	const uint32_t*     pUniqueIndices;
+	tfrg_atomic32_t     mDoneCount;
+} PipelineBatch;
+
+static void addPipelineBatchTask(void* pUser, uintptr_t index)
+{
+	PipelineBatch* pBatch = (PipelineBatch*)pUser;
+	const uint32_t descIndex = pBatch->pUniqueIndices[index];
+	addPipeline(pBatch->pRenderer, &pBatch->pDescs[descIndex], &pBatch->ppPipelines[descIndex]);
+	tfrg_atomic32_add_relaxed(&pBatch->mDoneCount, 1);
+}
+
+void addPipelines(Renderer* pRenderer, ThreadSystem* pThreadSystem, uint32_t count, const PipelineDesc* pDescs, Pipeline** ppPipelines)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDescs || !count);
+	ASSERT(ppPipelines || !count);
+
+	// sourceIndices[i] is the first desc with the same content as desc i, only those get created
+	eastl::vector<uint32_t> uniqueIndices;
+	eastl::vector<uint32_t> sourceIndices(count);
+	eastl::hash_multimap<uint32_t, uint32_t> uniqueByHash;
+	uniqueIndices.reserve(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		sourceIndices[i] = i;
+		if (util_pipeline_desc_shareable(&pDescs[i]))
+		{
+			const uint32_t hash = util_pipeline_desc_hash(&pDescs[i]);
+			auto range = uniqueByHash.equal_range(hash);
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				if (util_pipeline_desc_equal(&pDescs[it->second], &pDescs[i]))
+				{
+					sourceIndices[i] = it->second;
+					break;
+				}
+			}
+			if (sourceIndices[i] == i)
+				uniqueByHash.insert(eastl::make_pair(hash, i));
+		}
+		if (sourceIndices[i] == i)
+			uniqueIndices.push_back(i);
+	}
+
+	const uint32_t uniqueCount = (uint32_t)uniqueIndices.size();
+	if (uniqueCount < count)
+		LOGF(LogLevel::eINFO, "addPipelines: %u of %u pipelines are duplicates and share a pipeline", count - uniqueCount, count);
+
+	PipelineBatch batch = {};
+	batch.pRenderer = pRenderer;
+	batch.pDescs = pDescs;
+	batch.ppPipelines = ppPipelines;
+	batch.pUniqueIndices = uniqueIndices.data();
+
+#if defined(GLES)
+	// GL objects can only be created on the thread owning the context
+	pThreadSystem = NULL;
+#endif
+	if (pThreadSystem && uniqueCount > 1)
+	{
+		addThreadSystemRangeTask(pThreadSystem, addPipelineBatchTask, &batch, uniqueCount);
+		while (tfrg_atomic32_load_acquire(&batch.mDoneCount) < uniqueCount)
+		{
+			if (!assistThreadSystem(pThreadSystem))
+				Thread::Sleep(0);
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < uniqueCount; ++i)
+			addPipelineBatchTask(&batch, i);
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+		ppPipelines[i] = ppPipelines[sourceIndices[i]];
+}
+
+void removePipelines(Renderer* pRenderer, uint32_t count, Pipeline** ppPipelines)
+{
+	ASSERT(pRenderer);
+	ASSERT(ppPipelines || !count);
+
+	eastl::hash_set<Pipeline*> removed;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (ppPipelines[i] && removed.insert(ppPipelines[i]).second)
+			removePipeline(pRenderer, ppPipelines[i]);
+		ppPipelines[i] = NULL;
+	}
+}
+/************************************************************************/
 /************************************************************************/
@@ -293,6 +293,12 @@ const char* gVkWantedDeviceExtensions[] =
 	/************************************************************************/
 #if VK_KHR_sampler_ycbcr_conversion
 	VK_KHR_SAMPLER_YCBCR_CONVERSION_EXTENSION_NAME,
+#endif
+	/************************************************************************/
+	// Memory budget query
+	/************************************************************************/
+#if VK_EXT_memory_budget
+	VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
 #endif
     /************************************************************************/
 	// Nsight Aftermath
@@ -321,6 +327,7 @@ static bool gAMDDrawIndirectCountExtension = false;
 static bool gAMDGCNShaderExtension = false;
 static bool gNVRayTracingExtension = false;
 static bool gYCbCrExtension = false;
+static bool gMemoryBudgetExtension = false;
 static bool gDebugMarkerSupport = false;
 
 static void* VKAPI_PTR gVkAllocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
@@ -407,6 +414,41 @@ static uint32_t gDescriptorTypeRangeSize = (FORGE_DESCRIPTOR_TYPE_RANGE_SIZE - 1
 
 static void removeVirtualTexture(Renderer* pRenderer, VirtualTexture* pTexture);
 /************************************************************************/
+// Movable Buffer Structures
+/************************************************************************/
+/// What a buffer created with BUFFER_CREATION_FLAG_MOVABLE_BIT needs to be recreated after defragmentMemory moved its memory
+typedef struct MovableBuffer
+{
+	Buffer*            pBuffer;
+	VkDeviceSize       mSize;
+	VkBufferUsageFlags mUsage;
+} MovableBuffer;
+
+typedef struct MovableBufferRegistry
+{
+	eastl::hash_map<Buffer*, MovableBuffer> mBuffers;
+	Mutex                                   mMutex;
+	/// Created on the first defragmentMemory for the queue it is called with
+	Queue*                                  pQueue;
+	CmdPool*                                pCmdPool;
+	Cmd*                                    pCmd;
+	Fence*                                  pFence;
+} MovableBufferRegistry;
+
+static void remove_movable_buffer_registry(Renderer* pRenderer)
+{
+	MovableBufferRegistry* pRegistry = pRenderer->pMovableBuffers;
+	if (pRegistry->pCmd)
+	{
+		removeFence(pRenderer, pRegistry->pFence);
+		removeCmd(pRenderer, pRegistry->pCmd);
+		removeCmdPool(pRenderer, pRegistry->pCmdPool);
+	}
+	pRegistry->mMutex.Destroy();
+	tf_delete(pRegistry);
+	pRenderer->pMovableBuffers = NULL;
+}
+/************************************************************************/
 // DescriptorInfo Heap Structures
 /************************************************************************/
 /// CPU Visible Heap to store all the resources needing CPU read / write operations - Textures/Buffers/RTV
@@ -528,6 +570,77 @@ static void consume_descriptor_sets(DescriptorPool* pPool,
 	pPool->mUsedDescriptorSetCount += numDescriptorSets;
 }
 
+/************************************************************************/
+// Transient DescriptorInfo Heap Implementation
+/************************************************************************/
+// CPU memory of the DescriptorSet structs is bump allocated in blocks of this size
+#define DESCRIPTOR_SET_ALLOCATOR_ARENA_BLOCK_SIZE (16 * 1024)
+
+/// Pools and CPU memory of the transient sets one thread allocates for one frame. Only touched by that thread
+/// between two resets of the frame, so nothing is locked. Aligned so neighbouring slots don't share a cache line
+typedef struct DescriptorSetAllocatorSlot
+{
+	DEFINE_ALIGNED(LinearAllocator mArena, 64);
+	eastl::vector<VkDescriptorPool> mPools;
+	uint32_t                        mCurrentPool;
+} DescriptorSetAllocatorSlot;
+
+typedef struct DescriptorSetAllocator
+{
+	DescriptorSetAllocatorSlot* pSlots;
+	VkDescriptorPoolSize*       pPoolSizes;
+	uint32_t                    mPoolSizeCount;
+	uint32_t                    mSetsPerPool;
+	uint32_t                    mThreadCount;
+	uint32_t                    mFrameCount;
+} DescriptorSetAllocator;
+
+static VkDescriptorPool add_transient_descriptor_pool(Renderer* pRenderer, const DescriptorSetAllocator* pAllocator)
+{
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.pNext = NULL;
+	poolCreateInfo.poolSizeCount = pAllocator->mPoolSizeCount;
+	poolCreateInfo.pPoolSizes = pAllocator->pPoolSizes;
+	poolCreateInfo.flags = 0;
+	poolCreateInfo.maxSets = pAllocator->mSetsPerPool;
+
+	VkDescriptorPool pDescriptorPool = VK_NULL_HANDLE;
+	CHECK_VKRESULT(vkCreateDescriptorPool(pRenderer->pVkDevice, &poolCreateInfo, &gVkAllocationCallbacks, &pDescriptorPool));
+	return pDescriptorPool;
+}
+
+static void consume_transient_descriptor_sets(Renderer* pRenderer, const DescriptorSetAllocator* pAllocator, DescriptorSetAllocatorSlot* pSlot,
+	const VkDescriptorSetLayout* pLayouts, VkDescriptorSet** pSets, uint32_t numDescriptorSets)
+{
+	DECLARE_ZERO(VkDescriptorSetAllocateInfo, alloc_info);
+	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	alloc_info.pNext = NULL;
+	alloc_info.descriptorSetCount = numDescriptorSets;
+	alloc_info.pSetLayouts = pLayouts;
+
+	// Walk the pools kept from earlier frames before creating new ones. Drivers without VK_KHR_maintenance1 may report
+	// a full pool with any error, so every failure moves on. A fresh pool that can't hold the sets means they are larger than mSetsPerPool allows
+	for (;;)
+	{
+		const bool newPool = pSlot->mCurrentPool == (uint32_t)pSlot->mPools.size();
+		if (newPool)
+			pSlot->mPools.push_back(add_transient_descriptor_pool(pRenderer, pAllocator));
+
+		alloc_info.descriptorPool = pSlot->mPools[pSlot->mCurrentPool];
+		if (VK_SUCCESS == vkAllocateDescriptorSets(pRenderer->pVkDevice, &alloc_info, *pSets))
+			return;
+
+		if (newPool)
+		{
+			LOGF(LogLevel::eERROR, "Transient descriptor sets don't fit in an empty pool of %u sets", pAllocator->mSetsPerPool);
+			ASSERT(false && "Transient descriptor sets don't fit in an empty pool");
+			return;
+		}
+		++pSlot->mCurrentPool;
+	}
+}
+
 /************************************************************************/
 /************************************************************************/
 VkPipelineBindPoint gPipelineBindPoint[PIPELINE_TYPE_COUNT] =
@@ -575,6 +688,14 @@ static const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature,
 		return NULL;
 	}
 }
+
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	ASSERT(pRootSignature);
+	ASSERT(pName);
+	DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap->mMap.find(pName);
+	return it != pRootSignature->pDescriptorNameToIndexMap->mMap.end() ? it->second : (uint32_t)-1;
+}
 /************************************************************************/
 // Render Pass Implementation
 /************************************************************************/
@@ -1676,6 +1797,235 @@ util_determine_pipeline_stage_flags(Renderer* pRenderer, VkAccessFlags accessFla
 	return flags;
 }
 
+/************************************************************************/
+// Barrier batching
+/************************************************************************/
+// Barriers from consecutive cmdResourceBarrier calls are collected per Cmd and recorded once, right before the next
+// draw, dispatch, copy, query or render pass. Nothing is recorded in between, so transitions of the same resource can be
+// folded (A->B, B->C becomes A->C) and read only transitions back to the same state dropped.
+// vkCmdPipelineBarrier takes one stage mask pair, so barriers are recorded in one call per distinct pair of stage masks
+// instead of one call with the union of all stages.
+#define MAX_BATCHED_BARRIERS 64
+
+typedef struct CmdBarrierBatch
+{
+	VkBufferMemoryBarrier mBufferBarriers[MAX_BATCHED_BARRIERS];
+	VkImageMemoryBarrier  mImageBarriers[MAX_BATCHED_BARRIERS];
+	VkPipelineStageFlags  mBufferSrcStages[MAX_BATCHED_BARRIERS];
+	VkPipelineStageFlags  mBufferDstStages[MAX_BATCHED_BARRIERS];
+	VkPipelineStageFlags  mImageSrcStages[MAX_BATCHED_BARRIERS];
+	VkPipelineStageFlags  mImageDstStages[MAX_BATCHED_BARRIERS];
+	uint32_t              mBufferBarrierCount;
+	uint32_t              mImageBarrierCount;
+} CmdBarrierBatch;
+
+static inline bool util_has_write_access(VkAccessFlags access)
+{
+	return (access & (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+					  VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT)) != 0;
+}
+
+static inline bool util_is_ownership_transfer(uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex)
+{
+	return srcQueueFamilyIndex != dstQueueFamilyIndex;
+}
+
+static inline bool util_same_subresource_range(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b)
+{
+	return a.aspectMask == b.aspectMask && a.baseMipLevel == b.baseMipLevel && a.levelCount == b.levelCount &&
+		   a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount;
+}
+
+static inline bool util_ranges_overlap(uint32_t baseA, uint32_t countA, uint32_t baseB, uint32_t countB, uint32_t remaining)
+{
+	const uint64_t endA = countA == remaining ? UINT64_MAX : (uint64_t)baseA + countA;
+	const uint64_t endB = countB == remaining ? UINT64_MAX : (uint64_t)baseB + countB;
+	return baseA < endB && baseB < endA;
+}
+
+static inline bool util_subresource_ranges_overlap(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b)
+{
+	return (a.aspectMask & b.aspectMask) &&
+		   util_ranges_overlap(a.baseMipLevel, a.levelCount, b.baseMipLevel, b.levelCount, VK_REMAINING_MIP_LEVELS) &&
+		   util_ranges_overlap(a.baseArrayLayer, a.layerCount, b.baseArrayLayer, b.layerCount, VK_REMAINING_ARRAY_LAYERS);
+}
+
+static inline bool util_same_barrier(const VkBufferMemoryBarrier& a, const VkBufferMemoryBarrier& b)
+{
+	return a.buffer == b.buffer && a.srcAccessMask == b.srcAccessMask && a.dstAccessMask == b.dstAccessMask &&
+		   a.srcQueueFamilyIndex == b.srcQueueFamilyIndex && a.dstQueueFamilyIndex == b.dstQueueFamilyIndex && a.offset == b.offset &&
+		   a.size == b.size;
+}
+
+static inline bool util_same_barrier(const VkImageMemoryBarrier& a, const VkImageMemoryBarrier& b)
+{
+	return a.image == b.image && a.srcAccessMask == b.srcAccessMask && a.dstAccessMask == b.dstAccessMask && a.oldLayout == b.oldLayout &&
+		   a.newLayout == b.newLayout && a.srcQueueFamilyIndex == b.srcQueueFamilyIndex && a.dstQueueFamilyIndex == b.dstQueueFamilyIndex &&
+		   util_same_subresource_range(a.subresourceRange, b.subresourceRange);
+}
+
+void util_flush_barriers(Cmd* pCmd)
+{
+	CmdBarrierBatch* pBatch = pCmd->pBarrierBatch;
+	if (!pBatch->mBufferBarrierCount && !pBatch->mImageBarrierCount)
+		return;
+
+	VkBufferMemoryBarrier* bufferBarriers =
+		pBatch->mBufferBarrierCount ? (VkBufferMemoryBarrier*)alloca(pBatch->mBufferBarrierCount * sizeof(VkBufferMemoryBarrier)) : NULL;
+	VkImageMemoryBarrier* imageBarriers =
+		pBatch->mImageBarrierCount ? (VkImageMemoryBarrier*)alloca(pBatch->mImageBarrierCount * sizeof(VkImageMemoryBarrier)) : NULL;
+	bool bufferDone[MAX_BATCHED_BARRIERS] = {};
+	bool imageDone[MAX_BATCHED_BARRIERS] = {};
+	uint32_t remaining = pBatch->mBufferBarrierCount + pBatch->mImageBarrierCount;
+
+	while (remaining)
+	{
+		// Stage masks of the first barrier not yet recorded, gather every barrier with the same masks
+		VkPipelineStageFlags srcStageMask = 0;
+		VkPipelineStageFlags dstStageMask = 0;
+		for (uint32_t i = 0; i < pBatch->mBufferBarrierCount && !srcStageMask; ++i)
+		{
+			if (!bufferDone[i])
+			{
+				srcStageMask = pBatch->mBufferSrcStages[i];
+				dstStageMask = pBatch->mBufferDstStages[i];
+			}
+		}
+		for (uint32_t i = 0; i < pBatch->mImageBarrierCount && !srcStageMask; ++i)
+		{
+			if (!imageDone[i])
+			{
+				srcStageMask = pBatch->mImageSrcStages[i];
+				dstStageMask = pBatch->mImageDstStages[i];
+			}
+		}
+
+		uint32_t bufferBarrierCount = 0;
+		for (uint32_t i = 0; i < pBatch->mBufferBarrierCount; ++i)
+		{
+			if (!bufferDone[i] && pBatch->mBufferSrcStages[i] == srcStageMask && pBatch->mBufferDstStages[i] == dstStageMask)
+			{
+				bufferBarriers[bufferBarrierCount++] = pBatch->mBufferBarriers[i];
+				bufferDone[i] = true;
+			}
+		}
+		uint32_t imageBarrierCount = 0;
+		for (uint32_t i = 0; i < pBatch->mImageBarrierCount; ++i)
+		{
+			if (!imageDone[i] && pBatch->mImageSrcStages[i] == srcStageMask && pBatch->mImageDstStages[i] == dstStageMask)
+			{
+				imageBarriers[imageBarrierCount++] = pBatch->mImageBarriers[i];
+				imageDone[i] = true;
+			}
+		}
+
+		vkCmdPipelineBarrier(
+			pCmd->pVkCmdBuf, srcStageMask, dstStageMask, 0, 0, NULL, bufferBarrierCount, bufferBarriers, imageBarrierCount, imageBarriers);
+		remaining -= bufferBarrierCount + imageBarrierCount;
+	}
+
+	pBatch->mBufferBarrierCount = 0;
+	pBatch->mImageBarrierCount = 0;
+}
+
+static void util_batch_buffer_barrier(Cmd* pCmd, const VkBufferMemoryBarrier* pBarrier)
+{
+	CmdBarrierBatch* pBatch = pCmd->pBarrierBatch;
+	const bool ownershipTransfer = util_is_ownership_transfer(pBarrier->srcQueueFamilyIndex, pBarrier->dstQueueFamilyIndex);
+
+	// A read only state transitioning to itself has nothing to wait for
+	if (!ownershipTransfer && pBarrier->srcAccessMask == pBarrier->dstAccessMask && !util_has_write_access(pBarrier->srcAccessMask))
+		return;
+
+	for (uint32_t i = pBatch->mBufferBarrierCount; i-- > 0;)
+	{
+		VkBufferMemoryBarrier* pPending = &pBatch->mBufferBarriers[i];
+		if (pPending->buffer != pBarrier->buffer)
+			continue;
+
+		if (util_same_barrier(*pPending, *pBarrier))
+			return;
+
+		if (!ownershipTransfer && !util_is_ownership_transfer(pPending->srcQueueFamilyIndex, pPending->dstQueueFamilyIndex) &&
+			pPending->dstAccessMask == pBarrier->srcAccessMask)
+		{
+			pPending->dstAccessMask = pBarrier->dstAccessMask;
+			pBatch->mBufferDstStages[i] = util_determine_pipeline_stage_flags(pCmd->pRenderer, pPending->dstAccessMask, (QueueType)pCmd->mType);
+			if (pPending->srcAccessMask == pPending->dstAccessMask && !util_has_write_access(pPending->srcAccessMask))
+			{
+				memmove(pPending, pPending + 1, (pBatch->mBufferBarrierCount - i - 1) * sizeof(*pPending));
+				memmove(&pBatch->mBufferSrcStages[i], &pBatch->mBufferSrcStages[i + 1], (pBatch->mBufferBarrierCount - i - 1) * sizeof(VkPipelineStageFlags));
+				memmove(&pBatch->mBufferDstStages[i], &pBatch->mBufferDstStages[i + 1], (pBatch->mBufferBarrierCount - i - 1) * sizeof(VkPipelineStageFlags));
+				--pBatch->mBufferBarrierCount;
+			}
+			return;
+		}
+
+		// Can't be folded, keep both transitions in order
+		util_flush_barriers(pCmd);
+		break;
+	}
+
+	if (MAX_BATCHED_BARRIERS == pBatch->mBufferBarrierCount)
+		util_flush_barriers(pCmd);
+
+	const uint32_t index = pBatch->mBufferBarrierCount++;
+	pBatch->mBufferBarriers[index] = *pBarrier;
+	pBatch->mBufferSrcStages[index] = util_determine_pipeline_stage_flags(pCmd->pRenderer, pBarrier->srcAccessMask, (QueueType)pCmd->mType);
+	pBatch->mBufferDstStages[index] = util_determine_pipeline_stage_flags(pCmd->pRenderer, pBarrier->dstAccessMask, (QueueType)pCmd->mType);
+}
+
+static void util_batch_image_barrier(Cmd* pCmd, const VkImageMemoryBarrier* pBarrier)
+{
+	CmdBarrierBatch* pBatch = pCmd->pBarrierBatch;
+	const bool ownershipTransfer = util_is_ownership_transfer(pBarrier->srcQueueFamilyIndex, pBarrier->dstQueueFamilyIndex);
+
+	if (!ownershipTransfer && pBarrier->oldLayout == pBarrier->newLayout && pBarrier->srcAccessMask == pBarrier->dstAccessMask &&
+		!util_has_write_access(pBarrier->srcAccessMask))
+		return;
+
+	for (uint32_t i = pBatch->mImageBarrierCount; i-- > 0;)
+	{
+		VkImageMemoryBarrier* pPending = &pBatch->mImageBarriers[i];
+		// Other mips or layers of the image (per subresource barrier arrays) go into the same vkCmdPipelineBarrier
+		if (pPending->image != pBarrier->image || !util_subresource_ranges_overlap(pPending->subresourceRange, pBarrier->subresourceRange))
+			continue;
+
+		if (util_same_barrier(*pPending, *pBarrier))
+			return;
+
+		if (!ownershipTransfer && !util_is_ownership_transfer(pPending->srcQueueFamilyIndex, pPending->dstQueueFamilyIndex) &&
+			util_same_subresource_range(pPending->subresourceRange, pBarrier->subresourceRange) &&
+			pPending->newLayout == pBarrier->oldLayout && pPending->dstAccessMask == pBarrier->srcAccessMask)
+		{
+			pPending->newLayout = pBarrier->newLayout;
+			pPending->dstAccessMask = pBarrier->dstAccessMask;
+			pBatch->mImageDstStages[i] = util_determine_pipeline_stage_flags(pCmd->pRenderer, pPending->dstAccessMask, (QueueType)pCmd->mType);
+			if (pPending->oldLayout == pPending->newLayout && pPending->srcAccessMask == pPending->dstAccessMask &&
+				!util_has_write_access(pPending->srcAccessMask))
+			{
+				memmove(pPending, pPending + 1, (pBatch->mImageBarrierCount - i - 1) * sizeof(*pPending));
+				memmove(&pBatch->mImageSrcStages[i], &pBatch->mImageSrcStages[i + 1], (pBatch->mImageBarrierCount - i - 1) * sizeof(VkPipelineStageFlags));
+				memmove(&pBatch->mImageDstStages[i], &pBatch->mImageDstStages[i + 1], (pBatch->mImageBarrierCount - i - 1) * sizeof(VkPipelineStageFlags));
+				--pBatch->mImageBarrierCount;
+			}
+			return;
+		}
+
+		// Overlapping transitions of the same image can't share a vkCmdPipelineBarrier, their layout changes would be unordered
+		util_flush_barriers(pCmd);
+		break;
+	}
+
+	if (MAX_BATCHED_BARRIERS == pBatch->mImageBarrierCount)
+		util_flush_barriers(pCmd);
+
+	const uint32_t index = pBatch->mImageBarrierCount++;
+	pBatch->mImageBarriers[index] = *pBarrier;
+	pBatch->mImageSrcStages[index] = util_determine_pipeline_stage_flags(pCmd->pRenderer, pBarrier->srcAccessMask, (QueueType)pCmd->mType);
+	pBatch->mImageDstStages[index] = util_determine_pipeline_stage_flags(pCmd->pRenderer, pBarrier->dstAccessMask, (QueueType)pCmd->mType);
+}
+
 VkImageAspectFlags util_vk_determine_aspect_mask(VkFormat format, bool includeStencilBit)
 {
 	VkImageAspectFlags result = 0;
@@ -2374,6 +2724,8 @@ static bool AddDevice(const RendererDesc* pDesc, Renderer* pRenderer)
 
 		//TODO: Fix once vulkan adds support for revision ID
 		strncpy(gpuSettings[i].mGpuVendorPreset.mRevisionId, "0x00", MAX_GPU_VENDOR_STRING_LENGTH);
+		// Packing is vendor specific, keep the raw value
+		sprintf(gpuSettings[i].mGpuVendorPreset.mGpuDriverVersion, "%#x", gpuProperties[i].properties.driverVersion);
 		gpuSettings[i].mGpuVendorPreset.mPresetLevel = getGPUPresetLevel(
 			gpuSettings[i].mGpuVendorPreset.mVendorId, gpuSettings[i].mGpuVendorPreset.mModelId,
 			gpuSettings[i].mGpuVendorPreset.mRevisionId);
@@ -2538,6 +2890,12 @@ static bool AddDevice(const RendererDesc* pDesc, Renderer* pRenderer)
 							gYCbCrExtension = true;
 						}
 #endif
+#ifdef VK_EXT_MEMORY_BUDGET_EXTENSION_NAME
+						if (strcmp(wantedDeviceExtensions[k], VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+						{
+							gMemoryBudgetExtension = true;
+						}
+#endif
 #ifdef USE_NSIGHT_AFTERMATH
 						if (strcmp(wantedDeviceExtensions[k], VK_NV_DEVICE_DIAGNOSTIC_CHECKPOINTS_EXTENSION_NAME) == 0)
 						{
@@ -2770,6 +3128,8 @@ uint64_t get_vk_device_memory_offset(Renderer* pRenderer, Buffer* pBuffer)
 /************************************************************************/
 void initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppRenderer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(appName);
 	ASSERT(pDesc);
 	ASSERT(ppRenderer);
@@ -2900,10 +3260,22 @@ void initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppR
 		vulkanFunctions.vkFlushMappedMemoryRanges = vkFlushMappedMemoryRanges;
 		vulkanFunctions.vkInvalidateMappedMemoryRanges = vkInvalidateMappedMemoryRanges;
 		vulkanFunctions.vkCmdCopyBuffer = vkCmdCopyBuffer;
+#if VMA_MEMORY_BUDGET
+		// Without the extension VMA estimates the budget as 80% of the heap sizes
+		if (gMemoryBudgetExtension && vkGetPhysicalDeviceMemoryProperties2KHR)
+		{
+			vulkanFunctions.vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2KHR;
+			createInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+			LOGF(LogLevel::eINFO, "Successfully loaded Memory Budget extension");
+		}
+#endif
 
 		createInfo.pVulkanFunctions = &vulkanFunctions;
 		createInfo.pAllocationCallbacks = &gVkAllocationCallbacks;
 		vmaCreateAllocator(&createInfo, &pRenderer->pVmaAllocator);
+
+		pRenderer->pMovableBuffers = tf_new(MovableBufferRegistry);
+		pRenderer->pMovableBuffers->mMutex.Init();
 	}
 
 	VkDescriptorPoolSize descriptorPoolSizes[FORGE_DESCRIPTOR_TYPE_RANGE_SIZE] =
@@ -2980,6 +3352,8 @@ void removeRenderer(Renderer* pRenderer)
 		for (FrameBufferMapNode& it : t.second)
 			remove_framebuffer(pRenderer, it.second);
 
+	remove_movable_buffer_registry(pRenderer);
+
 	// Destroy the Vulkan bits
 	vmaDestroyAllocator(pRenderer->pVmaAllocator);
 
@@ -3184,6 +3558,8 @@ void addCmd(Renderer* pRenderer, const CmdDesc* pDesc, Cmd** ppCmd)
 	alloc_info.commandBufferCount = 1;
 	CHECK_VKRESULT(vkAllocateCommandBuffers(pRenderer->pVkDevice, &alloc_info, &(pCmd->pVkCmdBuf)));
 
+	pCmd->pBarrierBatch = (CmdBarrierBatch*)tf_calloc(1, sizeof(CmdBarrierBatch));
+
 	*ppCmd = pCmd;
 }
 
@@ -3196,6 +3572,7 @@ void removeCmd(Renderer* pRenderer, Cmd* pCmd)
 
 	vkFreeCommandBuffers(pRenderer->pVkDevice, pCmd->pCmdPool->pVkCmdPool, 1, &(pCmd->pVkCmdBuf));
 
+	SAFE_FREE(pCmd->pBarrierBatch);
 	SAFE_FREE(pCmd);
 }
 
@@ -3253,6 +3630,8 @@ void toggleVSync(Renderer* pRenderer, SwapChain** ppSwapChain)
 
 void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppSwapChain);
@@ -3631,6 +4010,8 @@ void removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain)
 
 void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(pDesc->mSize > 0);
@@ -3770,6 +4151,24 @@ void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
 	pBuffer->mNodeIndex = pDesc->mNodeIndex;
 	pBuffer->mDescriptors = pDesc->mDescriptors;
 
+	if (pDesc->mFlags & BUFFER_CREATION_FLAG_MOVABLE_BIT)
+	{
+		// Texel views and device group bindings would have to be recreated with the buffer, dedicated memory never moves
+		const VkBufferUsageFlags texelUsage = VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+		if (RESOURCE_MEMORY_USAGE_GPU_ONLY != pDesc->mMemoryUsage || (pDesc->mFlags & BUFFER_CREATION_FLAG_OWN_MEMORY_BIT) ||
+			(add_info.usage & texelUsage) || linkedMultiGpu)
+		{
+			LOGF(LogLevel::eWARNING, "Buffer %s can't be movable, only GPU only buffers without texel views or own memory can",
+				 pDesc->pName ? pDesc->pName : "");
+		}
+		else
+		{
+			MovableBuffer movable = { pBuffer, add_info.size, add_info.usage };
+			MutexLock lock(pRenderer->pMovableBuffers->mMutex);
+			pRenderer->pMovableBuffers->mBuffers[pBuffer] = movable;
+		}
+	}
+
 	*ppBuffer = pBuffer;
 }
 
@@ -3791,6 +4190,11 @@ void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
 		pBuffer->pVkStorageTexelView = VK_NULL_HANDLE;
 	}
 
+	{
+		MutexLock lock(pRenderer->pMovableBuffers->mMutex);
+		pRenderer->pMovableBuffers->mBuffers.erase(pBuffer);
+	}
+
 	vmaDestroyBuffer(pRenderer->pVmaAllocator, pBuffer->pVkBuffer, pBuffer->pVkAllocation);
 
 	SAFE_FREE(pBuffer);
@@ -3798,6 +4202,8 @@ void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
 
 void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
 	if (pDesc->mSampleCount > SAMPLE_COUNT_1 && pDesc->mMipLevels > 1)
@@ -4193,6 +4599,8 @@ void removeTexture(Renderer* pRenderer, Texture* pTexture)
 
 void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppRenderTarget);
@@ -4465,15 +4873,10 @@ void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
 /************************************************************************/
 // Descriptor Set Functions
 /************************************************************************/
-void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
+static uint32_t util_get_descriptor_set_size(const DescriptorSetDesc* pDesc)
 {
-	ASSERT(pRenderer);
-	ASSERT(pDesc);
-	ASSERT(ppDescriptorSet);
-
 	const RootSignature* pRootSignature = pDesc->pRootSignature;
 	const DescriptorUpdateFrequency updateFreq = pDesc->mUpdateFrequency;
-	const uint32_t nodeIndex = pDesc->mNodeIndex;
 	const uint32_t descriptorCount = pRootSignature->mVkCumulativeDescriptorCounts[updateFreq];
 	const uint32_t dynamicOffsetCount = pRootSignature->mVkDynamicDescriptorCounts[updateFreq];
 
@@ -4490,43 +4893,50 @@ void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, Descr
 		totalSize += pDesc->mMaxSets * sizeof(SizeOffset);
 	}
 
-	DescriptorSet* pDescriptorSet = (DescriptorSet*)tf_calloc_memalign(1, alignof(DescriptorSet), totalSize);
+	return totalSize;
+}
+
+// Lays out the descriptor set in pMemory (zeroed, util_get_descriptor_set_size bytes) and fills the layouts and handle pointers to allocate.
+// Returns false if the root signature has no layout for this update frequency
+static bool util_init_descriptor_set(
+	void* pMemory, const DescriptorSetDesc* pDesc, VkDescriptorSetLayout* pLayouts, VkDescriptorSet** pHandles, DescriptorSet** ppDescriptorSet)
+{
+	const RootSignature* pRootSignature = pDesc->pRootSignature;
+	const DescriptorUpdateFrequency updateFreq = pDesc->mUpdateFrequency;
+	const uint32_t descriptorCount = pRootSignature->mVkCumulativeDescriptorCounts[updateFreq];
+
+	DescriptorSet* pDescriptorSet = (DescriptorSet*)pMemory;
+	*ppDescriptorSet = pDescriptorSet;
 
 	pDescriptorSet->pRootSignature = pRootSignature;
 	pDescriptorSet->mUpdateFrequency = updateFreq;
-	pDescriptorSet->mDynamicOffsetCount = dynamicOffsetCount;
-	pDescriptorSet->mNodeIndex = nodeIndex;
+	pDescriptorSet->mDynamicOffsetCount = pRootSignature->mVkDynamicDescriptorCounts[updateFreq];
+	pDescriptorSet->mNodeIndex = pDesc->mNodeIndex;
 	pDescriptorSet->mMaxSets = pDesc->mMaxSets;
 
 	uint8_t* pMem = (uint8_t*)(pDescriptorSet + 1);
 	pDescriptorSet->pHandles = (VkDescriptorSet*)pMem;
 
-	if (VK_NULL_HANDLE != pRootSignature->mVkDescriptorSetLayouts[updateFreq])
+	if (VK_NULL_HANDLE == pRootSignature->mVkDescriptorSetLayouts[updateFreq])
 	{
-		pMem += pDesc->mMaxSets * sizeof(VkDescriptorSet);
-
-		pDescriptorSet->ppUpdateData = (DescriptorUpdateData**)pMem;
-		pMem += pDesc->mMaxSets * sizeof(DescriptorUpdateData*);
-
-		VkDescriptorSetLayout* pLayouts = (VkDescriptorSetLayout*)alloca(pDesc->mMaxSets * sizeof(VkDescriptorSetLayout));
-		VkDescriptorSet** pHandles = (VkDescriptorSet**)alloca(pDesc->mMaxSets * sizeof(VkDescriptorSet*));
+		LOGF(LogLevel::eERROR, "NULL Descriptor Set Layout for update frequency %u. Cannot allocate descriptor set", (uint32_t)updateFreq);
+		ASSERT(false && "NULL Descriptor Set Layout for update frequency. Cannot allocate descriptor set");
+		return false;
+	}
 
-		for (uint32_t i = 0; i < pDesc->mMaxSets; ++i)
-		{
-			pLayouts[i] = pRootSignature->mVkDescriptorSetLayouts[updateFreq];
-			pHandles[i] = &pDescriptorSet->pHandles[i];
+	pMem += pDesc->mMaxSets * sizeof(VkDescriptorSet);
 
-			pDescriptorSet->ppUpdateData[i] = (DescriptorUpdateData*)pMem;
-			pMem += descriptorCount * sizeof(DescriptorUpdateData);
-			memcpy(pDescriptorSet->ppUpdateData[i], pRootSignature->pUpdateTemplateData[updateFreq][pDescriptorSet->mNodeIndex], descriptorCount * sizeof(DescriptorUpdateData));
-		}
+	pDescriptorSet->ppUpdateData = (DescriptorUpdateData**)pMem;
+	pMem += pDesc->mMaxSets * sizeof(DescriptorUpdateData*);
 
-		consume_descriptor_sets(pRenderer->pDescriptorPool, pLayouts, pHandles, pDesc->mMaxSets);
-	}
-	else
+	for (uint32_t i = 0; i < pDesc->mMaxSets; ++i)
 	{
-		LOGF(LogLevel::eERROR, "NULL Descriptor Set Layout for update frequency %u. Cannot allocate descriptor set", (uint32_t)updateFreq);
-		ASSERT(false && "NULL Descriptor Set Layout for update frequency. Cannot allocate descriptor set");
+		pLayouts[i] = pRootSignature->mVkDescriptorSetLayouts[updateFreq];
+		pHandles[i] = &pDescriptorSet->pHandles[i];
+
+		pDescriptorSet->ppUpdateData[i] = (DescriptorUpdateData*)pMem;
+		pMem += descriptorCount * sizeof(DescriptorUpdateData);
+		memcpy(pDescriptorSet->ppUpdateData[i], pRootSignature->pUpdateTemplateData[updateFreq][pDescriptorSet->mNodeIndex], descriptorCount * sizeof(DescriptorUpdateData));
 	}
 
 	if (pDescriptorSet->mDynamicOffsetCount)
@@ -4536,6 +4946,29 @@ void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, Descr
 		pMem += pDescriptorSet->mMaxSets * sizeof(SizeOffset);
 	}
 
+	return true;
+}
+
+void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
+{
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppDescriptorSet);
+
+	const uint32_t totalSize = util_get_descriptor_set_size(pDesc);
+	void* pMemory = tf_calloc_memalign(1, alignof(DescriptorSet), totalSize);
+
+	VkDescriptorSetLayout* pLayouts = (VkDescriptorSetLayout*)alloca(pDesc->mMaxSets * sizeof(VkDescriptorSetLayout));
+	VkDescriptorSet** pHandles = (VkDescriptorSet**)alloca(pDesc->mMaxSets * sizeof(VkDescriptorSet*));
+
+	DescriptorSet* pDescriptorSet = NULL;
+	if (util_init_descriptor_set(pMemory, pDesc, pLayouts, pHandles, &pDescriptorSet))
+	{
+		consume_descriptor_sets(pRenderer->pDescriptorPool, pLayouts, pHandles, pDesc->mMaxSets);
+	}
+
 	*ppDescriptorSet = pDescriptorSet;
 }
 
@@ -4547,6 +4980,108 @@ void removeDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet)
 	SAFE_FREE(pDescriptorSet);
 }
 
+void addDescriptorSetAllocator(Renderer* pRenderer, const DescriptorSetAllocatorDesc* pDesc, DescriptorSetAllocator** ppAllocator)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppAllocator);
+	ASSERT(pDesc->mThreadCount && pDesc->mFrameCount);
+
+	DescriptorSetAllocator* pAllocator = (DescriptorSetAllocator*)tf_calloc(1, sizeof(DescriptorSetAllocator));
+	pAllocator->mThreadCount = pDesc->mThreadCount;
+	pAllocator->mFrameCount = pDesc->mFrameCount;
+	pAllocator->mSetsPerPool = pDesc->mSetsPerPool ? pDesc->mSetsPerPool : DESCRIPTOR_SET_ALLOCATOR_DEFAULT_SETS_PER_POOL;
+
+	// Same mix of descriptor types as the renderer pool, scaled down to mSetsPerPool sets
+	const DescriptorPool* pRendererPool = pRenderer->pDescriptorPool;
+	pAllocator->mPoolSizeCount = pRendererPool->mPoolSizeCount;
+	pAllocator->pPoolSizes = (VkDescriptorPoolSize*)tf_calloc(pAllocator->mPoolSizeCount, sizeof(VkDescriptorPoolSize));
+	for (uint32_t i = 0; i < pAllocator->mPoolSizeCount; ++i)
+	{
+		const uint64_t count = (uint64_t)pRendererPool->pPoolSizes[i].descriptorCount * pAllocator->mSetsPerPool;
+		pAllocator->pPoolSizes[i].type = pRendererPool->pPoolSizes[i].type;
+		pAllocator->pPoolSizes[i].descriptorCount = max(1U, (uint32_t)((count + pRendererPool->mNumDescriptorSets - 1) / pRendererPool->mNumDescriptorSets));
+	}
+
+	const uint32_t slotCount = pAllocator->mThreadCount * pAllocator->mFrameCount;
+	pAllocator->pSlots = (DescriptorSetAllocatorSlot*)tf_memalign(alignof(DescriptorSetAllocatorSlot), slotCount * sizeof(DescriptorSetAllocatorSlot));
+	for (uint32_t i = 0; i < slotCount; ++i)
+	{
+		DescriptorSetAllocatorSlot* pSlot = tf_placement_new<DescriptorSetAllocatorSlot>(&pAllocator->pSlots[i]);
+		initLinearAllocator(&pSlot->mArena, DESCRIPTOR_SET_ALLOCATOR_ARENA_BLOCK_SIZE);
+		pSlot->mCurrentPool = 0;
+	}
+
+	*ppAllocator = pAllocator;
+}
+
+void removeDescriptorSetAllocator(Renderer* pRenderer, DescriptorSetAllocator* pAllocator)
+{
+	ASSERT(pRenderer);
+	ASSERT(pAllocator);
+
+	const uint32_t slotCount = pAllocator->mThreadCount * pAllocator->mFrameCount;
+	for (uint32_t i = 0; i < slotCount; ++i)
+	{
+		DescriptorSetAllocatorSlot* pSlot = &pAllocator->pSlots[i];
+		for (uint32_t p = 0; p < (uint32_t)pSlot->mPools.size(); ++p)
+			vkDestroyDescriptorPool(pRenderer->pVkDevice, pSlot->mPools[p], &gVkAllocationCallbacks);
+		exitLinearAllocator(&pSlot->mArena);
+		pSlot->~DescriptorSetAllocatorSlot();
+	}
+
+	tf_free(pAllocator->pSlots);
+	SAFE_FREE(pAllocator->pPoolSizes);
+	SAFE_FREE(pAllocator);
+}
+
+void resetDescriptorSetAllocator(Renderer* pRenderer, DescriptorSetAllocator* pAllocator, uint32_t frameIndex)
+{
+	ASSERT(pRenderer);
+	ASSERT(pAllocator);
+	ASSERT(frameIndex < pAllocator->mFrameCount);
+
+	for (uint32_t t = 0; t < pAllocator->mThreadCount; ++t)
+	{
+		DescriptorSetAllocatorSlot* pSlot = &pAllocator->pSlots[frameIndex * pAllocator->mThreadCount + t];
+		// Pools past mCurrentPool were not used this time around and are already empty
+		const uint32_t usedPoolCount = min(pSlot->mCurrentPool + 1, (uint32_t)pSlot->mPools.size());
+		for (uint32_t p = 0; p < usedPoolCount; ++p)
+			CHECK_VKRESULT(vkResetDescriptorPool(pRenderer->pVkDevice, pSlot->mPools[p], 0));
+		pSlot->mCurrentPool = 0;
+		resetLinearAllocator(&pSlot->mArena);
+	}
+}
+
+void addTransientDescriptorSet(
+	Renderer* pRenderer, DescriptorSetAllocator* pAllocator, uint32_t threadIndex, uint32_t frameIndex, const DescriptorSetDesc* pDesc,
+	DescriptorSet** ppDescriptorSet)
+{
+	ASSERT(pRenderer);
+	ASSERT(pAllocator);
+	ASSERT(pDesc);
+	ASSERT(ppDescriptorSet);
+	ASSERT(threadIndex < pAllocator->mThreadCount);
+	ASSERT(frameIndex < pAllocator->mFrameCount);
+
+	DescriptorSetAllocatorSlot* pSlot = &pAllocator->pSlots[frameIndex * pAllocator->mThreadCount + threadIndex];
+
+	const uint32_t totalSize = util_get_descriptor_set_size(pDesc);
+	void* pMemory = linearAlloc(&pSlot->mArena, totalSize, alignof(DescriptorSet));
+	memset(pMemory, 0, totalSize);
+
+	VkDescriptorSetLayout* pLayouts = (VkDescriptorSetLayout*)alloca(pDesc->mMaxSets * sizeof(VkDescriptorSetLayout));
+	VkDescriptorSet** pHandles = (VkDescriptorSet**)alloca(pDesc->mMaxSets * sizeof(VkDescriptorSet*));
+
+	DescriptorSet* pDescriptorSet = NULL;
+	if (util_init_descriptor_set(pMemory, pDesc, pLayouts, pHandles, &pDescriptorSet))
+	{
+		consume_transient_descriptor_sets(pRenderer, pAllocator, pSlot, pLayouts, pHandles, pDesc->mMaxSets);
+	}
+
+	*ppDescriptorSet = pDescriptorSet;
+}
+
 void updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDescriptorSet, uint32_t count, const DescriptorData* pParams)
 {
 #if defined(ENABLE_GRAPHICS_DEBUG)
@@ -4934,6 +5469,8 @@ void cmdBindPushConstantsByIndex(Cmd* pCmd, RootSignature* pRootSignature, uint3
 /************************************************************************/
 void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pDesc);
 	ASSERT(ppShaderProgram);
@@ -5141,6 +5678,8 @@ typedef struct UpdateFrequencyLayoutInfo
 
 void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatureDesc, RootSignature** ppRootSignature)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	ASSERT(pRenderer);
 	ASSERT(pRootSignatureDesc);
 	ASSERT(ppRootSignature);
@@ -5914,6 +6453,8 @@ static void addComputePipeline(Renderer* pRenderer, const PipelineDesc* pMainDes
 
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_RENDERER);
+
 	switch (pDesc->mType)
 	{
 		case(PIPELINE_TYPE_COMPUTE):
@@ -6041,6 +6582,8 @@ void beginCmd(Cmd* pCmd)
 
 	// Reset CPU side data
 	pCmd->pBoundPipelineLayout = NULL;
+	pCmd->pBarrierBatch->mBufferBarrierCount = 0;
+	pCmd->pBarrierBatch->mImageBarrierCount = 0;
 }
 
 void endCmd(Cmd* pCmd)
@@ -6055,6 +6598,8 @@ void endCmd(Cmd* pCmd)
 
 	pCmd->pVkActiveRenderPass = VK_NULL_HANDLE;
 
+	util_flush_barriers(pCmd);
+
 	VkResult vk_res = vkEndCommandBuffer(pCmd->pVkCmdBuf);
 	ASSERT(VK_SUCCESS == vk_res);
 }
@@ -6234,6 +6779,7 @@ void cmdBindRenderTargets(
 	begin_info.clearValueCount = clearValueCount;
 	begin_info.pClearValues = clearValues;
 
+	util_flush_barriers(pCmd);
 	vkCmdBeginRenderPass(pCmd->pVkCmdBuf, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
 	pCmd->pVkActiveRenderPass = pRenderPass->pRenderPass;
 }
@@ -6326,6 +6872,7 @@ void cmdDraw(Cmd* pCmd, uint32_t vertex_count, uint32_t first_vertex)
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
 
+	util_flush_barriers(pCmd);
 	vkCmdDraw(pCmd->pVkCmdBuf, vertex_count, 1, first_vertex, 0);
 }
 
@@ -6334,6 +6881,7 @@ void cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex, uin
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
 
+	util_flush_barriers(pCmd);
 	vkCmdDraw(pCmd->pVkCmdBuf, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
@@ -6342,6 +6890,7 @@ void cmdDrawIndexed(Cmd* pCmd, uint32_t index_count, uint32_t first_index, uint3
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
 
+	util_flush_barriers(pCmd);
 	vkCmdDrawIndexed(pCmd->pVkCmdBuf, index_count, 1, first_index, first_vertex, 0);
 }
 
@@ -6351,6 +6900,7 @@ void cmdDrawIndexedInstanced(
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
 
+	util_flush_barriers(pCmd);
 	vkCmdDrawIndexed(pCmd->pVkCmdBuf, indexCount, instanceCount, firstIndex, firstVertex, firstInstance);
 }
 
@@ -6359,6 +6909,7 @@ void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t
 	ASSERT(pCmd);
 	ASSERT(pCmd->pVkCmdBuf != VK_NULL_HANDLE);
 
+	util_flush_barriers(pCmd);
 	vkCmdDispatch(pCmd->pVkCmdBuf, groupCountX, groupCountY, groupCountZ);
 }
 
@@ -6375,9 +6926,6 @@ void cmdResourceBarrier(Cmd* pCmd,
 		numBufferBarriers ? (VkBufferMemoryBarrier*)alloca(numBufferBarriers * sizeof(VkBufferMemoryBarrier)) : NULL;
 	uint32_t bufferBarrierCount = 0;
 
-	VkAccessFlags srcAccessFlags = 0;
-	VkAccessFlags dstAccessFlags = 0;
-
 	for (uint32_t i = 0; i < numBufferBarriers; ++i)
 	{
 		BufferBarrier* pTrans = &pBufferBarriers[i];
@@ -6425,9 +6973,6 @@ void cmdResourceBarrier(Cmd* pCmd,
 				pBufferBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 				pBufferBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			}
-
-			srcAccessFlags |= pBufferBarrier->srcAccessMask;
-			dstAccessFlags |= pBufferBarrier->dstAccessMask;
 		}
 	}
 
@@ -6485,9 +7030,6 @@ void cmdResourceBarrier(Cmd* pCmd,
 				pImageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 				pImageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			}
-
-			srcAccessFlags |= pImageBarrier->srcAccessMask;
-			dstAccessFlags |= pImageBarrier->dstAccessMask;
 		}
 	}
 
@@ -6545,21 +7087,14 @@ void cmdResourceBarrier(Cmd* pCmd,
 				pImageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 				pImageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			}
-
-			srcAccessFlags |= pImageBarrier->srcAccessMask;
-			dstAccessFlags |= pImageBarrier->dstAccessMask;
 		}
 	}
 
-	VkPipelineStageFlags srcStageMask = util_determine_pipeline_stage_flags(pCmd->pRenderer, srcAccessFlags, (QueueType)pCmd->mType);
-	VkPipelineStageFlags dstStageMask = util_determine_pipeline_stage_flags(pCmd->pRenderer, dstAccessFlags, (QueueType)pCmd->mType);
-
-	if (bufferBarrierCount || imageBarrierCount)
-	{
-		vkCmdPipelineBarrier(
-			pCmd->pVkCmdBuf, srcStageMask, dstStageMask, 0, 0, NULL, bufferBarrierCount, bufferBarriers, imageBarrierCount,
-			imageBarriers);
-	}
+	// Recorded by the next command that depends on them, see util_flush_barriers
+	for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+		util_batch_buffer_barrier(pCmd, &bufferBarriers[i]);
+	for (uint32_t i = 0; i < imageBarrierCount; ++i)
+		util_batch_image_barrier(pCmd, &imageBarriers[i]);
 }
 
 void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size)
@@ -6576,6 +7111,7 @@ void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSr
 	region.srcOffset = srcOffset;
 	region.dstOffset = dstOffset;
 	region.size = (VkDeviceSize)size;
+	util_flush_barriers(pCmd);
 	vkCmdCopyBuffer(pCmd->pVkCmdBuf, pSrcBuffer->pVkBuffer, pBuffer->pVkBuffer, 1, &region);
 }
 
@@ -6584,12 +7120,18 @@ typedef struct SubresourceDataDesc
 	uint64_t mSrcOffset;
 	uint32_t mMipLevel;
 	uint32_t mArrayLayer;
+	uint32_t mRowOffset;
+	uint32_t mRowCount;
+	uint32_t mDepthOffset;
+	uint32_t mDepthCount;
 	uint32_t mRowPitch;
 	uint32_t mSlicePitch;
 } SubresourceDataDesc;
 
 void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pSubresourceDesc)
 {
+	util_flush_barriers(pCmd);
+
 	const TinyImageFormat fmt = (TinyImageFormat)pTexture->mFormat;
 	const bool isSinglePlane = TinyImageFormat_IsSinglePlane(fmt);
 
@@ -6600,6 +7142,9 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 		const uint32_t depth = max<uint32_t>(1, pTexture->mDepth >> pSubresourceDesc->mMipLevel);
 		const uint32_t numBlocksWide = pSubresourceDesc->mRowPitch / (TinyImageFormat_BitSizeOfBlock(fmt) >> 3);
 		const uint32_t numBlocksHigh = (pSubresourceDesc->mSlicePitch / pSubresourceDesc->mRowPitch);
+		// The source may only hold a range of block rows or depth slices of the subresource
+		const uint32_t rowOffset = pSubresourceDesc->mRowOffset * TinyImageFormat_HeightOfBlock(fmt);
+		const uint32_t rowEnd = min(height, (pSubresourceDesc->mRowOffset + pSubresourceDesc->mRowCount) * TinyImageFormat_HeightOfBlock(fmt));
 
 		VkBufferImageCopy copy = {};
 		copy.bufferOffset = pSubresourceDesc->mSrcOffset;
@@ -6610,11 +7155,11 @@ void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, cons
 		copy.imageSubresource.baseArrayLayer = pSubresourceDesc->mArrayLayer;
 		copy.imageSubresource.layerCount = 1;
 		copy.imageOffset.x = 0;
-		copy.imageOffset.y = 0;
-		copy.imageOffset.z = 0;
+		copy.imageOffset.y = rowOffset;
+		copy.imageOffset.z = pSubresourceDesc->mDepthOffset;
 		copy.imageExtent.width = width;
-		copy.imageExtent.height = height;
-		copy.imageExtent.depth = depth;
+		copy.imageExtent.height = rowEnd - rowOffset;
+		copy.imageExtent.depth = min(depth - pSubresourceDesc->mDepthOffset, pSubresourceDesc->mDepthCount);
 
 		vkCmdCopyBufferToImage(pCmd->pVkCmdBuf, pSrcBuffer->pVkBuffer, pTexture->pVkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
 	}
@@ -7008,6 +7553,8 @@ void cmdExecuteIndirect(
 	Cmd* pCmd, CommandSignature* pCommandSignature, uint maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset,
 	Buffer* pCounterBuffer, uint64_t counterBufferOffset)
 {
+	util_flush_barriers(pCmd);
+
 	if (pCommandSignature->mDrawType == INDIRECT_DRAW)
 	{
 #ifndef NX64
@@ -7097,6 +7644,7 @@ void removeQueryPool(Renderer* pRenderer, QueryPool* pQueryPool)
 
 void cmdResetQueryPool(Cmd* pCmd, QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount)
 {
+	util_flush_barriers(pCmd);
 	vkCmdResetQueryPool(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery, queryCount);
 }
 
@@ -7106,6 +7654,8 @@ void cmdBeginQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
 	switch (type)
 	{
 		case VK_QUERY_TYPE_TIMESTAMP:
+			// Pending barriers belong to the work before the timestamp
+			util_flush_barriers(pCmd);
 			vkCmdWriteTimestamp(pCmd->pVkCmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pQueryPool->pVkQueryPool, pQuery->mIndex);
 			break;
 		case VK_QUERY_TYPE_PIPELINE_STATISTICS: break;
@@ -7127,6 +7677,7 @@ void cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPool, Buffer* pReadbackBuffer,
 #else
 	flags |= VK_QUERY_RESULT_WAIT_BIT;
 #endif
+	util_flush_barriers(pCmd);
 	vkCmdCopyQueryPoolResults(
 		pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery, queryCount, pReadbackBuffer->pVkBuffer, 0, sizeof(uint64_t), flags);
 }
@@ -7144,6 +7695,141 @@ void calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* tota
 }
 
 void freeMemoryStats(Renderer* pRenderer, char* stats) { vmaFreeStatsString(pRenderer->pVmaAllocator, stats); }
+
+void getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget)
+{
+	ASSERT(pRenderer);
+	ASSERT(pBudget);
+
+	const VkPhysicalDeviceMemoryProperties* pMemoryProperties = NULL;
+	vmaGetMemoryProperties(pRenderer->pVmaAllocator, &pMemoryProperties);
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+	vmaGetBudget(pRenderer->pVmaAllocator, budgets);
+
+	*pBudget = {};
+	for (uint32_t i = 0; i < pMemoryProperties->memoryHeapCount; ++i)
+	{
+		if (pMemoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			pBudget->mUsage += budgets[i].usage;
+			pBudget->mBudget += budgets[i].budget;
+		}
+	}
+}
+
+// Blocking by design, the copies run on an idle queue and are waited for before the old VkBuffers are replaced. Meant for load
+// time, a per frame budgeted version would need the moved buffers to stay alive until the frames using them retired
+uint32_t defragmentMemory(Renderer* pRenderer, Queue* pQueue, uint64_t maxBytesToMove, uint32_t maxMovedBuffers, Buffer** ppMovedBuffers)
+{
+	ASSERT(pRenderer);
+	ASSERT(pQueue);
+	ASSERT(!maxMovedBuffers || ppMovedBuffers);
+
+	MovableBufferRegistry* pRegistry = pRenderer->pMovableBuffers;
+	MutexLock              lock(pRegistry->mMutex);
+	if (pRegistry->mBuffers.empty() || !maxBytesToMove || !maxMovedBuffers)
+		return 0;
+
+	if (pRegistry->pQueue != pQueue)
+	{
+		if (pRegistry->pCmd)
+		{
+			removeFence(pRenderer, pRegistry->pFence);
+			removeCmd(pRenderer, pRegistry->pCmd);
+			removeCmdPool(pRenderer, pRegistry->pCmdPool);
+		}
+		CmdPoolDesc cmdPoolDesc = {};
+		cmdPoolDesc.pQueue = pQueue;
+		cmdPoolDesc.mTransient = true;
+		addCmdPool(pRenderer, &cmdPoolDesc, &pRegistry->pCmdPool);
+		CmdDesc cmdDesc = {};
+		cmdDesc.pPool = pRegistry->pCmdPool;
+		addCmd(pRenderer, &cmdDesc, &pRegistry->pCmd);
+		addFence(pRenderer, &pRegistry->pFence);
+		pRegistry->pQueue = pQueue;
+	}
+
+	const uint32_t                  bufferCount = (uint32_t)pRegistry->mBuffers.size();
+	eastl::vector<MovableBuffer*>   buffers(bufferCount);
+	eastl::vector<VmaAllocation>    allocations(bufferCount);
+	eastl::vector<VkBool32>         allocationsChanged(bufferCount, VK_FALSE);
+	uint32_t                        index = 0;
+	for (eastl::hash_map<Buffer*, MovableBuffer>::iterator it = pRegistry->mBuffers.begin(); it != pRegistry->mBuffers.end(); ++it, ++index)
+	{
+		buffers[index] = &it->second;
+		allocations[index] = it->first->pVkAllocation;
+	}
+
+	// The buffers must not be in use while their memory moves
+	waitQueueIdle(pQueue);
+
+	Cmd* pCmd = pRegistry->pCmd;
+	resetCmdPool(pRenderer, pRegistry->pCmdPool);
+	beginCmd(pCmd);
+
+	// Make earlier writes visible to the copies, and the copies to everything after
+	VkMemoryBarrier memoryBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL };
+	memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(
+		pCmd->pVkCmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, NULL, 0, NULL);
+
+	VmaDefragmentationInfo2 defragInfo = {};
+	defragInfo.allocationCount = bufferCount;
+	defragInfo.pAllocations = allocations.data();
+	defragInfo.pAllocationsChanged = allocationsChanged.data();
+	defragInfo.maxGpuBytesToMove = maxBytesToMove;
+	defragInfo.maxGpuAllocationsToMove = maxMovedBuffers;
+	defragInfo.commandBuffer = pCmd->pVkCmdBuf;
+	VmaDefragmentationContext defragContext = VK_NULL_HANDLE;
+	VkResult                  result = vmaDefragmentationBegin(pRenderer->pVmaAllocator, &defragInfo, NULL, &defragContext);
+
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(
+		pCmd->pVkCmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, NULL, 0, NULL);
+	endCmd(pCmd);
+
+	if (VK_SUCCESS != result && VK_NOT_READY != result)
+	{
+		LOGF(LogLevel::eERROR, "vmaDefragmentationBegin failed (%d)", (int)result);
+		vmaDefragmentationEnd(pRenderer->pVmaAllocator, defragContext);
+		return 0;
+	}
+
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.mCmdCount = 1;
+	submitDesc.ppCmds = &pCmd;
+	submitDesc.pSignalFence = pRegistry->pFence;
+	queueSubmit(pQueue, &submitDesc);
+	waitForFences(pRenderer, 1, &pRegistry->pFence);
+	vmaDefragmentationEnd(pRenderer->pVmaAllocator, defragContext);
+
+	// The old VkBuffer is bound to memory that is no longer this allocation, bind a new one to where the data went
+	uint32_t movedCount = 0;
+	for (uint32_t i = 0; i < bufferCount && movedCount < maxMovedBuffers; ++i)
+	{
+		if (!allocationsChanged[i])
+			continue;
+
+		Buffer* pBuffer = buffers[i]->pBuffer;
+		vkDestroyBuffer(pRenderer->pVkDevice, pBuffer->pVkBuffer, &gVkAllocationCallbacks);
+
+		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, NULL };
+		bufferInfo.size = buffers[i]->mSize;
+		bufferInfo.usage = buffers[i]->mUsage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		CHECK_VKRESULT(vkCreateBuffer(pRenderer->pVkDevice, &bufferInfo, &gVkAllocationCallbacks, &pBuffer->pVkBuffer));
+		// Keeps the validation layers happy, VMA already knows the requirements
+		VkMemoryRequirements memoryRequirements;
+		vkGetBufferMemoryRequirements(pRenderer->pVkDevice, pBuffer->pVkBuffer, &memoryRequirements);
+		CHECK_VKRESULT(vmaBindBufferMemory(pRenderer->pVmaAllocator, pBuffer->pVkAllocation, pBuffer->pVkBuffer));
+
+		ppMovedBuffers[movedCount++] = pBuffer;
+	}
+
+	return movedCount;
+}
 /************************************************************************/
 // Debug Marker Implementation
 /************************************************************************/
@@ -7450,6 +8136,8 @@ void releasePage(Cmd* pCmd, Texture* pTexture)
 // Need to get visibility info first then fill them
 void fillVirtualTexture(Cmd* pCmd, Texture* pTexture, Fence* pFence)
 {
+	util_flush_barriers(pCmd);
+
 	Renderer* pRenderer = pCmd->pRenderer;
 
 	eastl::vector<VirtualTexturePage>* pPageTable = (eastl::vector<VirtualTexturePage>*)pTexture->pSvt->pPages;
@@ -7530,6 +8218,8 @@ void fillVirtualTexture(Cmd* pCmd, Texture* pTexture, Fence* pFence)
 // Fill specific mipLevel
 void fillVirtualTextureLevel(Cmd* pCmd, Texture* pTexture, uint32_t mipLevel)
 {
+	util_flush_barriers(pCmd);
+
 	Renderer* pRenderer = pCmd->pRenderer;
 
 	eastl::vector<VirtualTexturePage>* pPageTable = (eastl::vector<VirtualTexturePage>*)pTexture->pSvt->pPages;
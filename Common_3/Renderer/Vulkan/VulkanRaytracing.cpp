@@ -97,6 +97,7 @@ extern void removeBuffer(Renderer* pRenderer, Buffer* p_buffer);
 
 extern VkDeviceMemory get_vk_device_memory(Renderer* pRenderer, Buffer* pBuffer);
 extern VkDeviceSize get_vk_device_memory_offset(Renderer* pRenderer, Buffer* pBuffer);
+extern void util_flush_barriers(Cmd* pCmd);
 
 VkBuildAccelerationStructureFlagsNV util_to_vk_acceleration_structure_build_flags(AccelerationStructureBuildFlags flags);
 VkGeometryFlagsNV util_to_vk_geometry_flags(AccelerationStructureGeometryFlags flags);
@@ -459,6 +460,8 @@ void cmdBuildAccelerationStructure(Cmd* pCmd, Raytracing* pRaytracing, Raytracin
 	ASSERT(pDesc);
 	ASSERT(pDesc->ppAccelerationStructures);
 
+	util_flush_barriers(pCmd);
+
 	for (unsigned i = 0; i < pDesc->mBottomASIndicesCount; ++i)
 	{
 		uint32_t index = pDesc->pBottomASIndices[i];
@@ -596,6 +599,7 @@ void addRaytracingShaderTable(Raytracing* pRaytracing, const RaytracingShaderTab
 void cmdDispatchRays(Cmd* pCmd, Raytracing* pRaytracing, const RaytracingDispatchDesc* pDesc)
 {
 	RaytracingShaderTable* table = pDesc->pShaderTable;
+	util_flush_barriers(pCmd);
 	vkCmdTraceRaysNV(
 		pCmd->pVkCmdBuf,
 		table->pBuffer->pVkBuffer, 0,
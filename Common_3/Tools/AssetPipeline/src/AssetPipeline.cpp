@@ -55,6 +55,7 @@
 #include "../../../OS/Interfaces/IOperatingSystem.h"
 #include "../../../OS/Interfaces/IFileSystem.h"
 #include "../../../OS/Interfaces/ILog.h"
+#include "../../../OS/Core/ThreadSystem.h"
 
 #include "../../FileSystem/IToolFileSystem.h"
 
@@ -342,158 +343,191 @@ bool AssetPipeline::ProcessAnimations(ProcessAssetsSettings* settings)
 	return success;
 }
 
-static bool SaveSVT(const char* fileName, FileStream* pSrc, SVT_HEADER* pHeader)
+/************************************************************************/
+// SVT Building
+/************************************************************************/
+// Upper bound for the source and page staging of one band. Two bands are in flight (one being
+// extracted while the other is read/written), so peak memory is 4x this value regardless of texture size.
+static const uint64_t SVT_MAX_BAND_SIZE = 16 * 1024 * 1024;
+
+// A band is a horizontal run of pages inside one page row of a mip
+struct SVTBand
+{
+	uint64_t mMipOffset;     // Offset of the first texel of the mip in the source stream
+	uint64_t mRowPitch;      // Size of one full row of the mip in bytes
+	uint32_t mPageRow;
+	uint32_t mFirstPage;
+	uint32_t mPageCount;
+};
+
+struct SVTExtractTask
+{
+	const unsigned char* pSrc;
+	unsigned char*       pDst;
+	uint32_t             mPageRowSize;    // pageSize * texelSize
+	uint32_t             mPageSize;
+	uint32_t             mSrcPitch;       // Size of one source row of the band in bytes
+};
+
+static void extractSVTPage(void* pUser, uintptr_t pageIndex)
+{
+	const SVTExtractTask* pTask = (const SVTExtractTask*)pUser;
+	const unsigned char* pSrc = pTask->pSrc + pageIndex * pTask->mPageRowSize;
+	unsigned char* pDst = pTask->pDst + pageIndex * pTask->mPageRowSize * pTask->mPageSize;
+
+	// Page rows are contiguous in both layouts, so each row is a single memcpy which the CRT vectorizes
+	for (uint32_t y = 0; y < pTask->mPageSize; ++y)
+	{
+		memcpy(pDst, pSrc, pTask->mPageRowSize);
+		pSrc += pTask->mSrcPitch;
+		pDst += pTask->mPageRowSize;
+	}
+}
+
+static bool readSVTBand(FileStream* pSrc, const SVTBand& band, uint32_t pageSize, uint32_t pageRowSize, unsigned char* pDst)
+{
+	const uint64_t bandPitch = (uint64_t)band.mPageCount * pageRowSize;
+	const uint64_t firstRow = (uint64_t)band.mPageRow * pageSize;
+
+	// Band spans the whole mip width - the rows are contiguous in the source
+	if (bandPitch == band.mRowPitch)
+	{
+		if (!fsSeekStream(pSrc, SBO_START_OF_FILE, (ssize_t)(band.mMipOffset + firstRow * band.mRowPitch)))
+			return false;
+		return fsReadFromStream(pSrc, pDst, bandPitch * pageSize) == bandPitch * pageSize;
+	}
+
+	for (uint32_t y = 0; y < pageSize; ++y)
+	{
+		const uint64_t offset = band.mMipOffset + (firstRow + y) * band.mRowPitch + (uint64_t)band.mFirstPage * pageRowSize;
+		if (!fsSeekStream(pSrc, SBO_START_OF_FILE, (ssize_t)offset))
+			return false;
+		if (fsReadFromStream(pSrc, pDst + y * bandPitch, bandPitch) != bandPitch)
+			return false;
+	}
+
+	return true;
+}
+
+static bool SaveSVT(ThreadSystem* pThreadSystem, const char* fileName, FileStream* pSrc, SVT_HEADER* pHeader, uint32_t texelSize)
 {
 	FileStream fh = {};
 
 	if (!fsOpenStreamFromPath(RD_OUTPUT, fileName, FM_WRITE_BINARY, &fh))
 		return false;
 
-	//TODO: SVT should support any components somepoint
-	const uint32_t numberOfComponents = pHeader->mComponentCount;
 	const uint32_t pageSize = pHeader->mPageSize;
+	const uint32_t pageRowSize = pageSize * texelSize;
+	const uint64_t pageBytes = (uint64_t)pageRowSize * pageSize;
+	const uint32_t mipPageCount = pHeader->mMipLevels - (uint32_t)log2f((float)pageSize);
 
 	//Header
 	fsWriteToStream(&fh, pHeader, sizeof(SVT_HEADER));
 
-	uint32_t mipPageCount = pHeader->mMipLevels - (uint32_t)log2f((float)pageSize);
-
-	// Allocate Pages
-	unsigned char** mipLevelPixels = (unsigned char**)tf_calloc(pHeader->mMipLevels, sizeof(unsigned char*));
-	unsigned char*** pagePixels = (unsigned char***)tf_calloc(mipPageCount + 1, sizeof(unsigned char**));
-
-	uint32_t* mipSizes = (uint32_t*)tf_calloc(pHeader->mMipLevels, sizeof(uint32_t));
-
+	// Source mips are stored back to back after the container header
+	uint64_t* mipOffsets = (uint64_t*)tf_calloc(pHeader->mMipLevels, sizeof(uint64_t));
+	uint64_t offset = (uint64_t)fsGetStreamSeekPosition(pSrc);
 	for (uint32_t i = 0; i < pHeader->mMipLevels; ++i)
 	{
-		uint32_t mipSize = (pHeader->mWidth >> i) * (pHeader->mHeight >> i) * numberOfComponents;
-		mipSizes[i] = mipSize;
-		mipLevelPixels[i] = (unsigned char*)tf_calloc(mipSize, sizeof(unsigned char));
-		fsReadFromStream(pSrc, mipLevelPixels[i], mipSize);
+		mipOffsets[i] = offset;
+		offset += (uint64_t)(pHeader->mWidth >> i) * (pHeader->mHeight >> i) * texelSize;
 	}
 
-	// Store Mip data
+	// Split every page row into bands that fit the staging budget
+	const uint32_t maxBandPages = (uint32_t)max<uint64_t>(1, SVT_MAX_BAND_SIZE / pageBytes);
+	eastl::vector<SVTBand> bands;
 	for (uint32_t i = 0; i < mipPageCount; ++i)
 	{
-		uint32_t xOffset = pHeader->mWidth >> i;
-		uint32_t yOffset = pHeader->mHeight >> i;
-
 		// width and height in tiles
-		uint32_t tileWidth = xOffset / pageSize;
-		uint32_t tileHeight = yOffset / pageSize;
-
-		uint32_t xMipOffset = 0;
-		uint32_t yMipOffset = 0;
-		uint32_t pageIndex = 0;
-
-		uint32_t rowLength = xOffset * numberOfComponents;
-
-		pagePixels[i] = (unsigned char**)tf_calloc(tileWidth * tileHeight, sizeof(unsigned char*));
+		const uint32_t tileWidth = (pHeader->mWidth >> i) / pageSize;
+		const uint32_t tileHeight = (pHeader->mHeight >> i) / pageSize;
 
 		for (uint32_t j = 0; j < tileHeight; ++j)
 		{
-			for (uint32_t k = 0; k < tileWidth; ++k)
+			for (uint32_t k = 0; k < tileWidth; k += maxBandPages)
 			{
-				pagePixels[i][pageIndex] = (unsigned char*)tf_calloc(pageSize * pageSize, sizeof(unsigned char) * numberOfComponents);
-
-				for (uint32_t y = 0; y < pageSize; ++y)
-				{
-					for (uint32_t x = 0; x < pageSize; ++x)
-					{
-						uint32_t mipPageIndex = (y * pageSize + x) * numberOfComponents;
-						uint32_t mipIndex = rowLength * (y + yMipOffset) + (numberOfComponents)*(x + xMipOffset);
-
-						pagePixels[i][pageIndex][mipPageIndex + 0] = mipLevelPixels[i][mipIndex + 0];
-						pagePixels[i][pageIndex][mipPageIndex + 1] = mipLevelPixels[i][mipIndex + 1];
-						pagePixels[i][pageIndex][mipPageIndex + 2] = mipLevelPixels[i][mipIndex + 2];
-						pagePixels[i][pageIndex][mipPageIndex + 3] = mipLevelPixels[i][mipIndex + 3];
-					}
-				}
-
-				xMipOffset += pageSize;
-				pageIndex += 1;
+				SVTBand band = {};
+				band.mMipOffset = mipOffsets[i];
+				band.mRowPitch = (uint64_t)(pHeader->mWidth >> i) * texelSize;
+				band.mPageRow = j;
+				band.mFirstPage = k;
+				band.mPageCount = min(maxBandPages, tileWidth - k);
+				bands.push_back(band);
 			}
-
-			xMipOffset = 0;
-			yMipOffset += pageSize;
 		}
 	}
 
-	uint32_t mipTailPageSize = 0;
-
-	pagePixels[mipPageCount] = (unsigned char**)tf_calloc(1, sizeof(unsigned char*));
-
-	// Calculate mip tail size
-	for (uint32_t i = mipPageCount; i < pHeader->mMipLevels - 1; ++i)
+	const uint64_t bandSize = (uint64_t)min<uint64_t>(maxBandPages, (pHeader->mWidth / pageSize)) * pageBytes;
+	unsigned char* pBandSrc[2] = {};
+	unsigned char* pBandPages[2] = {};
+	uint32_t bandPageCount[2] = {};
+	SVTExtractTask tasks[2] = {};
+	for (uint32_t i = 0; i < 2; ++i)
 	{
-		uint32_t mipSize = mipSizes[i];
-		mipTailPageSize += mipSize;
+		pBandSrc[i] = (unsigned char*)tf_malloc(bandSize);
+		pBandPages[i] = (unsigned char*)tf_malloc(bandSize);
 	}
 
-	pagePixels[mipPageCount][0] = (unsigned char*)tf_calloc(mipTailPageSize, sizeof(unsigned char));
+	bool success = bands.empty() || readSVTBand(pSrc, bands[0], pageSize, pageRowSize, pBandSrc[0]);
 
-	// Store mip tail data
-	uint32_t mipTailPageWrites = 0;
-	for (uint32_t i = mipPageCount; i < pHeader->mMipLevels - 1; ++i)
+	// Pipeline: pages of band N are extracted on the thread system while band N-1 is written and band N+1 is read.
+	// Pages come out in the same order the runtime expects (mip, page row, page column).
+	for (uint32_t b = 0; success && b < (uint32_t)bands.size(); ++b)
 	{
-		uint32_t mipSize = mipSizes[i];
-
-		for (uint32_t j = 0; j < mipSize; ++j)
+		const uint32_t slot = b & 1;
+		SVTExtractTask& task = tasks[slot];
+		task.pSrc = pBandSrc[slot];
+		task.pDst = pBandPages[slot];
+		task.mPageRowSize = pageRowSize;
+		task.mPageSize = pageSize;
+		task.mSrcPitch = bands[b].mPageCount * pageRowSize;
+		bandPageCount[slot] = bands[b].mPageCount;
+		addThreadSystemRangeTask(pThreadSystem, extractSVTPage, &task, bands[b].mPageCount);
+
+		if (b > 0)
 		{
-			pagePixels[mipPageCount][0][mipTailPageWrites++] = mipLevelPixels[i][j];
+			const uint64_t writeSize = bandPageCount[slot ^ 1] * pageBytes;
+			success = fsWriteToStream(&fh, pBandPages[slot ^ 1], writeSize) == writeSize;
 		}
-	}
 
-	// Write mip data
-	for (uint32_t i = 0; i < mipPageCount; ++i)
-	{
-		// width and height in tiles
-		uint32_t mipWidth = (pHeader->mWidth >> i) / pageSize;
-		uint32_t mipHeight = (pHeader->mHeight >> i) / pageSize;
+		if (success && b + 1 < (uint32_t)bands.size())
+			success = readSVTBand(pSrc, bands[b + 1], pageSize, pageRowSize, pBandSrc[slot ^ 1]);
 
-		for (uint32_t j = 0; j < mipWidth * mipHeight; ++j)
-		{
-			fsWriteToStream(&fh, pagePixels[i][j], pageSize * pageSize * numberOfComponents * sizeof(char));
-		}
+		waitThreadSystemIdle(pThreadSystem);
 	}
 
-	// Write mip tail data
-	fsWriteToStream(&fh, pagePixels[mipPageCount][0], mipTailPageSize * sizeof(char));
+	if (success && !bands.empty())
+	{
+		const uint32_t slot = (uint32_t)(bands.size() - 1) & 1;
+		const uint64_t writeSize = bandPageCount[slot] * pageBytes;
+		success = fsWriteToStream(&fh, pBandPages[slot], writeSize) == writeSize;
+	}
 
-	// free memory
-	tf_free(mipSizes);
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		tf_free(pBandSrc[i]);
+		tf_free(pBandPages[i]);
+	}
 
-	for (uint32_t i = 0; i < mipPageCount; ++i)
+	// Mip tail: every mip smaller than a page except the last one, stored back to back.
+	// Its size is bounded by the page size (less than 4/3 of a page) so it is copied in one go.
+	if (success && mipPageCount < pHeader->mMipLevels - 1)
 	{
-		// width and height in tiles
-		uint32_t mipWidth = (pHeader->mWidth >> i) / pageSize;
-		uint32_t mipHeight = (pHeader->mHeight >> i) / pageSize;
-		uint32_t pageIndex = 0;
+		const uint64_t mipTailPageSize = mipOffsets[pHeader->mMipLevels - 1] - mipOffsets[mipPageCount];
+		unsigned char* pMipTail = (unsigned char*)tf_malloc(mipTailPageSize);
 
-		for (uint32_t j = 0; j < mipHeight; ++j)
-		{
-			for (uint32_t k = 0; k < mipWidth; ++k)
-			{
-				tf_free(pagePixels[i][pageIndex]);
-				pageIndex += 1;
-			}
-		}
+		success = fsSeekStream(pSrc, SBO_START_OF_FILE, (ssize_t)mipOffsets[mipPageCount]) &&
+			fsReadFromStream(pSrc, pMipTail, mipTailPageSize) == mipTailPageSize &&
+			fsWriteToStream(&fh, pMipTail, mipTailPageSize) == mipTailPageSize;
 
-		tf_free(pagePixels[i]);
+		tf_free(pMipTail);
 	}
-	tf_free(pagePixels[mipPageCount][0]);
-	tf_free(pagePixels[mipPageCount]);
-	tf_free(pagePixels);
 
-	for (uint32_t i = 0; i < pHeader->mMipLevels; ++i)
-	{
-		tf_free(mipLevelPixels[i]);
-	}
-	tf_free(mipLevelPixels);
+	tf_free(mipOffsets);
 
 	fsCloseStream(&fh);
 
-	return true;
+	return success;
 }
 
 bool AssetPipeline::ProcessVirtualTextures(ProcessAssetsSettings* settings)
@@ -502,6 +536,9 @@ bool AssetPipeline::ProcessVirtualTextures(ProcessAssetsSettings* settings)
 	eastl::vector<eastl::string> ddsFilesInDirectory;
 	fsGetFilesWithExtension(RD_INPUT, "", ".dds", ddsFilesInDirectory);
 
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
 	for (size_t i = 0; i < ddsFilesInDirectory.size(); ++i)
 	{
 		eastl::string outputFile = ddsFilesInDirectory[i];
@@ -510,7 +547,6 @@ bool AssetPipeline::ProcessVirtualTextures(ProcessAssetsSettings* settings)
 		{
 			TextureDesc textureDesc = {};
 			FileStream ddsFile = {};
-			fsOpenStreamFromPath(RD_INPUT, ddsFilesInDirectory[i].c_str(), FM_READ_BINARY, &ddsFile);
 			bool success = false;
 			if (!fsOpenStreamFromPath(RD_INPUT, ddsFilesInDirectory[i].c_str(), FM_READ_BINARY, &ddsFile))
 			{
@@ -526,17 +562,27 @@ bool AssetPipeline::ProcessVirtualTextures(ProcessAssetsSettings* settings)
 				continue;
 			}
 
+			// Pages are cut out of the texel grid so only uncompressed 8 bit per channel formats are supported
+			const uint32_t componentCount = TinyImageFormat_ChannelCount(textureDesc.mFormat);
+			if (TinyImageFormat_IsCompressed(textureDesc.mFormat) || !componentCount ||
+				TinyImageFormat_BitSizeOfBlock(textureDesc.mFormat) != componentCount * 8)
+			{
+				fsCloseStream(&ddsFile);
+				LOGF(LogLevel::eERROR, "Unsupported format %s for sparse virtual texture %s.", TinyImageFormat_Name(textureDesc.mFormat), outputFile.c_str());
+				continue;
+			}
+
 			outputFile.resize(outputFile.size() - 4);
 			outputFile.append(".svt");
 
 			SVT_HEADER header = {};
-			header.mComponentCount = 4;
+			header.mComponentCount = componentCount;
 			header.mHeight = textureDesc.mHeight;
 			header.mMipLevels = textureDesc.mMipLevels;
 			header.mPageSize = 128;
 			header.mWidth = textureDesc.mWidth;
 
-			success = SaveSVT(outputFile.c_str(), &ddsFile, &header);
+			success = SaveSVT(pThreadSystem, outputFile.c_str(), &ddsFile, &header, componentCount);
 
 			fsCloseStream(&ddsFile);
 
@@ -548,6 +594,8 @@ bool AssetPipeline::ProcessVirtualTextures(ProcessAssetsSettings* settings)
 		}
 	}
 
+	shutdownThreadSystem(pThreadSystem);
+
 	return true;
 }
 
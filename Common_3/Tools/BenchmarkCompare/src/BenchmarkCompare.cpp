@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Compares two benchmark reports written by dumpBenchmarkData (or the headless benchmark) and flags regressions.
+// Every number in the report is flattened to a dotted path, e.g. "timers.Main/Update.averageMs". The suffix of the last
+// component decides how a metric is judged: Ms and Bytes are lower-is-better, PerSecond is higher-is-better, anything else
+// is informational. Standalone on purpose so it builds on any host without the rest of the framework.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PATH_LENGTH 512
+
+struct Metric
+{
+	char   mPath[MAX_PATH_LENGTH];
+	double mValue;
+};
+
+struct MetricList
+{
+	Metric*  pMetrics;
+	uint32_t mCount;
+	uint32_t mCapacity;
+};
+
+struct Parser
+{
+	const char* pData;
+	size_t      mSize;
+	size_t      mPos;
+	MetricList* pList;
+	bool        mError;
+};
+
+enum MetricDirection
+{
+	METRIC_INFO,
+	METRIC_LOWER_IS_BETTER,
+	METRIC_HIGHER_IS_BETTER,
+};
+
+static void addMetric(MetricList* pList, const char* path, double value)
+{
+	if (pList->mCount == pList->mCapacity)
+	{
+		pList->mCapacity = pList->mCapacity ? pList->mCapacity * 2 : 256;
+		pList->pMetrics = (Metric*)realloc(pList->pMetrics, pList->mCapacity * sizeof(Metric));
+	}
+	Metric* pMetric = &pList->pMetrics[pList->mCount++];
+	strncpy(pMetric->mPath, path, MAX_PATH_LENGTH - 1);
+	pMetric->mPath[MAX_PATH_LENGTH - 1] = '\0';
+	pMetric->mValue = value;
+}
+
+static void skipWhitespace(Parser* pParser)
+{
+	while (pParser->mPos < pParser->mSize && strchr(" \t\r\n", pParser->pData[pParser->mPos]))
+		++pParser->mPos;
+}
+
+static bool expect(Parser* pParser, char c)
+{
+	skipWhitespace(pParser);
+	if (pParser->mPos < pParser->mSize && pParser->pData[pParser->mPos] == c)
+	{
+		++pParser->mPos;
+		return true;
+	}
+	pParser->mError = true;
+	return false;
+}
+
+// Reads a string into pOut (truncated to outSize), escapes are reduced to the escaped character
+static bool parseString(Parser* pParser, char* pOut, size_t outSize)
+{
+	if (!expect(pParser, '"'))
+		return false;
+	size_t length = 0;
+	while (pParser->mPos < pParser->mSize)
+	{
+		char c = pParser->pData[pParser->mPos++];
+		if (c == '"')
+		{
+			pOut[length] = '\0';
+			return true;
+		}
+		if (c == '\\' && pParser->mPos < pParser->mSize)
+		{
+			c = pParser->pData[pParser->mPos++];
+			if (c == 'u')
+			{
+				pParser->mPos += 4;
+				c = '?';
+			}
+		}
+		if (length + 1 < outSize)
+			pOut[length++] = c;
+	}
+	pParser->mError = true;
+	return false;
+}
+
+static void parseValue(Parser* pParser, char* path, size_t pathLength);
+
+static void appendPath(char* path, size_t pathLength, const char* component)
+{
+	snprintf(path + pathLength, MAX_PATH_LENGTH - pathLength, "%s%s", pathLength ? "." : "", component);
+}
+
+static void parseObject(Parser* pParser, char* path, size_t pathLength)
+{
+	expect(pParser, '{');
+	skipWhitespace(pParser);
+	if (pParser->mPos < pParser->mSize && pParser->pData[pParser->mPos] == '}')
+	{
+		++pParser->mPos;
+		return;
+	}
+	while (!pParser->mError)
+	{
+		char key[MAX_PATH_LENGTH];
+		if (!parseString(pParser, key, sizeof(key)) || !expect(pParser, ':'))
+			return;
+		appendPath(path, pathLength, key);
+		parseValue(pParser, path, strlen(path));
+		path[pathLength] = '\0';
+
+		skipWhitespace(pParser);
+		if (pParser->mPos < pParser->mSize && pParser->pData[pParser->mPos] == ',')
+		{
+			++pParser->mPos;
+			continue;
+		}
+		expect(pParser, '}');
+		return;
+	}
+}
+
+static void parseArray(Parser* pParser, char* path, size_t pathLength)
+{
+	expect(pParser, '[');
+	skipWhitespace(pParser);
+	if (pParser->mPos < pParser->mSize && pParser->pData[pParser->mPos] == ']')
+	{
+		++pParser->mPos;
+		return;
+	}
+	for (uint32_t index = 0; !pParser->mError; ++index)
+	{
+		char component[16];
+		snprintf(component, sizeof(component), "%u", index);
+		appendPath(path, pathLength, component);
+		parseValue(pParser, path, strlen(path));
+		path[pathLength] = '\0';
+
+		skipWhitespace(pParser);
+		if (pParser->mPos < pParser->mSize && pParser->pData[pParser->mPos] == ',')
+		{
+			++pParser->mPos;
+			continue;
+		}
+		expect(pParser, ']');
+		return;
+	}
+}
+
+static void parseValue(Parser* pParser, char* path, size_t pathLength)
+{
+	skipWhitespace(pParser);
+	if (pParser->mPos >= pParser->mSize)
+	{
+		pParser->mError = true;
+		return;
+	}
+
+	const char c = pParser->pData[pParser->mPos];
+	if (c == '{')
+	{
+		parseObject(pParser, path, pathLength);
+	}
+	else if (c == '[')
+	{
+		parseArray(pParser, path, pathLength);
+	}
+	else if (c == '"')
+	{
+		char ignored[MAX_PATH_LENGTH];
+		parseString(pParser, ignored, sizeof(ignored));
+	}
+	else if (c == '-' || (c >= '0' && c <= '9'))
+	{
+		char* pEnd = NULL;
+		const double value = strtod(pParser->pData + pParser->mPos, &pEnd);
+		pParser->mPos = (size_t)(pEnd - pParser->pData);
+		addMetric(pParser->pList, path, value);
+	}
+	else
+	{
+		// true, false, null
+		while (pParser->mPos < pParser->mSize && pParser->pData[pParser->mPos] >= 'a' && pParser->pData[pParser->mPos] <= 'z')
+			++pParser->mPos;
+	}
+}
+
+static bool loadReport(const char* fileName, MetricList* pList)
+{
+	FILE* pFile = fopen(fileName, "rb");
+	if (!pFile)
+	{
+		printf("ERROR: Could not open %s\n", fileName);
+		return false;
+	}
+	fseek(pFile, 0, SEEK_END);
+	const long fileSize = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+	char* pData = (char*)malloc(fileSize > 0 ? (size_t)fileSize : 1);
+	const size_t bytesRead = fread(pData, 1, (size_t)(fileSize > 0 ? fileSize : 0), pFile);
+	fclose(pFile);
+
+	char path[MAX_PATH_LENGTH] = {};
+	Parser parser = { pData, bytesRead, 0, pList, false };
+	parseValue(&parser, path, 0);
+	free(pData);
+	if (parser.mError)
+	{
+		printf("ERROR: %s is not a valid benchmark report (parse error at byte %zu)\n", fileName, parser.mPos);
+		return false;
+	}
+	return true;
+}
+
+static bool endsWith(const char* string, const char* suffix, bool ignoreCase)
+{
+	const size_t stringLength = strlen(string);
+	const size_t suffixLength = strlen(suffix);
+	if (suffixLength > stringLength)
+		return false;
+	const char* pTail = string + stringLength - suffixLength;
+	for (size_t i = 0; i < suffixLength; ++i)
+	{
+		char a = pTail[i], b = suffix[i];
+		if (ignoreCase)
+		{
+			a = (a >= 'A' && a <= 'Z') ? (char)(a - 'A' + 'a') : a;
+			b = (b >= 'A' && b <= 'Z') ? (char)(b - 'A' + 'a') : b;
+		}
+		if (a != b)
+			return false;
+	}
+	return true;
+}
+
+static MetricDirection getDirection(const char* path)
+{
+	if (endsWith(path, "Ms", false))
+		return METRIC_LOWER_IS_BETTER;
+	if (endsWith(path, "bytes", true))
+		return METRIC_LOWER_IS_BETTER;
+	if (endsWith(path, "PerSecond", false))
+		return METRIC_HIGHER_IS_BETTER;
+	return METRIC_INFO;
+}
+
+static const Metric* findMetric(const MetricList* pList, const char* path)
+{
+	for (uint32_t i = 0; i < pList->mCount; ++i)
+	{
+		if (!strcmp(pList->pMetrics[i].mPath, path))
+			return &pList->pMetrics[i];
+	}
+	return NULL;
+}
+
+static void printHelp()
+{
+	printf("BenchmarkCompare\n"
+		   "\nUsage: BenchmarkCompare <baseline.json> <current.json> [-threshold <percent>] [-min-ms <ms>] [-all]\n"
+		   "\tCompares two benchmark reports and lists metrics that got worse by more than the threshold (default 5%%).\n"
+		   "\t-min-ms  timings where both values are below this are ignored as noise (default 0.05)\n"
+		   "\t-all     also print improvements, unchanged and informational metrics\n"
+		   "\tReturns 0 if there is no regression, 2 if there is one and 1 on errors.\n");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "-help"))
+	{
+		printHelp();
+		return argc < 3 ? 1 : 0;
+	}
+
+	double threshold = 5.0;
+	double minMs = 0.05;
+	bool   printAll = false;
+	for (int i = 3; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-threshold") && i + 1 < argc)
+			threshold = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-min-ms") && i + 1 < argc)
+			minMs = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-all"))
+			printAll = true;
+		else
+		{
+			printf("ERROR: Unknown argument %s\n", argv[i]);
+			printHelp();
+			return 1;
+		}
+	}
+
+	MetricList baseline = {};
+	MetricList current = {};
+	if (!loadReport(argv[1], &baseline) || !loadReport(argv[2], &current))
+	{
+		free(baseline.pMetrics);
+		free(current.pMetrics);
+		return 1;
+	}
+
+	uint32_t regressionCount = 0;
+	uint32_t improvementCount = 0;
+	uint32_t comparedCount = 0;
+	printf("%-64s %14s %14s %9s\n", "metric", "baseline", "current", "change");
+	for (uint32_t i = 0; i < current.mCount; ++i)
+	{
+		const Metric*         pCurrent = &current.pMetrics[i];
+		const Metric*         pBaseline = findMetric(&baseline, pCurrent->mPath);
+		const MetricDirection direction = getDirection(pCurrent->mPath);
+		if (!pBaseline)
+		{
+			if (printAll)
+				printf("%-64s %14s %14.4f %9s  new\n", pCurrent->mPath, "-", pCurrent->mValue, "");
+			continue;
+		}
+
+		const double before = pBaseline->mValue;
+		const double after = pCurrent->mValue;
+		const double change = before != 0.0 ? (after - before) / fabs(before) * 100.0 : (after != 0.0 ? 100.0 : 0.0);
+		const char*  verdict = "";
+		if (direction != METRIC_INFO)
+		{
+			++comparedCount;
+			const bool isTiming = endsWith(pCurrent->mPath, "Ms", false);
+			const bool isNoise = isTiming && fabs(before) < minMs && fabs(after) < minMs;
+			const double worse = direction == METRIC_LOWER_IS_BETTER ? change : -change;
+			if (!isNoise && worse > threshold)
+			{
+				verdict = "REGRESSION";
+				++regressionCount;
+			}
+			else if (!isNoise && worse < -threshold)
+			{
+				verdict = "improved";
+				++improvementCount;
+			}
+		}
+
+		if (printAll || verdict[0] == 'R')
+			printf("%-64s %14.4f %14.4f %+8.2f%%  %s\n", pCurrent->mPath, before, after, change, verdict);
+	}
+	if (printAll)
+	{
+		for (uint32_t i = 0; i < baseline.mCount; ++i)
+		{
+			if (!findMetric(&current, baseline.pMetrics[i].mPath))
+				printf("%-64s %14.4f %14s %9s  removed\n", baseline.pMetrics[i].mPath, baseline.pMetrics[i].mValue, "-", "");
+		}
+	}
+
+	printf("\n%u metrics compared, %u regressions, %u improvements (threshold %.2f%%)\n", comparedCount, regressionCount, improvementCount, threshold);
+
+	free(baseline.pMetrics);
+	free(current.pMetrics);
+	return regressionCount ? 2 : 0;
+}
@@ -0,0 +1,450 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Turns binary logs written by BLOGF (Log::SetBinaryLogging) back into text in the same layout as the regular log.
+// Standalone on purpose so it builds on any host without the rest of the framework.
+
+#include "../../../OS/Logging/BinaryLogFormat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct FormatDef
+{
+	char*    pFile;
+	char*    pFormat;
+	uint32_t mLevel;
+	uint32_t mLine;
+};
+
+struct ThreadDef
+{
+	char mName[256];
+};
+
+struct DecodedArg
+{
+	BinaryLogArgType mType;
+	union
+	{
+		int64_t  mInt;
+		uint64_t mUInt;
+		double   mFloat;
+	};
+	const char* pString;
+	uint16_t    mStringLength;
+};
+
+struct Reader
+{
+	const uint8_t* pData;
+	size_t         mSize;
+	size_t         mPos;
+};
+
+static bool read(Reader* pReader, void* pDst, size_t size)
+{
+	if (pReader->mPos + size > pReader->mSize)
+		return false;
+	memcpy(pDst, pReader->pData + pReader->mPos, size);
+	pReader->mPos += size;
+	return true;
+}
+
+static const char* getFileName(const char* path)
+{
+	for (const char* ptr = path; *ptr; ++ptr)
+	{
+		if (*ptr == '/' || *ptr == '\\')
+			path = ptr + 1;
+	}
+	return path;
+}
+
+static const char* getLevelPrefix(uint32_t level)
+{
+	// Same priority as Log::Write when several flags are set
+	if (level & 8)
+		return "WARN| ";
+	if (level & 4)
+		return "INFO| ";
+	if (level & 2)
+		return " DBG| ";
+	if (level & 16)
+		return " ERR| ";
+	return "    | ";
+}
+
+// Decodes the payload of one message, returns the number of arguments
+static uint32_t decodeArgs(const uint8_t* pPayload, uint16_t size, DecodedArg* pArgs, uint32_t maxArgs)
+{
+	Reader   reader = { pPayload, size, 0 };
+	uint32_t count = 0;
+	uint8_t  type = 0;
+	while (count < maxArgs && read(&reader, &type, 1))
+	{
+		DecodedArg& arg = pArgs[count];
+		arg.mType = (BinaryLogArgType)type;
+		arg.pString = NULL;
+		arg.mStringLength = 0;
+		bool ok = true;
+		switch (type)
+		{
+		case BINARY_LOG_ARG_I32: { int32_t v = 0; ok = read(&reader, &v, sizeof(v)); arg.mInt = v; break; }
+		case BINARY_LOG_ARG_U32: { uint32_t v = 0; ok = read(&reader, &v, sizeof(v)); arg.mUInt = v; break; }
+		case BINARY_LOG_ARG_I64: ok = read(&reader, &arg.mInt, sizeof(arg.mInt)); break;
+		case BINARY_LOG_ARG_U64:
+		case BINARY_LOG_ARG_POINTER: ok = read(&reader, &arg.mUInt, sizeof(arg.mUInt)); break;
+		case BINARY_LOG_ARG_F64: ok = read(&reader, &arg.mFloat, sizeof(arg.mFloat)); break;
+		case BINARY_LOG_ARG_STRING:
+			ok = read(&reader, &arg.mStringLength, sizeof(arg.mStringLength)) && reader.mPos + arg.mStringLength <= reader.mSize;
+			if (ok)
+			{
+				arg.pString = (const char*)reader.pData + reader.mPos;
+				reader.mPos += arg.mStringLength;
+			}
+			break;
+		default: ok = false; break;
+		}
+		if (!ok)
+			break;
+		++count;
+	}
+	return count;
+}
+
+template <typename T>
+static void formatValue(char* pOut, size_t outSize, const char* spec, const int* pStars, int starCount, T value)
+{
+	if (starCount == 2)
+		snprintf(pOut, outSize, spec, pStars[0], pStars[1], value);
+	else if (starCount == 1)
+		snprintf(pOut, outSize, spec, pStars[0], value);
+	else
+		snprintf(pOut, outSize, spec, value);
+}
+
+static void append(char* pOut, size_t outSize, size_t* pPos, const char* str, size_t length)
+{
+	if (*pPos + 1 >= outSize)
+		return;
+	if (length > outSize - *pPos - 1)
+		length = outSize - *pPos - 1;
+	memcpy(pOut + *pPos, str, length);
+	*pPos += length;
+	pOut[*pPos] = 0;
+}
+
+// printf style expansion with arguments whose types are only known at runtime. Length modifiers in the format are
+// replaced by the ones matching the recorded argument type, so %d with a 64 bit argument still prints correctly.
+static void formatMessage(const char* pFormat, const DecodedArg* pArgs, uint32_t argCount, char* pOut, size_t outSize)
+{
+	size_t   pos = 0;
+	uint32_t argIndex = 0;
+	pOut[0] = 0;
+
+	for (const char* p = pFormat; *p;)
+	{
+		if (*p != '%')
+		{
+			const char* pEnd = strchr(p, '%');
+			size_t length = pEnd ? (size_t)(pEnd - p) : strlen(p);
+			append(pOut, outSize, &pos, p, length);
+			p += length;
+			continue;
+		}
+		if (p[1] == '%')
+		{
+			append(pOut, outSize, &pos, "%", 1);
+			p += 2;
+			continue;
+		}
+
+		// Collect flags, width and precision, consume '*' from the arguments
+		char spec[64] = "%";
+		size_t specLength = 1;
+		int starValues[2] = {};
+		int starCount = 0;
+		++p;
+		while (*p && strchr("-+ #0123456789.*", *p))
+		{
+			if (*p == '*' && starCount < 2)
+				starValues[starCount++] = argIndex < argCount ? (int)pArgs[argIndex++].mInt : 0;
+			if (specLength < sizeof(spec) - 8)
+				spec[specLength++] = *p;
+			++p;
+		}
+		while (*p && strchr("hljztL", *p))
+			++p;
+		const char conversion = *p ? *p++ : 0;
+		if (!conversion)
+			break;
+
+		char value[512];
+		value[0] = 0;
+		if (conversion == 'n')
+			continue;
+		if (argIndex >= argCount)
+		{
+			append(pOut, outSize, &pos, "<missing>", 9);
+			continue;
+		}
+
+		const DecodedArg& arg = pArgs[argIndex++];
+		const bool isSigned = arg.mType == BINARY_LOG_ARG_I32 || arg.mType == BINARY_LOG_ARG_I64;
+		switch (conversion)
+		{
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			spec[specLength++] = 'l';
+			spec[specLength++] = 'l';
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			if (arg.mType == BINARY_LOG_ARG_F64)
+				formatValue(value, sizeof(value), spec, starValues, starCount, (long long)arg.mFloat);
+			else if (isSigned)
+				formatValue(value, sizeof(value), spec, starValues, starCount, (long long)arg.mInt);
+			else
+				formatValue(value, sizeof(value), spec, starValues, starCount, (unsigned long long)arg.mUInt);
+			break;
+		case 'c':
+			spec[specLength++] = 'c';
+			spec[specLength] = 0;
+			formatValue(value, sizeof(value), spec, starValues, starCount, (int)arg.mInt);
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			spec[specLength++] = conversion;
+			spec[specLength] = 0;
+			formatValue(value, sizeof(value), spec, starValues, starCount,
+				arg.mType == BINARY_LOG_ARG_F64 ? arg.mFloat : (isSigned ? (double)arg.mInt : (double)arg.mUInt));
+			break;
+		case 's':
+		{
+			spec[specLength++] = 's';
+			spec[specLength] = 0;
+			// Strings are stored without terminator and never exceed the payload size
+			char str[BINARY_LOG_MAX_PAYLOAD + 1];
+			if (arg.mType == BINARY_LOG_ARG_STRING)
+			{
+				memcpy(str, arg.pString, arg.mStringLength);
+				str[arg.mStringLength] = 0;
+			}
+			else
+				snprintf(str, sizeof(str), "<not a string>");
+			formatValue(value, sizeof(value), spec, starValues, starCount, (const char*)str);
+			break;
+		}
+		case 'p':
+			snprintf(value, sizeof(value), "0x%llx", (unsigned long long)arg.mUInt);
+			break;
+		default:
+			snprintf(value, sizeof(value), "<%%%c?>", conversion);
+			break;
+		}
+		append(pOut, outSize, &pos, value, strlen(value));
+	}
+}
+
+static void printHelp()
+{
+	printf("BinaryLogDecoder\n"
+		   "\nUsage: BinaryLogDecoder <input.blog> [output.log]\n"
+		   "\tDecodes a binary log written with Log::SetBinaryLogging. Prints to stdout when no output file is given.\n");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "-help"))
+	{
+		printHelp();
+		return argc < 2 ? 1 : 0;
+	}
+
+	FILE* pInput = fopen(argv[1], "rb");
+	if (!pInput)
+	{
+		printf("ERROR: Could not open %s\n", argv[1]);
+		return 1;
+	}
+	fseek(pInput, 0, SEEK_END);
+	const long fileSize = ftell(pInput);
+	fseek(pInput, 0, SEEK_SET);
+	uint8_t* pData = (uint8_t*)malloc(fileSize > 0 ? (size_t)fileSize : 1);
+	const size_t bytesRead = fread(pData, 1, (size_t)(fileSize > 0 ? fileSize : 0), pInput);
+	fclose(pInput);
+
+	FILE* pOutput = argc > 2 ? fopen(argv[2], "w") : stdout;
+	if (!pOutput)
+	{
+		printf("ERROR: Could not create %s\n", argv[2]);
+		free(pData);
+		return 1;
+	}
+
+	Reader reader = { pData, bytesRead, 0 };
+	BinaryLogFileHeader header = {};
+	if (!read(&reader, &header, sizeof(header)) || header.mMagic != BINARY_LOG_MAGIC)
+	{
+		printf("ERROR: %s is not a binary log\n", argv[1]);
+		free(pData);
+		return 1;
+	}
+	if (header.mVersion != BINARY_LOG_VERSION)
+	{
+		printf("ERROR: %s has version %u, expected %u\n", argv[1], header.mVersion, BINARY_LOG_VERSION);
+		free(pData);
+		return 1;
+	}
+
+	FormatDef* pFormats = NULL;
+	uint32_t   formatCount = 0;
+	ThreadDef* pThreads = NULL;
+	uint32_t   threadCount = 0;
+	uint64_t   messageCount = 0;
+	bool       truncated = false;
+
+	DecodedArg args[BINARY_LOG_MAX_PAYLOAD / 2];
+	uint8_t    payload[BINARY_LOG_MAX_PAYLOAD];
+	char       message[4096];
+
+	uint8_t type = 0;
+	while (read(&reader, &type, 1))
+	{
+		if (type == BINARY_LOG_RECORD_FORMAT)
+		{
+			uint32_t id = 0, level = 0, line = 0;
+			uint16_t fileLength = 0, formatLength = 0;
+			if (!read(&reader, &id, 4) || !read(&reader, &level, 4) || !read(&reader, &line, 4) || !read(&reader, &fileLength, 2) ||
+				!read(&reader, &formatLength, 2) || reader.mPos + fileLength + formatLength > reader.mSize || !id)
+			{
+				truncated = true;
+				break;
+			}
+			if (id > formatCount)
+			{
+				pFormats = (FormatDef*)realloc(pFormats, id * sizeof(FormatDef));
+				memset(pFormats + formatCount, 0, (id - formatCount) * sizeof(FormatDef));
+				formatCount = id;
+			}
+			FormatDef& def = pFormats[id - 1];
+			free(def.pFile);
+			free(def.pFormat);
+			def.pFile = (char*)calloc(fileLength + 1, 1);
+			def.pFormat = (char*)calloc(formatLength + 1, 1);
+			read(&reader, def.pFile, fileLength);
+			read(&reader, def.pFormat, formatLength);
+			def.mLevel = level;
+			def.mLine = line;
+		}
+		else if (type == BINARY_LOG_RECORD_THREAD)
+		{
+			uint32_t index = 0;
+			uint8_t  nameLength = 0;
+			if (!read(&reader, &index, 4) || !read(&reader, &nameLength, 1) || reader.mPos + nameLength > reader.mSize || !index)
+			{
+				truncated = true;
+				break;
+			}
+			if (index > threadCount)
+			{
+				pThreads = (ThreadDef*)realloc(pThreads, index * sizeof(ThreadDef));
+				memset(pThreads + threadCount, 0, (index - threadCount) * sizeof(ThreadDef));
+				threadCount = index;
+			}
+			read(&reader, pThreads[index - 1].mName, nameLength);
+			pThreads[index - 1].mName[nameLength] = 0;
+		}
+		else if (type == BINARY_LOG_RECORD_MESSAGE)
+		{
+			uint32_t id = 0, threadIndex = 0;
+			uint64_t timestamp = 0;
+			uint16_t payloadSize = 0;
+			if (!read(&reader, &id, 4) || !read(&reader, &threadIndex, 4) || !read(&reader, &timestamp, 8) ||
+				!read(&reader, &payloadSize, 2) || payloadSize > BINARY_LOG_MAX_PAYLOAD || !read(&reader, payload, payloadSize))
+			{
+				truncated = true;
+				break;
+			}
+
+			const uint32_t argCount = decodeArgs(payload, payloadSize, args, sizeof(args) / sizeof(args[0]));
+			const FormatDef* pDef = (id && id <= formatCount && pFormats[id - 1].pFormat) ? &pFormats[id - 1] : NULL;
+			if (pDef)
+				formatMessage(pDef->pFormat, args, argCount, message, sizeof(message));
+			else
+				snprintf(message, sizeof(message), "<unknown format id %u>", id);
+
+			// Absolute time from the wall clock captured when the file was opened
+			const int64_t  elapsedUs = (int64_t)(timestamp - header.mStartTimestampUs);
+			const time_t   seconds = (time_t)((int64_t)header.mStartTime + elapsedUs / 1000000);
+			const uint32_t micro = (uint32_t)(((elapsedUs % 1000000) + 1000000) % 1000000);
+			struct tm      timeInfo = {};
+#if defined(_WIN32)
+			localtime_s(&timeInfo, &seconds);
+#else
+			localtime_r(&seconds, &timeInfo);
+#endif
+			const char* threadName = (threadIndex && threadIndex <= threadCount && pThreads[threadIndex - 1].mName[0])
+				? pThreads[threadIndex - 1].mName : "NoName";
+
+			fprintf(pOutput, "%04d-%02d-%02d %02d:%02d:%02d.%06u [%-15s] %22.*s:%-5u %s%s\n", 1900 + timeInfo.tm_year,
+				1 + timeInfo.tm_mon, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec, micro, threadName, 23,
+				pDef ? getFileName(pDef->pFile) : "?", pDef ? pDef->mLine : 0, getLevelPrefix(pDef ? pDef->mLevel : 0), message);
+			++messageCount;
+		}
+		else
+		{
+			truncated = true;
+			break;
+		}
+	}
+
+	if (truncated)
+		fprintf(stderr, "WARNING: %s ends with an incomplete record (application did not shut down cleanly?)\n", argv[1]);
+	fprintf(stderr, "Decoded %llu messages, %u formats, %u threads\n", (unsigned long long)messageCount, formatCount, threadCount);
+
+	if (pOutput != stdout)
+		fclose(pOutput);
+	for (uint32_t i = 0; i < formatCount; ++i)
+	{
+		free(pFormats[i].pFile);
+		free(pFormats[i].pFormat);
+	}
+	free(pFormats);
+	free(pThreads);
+	free(pData);
+	return 0;
+}
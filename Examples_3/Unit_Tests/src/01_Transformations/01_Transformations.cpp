@@ -40,6 +40,7 @@
 #include "../../../../Middleware_3/UI/AppUI.h"
 #include "../../../../Common_3/Renderer/IRenderer.h"
 #include "../../../../Common_3/Renderer/IResourceLoader.h"
+#include "../../../../Common_3/OS/Core/RenderGraph.h"
 
 //Math
 #include "../../../../Common_3/OS/Math/MathTypes.h"
@@ -86,7 +87,9 @@ CmdPool* pCmdPools[gImageCount] = { NULL };
 Cmd*     pCmds[gImageCount] = { NULL };
 
 SwapChain*    pSwapChain = NULL;
-RenderTarget* pDepthBuffer = NULL;
+// The depth buffer is a transient of the render graph, which creates and pools it from this desc
+RenderGraph*     pRenderGraph = NULL;
+RenderTargetDesc gDepthBufferDesc = {};
 Fence*        pRenderCompleteFences[gImageCount] = { NULL };
 Semaphore*    pImageAcquiredSemaphore = NULL;
 Semaphore*    pRenderCompleteSemaphores[gImageCount] = { NULL };
@@ -109,6 +112,14 @@ Buffer* pProjViewUniformBuffer[gImageCount] = { NULL };
 Buffer* pSkyboxUniformBuffer[gImageCount] = { NULL };
 
 uint32_t gFrameIndex = 0;
+
+// Resources of the frame graph, handed to its passes
+struct FramePasses
+{
+	RenderGraphHandle mSwapChainTarget;
+	RenderGraphHandle mDepthBuffer;
+} gFramePasses;
+
 ProfileToken gGpuProfileToken = PROFILE_INVALID_TOKEN;
 
 bool			 bToggleVSync = false;
@@ -576,8 +587,8 @@ public:
 		if (!addSwapChain())
 			return false;
 
-		if (!addDepthBuffer())
-			return false;
+		addDepthBufferDesc();
+		addRenderGraph(pRenderer, &pRenderGraph);
 
 		if (!gAppUI.Load(pSwapChain->ppRenderTargets, 1))
 			return false;
@@ -619,7 +630,7 @@ public:
 		pipelineSettings.pColorFormats = &pSwapChain->ppRenderTargets[0]->mFormat;
 		pipelineSettings.mSampleCount = pSwapChain->ppRenderTargets[0]->mSampleCount;
 		pipelineSettings.mSampleQuality = pSwapChain->ppRenderTargets[0]->mSampleQuality;
-		pipelineSettings.mDepthStencilFormat = pDepthBuffer->mFormat;
+		pipelineSettings.mDepthStencilFormat = gDepthBufferDesc.mFormat;
 		pipelineSettings.pRootSignature = pRootSignature;
 		pipelineSettings.pShaderProgram = pSphereShader;
 		pipelineSettings.pVertexLayout = &vertexLayout;
@@ -663,7 +674,7 @@ public:
 		removePipeline(pRenderer, pCrashPipeline);
 #endif
 		removeSwapChain(pRenderer, pSwapChain);
-		removeRenderTarget(pRenderer, pDepthBuffer);
+		removeRenderGraph(pRenderGraph);
 
 		if (mSettings.mResetGraphics || mSettings.mQuit)
 		{
@@ -822,10 +833,75 @@ public:
 
 		cmdBeginGpuFrameProfile(cmd, gGpuProfileToken);
 
-		RenderTargetBarrier barriers[] = {
-			{ pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET },
-		};
-		cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, barriers);
+		// The graph records the barriers of the swap chain image and creates the depth buffer
+		beginRenderGraph(pRenderGraph);
+		gFramePasses.mSwapChainTarget = importRenderGraphRenderTarget(pRenderGraph, pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+		gFramePasses.mDepthBuffer = addRenderGraphRenderTarget(pRenderGraph, &gDepthBufferDesc);
+
+		uint32_t pass = addRenderGraphPass(pRenderGraph, "Draw Scene", DrawScenePass, &gFramePasses);
+		writeRenderGraphResource(pRenderGraph, pass, gFramePasses.mSwapChainTarget, RESOURCE_STATE_RENDER_TARGET);
+		writeRenderGraphResource(pRenderGraph, pass, gFramePasses.mDepthBuffer, RESOURCE_STATE_DEPTH_WRITE);
+
+		pass = addRenderGraphPass(pRenderGraph, "Draw UI", DrawUIPass, &gFramePasses);
+		writeRenderGraphResource(pRenderGraph, pass, gFramePasses.mSwapChainTarget, RESOURCE_STATE_RENDER_TARGET);
+
+		compileRenderGraph(pRenderGraph);
+		cmdExecuteRenderGraph(cmd, pRenderGraph);
+
+		cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
+		endCmd(cmd);
+
+		QueueSubmitDesc submitDesc = {};
+		submitDesc.mCmdCount = 1;
+		submitDesc.mSignalSemaphoreCount = 1;
+		submitDesc.mWaitSemaphoreCount = 1;
+		submitDesc.ppCmds = &cmd;
+		submitDesc.ppSignalSemaphores = &pRenderCompleteSemaphore;
+		submitDesc.ppWaitSemaphores = &pImageAcquiredSemaphore;
+		submitDesc.pSignalFence = pRenderCompleteFence;
+		queueSubmit(pGraphicsQueue, &submitDesc);
+		QueuePresentDesc presentDesc = {};
+		presentDesc.mIndex = swapchainImageIndex;
+		presentDesc.mWaitSemaphoreCount = 1;
+		presentDesc.pSwapChain = pSwapChain;
+		presentDesc.ppWaitSemaphores = &pRenderCompleteSemaphore;
+		presentDesc.mSubmitDone = true;
+
+		// captureScreenshot() must be used before presentation.
+		if (gTakeScreenshot)
+		{
+			// Metal platforms need one renderpass to prepare the swapchain textures for copy.
+			if(prepareScreenshot(pSwapChain))
+			{
+				captureScreenshot(pSwapChain, swapchainImageIndex, RESOURCE_STATE_PRESENT, "01_Transformations_Screenshot.png");
+				gTakeScreenshot = false;
+			}
+		}
+		
+		PresentStatus presentStatus = queuePresent(pGraphicsQueue, &presentDesc);
+		flipProfiler();
+
+		if (presentStatus == PRESENT_STATUS_DEVICE_RESET)
+		{
+			Thread::Sleep(5000);// Wait for a few seconds to allow the driver to come back online before doing a reset.
+			mSettings.mResetGraphics = true;
+		}
+
+		// Test re-creating graphics resources mid app.
+		if (gTestGraphicsReset) 
+		{
+			mSettings.mResetGraphics = true;
+			gTestGraphicsReset = false;
+		}
+
+		gFrameIndex = (gFrameIndex + 1) % gImageCount;
+	}
+
+	static void DrawScenePass(Cmd* cmd, RenderGraph* pGraph, void* pUserData)
+	{
+		const FramePasses* pPasses = (const FramePasses*)pUserData;
+		RenderTarget*      pRenderTarget = getRenderGraphRenderTarget(pGraph, pPasses->mSwapChainTarget);
+		RenderTarget*      pDepthBuffer = getRenderGraphRenderTarget(pGraph, pPasses->mDepthBuffer);
 
 		// simply record the screen cleaning command
 		LoadActionsDesc loadActions = {};
@@ -891,8 +967,14 @@ public:
 #endif
 
 		cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+	}
 
-		loadActions = {};
+	static void DrawUIPass(Cmd* cmd, RenderGraph* pGraph, void* pUserData)
+	{
+		const FramePasses* pPasses = (const FramePasses*)pUserData;
+		RenderTarget*      pRenderTarget = getRenderGraphRenderTarget(pGraph, pPasses->mSwapChainTarget);
+
+		LoadActionsDesc loadActions = {};
 		loadActions.mLoadActionsColor[0] = LOAD_ACTION_LOAD;
 		cmdBindRenderTargets(cmd, 1, &pRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
 		cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw UI");
@@ -910,57 +992,6 @@ public:
 		gAppUI.Draw(cmd);
 		cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
 		cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
-
-		barriers[0] = { pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT };
-		cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, barriers);
-
-		cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
-		endCmd(cmd);
-
-		QueueSubmitDesc submitDesc = {};
-		submitDesc.mCmdCount = 1;
-		submitDesc.mSignalSemaphoreCount = 1;
-		submitDesc.mWaitSemaphoreCount = 1;
-		submitDesc.ppCmds = &cmd;
-		submitDesc.ppSignalSemaphores = &pRenderCompleteSemaphore;
-		submitDesc.ppWaitSemaphores = &pImageAcquiredSemaphore;
-		submitDesc.pSignalFence = pRenderCompleteFence;
-		queueSubmit(pGraphicsQueue, &submitDesc);
-		QueuePresentDesc presentDesc = {};
-		presentDesc.mIndex = swapchainImageIndex;
-		presentDesc.mWaitSemaphoreCount = 1;
-		presentDesc.pSwapChain = pSwapChain;
-		presentDesc.ppWaitSemaphores = &pRenderCompleteSemaphore;
-		presentDesc.mSubmitDone = true;
-
-		// captureScreenshot() must be used before presentation.
-		if (gTakeScreenshot)
-		{
-			// Metal platforms need one renderpass to prepare the swapchain textures for copy.
-			if(prepareScreenshot(pSwapChain))
-			{
-				captureScreenshot(pSwapChain, swapchainImageIndex, RESOURCE_STATE_PRESENT, "01_Transformations_Screenshot.png");
-				gTakeScreenshot = false;
-			}
-		}
-		
-		PresentStatus presentStatus = queuePresent(pGraphicsQueue, &presentDesc);
-		flipProfiler();
-
-		if (presentStatus == PRESENT_STATUS_DEVICE_RESET)
-		{
-			Thread::Sleep(5000);// Wait for a few seconds to allow the driver to come back online before doing a reset.
-			mSettings.mResetGraphics = true;
-		}
-
-		// Test re-creating graphics resources mid app.
-		if (gTestGraphicsReset) 
-		{
-			mSettings.mResetGraphics = true;
-			gTestGraphicsReset = false;
-		}
-
-		gFrameIndex = (gFrameIndex + 1) % gImageCount;
 	}
 
 	const char* GetName() { return "01_Transformations"; }
@@ -981,10 +1012,10 @@ public:
 		return pSwapChain != NULL;
 	}
 
-	bool addDepthBuffer()
+	void addDepthBufferDesc()
 	{
-		// Add depth buffer
-		RenderTargetDesc depthRT = {};
+		RenderTargetDesc& depthRT = gDepthBufferDesc;
+		depthRT = {};
 		depthRT.mArraySize = 1;
 		depthRT.mClearValue.depth = 0.0f;
 		depthRT.mClearValue.stencil = 0;
@@ -996,9 +1027,7 @@ public:
 		depthRT.mSampleQuality = 0;
 		depthRT.mWidth = mSettings.mWidth;
 		depthRT.mFlags = TEXTURE_CREATION_FLAG_ON_TILE;
-		addRenderTarget(pRenderer, &depthRT, &pDepthBuffer);
-
-		return pDepthBuffer != NULL;
+		depthRT.pName = "Depth Buffer";
 	}
 
 	void initMarkers()
@@ -40,6 +40,7 @@
 #include "../../../../Common_3/Renderer/IRenderer.h"
 #include "../../../../Common_3/OS/Interfaces/IApp.h"
 #include "../../../../Common_3/Renderer/IResourceLoader.h"
+#include "../../../../Common_3/OS/Core/ResourceStateTracker.h"
 
 //Math
 #include "../../../../Common_3/OS/Math/MathTypes.h"
@@ -90,6 +91,11 @@ Buffer*   pUniformBuffer[gImageCount] = { NULL };
 Queue*           pGraphicsQueue = NULL;
 CmdPool*         pCmdPools[gImageCount];
 Cmd*             pCmds[gImageCount];
+// Transitions from the state the previous frame left a resource in to the state of its first use in pCmds
+Cmd*             pFixupCmds[gImageCount];
+
+ResourceStateTracker* pResourceStateTracker = NULL;
+CmdResourceStates*    pCmdResourceStates[gImageCount] = { NULL };
 Sampler*         pSampler = NULL;
 
 Fence*     pRenderCompleteFences[gImageCount] = { NULL };
@@ -233,7 +239,10 @@ class Compute: public IApp
 				CmdDesc cmdDesc = {};
 				cmdDesc.pPool = pCmdPools[i];
 				addCmd(pRenderer, &cmdDesc, &pCmds[i]);
+				addCmd(pRenderer, &cmdDesc, &pFixupCmds[i]);
+				addCmdResourceStates(&pCmdResourceStates[i]);
 			}
+			addResourceStateTracker(&pResourceStateTracker);
 
 			for (uint32_t i = 0; i < gImageCount; ++i)
 			{
@@ -393,6 +402,10 @@ class Compute: public IApp
 
 		removePipeline(pRenderer, pPipeline);
 
+		untrackResourceState(pResourceStateTracker, pTextureComputeOutput);
+		for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+			untrackResourceState(pResourceStateTracker, pSwapChain->ppRenderTargets[i]);
+
 		removeResource(pTextureComputeOutput);
 		removeSwapChain(pRenderer, pSwapChain);
 
@@ -418,9 +431,12 @@ class Compute: public IApp
 
 			for (uint32_t i = 0; i < gImageCount; ++i)
 			{
+				removeCmdResourceStates(pCmdResourceStates[i]);
+				removeCmd(pRenderer, pFixupCmds[i]);
 				removeCmd(pRenderer, pCmds[i]);
 				removeCmdPool(pRenderer, pCmdPools[i]);
 			}
+			removeResourceStateTracker(pResourceStateTracker);
 
 			removeSampler(pRenderer, pSampler);
 
@@ -511,6 +527,9 @@ class Compute: public IApp
 		Cmd* cmd = pCmds[gFrameIndex];
 		beginCmd(cmd);
 
+		CmdResourceStates* pStates = pCmdResourceStates[gFrameIndex];
+		beginCmdResourceStates(pStates, cmd);
+
 		cmdBeginGpuFrameProfile(cmd, gGpuProfileToken);
 
 		BufferUpdateDesc cbvUpdate = { pUniformBuffer[gFrameIndex] };
@@ -523,6 +542,8 @@ class Compute: public IApp
 		cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Compute Pass");
 
 		// Compute Julia 4D
+		cmdTransitionResource(pStates, pTextureComputeOutput, RESOURCE_STATE_UNORDERED_ACCESS);
+		cmdFlushResourceStates(pStates);
 		cmdBindPipeline(cmd, pComputePipeline);
 		cmdBindDescriptorSet(cmd, 0, pDescriptorSetComputeTexture);
 		cmdBindDescriptorSet(cmd, gFrameIndex, pDescriptorSetUniforms);
@@ -533,13 +554,9 @@ class Compute: public IApp
 
 		cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
 
-		TextureBarrier barriers[] = {
-			{ pTextureComputeOutput, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_SHADER_RESOURCE },
-		};
-		RenderTargetBarrier rtBarriers[] = {
-			{ pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET },
-		};
-		cmdResourceBarrier(cmd, 0, NULL, 1, barriers, 1, rtBarriers);
+		cmdTransitionResource(pStates, pTextureComputeOutput, RESOURCE_STATE_SHADER_RESOURCE);
+		cmdTransitionResource(pStates, pRenderTarget, RESOURCE_STATE_RENDER_TARGET);
+		cmdFlushResourceStates(pStates);
 
 		cmdBindRenderTargets(cmd, 1, &pRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
 		cmdSetViewport(cmd, 0.0f, 0.0f, (float)mSettings.mWidth, (float)mSettings.mHeight, 0.0f, 1.0f);
@@ -565,18 +582,26 @@ class Compute: public IApp
 
 		cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
 
-		rtBarriers[0] = { pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT };
-		barriers[0] = { pTextureComputeOutput, RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS };
-		cmdResourceBarrier(cmd, 0, NULL, 1, barriers, 1, rtBarriers);
+		// The output texture stays readable, the fixup of the next frame moves it back to unordered access
+		cmdTransitionResource(pStates, pRenderTarget, RESOURCE_STATE_PRESENT);
+		cmdFlushResourceStates(pStates);
 
 		cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
 		endCmd(cmd);
 
+		// The states the first uses in cmd expect are only known to match now, at submit time
+		Cmd* fixupCmd = pFixupCmds[gFrameIndex];
+		beginCmd(fixupCmd);
+		const uint32_t fixupCount = resolveResourceStates(pResourceStateTracker, pStates, fixupCmd);
+		endCmd(fixupCmd);
+
+		Cmd* ppCmds[] = { fixupCmd, cmd };
+
 		QueueSubmitDesc submitDesc = {};
-		submitDesc.mCmdCount = 1;
+		submitDesc.mCmdCount = fixupCount ? 2 : 1;
 		submitDesc.mSignalSemaphoreCount = 1;
 		submitDesc.mWaitSemaphoreCount = 1;
-		submitDesc.ppCmds = &cmd;
+		submitDesc.ppCmds = fixupCount ? ppCmds : &cmd;
 		submitDesc.ppSignalSemaphores = &pRenderCompleteSemaphore;
 		submitDesc.ppWaitSemaphores = &pImageAcquiredSemaphore;
 		submitDesc.pSignalFence = pRenderCompleteFence;
@@ -620,8 +645,13 @@ class Compute: public IApp
 		swapChainDesc.mColorFormat = getRecommendedSwapchainFormat(true);
 		swapChainDesc.mEnableVsync = mSettings.mDefaultVSyncEnabled;
 		::addSwapChain(pRenderer, &swapChainDesc, &pSwapChain);
+		if (!pSwapChain)
+			return false;
 
-		return pSwapChain != NULL;
+		// Swap chain images are handed out ready to present
+		for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+			trackResourceState(pResourceStateTracker, pSwapChain->ppRenderTargets[i], RESOURCE_STATE_PRESENT);
+		return true;
 	}
 
 	bool addJuliaFractalUAV()
@@ -641,8 +671,11 @@ class Compute: public IApp
 		textureDesc.pDesc = &desc;
 		textureDesc.ppTexture = &pTextureComputeOutput;
 		addResource(&textureDesc, NULL);
+		if (!pTextureComputeOutput)
+			return false;
 
-		return pTextureComputeOutput != NULL;
+		trackResourceState(pResourceStateTracker, pTextureComputeOutput, desc.mStartState);
+		return true;
 	}
 
 	void Interpolate(float m[4], float t, float a[4], float b[4])
@@ -43,6 +43,7 @@
 #include "../../../../Common_3/OS/Interfaces/IInput.h"
 #include "../../../../Common_3/OS/Math/MathTypes.h"
 #include "../../../../Common_3/OS/Core/ThreadSystem.h"
+#include "../../../../Common_3/OS/Core/ParallelCmdRecorder.h"
 
 
 // for cpu usage query
@@ -79,8 +80,6 @@ struct ParticleData
 
 struct ThreadData
 {
-	CmdPool*          pCmdPool;
-	Cmd*              pCmd;
 	RenderTarget*     pRenderTarget;
 	int               mStartPoint;
 	int               mDrawCount;
@@ -137,8 +136,8 @@ CmdPool*  pCmdPool[gImageCount] = { NULL };
 Cmd*      ppCmds[gImageCount] = { NULL };
 Cmd*      ppGraphCmds[gImageCount] = { NULL };
 
-Cmd**     ppThreadCmds[gImageCount] = { NULL };
-CmdPool** pThreadCmdPools[gImageCount] = { NULL };
+// Cmds of the particle threads, one per thread and frame
+ParallelCmdRecorder* pParallelCmdRecorder = NULL;
 
 Fence*     pRenderCompleteFences[gImageCount] = { NULL };
 Semaphore* pImageAcquiredSemaphore = NULL;
@@ -390,18 +389,14 @@ class MultiThread: public IApp
 
 				addFence(pRenderer, &pRenderCompleteFences[i]);
 				addSemaphore(pRenderer, &pRenderCompleteSemaphores[i]);
-
-				ppThreadCmds[i] = (Cmd**)tf_malloc(gThreadCount * sizeof(Cmd*));
-				pThreadCmdPools[i] = (CmdPool**)tf_malloc(gThreadCount * sizeof(CmdPool*));
-
-				for (uint32_t t = 0; t < gThreadCount; ++t)
-				{
-					// create cmd pools and and cmdbuffers for all thread
-					addCmdPool(pRenderer, &cmdPoolDesc, &pThreadCmdPools[i][t]);
-					cmdDesc.pPool = pThreadCmdPools[i][t];
-					addCmd(pRenderer, &cmdDesc, &ppThreadCmds[i][t]);
-				}
 			}
+
+			ParallelCmdRecorderDesc recorderDesc = {};
+			recorderDesc.pQueue = pGraphicsQueue;
+			recorderDesc.pThreadSystem = pThreadSystem;
+			recorderDesc.mFrameCount = gImageCount;
+			recorderDesc.mMaxCmdsPerFrame = gThreadCount;
+			addParallelCmdRecorder(pRenderer, &recorderDesc, &pParallelCmdRecorder);
 			addSemaphore(pRenderer, &pImageAcquiredSemaphore);
 
 			HiresTimer timer;
@@ -822,16 +817,8 @@ class MultiThread: public IApp
 				removeCmd(pRenderer, ppCmds[i]);
 				removeCmd(pRenderer, ppGraphCmds[i]);
 				removeCmdPool(pRenderer, pCmdPool[i]);
-
-				for (uint32_t t = 0; t < gThreadCount; ++t)
-				{
-					removeCmd(pRenderer, ppThreadCmds[i][t]);
-					removeCmdPool(pRenderer, pThreadCmdPools[i][t]);
-				}
-
-				tf_free(ppThreadCmds[i]);
-				tf_free(pThreadCmdPools[i]);
 			}
+			removeParallelCmdRecorder(pParallelCmdRecorder);
 
 			removeSemaphore(pRenderer, pImageAcquiredSemaphore);
 			removeQueue(pRenderer, pGraphicsQueue);
@@ -931,6 +918,7 @@ class MultiThread: public IApp
 		uint32_t frameIdx = gFrameIndex;
 
 		resetCmdPool(pRenderer, pCmdPool[frameIdx]);
+		beginParallelCmdRecording(pParallelCmdRecorder, frameIdx);
 
 		SyncToken graphUpdateToken = {};
 
@@ -944,10 +932,9 @@ class MultiThread: public IApp
 		{
 			pThreadData[i].pRenderTarget = pRenderTarget;
 			pThreadData[i].mFrameIndex = frameIdx;
-			pThreadData[i].pCmdPool = pThreadCmdPools[gFrameIndex][i];
-			pThreadData[i].pCmd = ppThreadCmds[gFrameIndex][i];
 		}
-		addThreadSystemRangeTask(pThreadSystem, &MultiThread::ParticleThreadDraw, pThreadData, gThreadCount);
+		// The main thread helps recording and continues once every particle cmd is recorded
+		recordParallelCmds(pParallelCmdRecorder, gThreadCount, &MultiThread::ParticleThreadDraw, pThreadData);
 		// simply record the screen cleaning command
 
 		LoadActionsDesc loadActions = {};
@@ -1075,22 +1062,22 @@ class MultiThread: public IApp
 
 		cmdDrawProfilerUI();
 
-		// wait all particle threads done
-		waitThreadSystemIdle(pThreadSystem);
 		// Wait till graph buffers have been uploaded to the gpu
 		waitForToken(&graphUpdateToken);
 		/***************draw cpu graph*****************************/
 		/***************draw cpu graph*****************************/
 		// gather all command buffer, it is important to keep the screen clean command at the beginning
-		uint32_t cmdCount = gThreadCount + 2;
+		uint32_t particleCmdCount = 0;
+		Cmd**    ppParticleCmds = getParallelCmds(pParallelCmdRecorder, &particleCmdCount);
+		uint32_t cmdCount = particleCmdCount + 2;
 		Cmd** allCmds = (Cmd**)alloca(cmdCount * sizeof(Cmd*));
 		allCmds[0] = cmd;
 
-		for (uint32_t i = 0; i < gThreadCount; ++i)
+		for (uint32_t i = 0; i < particleCmdCount; ++i)
 		{
-			allCmds[i + 1] = pThreadData[i].pCmd;
+			allCmds[i + 1] = ppParticleCmds[i];
 		}
-		allCmds[gThreadCount + 1] = ppGraphCmds[frameIdx];
+		allCmds[particleCmdCount + 1] = ppGraphCmds[frameIdx];
 
 		QueueSubmitDesc submitDesc = {};
 		submitDesc.mCmdCount = cmdCount;
@@ -1535,16 +1522,13 @@ class MultiThread: public IApp
 		endUpdateResource(&vbUpdate, token);
 	}
 
-	// thread for recording particle draw
-	static void ParticleThreadDraw(void* pData, uintptr_t i)
+	// thread for recording particle draw, cmd is in recording state and ended by the recorder
+	static void ParticleThreadDraw(Cmd* cmd, uint32_t i, void* pData)
 	{
 		ThreadData& data = ((ThreadData*)pData)[i];
         if(data.mThreadID ==  Thread::mainThreadID)
             data.mThreadID = Thread::GetCurrentThreadID();
         //PROFILER_SET_CPU_SCOPE("Threads", "Cpu draw", 0xffffff);
-		Cmd*        cmd = data.pCmd;
-		resetCmdPool(pRenderer, data.pCmdPool);
-		beginCmd(cmd);
 		cmdBeginGpuFrameProfile(cmd, pGpuProfiletokens[data.mThreadIndex + 1]); // pGpuProfiletokens[0] is reserved for main thread
 
 		LoadActionsDesc loadActions = {};
@@ -1564,7 +1548,6 @@ class MultiThread: public IApp
 		cmdDrawInstanced(cmd, data.mDrawCount, data.mStartPoint, 1, 0);
 
 		cmdEndGpuFrameProfile(cmd, pGpuProfiletokens[data.mThreadIndex + 1]);  // pGpuProfiletokens[0] is reserved for main thread
-		endCmd(cmd);
 	}
 };
 
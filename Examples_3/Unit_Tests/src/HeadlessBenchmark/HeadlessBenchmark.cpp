@@ -0,0 +1,967 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Headless benchmark of CPU-side engine subsystems.
+//
+// Runs a fixed set of workloads without creating a window or a graphics device, every workload
+// seeds its own random number generator so runs are comparable. Results are written as JSON to
+// the log directory using the same naming conventions as the profiler benchmark report
+// (*Ms lower is better, *PerSecond higher is better) so Tools/BenchmarkCompare can diff them.
+//
+// Usage: HeadlessBenchmark [-iterations <n>] [-seed <n>] [-filter <name>] [-output <file>]
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/ITime.h"
+#include "../../../../Common_3/OS/Core/ThreadSystem.h"
+#include "../../../../Common_3/OS/Core/TextureContainers.h"
+#include "../../../../Common_3/OS/Core/VertexPacking.h"
+
+#include "../../../../Common_3/ThirdParty/OpenSource/cgltf/cgltf.h"
+#include "../../../../Common_3/ThirdParty/OpenSource/Fontstash/src/fontstash.h"
+
+//ECS
+#include "../../../../Middleware_3/ECS/EntityManager.h"
+#include "../17_EntityComponentSystem/Representations/WorldBoundsRepresentation.h"
+#include "../17_EntityComponentSystem/Representations/PositionRepresentation.h"
+#include "../17_EntityComponentSystem/Representations/MoveRepresentation.h"
+#include "../17_EntityComponentSystem/Components/WorldBoundsComponent.h"
+#include "../17_EntityComponentSystem/Components/PositionComponent.h"
+#include "../17_EntityComponentSystem/Components/MoveComponent.h"
+
+//Animation
+#include "../../../../Middleware_3/Animation/AnimatedObject.h"
+#include "../../../../Middleware_3/Animation/Animation.h"
+#include "../../../../Middleware_3/Animation/Clip.h"
+#include "../../../../Middleware_3/Animation/ClipController.h"
+#include "../../../../Middleware_3/Animation/Rig.h"
+
+//Lua
+#include "../../../../Middleware_3/LUA/LuaManager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"    // Must be the last include in a cpp file
+
+const char* gApplicationName = "HeadlessBenchmark";
+
+static uint32_t    gIterations = 32;
+static uint32_t    gWarmupIterations = 2;
+static uint32_t    gSeed = 0x1234;
+static const char* pFilter = NULL;
+static const char* pOutputFile = NULL;
+
+static ThreadSystem* pThreadSystem = NULL;
+
+/************************************************************************/
+// Fixed seed random numbers (xorshift32), independent of the CRT so results match across platforms
+/************************************************************************/
+static uint32_t gRandomState = 1;
+
+static void benchmarkSeed(uint32_t seed) { gRandomState = seed ? seed : 1; }
+
+static uint32_t benchmarkRandom(uint32_t* pState)
+{
+	uint32_t x = *pState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*pState = x;
+	return x;
+}
+
+static float benchmarkRandomFloat(float min, float max)
+{
+	return min + (max - min) * ((float)(benchmarkRandom(&gRandomState) & 0xFFFFFF) / (float)0xFFFFFF);
+}
+
+static void* readWholeFile(ResourceDirectory resourceDir, const char* pFileName, uint32_t* pOutSize)
+{
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(resourceDir, pFileName, FM_READ_BINARY, &stream))
+	{
+		LOGF(eERROR, "Failed to open %s", pFileName);
+		return NULL;
+	}
+
+	ssize_t size = fsGetStreamFileSize(&stream);
+	void*   pData = tf_malloc(size);
+	fsReadFromStream(&stream, pData, size);
+	fsCloseStream(&stream);
+	*pOutSize = (uint32_t)size;
+	return pData;
+}
+
+/************************************************************************/
+// ThreadSystem
+/************************************************************************/
+#define BENCHMARK_TASK_COUNT 4096
+#define BENCHMARK_TASK_BATCH 64
+
+static uint32_t gTaskInputs[BENCHMARK_TASK_COUNT];
+static uint32_t gTaskOutputs[BENCHMARK_TASK_COUNT];
+
+static void hashTask(void* pUser, uintptr_t index)
+{
+	uint32_t hash = gTaskInputs[index];
+	for (uint32_t i = 0; i < 64; ++i)
+		hash = (hash ^ i) * 16777619u;
+	gTaskOutputs[index] = hash;
+}
+
+static bool threadSystemInit()
+{
+	benchmarkSeed(gSeed);
+	for (uint32_t i = 0; i < BENCHMARK_TASK_COUNT; ++i)
+		gTaskInputs[i] = benchmarkRandom(&gRandomState);
+	return true;
+}
+
+static void threadSystemExit() {}
+
+// One range task, the workers pick the indices one by one
+static void threadSystemRangeRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	addThreadSystemRangeTask(pThreadSystem, hashTask, NULL, BENCHMARK_TASK_COUNT);
+	waitThreadSystemIdle(pThreadSystem);
+	*pItems += BENCHMARK_TASK_COUNT;
+}
+
+// Individual tasks submitted in batches, the queue only holds MAX_SYSTEM_TASKS entries
+static void threadSystemTasksRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	for (uint32_t batch = 0; batch < BENCHMARK_TASK_COUNT; batch += BENCHMARK_TASK_BATCH)
+	{
+		for (uint32_t i = 0; i < BENCHMARK_TASK_BATCH; ++i)
+			addThreadSystemTask(pThreadSystem, hashTask, NULL, batch + i);
+		waitThreadSystemIdle(pThreadSystem);
+	}
+	*pItems += BENCHMARK_TASK_COUNT;
+}
+
+/************************************************************************/
+// Memory allocation from all worker threads
+/************************************************************************/
+#define BENCHMARK_MEMORY_SLOTS 256
+#define BENCHMARK_MEMORY_OPERATIONS 8192
+
+static uint32_t gMemoryTaskCount = 0;
+
+static void memoryTask(void* pUser, uintptr_t index)
+{
+	uint32_t state = gSeed + (uint32_t)index * 7919u + 1u;
+	void*    slots[BENCHMARK_MEMORY_SLOTS] = {};
+
+	for (uint32_t i = 0; i < BENCHMARK_MEMORY_OPERATIONS; ++i)
+	{
+		uint32_t r = benchmarkRandom(&state);
+		uint32_t slot = r % BENCHMARK_MEMORY_SLOTS;
+		size_t   size = 16 + ((r >> 8) & 4095);
+		if (!slots[slot])
+			slots[slot] = (r & 0x10000) ? tf_memalign(64, size) : tf_malloc(size);
+		else if (r & 0x20000)
+			slots[slot] = tf_realloc(slots[slot], size);
+		else
+		{
+			tf_free(slots[slot]);
+			slots[slot] = NULL;
+		}
+	}
+
+	for (uint32_t i = 0; i < BENCHMARK_MEMORY_SLOTS; ++i)
+		tf_free(slots[i]);
+}
+
+static bool memoryInit()
+{
+	gMemoryTaskCount = getThreadSystemThreadCount(pThreadSystem) * 2;
+	return gMemoryTaskCount > 0;
+}
+
+static void memoryExit() {}
+
+static void memoryRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	addThreadSystemRangeTask(pThreadSystem, memoryTask, NULL, gMemoryTaskCount);
+	waitThreadSystemIdle(pThreadSystem);
+	*pItems += (uint64_t)gMemoryTaskCount * BENCHMARK_MEMORY_OPERATIONS;
+}
+
+/************************************************************************/
+// File system reads
+/************************************************************************/
+static const char* gFileReadNames[] = {
+	"Skybox_back6.dds", "Skybox_bottom4.dds", "Skybox_front5.dds", "Skybox_left2.dds", "Skybox_right1.dds", "Skybox_top3.dds",
+	"Palette_Fire.dds", "Palette_Muted.dds", "Palette_Purple.dds", "Palette_Rainbow.dds", "Palette_Sky.dds", "grid.dds",
+};
+#define BENCHMARK_FILE_CHUNK_SIZE (64 * 1024)
+
+static void* pFileReadBuffer = NULL;
+
+static bool fileSystemInit()
+{
+	pFileReadBuffer = tf_malloc(BENCHMARK_FILE_CHUNK_SIZE);
+	return pFileReadBuffer != NULL;
+}
+
+static void fileSystemExit()
+{
+	tf_free(pFileReadBuffer);
+	pFileReadBuffer = NULL;
+}
+
+// Open, read in fixed size chunks and close, like the resource loader streams textures
+static void fileSystemRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	for (uint32_t i = 0; i < sizeof(gFileReadNames) / sizeof(gFileReadNames[0]); ++i)
+	{
+		FileStream stream = {};
+		if (!fsOpenStreamFromPath(RD_TEXTURES, gFileReadNames[i], FM_READ_BINARY, &stream))
+			continue;
+
+		size_t read = 0;
+		while ((read = fsReadFromStream(&stream, pFileReadBuffer, BENCHMARK_FILE_CHUNK_SIZE)) > 0)
+			*pBytes += read;
+		fsCloseStream(&stream);
+		++*pItems;
+	}
+}
+
+/************************************************************************/
+// glTF parsing and vertex packing
+/************************************************************************/
+static const char* gGltfNames[] = { "FlightHelmet.gltf", "Lantern.gltf", "matBall.gltf" };
+#define BENCHMARK_GLTF_COUNT (sizeof(gGltfNames) / sizeof(gGltfNames[0]))
+
+static void*        pGltfFiles[BENCHMARK_GLTF_COUNT] = {};
+static uint32_t     gGltfFileSizes[BENCHMARK_GLTF_COUNT] = {};
+static cgltf_data*  pGltfData[BENCHMARK_GLTF_COUNT] = {};
+static uint8_t*     pPackedVertices = NULL;
+
+static cgltf_options gltfOptions()
+{
+	cgltf_options options = {};
+	options.memory_alloc = [](void* user, cgltf_size size) { return tf_malloc(size); };
+	options.memory_free = [](void* user, void* ptr) { tf_free(ptr); };
+	return options;
+}
+
+static void gltfExit()
+{
+	for (uint32_t i = 0; i < BENCHMARK_GLTF_COUNT; ++i)
+	{
+		if (pGltfData[i])
+			cgltf_free(pGltfData[i]);
+		tf_free(pGltfFiles[i]);
+		pGltfData[i] = NULL;
+		pGltfFiles[i] = NULL;
+	}
+	tf_free(pPackedVertices);
+	pPackedVertices = NULL;
+}
+
+static bool gltfInit()
+{
+	cgltf_options options = gltfOptions();
+	size_t        maxVertexCount = 0;
+
+	for (uint32_t i = 0; i < BENCHMARK_GLTF_COUNT; ++i)
+	{
+		pGltfFiles[i] = readWholeFile(RD_MESHES, gGltfNames[i], &gGltfFileSizes[i]);
+		if (!pGltfFiles[i])
+			return false;
+
+		if (cgltf_parse(&options, pGltfFiles[i], gGltfFileSizes[i], &pGltfData[i]) != cgltf_result_success)
+		{
+			LOGF(eERROR, "Failed to parse %s", gGltfNames[i]);
+			return false;
+		}
+
+		// Same as the resource loader: buffers next to the .gltf are loaded through our file system
+		cgltf_data* data = pGltfData[i];
+		for (uint32_t b = 0; b < data->buffers_count; ++b)
+		{
+			const char* uri = data->buffers[b].uri;
+			if (!uri || data->buffers[b].data || !strncmp(uri, "data:", 5))
+				continue;
+
+			uint32_t size = 0;
+			data->buffers[b].data = readWholeFile(RD_MESHES, uri, &size);
+			if (!data->buffers[b].data || size < data->buffers[b].size)
+				return false;
+		}
+
+		for (uint32_t m = 0; m < data->meshes_count; ++m)
+			for (uint32_t p = 0; p < data->meshes[m].primitives_count; ++p)
+				for (uint32_t a = 0; a < data->meshes[m].primitives[p].attributes_count; ++a)
+					maxVertexCount = max(maxVertexCount, (size_t)data->meshes[m].primitives[p].attributes[a].data->count);
+	}
+
+	pPackedVertices = (uint8_t*)tf_malloc(maxVertexCount * sizeof(uint32_t));
+	return true;
+}
+
+static void gltfParseRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	cgltf_options options = gltfOptions();
+	for (uint32_t i = 0; i < BENCHMARK_GLTF_COUNT; ++i)
+	{
+		cgltf_data* data = NULL;
+		if (cgltf_parse(&options, pGltfFiles[i], gGltfFileSizes[i], &data) == cgltf_result_success)
+		{
+			cgltf_free(data);
+			++*pItems;
+			*pBytes += gGltfFileSizes[i];
+		}
+	}
+}
+
+// Packs texcoords to half2 and normals / tangents to octahedral unorm2x16 with the resource loader functions
+static void vertexPackingRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	for (uint32_t i = 0; i < BENCHMARK_GLTF_COUNT; ++i)
+	{
+		const cgltf_data* data = pGltfData[i];
+		for (uint32_t m = 0; m < data->meshes_count; ++m)
+		{
+			for (uint32_t p = 0; p < data->meshes[m].primitives_count; ++p)
+			{
+				const cgltf_primitive& primitive = data->meshes[m].primitives[p];
+				for (uint32_t a = 0; a < primitive.attributes_count; ++a)
+				{
+					const cgltf_attribute& attr = primitive.attributes[a];
+					const cgltf_accessor*  accessor = attr.data;
+					if (!accessor->buffer_view || accessor->component_type != cgltf_component_type_r_32f)
+						continue;
+
+					const uint8_t* src =
+						(const uint8_t*)accessor->buffer_view->buffer->data + accessor->buffer_view->offset + accessor->offset;
+					const uint32_t count = (uint32_t)accessor->count;
+					const uint32_t stride = (uint32_t)accessor->stride;
+
+					if (cgltf_attribute_type_texcoord == attr.type && cgltf_type_vec2 == accessor->type)
+						util_pack_float2_to_half2(count, stride, 0, src, pPackedVertices);
+					else if ((cgltf_attribute_type_normal == attr.type || cgltf_attribute_type_tangent == attr.type) &&
+							 (cgltf_type_vec3 == accessor->type || cgltf_type_vec4 == accessor->type))
+						util_pack_float3_direction_to_half2(count, stride, 0, src, pPackedVertices);
+					else
+						continue;
+
+					*pItems += count;
+					*pBytes += (uint64_t)count * stride;
+				}
+			}
+		}
+	}
+}
+
+/************************************************************************/
+// Texture containers
+/************************************************************************/
+typedef struct BenchmarkTextureFile
+{
+	const char* pName;
+	void*       pData;
+	uint32_t    mSize;
+} BenchmarkTextureFile;
+
+static BenchmarkTextureFile gDdsFiles[] = {
+	{ "Skybox_back6.dds", NULL, 0 },
+	{ "Palette_Fire.dds", NULL, 0 },
+	{ "grid.dds", NULL, 0 },
+	{ "curlNoise.dds", NULL, 0 },
+	{ "environment_sky.dds", NULL, 0 },
+	{ "sprites.dds", NULL, 0 },
+};
+static BenchmarkTextureFile gKtxFiles[] = {
+	{ "Skybox_back6.ktx", NULL, 0 },
+	{ "Palette_Fire.ktx", NULL, 0 },
+	{ "grid.ktx", NULL, 0 },
+	{ "curlNoise.ktx", NULL, 0 },
+	{ "environment_sky.ktx", NULL, 0 },
+	{ "sprites.ktx", NULL, 0 },
+};
+static BenchmarkTextureFile gBasisFiles[] = {
+	{ "Lantern_emissive.basis", NULL, 0 },
+	{ "Lantern_roughnessMetallic.basis", NULL, 0 },
+};
+
+static bool loadTextureFiles(BenchmarkTextureFile* pFiles, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		pFiles[i].pData = readWholeFile(RD_TEXTURES, pFiles[i].pName, &pFiles[i].mSize);
+		if (!pFiles[i].pData)
+			return false;
+	}
+	return true;
+}
+
+static void unloadTextureFiles(BenchmarkTextureFile* pFiles, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		tf_free(pFiles[i].pData);
+		pFiles[i].pData = NULL;
+	}
+}
+
+#define TEXTURE_FILE_FUNCTIONS(name, files)                                                           \
+	static bool name##Init() { return loadTextureFiles(files, sizeof(files) / sizeof(files[0])); } \
+	static void name##Exit() { unloadTextureFiles(files, sizeof(files) / sizeof(files[0])); }
+
+TEXTURE_FILE_FUNCTIONS(dds, gDdsFiles)
+TEXTURE_FILE_FUNCTIONS(ktx, gKtxFiles)
+TEXTURE_FILE_FUNCTIONS(basis, gBasisFiles)
+
+// Header parsing is cheap, each file is parsed several times so the iteration is long enough to time
+#define BENCHMARK_TEXTURE_PARSE_REPEAT 512
+
+static void parseTextureFiles(
+	BenchmarkTextureFile* pFiles, uint32_t count, bool (*pParse)(FileStream*, TextureDesc*), uint64_t* pItems, uint64_t* pBytes)
+{
+	for (uint32_t i = 0; i < count * BENCHMARK_TEXTURE_PARSE_REPEAT; ++i)
+	{
+		FileStream stream = {};
+		const BenchmarkTextureFile& file = pFiles[i % count];
+		fsOpenStreamFromMemory(file.pData, file.mSize, FM_READ_BINARY, false, &stream);
+		TextureDesc desc = {};
+		if (pParse(&stream, &desc))
+		{
+			++*pItems;
+			*pBytes += file.mSize;
+		}
+		fsCloseStream(&stream);
+	}
+}
+
+static void ddsRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	parseTextureFiles(gDdsFiles, sizeof(gDdsFiles) / sizeof(gDdsFiles[0]), loadDDSTextureDesc, pItems, pBytes);
+}
+
+static void ktxRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	parseTextureFiles(gKtxFiles, sizeof(gKtxFiles) / sizeof(gKtxFiles[0]), loadKTXTextureDesc, pItems, pBytes);
+}
+
+// Basis files are transcoded to the runtime format, bytes are the transcoded output
+static void basisRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	for (uint32_t i = 0; i < sizeof(gBasisFiles) / sizeof(gBasisFiles[0]); ++i)
+	{
+		FileStream stream = {};
+		fsOpenStreamFromMemory(gBasisFiles[i].pData, gBasisFiles[i].mSize, FM_READ_BINARY, false, &stream);
+		TextureDesc desc = {};
+		void*       pData = NULL;
+		uint32_t    dataSize = 0;
+		if (loadBASISTextureDesc(&stream, &desc, &pData, &dataSize))
+		{
+			++*pItems;
+			*pBytes += dataSize;
+			tf_free(pData);
+		}
+		fsCloseStream(&stream);
+	}
+}
+
+/************************************************************************/
+// ECS, the move system of 17_EntityComponentSystem on a fixed entity set
+/************************************************************************/
+#define BENCHMARK_ENTITY_COUNT 16384
+#define BENCHMARK_ENTITY_STEPS 8
+
+static EntityManager*        pEntityManager = NULL;
+static Entity*               pEntities[BENCHMARK_ENTITY_COUNT] = {};
+static WorldBoundsComponent* pWorldBounds = NULL;
+
+static bool ecsInit()
+{
+	MoveComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+	PositionComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+	WorldBoundsComponentRepresentation::BUILD_VAR_REPRESENTATIONS();
+
+	pEntityManager = tf_new(EntityManager);
+
+	EntityId worldBoundsEntityId = pEntityManager->createEntity();
+	pWorldBounds = &(pEntityManager->addComponentToEntity<WorldBoundsComponent>(worldBoundsEntityId));
+	pWorldBounds->xMin = -80.0f;
+	pWorldBounds->xMax = 80.0f;
+	pWorldBounds->yMin = -50.0f;
+	pWorldBounds->yMax = 50.0f;
+
+	benchmarkSeed(gSeed);
+	for (uint32_t i = 0; i < BENCHMARK_ENTITY_COUNT; ++i)
+	{
+		EntityId entityId = pEntityManager->createEntity();
+		pEntities[i] = pEntityManager->getEntityById(entityId);
+
+		PositionComponent& position = pEntityManager->addComponentToEntity<PositionComponent>(entityId);
+		position.x = benchmarkRandomFloat(pWorldBounds->xMin, pWorldBounds->xMax);
+		position.y = benchmarkRandomFloat(pWorldBounds->yMin, pWorldBounds->yMax);
+
+		MoveComponent& move = pEntityManager->addComponentToEntity<MoveComponent>(entityId);
+		move.velx = benchmarkRandomFloat(-5.0f, 5.0f);
+		move.vely = benchmarkRandomFloat(-5.0f, 5.0f);
+	}
+	return true;
+}
+
+static void ecsExit()
+{
+	tf_delete(pEntityManager);
+	pEntityManager = NULL;
+	pWorldBounds = NULL;
+
+	MoveComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+	PositionComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+	WorldBoundsComponentRepresentation::DESTROY_VAR_REPRESENTATIONS();
+}
+
+static void ecsRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	const WorldBoundsComponent& bounds = *pWorldBounds;
+	const float                 deltaTime = 1.0f / 60.0f;
+
+	for (uint32_t step = 0; step < BENCHMARK_ENTITY_STEPS; ++step)
+	{
+		for (uint32_t i = 0; i < BENCHMARK_ENTITY_COUNT; ++i)
+		{
+			PositionComponent& position = *(pEntities[i]->getComponent<PositionComponent>());
+			MoveComponent&     move = *(pEntities[i]->getComponent<MoveComponent>());
+
+			position.x += move.velx * deltaTime;
+			position.y += move.vely * deltaTime;
+
+			if (position.x < bounds.xMin || position.x > bounds.xMax)
+			{
+				move.velx = -move.velx;
+				position.x = clamp(position.x, bounds.xMin, bounds.xMax);
+			}
+			if (position.y < bounds.yMin || position.y > bounds.yMax)
+			{
+				move.vely = -move.vely;
+				position.y = clamp(position.y, bounds.yMin, bounds.yMax);
+			}
+		}
+	}
+	*pItems += (uint64_t)BENCHMARK_ENTITY_COUNT * BENCHMARK_ENTITY_STEPS;
+}
+
+/************************************************************************/
+// Animation sampling of the stick figure, one rig shared by all instances
+/************************************************************************/
+#define BENCHMARK_ANIMATION_INSTANCES 64
+#define BENCHMARK_ANIMATION_STEPS 4
+
+static Rig            gRig;
+static Clip           gClip;
+static ClipController gClipControllers[BENCHMARK_ANIMATION_INSTANCES];
+static Animation      gAnimations[BENCHMARK_ANIMATION_INSTANCES];
+static AnimatedObject gAnimatedObjects[BENCHMARK_ANIMATION_INSTANCES];
+
+static bool animationInit()
+{
+	gRig.Initialize(RD_ANIMATIONS, "stickFigure/skeleton.ozz");
+	gClip.Initialize(RD_ANIMATIONS, "stickFigure/animations/walk.ozz", &gRig);
+
+	benchmarkSeed(gSeed);
+	for (uint32_t i = 0; i < BENCHMARK_ANIMATION_INSTANCES; ++i)
+	{
+		gClipControllers[i].Initialize(gClip.GetDuration());
+		// Spread the instances over the clip so they do not all sample the same keys
+		gClipControllers[i].SetTimeRatioHard(benchmarkRandomFloat(0.0f, 1.0f));
+
+		AnimationDesc animationDesc{};
+		animationDesc.mRig = &gRig;
+		animationDesc.mNumLayers = 1;
+		animationDesc.mLayerProperties[0].mClip = &gClip;
+		animationDesc.mLayerProperties[0].mClipController = &gClipControllers[i];
+		gAnimations[i].Initialize(animationDesc);
+
+		gAnimatedObjects[i].Initialize(&gRig, &gAnimations[i]);
+	}
+	return true;
+}
+
+static void animationExit()
+{
+	for (uint32_t i = 0; i < BENCHMARK_ANIMATION_INSTANCES; ++i)
+	{
+		gAnimatedObjects[i].Destroy();
+		gAnimations[i].Destroy();
+	}
+	gClip.Destroy();
+	gRig.Destroy();
+}
+
+static void animationRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	for (uint32_t step = 0; step < BENCHMARK_ANIMATION_STEPS; ++step)
+	{
+		for (uint32_t i = 0; i < BENCHMARK_ANIMATION_INSTANCES; ++i)
+		{
+			if (gAnimatedObjects[i].Update(1.0f / 60.0f))
+			{
+				gAnimatedObjects[i].PoseRig();
+				++*pItems;
+			}
+		}
+	}
+}
+
+/************************************************************************/
+// Lua, script update calling back into a native function
+/************************************************************************/
+static LuaManager* pLuaManager = NULL;
+static double      gLuaAccumulator = 0.0;
+static uint64_t    gLuaCalls = 0;
+
+static bool luaInit()
+{
+	pLuaManager = tf_new(LuaManager);
+	pLuaManager->Init();
+	pLuaManager->SetFunction("BenchmarkAccumulate", [](ILuaStateWrap* state) -> int {
+		gLuaAccumulator += state->GetNumberArg(1);
+		++gLuaCalls;
+		state->PushResultNumber(gLuaAccumulator);
+		return 1;
+	});
+	return pLuaManager->SetUpdatableScript("Benchmark.lua", "Update", "Exit");
+}
+
+static void luaExit()
+{
+	pLuaManager->Exit();
+	tf_delete(pLuaManager);
+	pLuaManager = NULL;
+}
+
+static void luaRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	gLuaCalls = 0;
+	for (uint32_t i = 0; i < 64; ++i)
+		pLuaManager->Update(1.0f / 60.0f);
+	*pItems += gLuaCalls;
+}
+
+/************************************************************************/
+// Font rasterization, every iteration starts from an empty atlas
+/************************************************************************/
+#define BENCHMARK_FONT_ATLAS_SIZE 1024
+
+static const float gFontSizes[] = { 12.0f, 16.0f, 24.0f, 32.0f, 48.0f };
+
+static FONScontext* pFontContext = NULL;
+static void*        pFontData = NULL;
+static int          gFontId = FONS_INVALID;
+static char         gFontText[128] = {};
+
+static bool fontInit()
+{
+	FONSparams params = {};
+	params.width = BENCHMARK_FONT_ATLAS_SIZE;
+	params.height = BENCHMARK_FONT_ATLAS_SIZE;
+	params.flags = (unsigned char)FONS_ZERO_TOPLEFT;
+	pFontContext = fonsCreateInternal(&params);
+	if (!pFontContext)
+		return false;
+
+	uint32_t size = 0;
+	pFontData = readWholeFile(RD_FONTS, "TitilliumText/TitilliumText-Bold.otf", &size);
+	if (!pFontData)
+		return false;
+	gFontId = fonsAddFontMem(pFontContext, "TitilliumText", (unsigned char*)pFontData, (int)size, 0);
+
+	// Printable ASCII, every glyph is rasterized once per size
+	uint32_t length = 0;
+	for (char c = '!'; c <= '~'; ++c)
+		gFontText[length++] = c;
+	gFontText[length] = '\0';
+
+	return gFontId != FONS_INVALID;
+}
+
+static void fontExit()
+{
+	if (pFontContext)
+		fonsDeleteInternal(pFontContext);
+	pFontContext = NULL;
+	tf_free(pFontData);
+	pFontData = NULL;
+}
+
+static void fontRun(uint64_t* pItems, uint64_t* pBytes)
+{
+	fonsResetAtlas(pFontContext, BENCHMARK_FONT_ATLAS_SIZE, BENCHMARK_FONT_ATLAS_SIZE);
+	fonsClearState(pFontContext);
+	fonsSetFont(pFontContext, gFontId);
+
+	for (uint32_t i = 0; i < sizeof(gFontSizes) / sizeof(gFontSizes[0]); ++i)
+	{
+		fonsSetSize(pFontContext, gFontSizes[i]);
+		fonsTextBounds(pFontContext, 0.0f, 0.0f, gFontText, NULL, NULL);
+		*pItems += strlen(gFontText);
+	}
+}
+
+/************************************************************************/
+// Benchmark driver
+/************************************************************************/
+typedef struct BenchmarkWorkload
+{
+	const char* pName;
+	// Reported as <pItemName>PerSecond
+	const char* pItemName;
+	bool (*pInit)();
+	void (*pExit)();
+	// One iteration, adds the number of processed items and bytes
+	void (*pRun)(uint64_t* pItems, uint64_t* pBytes);
+} BenchmarkWorkload;
+
+static const BenchmarkWorkload gWorkloads[] = {
+	{ "threadSystemRange", "tasks", threadSystemInit, threadSystemExit, threadSystemRangeRun },
+	{ "threadSystemTasks", "tasks", threadSystemInit, threadSystemExit, threadSystemTasksRun },
+	{ "memoryAllocation", "operations", memoryInit, memoryExit, memoryRun },
+	{ "fileSystemRead", "files", fileSystemInit, fileSystemExit, fileSystemRun },
+	{ "gltfParse", "files", gltfInit, gltfExit, gltfParseRun },
+	{ "vertexPacking", "vertices", gltfInit, gltfExit, vertexPackingRun },
+	{ "ddsParse", "files", ddsInit, ddsExit, ddsRun },
+	{ "ktxParse", "files", ktxInit, ktxExit, ktxRun },
+	{ "basisTranscode", "files", basisInit, basisExit, basisRun },
+	{ "ecsMove", "entities", ecsInit, ecsExit, ecsRun },
+	{ "animationSample", "instances", animationInit, animationExit, animationRun },
+	{ "luaCall", "calls", luaInit, luaExit, luaRun },
+	{ "fontRasterize", "glyphs", fontInit, fontExit, fontRun },
+};
+#define BENCHMARK_WORKLOAD_COUNT (sizeof(gWorkloads) / sizeof(gWorkloads[0]))
+
+typedef struct BenchmarkResult
+{
+	bool     mValid;
+	double   mAverageMs;
+	double   mMinMs;
+	double   mMaxMs;
+	double   mP50Ms;
+	double   mP90Ms;
+	uint64_t mItems;
+	uint64_t mBytes;
+	double   mTotalMs;
+} BenchmarkResult;
+
+static int compareDouble(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Nearest rank on sorted samples
+static double percentile(const double* pSorted, uint32_t count, double p)
+{
+	uint32_t rank = (uint32_t)ceil(p * count);
+	return pSorted[rank ? min(rank, count) - 1 : 0];
+}
+
+static void runWorkload(const BenchmarkWorkload* pWorkload, BenchmarkResult* pResult)
+{
+	*pResult = {};
+	if (!pWorkload->pInit())
+	{
+		LOGF(eERROR, "Benchmark %s failed to initialize, skipped", pWorkload->pName);
+		pWorkload->pExit();
+		return;
+	}
+
+	for (uint32_t i = 0; i < gWarmupIterations; ++i)
+	{
+		uint64_t items = 0, bytes = 0;
+		pWorkload->pRun(&items, &bytes);
+	}
+
+	double* pSamples = (double*)tf_malloc(gIterations * sizeof(double));
+	for (uint32_t i = 0; i < gIterations; ++i)
+	{
+		int64_t start = getUSec();
+		pWorkload->pRun(&pResult->mItems, &pResult->mBytes);
+		pSamples[i] = (double)(getUSec() - start) / 1000.0;
+		pResult->mTotalMs += pSamples[i];
+	}
+	pWorkload->pExit();
+
+	qsort(pSamples, gIterations, sizeof(double), compareDouble);
+	pResult->mValid = true;
+	pResult->mAverageMs = pResult->mTotalMs / gIterations;
+	pResult->mMinMs = pSamples[0];
+	pResult->mMaxMs = pSamples[gIterations - 1];
+	pResult->mP50Ms = percentile(pSamples, gIterations, 0.5);
+	pResult->mP90Ms = percentile(pSamples, gIterations, 0.9);
+	tf_free(pSamples);
+
+	LOGF(
+		eINFO, "%-20s avg %8.3f ms  min %8.3f ms  p90 %8.3f ms  %12.0f %s/s", pWorkload->pName, pResult->mAverageMs, pResult->mMinMs,
+		pResult->mP90Ms, pResult->mTotalMs > 0.0 ? pResult->mItems * 1000.0 / pResult->mTotalMs : 0.0, pWorkload->pItemName);
+}
+
+static void writeJson(FileStream* pStream, const char* pFormat, ...)
+{
+	char    buffer[512];
+	va_list args;
+	va_start(args, pFormat);
+	int length = vsnprintf(buffer, sizeof(buffer), pFormat, args);
+	va_end(args);
+	if (length > 0)
+		fsWriteToStream(pStream, buffer, min((size_t)length, sizeof(buffer) - 1));
+}
+
+static bool writeResults(const BenchmarkResult* pResults)
+{
+	char fileName[FS_MAX_PATH] = {};
+	if (pOutputFile)
+	{
+		strncpy(fileName, pOutputFile, sizeof(fileName) - 1);
+	}
+	else
+	{
+		time_t    t = time(NULL);
+		struct tm* timeInfo = localtime(&t);
+		char      date[64] = {};
+		strftime(date, sizeof(date), "%Y-%m-%d-%H.%M.%S", timeInfo);
+		snprintf(fileName, sizeof(fileName), "%s-%s.json", gApplicationName, date);
+	}
+
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_LOG, fileName, FM_WRITE, &stream))
+	{
+		LOGF(eERROR, "Failed to open %s for writing", fileName);
+		return false;
+	}
+
+	writeJson(&stream, "{\n\t\"application\": \"%s\",\n", gApplicationName);
+	writeJson(&stream, "\t\"seed\": %u,\n\t\"iterations\": %u,\n", gSeed, gIterations);
+	writeJson(&stream, "\t\"threads\": %u,\n", getThreadSystemThreadCount(pThreadSystem));
+	writeJson(&stream, "\t\"benchmarks\": {");
+
+	bool first = true;
+	for (uint32_t i = 0; i < BENCHMARK_WORKLOAD_COUNT; ++i)
+	{
+		const BenchmarkResult& result = pResults[i];
+		if (!result.mValid)
+			continue;
+
+		const double seconds = result.mTotalMs / 1000.0;
+		writeJson(&stream, "%s\n\t\t\"%s\": {\n", first ? "" : ",", gWorkloads[i].pName);
+		writeJson(
+			&stream, "\t\t\t\"averageMs\": %.4f,\n\t\t\t\"minMs\": %.4f,\n\t\t\t\"maxMs\": %.4f,\n", result.mAverageMs, result.mMinMs,
+			result.mMaxMs);
+		writeJson(&stream, "\t\t\t\"p50Ms\": %.4f,\n\t\t\t\"p90Ms\": %.4f,\n", result.mP50Ms, result.mP90Ms);
+		writeJson(&stream, "\t\t\t\"%sPerIteration\": %llu", gWorkloads[i].pItemName, (unsigned long long)(result.mItems / gIterations));
+		if (seconds > 0.0)
+		{
+			writeJson(&stream, ",\n\t\t\t\"%sPerSecond\": %.1f", gWorkloads[i].pItemName, result.mItems / seconds);
+			if (result.mBytes)
+				writeJson(&stream, ",\n\t\t\t\"bytesPerSecond\": %.1f", result.mBytes / seconds);
+		}
+		writeJson(&stream, "\n\t\t}");
+		first = false;
+	}
+
+	writeJson(&stream, "\n\t}\n}\n");
+	fsCloseStream(&stream);
+
+	LOGF(eINFO, "Benchmark results written to %s", fileName);
+	return true;
+}
+
+static int HeadlessBenchmark(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-iterations") && i + 1 < argc)
+			gIterations = max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "-seed") && i + 1 < argc)
+			gSeed = (uint32_t)strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-filter") && i + 1 < argc)
+			pFilter = argv[++i];
+		else if (!strcmp(argv[i], "-output") && i + 1 < argc)
+			pOutputFile = argv[++i];
+		else
+		{
+			LOGF(eERROR, "Usage: %s [-iterations <n>] [-seed <n>] [-filter <name>] [-output <file>]", gApplicationName);
+			return EXIT_FAILURE;
+		}
+	}
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_TEXTURES, "Textures");
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_MESHES, "Meshes");
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_FONTS, "Fonts");
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_ANIMATIONS, "Animation");
+	fsSetPathForResourceDir(pSystemFileIO, RM_CONTENT, RD_SCRIPTS, "Scripts");
+
+	initThreadSystem(&pThreadSystem);
+
+	BenchmarkResult results[BENCHMARK_WORKLOAD_COUNT] = {};
+	for (uint32_t i = 0; i < BENCHMARK_WORKLOAD_COUNT; ++i)
+	{
+		if (pFilter && !strstr(gWorkloads[i].pName, pFilter))
+			continue;
+		runWorkload(&gWorkloads[i], &results[i]);
+	}
+
+	bool written = writeResults(results);
+
+	shutdownThreadSystem(pThreadSystem);
+	return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char** argv)
+{
+	extern bool MemAllocInit(const char*);
+	extern void MemAllocExit();
+
+	if (!MemAllocInit(gApplicationName))
+		return EXIT_FAILURE;
+
+	FileSystemInitDesc fsDesc = {};
+	fsDesc.pAppName = gApplicationName;
+	if (!initFileSystem(&fsDesc))
+		return EXIT_FAILURE;
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_LOG, "");
+
+	Log::Init(gApplicationName);
+
+	int ret = HeadlessBenchmark(argc, argv);
+
+	Log::Exit();
+	exitFileSystem();
+	MemAllocExit();
+
+	return ret;
+}
@@ -0,0 +1,15 @@
+--[[
+Copyright (c) 2018-2021 The Forge Interactive Inc.
+]]--
+
+-- Driven by the luaCall workload of HeadlessBenchmark, every Update calls back into native code
+local value = 0
+
+function Update(dt)
+	for i = 1, 256 do
+		value = loader.BenchmarkAccumulate(i * dt)
+	end
+end
+
+function Exit(dt)
+end
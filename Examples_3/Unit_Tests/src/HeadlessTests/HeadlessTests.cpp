@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2018-2021 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Headless tests of CPU-side engine subsystems.
+//
+// Every test runs without a window or a graphics device. Failed checks are logged with their location and the
+// process exits with EXIT_FAILURE if any test failed, so the tests can run in CI next to HeadlessBenchmark.
+//
+// Usage: HeadlessTests [-filter <name>]
+
+#include "../../../../Common_3/OS/Interfaces/ILog.h"
+#include "../../../../Common_3/OS/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/OS/Interfaces/IProfiler.h"
+#include "../../../../Common_3/OS/Profiler/ProfilerBase.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../../../Common_3/OS/Interfaces/IMemory.h"    // Must be the last include in a cpp file
+
+const char* gApplicationName = "HeadlessTests";
+
+static const char* pFilter = NULL;
+
+#define TEST_CHECK(condition)                                                            \
+	do                                                                                   \
+	{                                                                                    \
+		if (!(condition))                                                                \
+		{                                                                                \
+			LOGF(eERROR, "%s(%d): check failed: %s", __FILE__, __LINE__, #condition);   \
+			return false;                                                                \
+		}                                                                                \
+	} while (0)
+
+static char* readLogFile(const char* pFileName, size_t* pOutSize)
+{
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_READ_BINARY, &stream))
+		return NULL;
+
+	ssize_t size = fsGetStreamFileSize(&stream);
+	char*   pData = (char*)tf_malloc(size + 1);
+	size_t  bytesRead = fsReadFromStream(&stream, pData, size);
+	fsCloseStream(&stream);
+	pData[bytesRead] = '\0';
+	*pOutSize = bytesRead;
+	return pData;
+}
+
+static uint32_t countOccurrences(const char* pText, const char* pPattern)
+{
+	uint32_t count = 0;
+	const size_t length = strlen(pPattern);
+	for (const char* p = strstr(pText, pPattern); p; p = strstr(p + length, pPattern))
+		++count;
+	return count;
+}
+
+/************************************************************************/
+// Profiler capture
+/************************************************************************/
+// Enough scopes that a single frame of entries and labels does not fit in one capture chunk
+#define TEST_CAPTURE_SCOPES 16384
+
+static bool profilerCaptureTruncation()
+{
+	initProfiler();
+	ProfileSetEnableAllGroups(true);
+
+	// The file name carries the time the capture started
+	const char* pCaptureName = "HeadlessTestsTruncation";
+	time_t startTime = time(NULL);
+	if (!startProfileCapture(pCaptureName, 0))
+	{
+		LOGF(eERROR, "startProfileCapture failed");
+		exitProfiler();
+		return false;
+	}
+	time_t endTime = time(NULL);
+
+	// Register the group so the next flip activates it
+	{
+		PROFILER_SET_CPU_SCOPE("HeadlessTests", "Scope", 0xff00ff);
+	}
+	flipProfiler();
+	// Every scope carries a label, the frame gets cut at the end of the chunk and the labels
+	// that still made it in have to come out intact
+	for (uint32_t i = 0; i < TEST_CAPTURE_SCOPES; ++i)
+	{
+		PROFILER_SET_CPU_SCOPE("HeadlessTests", "Scope", 0xff00ff);
+		PROFILE_LABELF("HeadlessTests", "label %u", i);
+	}
+	// The capture trails the flip by the gpu frame delay
+	for (uint32_t i = 0; i < PROFILE_GPU_FRAME_DELAY + 2; ++i)
+		flipProfiler();
+	stopProfileCapture();
+	exitProfiler();
+
+	char*  pCapture = NULL;
+	size_t captureSize = 0;
+	for (time_t t = startTime; t <= endTime && !pCapture; ++t)
+	{
+		char format[FS_MAX_PATH] = {};
+		char fileName[FS_MAX_PATH] = {};
+		snprintf(format, sizeof(format), "%sProfile-%%Y-%%m-%%d-%%H.%%M.%%S.json", pCaptureName);
+		strftime(fileName, sizeof(fileName), format, localtime(&t));
+		pCapture = readLogFile(fileName, &captureSize);
+	}
+	TEST_CHECK(pCapture);
+
+	const uint32_t scopeCount = countOccurrences(pCapture, "{\"name\":\"Scope\"");
+	const uint32_t labelCount = countOccurrences(pCapture, "{\"name\":\"label ");
+	LOGF(eINFO, "profilerCaptureTruncation: %u of %u scopes and %u labels captured", scopeCount, TEST_CAPTURE_SCOPES, labelCount);
+
+	bool labelsIntact = true;
+	for (const char* p = strstr(pCapture, "{\"name\":\"label "); p && labelsIntact; p = strstr(p + 1, "{\"name\":\"label "))
+	{
+		const char* pNumber = p + strlen("{\"name\":\"label ");
+		char* pEnd = NULL;
+		unsigned long index = strtoul(pNumber, &pEnd, 10);
+		labelsIntact = pEnd != pNumber && *pEnd == '"' && index < TEST_CAPTURE_SCOPES;
+	}
+
+	const bool complete = captureSize >= 4 && !strcmp(pCapture + captureSize - 4, "\n]}\n");
+	const bool dropped = strstr(pCapture, "Dropped") != NULL;
+	tf_free(pCapture);
+
+	TEST_CHECK(complete);
+	// The frame was truncated, not dropped
+	TEST_CHECK(!dropped);
+	TEST_CHECK(scopeCount > 0 && scopeCount < TEST_CAPTURE_SCOPES);
+	TEST_CHECK(labelCount > 0);
+	TEST_CHECK(labelsIntact);
+	return true;
+}
+
+/************************************************************************/
+// Test driver
+/************************************************************************/
+typedef struct HeadlessTest
+{
+	const char* pName;
+	bool (*pRun)();
+} HeadlessTest;
+
+static const HeadlessTest gTests[] = {
+	{ "profilerCaptureTruncation", profilerCaptureTruncation },
+};
+#define HEADLESS_TEST_COUNT (sizeof(gTests) / sizeof(gTests[0]))
+
+static int HeadlessTests(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-filter") && i + 1 < argc)
+			pFilter = argv[++i];
+		else
+		{
+			LOGF(eERROR, "Usage: %s [-filter <name>]", gApplicationName);
+			return EXIT_FAILURE;
+		}
+	}
+
+	uint32_t runCount = 0;
+	uint32_t failCount = 0;
+	for (uint32_t i = 0; i < HEADLESS_TEST_COUNT; ++i)
+	{
+		if (pFilter && !strstr(gTests[i].pName, pFilter))
+			continue;
+
+		bool passed = gTests[i].pRun();
+		LOGF(passed ? eINFO : eERROR, "%-32s %s", gTests[i].pName, passed ? "passed" : "FAILED");
+		++runCount;
+		failCount += passed ? 0 : 1;
+	}
+
+	LOGF(failCount ? eERROR : eINFO, "%u of %u tests passed", runCount - failCount, runCount);
+	return failCount ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+	extern bool MemAllocInit(const char*);
+	extern void MemAllocExit();
+
+	if (!MemAllocInit(gApplicationName))
+		return EXIT_FAILURE;
+
+	FileSystemInitDesc fsDesc = {};
+	fsDesc.pAppName = gApplicationName;
+	if (!initFileSystem(&fsDesc))
+		return EXIT_FAILURE;
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_LOG, "");
+
+	Log::Init(gApplicationName);
+
+	int ret = HeadlessTests(argc, argv);
+
+	Log::Exit();
+	exitFileSystem();
+	MemAllocExit();
+
+	return ret;
+}
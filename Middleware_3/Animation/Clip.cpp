@@ -24,8 +24,11 @@
 
 #include "Clip.h"
 
+#include "../../Common_3/OS/Interfaces/IMemory.h"
+
 void Clip::Initialize(const ResourceDirectory resourceDir, const char* fileName, Rig* rig)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_ANIMATION);
 	LoadClip(resourceDir, fileName);
 }
 
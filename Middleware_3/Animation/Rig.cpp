@@ -24,8 +24,12 @@
 
 #include "Rig.h"
 
+#include "../../Common_3/OS/Interfaces/IMemory.h"
+
 void Rig::Initialize(const ResourceDirectory resourceDir, const char* fileName)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_ANIMATION);
+
 	// Reading skeleton.
 	if (!LoadSkeleton(resourceDir, fileName))
 		return;    //need error catching
@@ -32,6 +32,8 @@
 
 void LuaManager::Init()
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_SCRIPTING);
+
 	m_Impl = (LuaManagerImpl*)tf_calloc(1, sizeof(LuaManagerImpl));
 	tf_placement_new<LuaManagerImpl>(m_Impl);
 }
@@ -138,6 +138,8 @@ public:
 		textureRootDesc.ppStaticSamplerNames = pStaticSamplers;
 		textureRootDesc.ppStaticSamplers = &pDefaultSampler;
 		addRootSignature(pRenderer, &textureRootDesc, &pRootSignature);
+		mUniformBlockIndex = getDescriptorIndexFromName(pRootSignature, "uniformBlock_rootcbv");
+		mRootConstantIndex = getDescriptorIndexFromName(pRootSignature, "uRootConstants");
 
 		addUniformGPURingBuffer(pRenderer, 65536, &pUniformRingBuffer, true);
 
@@ -295,6 +297,9 @@ public:
 	RootSignature*     pRootSignature;
 	DescriptorSet*     pDescriptorSets;
 	Pipeline*          pPipelines[2];
+	/// Resolved once, text is drawn in many small batches
+	uint32_t           mUniformBlockIndex;
+	uint32_t           mRootConstantIndex;
 	/// Default states
 	Sampler*             pDefaultSampler;
 	GPURingBuffer*       pUniformRingBuffer;
@@ -553,13 +558,13 @@ void _Impl_FontStash::fonsImplementationRenderText(
 		const uint32_t stride = sizeof(float4);
 
 		DescriptorData params[1] = {};
-		params[0].pName = "uniformBlock_rootcbv";
+		params[0].mIndex = ctx->mUniformBlockIndex;
 		params[0].ppBuffers = &uniformBlock.pBuffer;
 		params[0].pOffsets = &uniformBlock.mOffset;
 		params[0].pSizes = &size;
 		updateDescriptorSet(ctx->pRenderer, pipelineIndex, ctx->pDescriptorSets, 1, params);
 		cmdBindDescriptorSet(pCmd, pipelineIndex, ctx->pDescriptorSets);
-		cmdBindPushConstants(pCmd, ctx->pRootSignature, "uRootConstants", &data);
+		cmdBindPushConstantsByIndex(pCmd, ctx->pRootSignature, ctx->mRootConstantIndex, &data);
 		cmdBindVertexBuffer(pCmd, 1, &buffer.pBuffer, &stride, &buffer.mOffset);
 		cmdDraw(pCmd, nverts, 0);
 	}
@@ -567,7 +572,7 @@ void _Impl_FontStash::fonsImplementationRenderText(
 	{
 		const uint32_t stride = sizeof(float4);
 		cmdBindDescriptorSet(pCmd, pipelineIndex, ctx->pDescriptorSets);
-		cmdBindPushConstants(pCmd, ctx->pRootSignature, "uRootConstants", &data);
+		cmdBindPushConstantsByIndex(pCmd, ctx->pRootSignature, ctx->mRootConstantIndex, &data);
 		cmdBindVertexBuffer(pCmd, 1, &buffer.pBuffer, &stride, &buffer.mOffset);
 		cmdDraw(pCmd, nverts, 0);
 	}
@@ -731,6 +731,8 @@ UIApp::UIApp(int32_t const fontAtlasSize, uint32_t const maxDynamicUIUpdatesPerB
 
 bool UIApp::Init(Renderer* renderer, PipelineCache* pCache)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_UI);
+
 	mShowDemoUiWindow = false;
 
 	pImpl = tf_new(UIAppImpl);
@@ -803,6 +805,8 @@ void UIApp::Exit()
 
 bool UIApp::Load(RenderTarget** rts, uint32_t count)
 {
+	MEMORY_TAG_SCOPE(MEMORY_TAG_UI);
+
 	ASSERT(rts && rts[0]);
 	mWidth = (float)rts[0]->mWidth;
 	mHeight = (float)rts[0]->mHeight;
@@ -301,6 +301,8 @@ class ImguiGUIDriver: public GUIDriver
 	Renderer*          pRenderer;
 	Shader*            pShaderTextured;
 	RootSignature*     pRootSignatureTextured;
+	/// Resolved once, dynamic textures are bound per draw
+	uint32_t           mTextureIndex;
 	DescriptorSet*     pDescriptorSetUniforms;
 	DescriptorSet*     pDescriptorSetTexture;
 	Pipeline*          pPipelineTextured;
@@ -819,6 +821,7 @@ bool ImguiGUIDriver::init(Renderer* renderer, uint32_t const maxDynamicUIUpdates
 	textureRootDesc.ppStaticSamplerNames = pStaticSamplerNames;
 	textureRootDesc.ppStaticSamplers = &pDefaultSampler;
 	addRootSignature(pRenderer, &textureRootDesc, &pRootSignatureTextured);
+	mTextureIndex = getDescriptorIndexFromName(pRootSignatureTextured, "uTex");
 
 	DescriptorSetDesc setDesc = { pRootSignatureTextured, DESCRIPTOR_UPDATE_FREQ_PER_BATCH, 1 + (maxDynamicUIUpdatesPerBatch * MAX_FRAMES) };
 	addDescriptorSet(pRenderer, &setDesc, &pDescriptorSetTexture);
@@ -1311,7 +1314,7 @@ void ImguiGUIDriver::draw(Cmd* pCmd)
 				{
 					uint32_t setIndex = (uint32_t)mFontTextures.size() + (frameIdx * mMaxDynamicUIUpdatesPerBatch + mDynamicUIUpdates);
 					DescriptorData params[1] = {};
-					params[0].pName = "uTex";
+					params[0].mIndex = mTextureIndex;
 					params[0].ppTextures = (Texture**)&pcmd->TextureId;
 					updateDescriptorSet(pRenderer, setIndex, pDescriptorSetTexture, 1, params);
 					cmdBindDescriptorSet(pCmd, setIndex, pDescriptorSetTexture);